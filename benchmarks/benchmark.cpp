@@ -0,0 +1,724 @@
+#include "asr.h"
+
+// The benchmark replaces the global operator new in debug builds to count the allocations of every frame.
+#define ASR_ALLOCATION_COUNTER_IMPLEMENTATION
+#include "utilities/allocation_counter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace asr;
+
+namespace
+{
+    const unsigned int RANDOM_SEED{42};
+    const size_t WARM_UP_FRAME_COUNT{30};
+
+    enum class LightCulling
+    {
+        None,
+        PerMesh,
+        Clustered
+    };
+
+    struct BenchmarkScene
+    {
+        std::string name;
+        std::shared_ptr<Scene> scene;
+        size_t mesh_count;
+        float camera_distance;
+        float camera_height;
+        std::function<void(size_t frame)> update;
+        LightCulling light_culling{LightCulling::None};
+        bool depth_pre_pass_enabled{false};
+        bool dynamic_resolution_enabled{false};
+        bool occlusion_culling_enabled{false};
+        bool shadow_mapping_enabled{false};
+    };
+
+    struct FrameStatistics
+    {
+        std::vector<double> cpu_frame_times;
+        std::vector<double> gpu_frame_times;
+        double draw_call_count{0.0};
+        double triangle_count{0.0};
+        double state_change_count{0.0};
+        double culled_mesh_count{0.0};
+        double occluded_mesh_count{0.0};
+        size_t max_frame_allocation_count{0};
+    };
+
+    std::vector<std::shared_ptr<Material>> create_phong_materials(size_t count)
+    {
+        std::mt19937 random{RANDOM_SEED};
+        std::uniform_real_distribution<float> color{0.2f, 1.0f};
+
+        std::vector<std::shared_ptr<Material>> materials;
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto material = std::make_shared<ES2PhongMaterial>();
+            material->set_diffuse_color(glm::vec4(color(random), color(random), color(random), 1.0f));
+            material->set_specular_exponent(20.0f);
+            materials.push_back(material);
+        }
+
+        return materials;
+    }
+
+    std::shared_ptr<PointLight> create_point_light(const glm::vec3 &position, const glm::vec3 &color)
+    {
+        auto point_light = create_node<PointLight>();
+        point_light->set_position(position);
+        point_light->set_diffuse_color(color);
+        point_light->set_intensity(1.0f);
+
+        return point_light;
+    }
+
+    BenchmarkScene create_mesh_grid_scene(const std::string &name, size_t mesh_count)
+    {
+        auto [box_indices, box_vertices] = geometry_generators::generate_box_geometry_data(0.8f, 0.8f, 0.8f, 1, 1, 1);
+        auto box_geometry = std::make_shared<ES2Geometry>(std::move(box_indices), std::move(box_vertices));
+        auto materials = create_phong_materials(8);
+
+        auto side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(mesh_count))));
+        std::vector<std::shared_ptr<Object>> objects;
+        objects.reserve(mesh_count);
+        for (size_t i = 0; i < mesh_count; ++i)
+        {
+            auto mesh = create_node<Mesh>(box_geometry, materials[i % materials.size()]);
+            mesh->set_position(glm::vec3(
+                static_cast<float>(i % side) - static_cast<float>(side) * 0.5f,
+                0.0f,
+                static_cast<float>(i / side) - static_cast<float>(side) * 0.5f));
+            objects.push_back(mesh);
+        }
+
+        auto scene = std::make_shared<Scene>(objects);
+        auto point_light = create_point_light(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(1.0f));
+        point_light->set_attenuation_distance(static_cast<float>(side) * 2.0f);
+        scene->get_root()->add_child(point_light);
+        scene->get_point_lights().push_back(point_light);
+
+        return BenchmarkScene{name, scene, mesh_count, static_cast<float>(side) * 0.6f, static_cast<float>(side) * 0.3f, {}};
+    }
+
+    BenchmarkScene create_level_of_detail_scene()
+    {
+        static const size_t SPHERE_SIDE{100};
+        static const unsigned int SEGMENT_COUNTS[]{64, 32, 16, 8};
+        static const float SCREEN_SIZES[]{0.0f, 0.08f, 0.03f, 0.01f};
+
+        std::vector<std::shared_ptr<Geometry>> levels;
+        for (unsigned int segment_count : SEGMENT_COUNTS)
+        {
+            auto [sphere_indices, sphere_vertices] = geometry_generators::generate_sphere_geometry_data(0.4f, segment_count, segment_count);
+            auto sphere_geometry = std::make_shared<ES2Geometry>(std::move(sphere_indices), std::move(sphere_vertices));
+            sphere_geometry->optimize_vertex_cache();
+            sphere_geometry->optimize_vertex_fetch();
+            levels.push_back(sphere_geometry);
+        }
+        auto materials = create_phong_materials(4);
+
+        std::vector<std::shared_ptr<Object>> objects;
+        for (size_t i = 0; i < SPHERE_SIDE * SPHERE_SIDE; ++i)
+        {
+            auto mesh = create_node<LODMesh>(levels[0], materials[i % materials.size()]);
+            for (size_t level = 1; level < levels.size(); ++level)
+            {
+                mesh->add_level(levels[level], SCREEN_SIZES[level]);
+            }
+            mesh->set_position(glm::vec3(
+                static_cast<float>(i % SPHERE_SIDE) - static_cast<float>(SPHERE_SIDE) * 0.5f,
+                0.0f,
+                static_cast<float>(i / SPHERE_SIDE) - static_cast<float>(SPHERE_SIDE) * 0.5f));
+            objects.push_back(mesh);
+        }
+
+        auto scene = std::make_shared<Scene>(objects);
+        auto point_light = create_point_light(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(1.0f));
+        point_light->set_attenuation_distance(static_cast<float>(SPHERE_SIDE) * 2.0f);
+        scene->get_root()->add_child(point_light);
+        scene->get_point_lights().push_back(point_light);
+
+        return BenchmarkScene{"level_of_detail", scene, SPHERE_SIDE * SPHERE_SIDE, 40.0f, 12.0f, {}};
+    }
+
+    // Detailed spheres inside a ring of walls that is taller than the orbiting camera, so that almost all of
+    // them are in the view frustum but hidden.
+    BenchmarkScene create_occlusion_scene()
+    {
+        static const size_t SPHERE_SIDE{40};
+        static const size_t WALL_COUNT{48};
+        static const float WALL_RADIUS{20.0f};
+        static const float WALL_HEIGHT{16.0f};
+
+        auto [sphere_indices, sphere_vertices] = geometry_generators::generate_sphere_geometry_data(0.3f, 32, 32);
+        auto sphere_geometry = std::make_shared<ES2Geometry>(std::move(sphere_indices), std::move(sphere_vertices));
+        float wall_width = 2.0f * static_cast<float>(M_PI) * WALL_RADIUS / static_cast<float>(WALL_COUNT) + 0.2f;
+        auto [wall_indices, wall_vertices] = geometry_generators::generate_box_geometry_data(wall_width, WALL_HEIGHT, 0.5f, 1, 1, 1);
+        auto wall_geometry = std::make_shared<ES2Geometry>(std::move(wall_indices), std::move(wall_vertices));
+        auto materials = create_phong_materials(4);
+
+        std::vector<std::shared_ptr<Object>> objects;
+        for (size_t i = 0; i < WALL_COUNT; ++i)
+        {
+            float angle = static_cast<float>(i) * 2.0f * static_cast<float>(M_PI) / static_cast<float>(WALL_COUNT);
+            auto mesh = create_node<Mesh>(wall_geometry, materials[0]);
+            mesh->set_position(glm::vec3(std::sin(angle) * WALL_RADIUS, WALL_HEIGHT * 0.5f - 0.5f, std::cos(angle) * WALL_RADIUS));
+            mesh->set_rotation_y(angle);
+            objects.push_back(mesh);
+        }
+        for (size_t i = 0; i < SPHERE_SIDE * SPHERE_SIDE; ++i)
+        {
+            auto mesh = create_node<Mesh>(sphere_geometry, materials[1 + i % (materials.size() - 1)]);
+            mesh->set_position(glm::vec3(
+                (static_cast<float>(i % SPHERE_SIDE) - static_cast<float>(SPHERE_SIDE) * 0.5f) * 0.7f,
+                0.0f,
+                (static_cast<float>(i / SPHERE_SIDE) - static_cast<float>(SPHERE_SIDE) * 0.5f) * 0.7f));
+            objects.push_back(mesh);
+        }
+
+        auto scene = std::make_shared<Scene>(objects);
+        auto point_light = create_point_light(glm::vec3(0.0f, 30.0f, 0.0f), glm::vec3(1.0f));
+        point_light->set_attenuation_distance(100.0f);
+        scene->get_root()->add_child(point_light);
+        scene->get_point_lights().push_back(point_light);
+
+        BenchmarkScene benchmark_scene{"occlusion", scene, objects.size(), 40.0f, 12.0f, {}};
+        benchmark_scene.occlusion_culling_enabled = true;
+
+        return benchmark_scene;
+    }
+
+    // Static boxes on a ground plane under a sun with cascaded shadow maps, with a few boxes that bounce, so
+    // only the cascades they are in are drawn again.
+    BenchmarkScene create_shadows_scene()
+    {
+        static const size_t BOX_SIDE{60};
+        static const size_t MOVING_BOX_COUNT{4};
+
+        auto [box_indices, box_vertices] = geometry_generators::generate_box_geometry_data(0.6f, 1.5f, 0.6f, 1, 1, 1);
+        auto box_geometry = std::make_shared<ES2Geometry>(std::move(box_indices), std::move(box_vertices));
+        auto [plane_indices, plane_vertices] = geometry_generators::generate_plane_geometry_data(
+            static_cast<float>(BOX_SIDE) * 2.0f, static_cast<float>(BOX_SIDE) * 2.0f, 1, 1);
+        auto plane_geometry = std::make_shared<ES2Geometry>(std::move(plane_indices), std::move(plane_vertices));
+        auto materials = create_phong_materials(4);
+
+        std::vector<std::shared_ptr<Object>> objects;
+        auto ground = create_node<Mesh>(plane_geometry, materials[0]);
+        ground->set_position(glm::vec3(0.0f, -0.75f, 0.0f));
+        ground->set_rotation_x(-static_cast<float>(M_PI) * 0.5f);
+        objects.push_back(ground);
+        std::vector<std::shared_ptr<Mesh>> moving_boxes;
+        for (size_t i = 0; i < BOX_SIDE * BOX_SIDE; ++i)
+        {
+            auto mesh = create_node<Mesh>(box_geometry, materials[1 + i % (materials.size() - 1)]);
+            mesh->set_position(glm::vec3(
+                (static_cast<float>(i % BOX_SIDE) - static_cast<float>(BOX_SIDE) * 0.5f) * 1.5f,
+                0.0f,
+                (static_cast<float>(i / BOX_SIDE) - static_cast<float>(BOX_SIDE) * 0.5f) * 1.5f));
+            objects.push_back(mesh);
+            if (i % (BOX_SIDE * BOX_SIDE / MOVING_BOX_COUNT) == BOX_SIDE * BOX_SIDE / MOVING_BOX_COUNT / 2)
+            {
+                moving_boxes.push_back(mesh);
+            }
+        }
+
+        auto scene = std::make_shared<Scene>(objects);
+        auto sun = create_node<DirectionalLight>();
+        sun->set_direction(glm::vec3(0.4f, 1.0f, 0.3f));
+        sun->set_diffuse_color(glm::vec3(1.0f));
+        sun->set_intensity(1.0f);
+        sun->set_casting_shadows(true);
+        sun->set_shadow_distance(60.0f);
+        scene->get_root()->add_child(sun);
+        scene->get_directional_lights().push_back(sun);
+
+        auto update = [moving_boxes](size_t frame) {
+            float time = static_cast<float>(frame) * 0.1f;
+            for (const auto &box : moving_boxes)
+            {
+                glm::vec3 position = box->get_position();
+                position.y = std::fabs(std::sin(time)) * 2.0f;
+                box->set_position(position);
+            }
+        };
+
+        BenchmarkScene benchmark_scene{"shadows", scene, objects.size(), 40.0f, 12.0f, update};
+        benchmark_scene.shadow_mapping_enabled = true;
+
+        return benchmark_scene;
+    }
+
+    BenchmarkScene create_particles_scene()
+    {
+        static const size_t PARTICLE_COUNT{1000000};
+        static const float FRAME_TIME{1.0f / 60.0f};
+
+        auto material = std::make_shared<ES2ConstantMaterial>();
+        material->set_blending_enabled(true);
+        material->set_depth_mask_enabled(false);
+        material->set_point_sizing_enabled(true);
+        material->set_point_size(2.0f);
+        material->set_transparent(true);
+
+        auto particle_system = std::make_shared<ParticleSystem>(
+            std::make_shared<ES2Geometry>(std::vector<unsigned int>{}, std::vector<Vertex>{}), material, PARTICLE_COUNT);
+        particle_system->set_random_seed(RANDOM_SEED);
+        particle_system->set_emission_extent(glm::vec3(20.0f, 1.0f, 20.0f));
+        particle_system->set_minimum_velocity(glm::vec3(-1.0f, 2.0f, -1.0f));
+        particle_system->set_maximum_velocity(glm::vec3(1.0f, 6.0f, 1.0f));
+        particle_system->set_minimum_lifetime(2.0f);
+        particle_system->set_maximum_lifetime(4.0f);
+        particle_system->set_acceleration(glm::vec3(0.0f, -1.0f, 0.0f));
+        particle_system->set_start_color(glm::vec4(1.0f, 0.8f, 0.3f, 0.6f));
+        particle_system->set_end_color(glm::vec4(0.8f, 0.2f, 0.1f, 0.0f));
+        particle_system->set_spawn_rate(static_cast<float>(PARTICLE_COUNT) / 3.0f);
+        particle_system->emit(PARTICLE_COUNT / 2);
+
+        auto update = [particle_system](size_t /*frame*/) {
+            particle_system->update(FRAME_TIME, &JobSystem::get_instance());
+        };
+
+        return BenchmarkScene{"particles", std::make_shared<Scene>(std::vector<std::shared_ptr<Object>>{particle_system}), 1,
+                              30.0f, 10.0f, update};
+    }
+
+    BenchmarkScene create_animation_scene()
+    {
+        static const size_t MESH_COUNT{10000};
+        static const float FRAME_TIME{1.0f / 60.0f};
+
+        auto clip = std::make_shared<AnimationClip>("bounce");
+        clip->add_position_track(0, {0.0f, 0.5f, 1.0f, 1.5f, 2.0f},
+                                 {glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.5f, 0.0f),
+                                  glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f)});
+        clip->add_rotation_track(0, {0.0f, 1.0f, 2.0f},
+                                 {glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::quat(0.0f, 0.0f, 1.0f, 0.0f),
+                                  glm::quat(-1.0f, 0.0f, 0.0f, 0.0f)});
+        clip->add_scale_track(0, {0.0f, 1.0f, 2.0f}, {glm::vec3(1.0f), glm::vec3(0.6f), glm::vec3(1.0f)});
+
+        auto [box_indices, box_vertices] = geometry_generators::generate_box_geometry_data(0.8f, 0.8f, 0.8f, 1, 1, 1);
+        auto box_geometry = std::make_shared<ES2Geometry>(std::move(box_indices), std::move(box_vertices));
+        auto materials = create_phong_materials(8);
+
+        // The clip moves every box relative to an anchor in the grid, from its own point in the clip.
+        auto animation_system = std::make_shared<AnimationSystem>();
+        auto side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(MESH_COUNT))));
+        std::vector<std::shared_ptr<Object>> objects;
+        objects.reserve(MESH_COUNT);
+        for (size_t i = 0; i < MESH_COUNT; ++i)
+        {
+            auto anchor = create_node<Object>("", glm::vec3(
+                static_cast<float>(i % side) - static_cast<float>(side) * 0.5f,
+                0.0f,
+                static_cast<float>(i / side) - static_cast<float>(side) * 0.5f));
+            auto mesh = create_node<Mesh>(box_geometry, materials[i % materials.size()]);
+            anchor->add_child(mesh);
+            objects.push_back(anchor);
+
+            auto player = animation_system->play(clip, {mesh});
+            animation_system->set_time(player, static_cast<float>(i % side + i / side) * 0.05f);
+        }
+
+        auto scene = std::make_shared<Scene>(objects);
+        auto point_light = create_point_light(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(1.0f));
+        point_light->set_attenuation_distance(static_cast<float>(side) * 2.0f);
+        scene->get_root()->add_child(point_light);
+        scene->get_point_lights().push_back(point_light);
+
+        auto update = [animation_system](size_t /*frame*/) {
+            animation_system->update(FRAME_TIME, &JobSystem::get_instance());
+        };
+
+        return BenchmarkScene{"animation", scene, MESH_COUNT, static_cast<float>(side) * 0.6f,
+                              static_cast<float>(side) * 0.3f, update};
+    }
+
+    BenchmarkScene create_primitive_batch_scene()
+    {
+        static const size_t SERIES_COUNT{64};
+        static const size_t SAMPLE_COUNT{512};
+        static const size_t BAR_COUNT{256};
+
+        auto line_material = std::make_shared<ES2ConstantMaterial>();
+        auto point_material = std::make_shared<ES2ConstantMaterial>();
+        point_material->set_point_sizing_enabled(true);
+        point_material->set_point_size(2.0f);
+
+        auto batch = std::make_shared<ES2PrimitiveBatch>();
+        batch->set_position(glm::vec3(-20.0f, -10.0f, 0.0f));
+
+        std::vector<glm::vec3> samples(SAMPLE_COUNT);
+        auto update = [batch, line_material, point_material, samples](size_t frame) mutable {
+            float time = static_cast<float>(frame) * 0.05f;
+            batch->begin();
+
+            batch->set_material(line_material);
+            for (size_t i = 0; i < BAR_COUNT; ++i)
+            {
+                float x = static_cast<float>(i) * 40.0f / static_cast<float>(BAR_COUNT);
+                float height = 2.0f + std::sin(time + static_cast<float>(i) * 0.2f);
+                batch->set_color(glm::vec4(0.2f, 0.3f, 0.5f, 1.0f));
+                batch->add_rectangle(glm::vec2(x, 0.0f), glm::vec2(x + 0.1f, height));
+            }
+
+            for (size_t series = 0; series < SERIES_COUNT; ++series)
+            {
+                auto offset = static_cast<float>(series);
+                for (size_t i = 0; i < SAMPLE_COUNT; ++i)
+                {
+                    float x = static_cast<float>(i) * 40.0f / static_cast<float>(SAMPLE_COUNT);
+                    samples[i] = glm::vec3(x, 10.0f + 8.0f * std::sin(time + x * 0.3f + offset * 0.1f) * std::cos(offset), 0.0f);
+                }
+                batch->set_color(glm::vec4(offset / static_cast<float>(SERIES_COUNT), 0.8f, 0.4f, 1.0f));
+                batch->set_line_width(series % 8 == 0 ? 0.1f : 0.0f);
+                batch->add_polyline(samples);
+
+                batch->set_material(point_material);
+                for (size_t i = 0; i < SAMPLE_COUNT; i += 4)
+                {
+                    batch->add_point(samples[i]);
+                }
+                batch->set_material(line_material);
+            }
+            batch->set_line_width(0.0f);
+
+            batch->end();
+        };
+        update(0);
+
+        return BenchmarkScene{"primitive_batch", std::make_shared<Scene>(std::vector<std::shared_ptr<Object>>{batch}), 1,
+                              30.0f, 0.0f, update};
+    }
+
+    BenchmarkScene create_many_lights_scene(const std::string &name, size_t light_count, LightCulling light_culling)
+    {
+        static const size_t SPHERE_SIDE{50};
+
+        auto [sphere_indices, sphere_vertices] = geometry_generators::generate_sphere_geometry_data(0.4f, 16, 16);
+        auto sphere_geometry = std::make_shared<ES2Geometry>(std::move(sphere_indices), std::move(sphere_vertices));
+        auto materials = create_phong_materials(4);
+
+        std::vector<std::shared_ptr<Object>> objects;
+        for (size_t i = 0; i < SPHERE_SIDE * SPHERE_SIDE; ++i)
+        {
+            auto mesh = create_node<Mesh>(sphere_geometry, materials[i % materials.size()]);
+            mesh->set_position(glm::vec3(
+                static_cast<float>(i % SPHERE_SIDE) - static_cast<float>(SPHERE_SIDE) * 0.5f,
+                0.0f,
+                static_cast<float>(i / SPHERE_SIDE) - static_cast<float>(SPHERE_SIDE) * 0.5f));
+            objects.push_back(mesh);
+        }
+
+        auto scene = std::make_shared<Scene>(objects);
+        std::mt19937 random{RANDOM_SEED};
+        std::uniform_real_distribution<float> color{0.3f, 1.0f};
+        std::vector<std::shared_ptr<PointLight>> point_lights;
+        for (size_t i = 0; i < light_count; ++i)
+        {
+            auto point_light = create_point_light(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(color(random), color(random), color(random)));
+            point_light->set_attenuation_distance(12.0f);
+            if (light_culling != LightCulling::None)
+            {
+                point_light->set_culling_range(6.0f);
+            }
+            scene->get_root()->add_child(point_light);
+            scene->get_point_lights().push_back(point_light);
+            point_lights.push_back(point_light);
+        }
+
+        auto update = [point_lights](size_t frame) {
+            for (size_t i = 0; i < point_lights.size(); ++i)
+            {
+                float angle = static_cast<float>(frame) * 0.01f + static_cast<float>(i) * 2.0f * static_cast<float>(M_PI) / static_cast<float>(point_lights.size());
+                float radius = 5.0f + static_cast<float>(i % 4) * 5.0f;
+                point_lights[i]->set_position(glm::vec3(std::cos(angle) * radius, 2.0f, std::sin(angle) * radius));
+            }
+        };
+
+        return BenchmarkScene{name, scene, SPHERE_SIDE * SPHERE_SIDE, 35.0f, 20.0f, update, light_culling};
+    }
+
+    BenchmarkScene create_transparency_scene()
+    {
+        static const size_t SPRITE_COUNT{20000};
+
+        auto [plane_indices, plane_vertices] = geometry_generators::generate_plane_geometry_data(1.0f, 1.0f, 1, 1);
+        auto plane_geometry = std::make_shared<ES2Geometry>(std::move(plane_indices), std::move(plane_vertices));
+        auto material = std::make_shared<ES2ConstantMaterial>();
+        material->set_emission_color(glm::vec4(0.9f, 0.6f, 0.3f, 0.1f));
+        material->set_blending_enabled(true);
+        material->set_face_culling_enabled(false);
+        material->set_transparent(true);
+
+        std::mt19937 random{RANDOM_SEED};
+        std::uniform_real_distribution<float> coordinate{-20.0f, 20.0f};
+        std::vector<std::shared_ptr<Object>> objects;
+        for (size_t i = 0; i < SPRITE_COUNT; ++i)
+        {
+            auto mesh = create_node<Mesh>(plane_geometry, material);
+            mesh->set_position(glm::vec3(coordinate(random), coordinate(random), coordinate(random)));
+            objects.push_back(mesh);
+        }
+
+        return BenchmarkScene{"transparency", std::make_shared<Scene>(objects), SPRITE_COUNT, 45.0f, 10.0f, {}};
+    }
+
+    BenchmarkScene create_streaming_geometry_scene()
+    {
+        static const size_t PLANE_SIDE{4};
+        static const unsigned int PLANE_SEGMENT_COUNT{128};
+
+        auto material = create_phong_materials(1).front();
+        std::vector<std::shared_ptr<Object>> objects;
+        std::vector<std::shared_ptr<Geometry>> geometries;
+        for (size_t i = 0; i < PLANE_SIDE * PLANE_SIDE; ++i)
+        {
+            auto [plane_indices, plane_vertices] = geometry_generators::generate_plane_geometry_data(
+                10.0f, 10.0f, PLANE_SEGMENT_COUNT, PLANE_SEGMENT_COUNT);
+            auto plane_geometry = std::make_shared<ES2Geometry>(std::move(plane_indices), std::move(plane_vertices));
+            plane_geometry->set_vertices_usage_strategy(Geometry::StreamStrategy);
+            geometries.push_back(plane_geometry);
+
+            auto mesh = create_node<Mesh>(plane_geometry, material);
+            mesh->set_position(glm::vec3(
+                (static_cast<float>(i % PLANE_SIDE) - static_cast<float>(PLANE_SIDE) * 0.5f) * 10.0f,
+                0.0f,
+                (static_cast<float>(i / PLANE_SIDE) - static_cast<float>(PLANE_SIDE) * 0.5f) * 10.0f));
+            mesh->set_rotation_x(-static_cast<float>(M_PI) * 0.5f);
+            objects.push_back(mesh);
+        }
+
+        auto scene = std::make_shared<Scene>(objects);
+        auto point_light = create_point_light(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(1.0f));
+        point_light->set_attenuation_distance(80.0f);
+        scene->get_root()->add_child(point_light);
+        scene->get_point_lights().push_back(point_light);
+
+        // The meshes are told by their geometries that the bounds follow the waves.
+        auto update = [geometries](size_t frame) {
+            float time = static_cast<float>(frame) * 0.05f;
+            for (const auto &geometry : geometries)
+            {
+                size_t vertex_count = geometry->get_vertex_count();
+                Vertex *vertices = geometry->edit_vertices(0, vertex_count);
+                for (size_t i = 0; i < vertex_count; ++i)
+                {
+                    Vertex &vertex = vertices[i];
+                    vertex.position.z = std::sin(vertex.position.x + time) * std::cos(vertex.position.y + time) * 0.5f;
+                }
+            }
+        };
+
+        return BenchmarkScene{"streaming_geometry", scene, PLANE_SIDE * PLANE_SIDE, 30.0f, 15.0f, update};
+    }
+
+    void update_camera(Camera &camera, const BenchmarkScene &benchmark_scene, size_t frame, size_t frame_count)
+    {
+        float angle = static_cast<float>(frame) * 2.0f * static_cast<float>(M_PI) / static_cast<float>(frame_count);
+        camera.set_position(glm::vec3(
+            std::sin(angle) * benchmark_scene.camera_distance,
+            benchmark_scene.camera_height,
+            std::cos(angle) * benchmark_scene.camera_distance));
+        camera.set_rotation(glm::vec3(
+            -std::atan2(benchmark_scene.camera_height, benchmark_scene.camera_distance), angle, 0.0f));
+    }
+
+    FrameStatistics run_benchmark(const std::shared_ptr<ES2SDLWindow> &window, BenchmarkScene &benchmark_scene,
+                                  size_t frame_count)
+    {
+        auto camera = benchmark_scene.scene->get_camera();
+        camera->set_far_plane(std::max(camera->get_far_plane(), benchmark_scene.camera_distance * 4.0f));
+
+        ES2Renderer renderer(benchmark_scene.scene, window);
+        renderer.set_gpu_timing_enabled(true);
+        renderer.set_light_culling_enabled(benchmark_scene.light_culling == LightCulling::PerMesh);
+        renderer.set_clustered_lighting_enabled(benchmark_scene.light_culling == LightCulling::Clustered);
+        renderer.set_depth_pre_pass_enabled(benchmark_scene.depth_pre_pass_enabled);
+        renderer.set_front_to_back_sorting_enabled(benchmark_scene.depth_pre_pass_enabled);
+        renderer.set_dynamic_resolution_enabled(benchmark_scene.dynamic_resolution_enabled);
+        renderer.set_occlusion_culling_enabled(benchmark_scene.occlusion_culling_enabled);
+        renderer.set_shadow_mapping_enabled(benchmark_scene.shadow_mapping_enabled);
+
+        FrameStatistics statistics;
+        for (size_t frame = 0; frame < WARM_UP_FRAME_COUNT + frame_count; ++frame)
+        {
+            window->poll();
+            update_camera(*camera, benchmark_scene, frame, frame_count);
+            if (benchmark_scene.update)
+            {
+                benchmark_scene.update(frame);
+            }
+
+            auto frame_start = std::chrono::steady_clock::now();
+            renderer.render();
+            auto frame_end = std::chrono::steady_clock::now();
+            if (frame < WARM_UP_FRAME_COUNT)
+            {
+                continue;
+            }
+
+            statistics.cpu_frame_times.push_back(std::chrono::duration<double, std::milli>(frame_end - frame_start).count());
+            const RenderStats &stats = renderer.get_stats();
+            if (stats.gpu_frame_time > 0.0f)
+            {
+                statistics.gpu_frame_times.push_back(static_cast<double>(stats.gpu_frame_time));
+            }
+            statistics.draw_call_count += static_cast<double>(stats.draw_call_count);
+            statistics.triangle_count += static_cast<double>(stats.triangle_count);
+            statistics.state_change_count += static_cast<double>(stats.state_change_count);
+            statistics.culled_mesh_count += static_cast<double>(stats.culled_mesh_count);
+            statistics.occluded_mesh_count += static_cast<double>(stats.occluded_mesh_count);
+            statistics.max_frame_allocation_count =
+                std::max(statistics.max_frame_allocation_count, renderer.get_frame_allocation_count());
+        }
+
+        auto measured_frame_count = static_cast<double>(std::max<size_t>(frame_count, 1));
+        statistics.draw_call_count /= measured_frame_count;
+        statistics.triangle_count /= measured_frame_count;
+        statistics.state_change_count /= measured_frame_count;
+        statistics.culled_mesh_count /= measured_frame_count;
+        statistics.occluded_mesh_count /= measured_frame_count;
+
+        return statistics;
+    }
+
+    void print_times(const char *name, std::vector<double> times, bool last)
+    {
+        std::sort(times.begin(), times.end());
+        double mean{0.0};
+        for (double time : times)
+        {
+            mean += time;
+        }
+        mean = times.empty() ? 0.0 : mean / static_cast<double>(times.size());
+        auto percentile = [&](double fraction) {
+            return times.empty() ? 0.0 : times[std::min(times.size() - 1, static_cast<size_t>(fraction * static_cast<double>(times.size())))];
+        };
+
+        std::printf("      \"%s\": {\"mean\": %.4f, \"median\": %.4f, \"p95\": %.4f, \"min\": %.4f, \"max\": %.4f}%s\n",
+                    name, mean, percentile(0.5), percentile(0.95),
+                    times.empty() ? 0.0 : times.front(), times.empty() ? 0.0 : times.back(), last ? "" : ",");
+    }
+}
+
+// Renders deterministic stress scenes for a fixed number of frames with vsync disabled and prints the
+// frame statistics as JSON on stdout. Debug builds also report the most heap allocations that a frame made
+// after the warm-up and exit with an error when any frame allocated.
+//
+//     benchmark [--frames <count>] [--scene <name>] [--hidden]
+int main(int argc, char **argv)
+{
+    size_t frame_count{600};
+    std::string scene_filter;
+    bool hidden{false};
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument{argv[i]};
+        if (argument == "--frames" && i + 1 < argc)
+        {
+            frame_count = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argument == "--scene" && i + 1 < argc)
+        {
+            scene_filter = argv[++i];
+        }
+        else if (argument == "--hidden")
+        {
+            hidden = true;
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [--frames <count>] [--scene <name>] [--hidden]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    auto window = std::make_shared<ES2SDLWindow>("asr benchmark", 1280, 720);
+    window->set_vsync_enabled(false);
+    window->set_visible(!hidden);
+    window->set_on_exit([]() {});
+    window->set_on_key_down([](int /* key */) {});
+
+    std::vector<std::pair<std::string, std::function<BenchmarkScene()>>> scene_factories{
+        {"meshes_10k", []() { return create_mesh_grid_scene("meshes_10k", 10000); }},
+        {"meshes_100k", []() { return create_mesh_grid_scene("meshes_100k", 100000); }},
+        {"depth_pre_pass", []() {
+             auto benchmark_scene = create_mesh_grid_scene("depth_pre_pass", 10000);
+             benchmark_scene.depth_pre_pass_enabled = true;
+             return benchmark_scene;
+         }},
+        {"dynamic_resolution", []() {
+             auto benchmark_scene = create_mesh_grid_scene("dynamic_resolution", 100000);
+             benchmark_scene.dynamic_resolution_enabled = true;
+             return benchmark_scene;
+         }},
+        {"many_lights", []() { return create_many_lights_scene("many_lights", 16, LightCulling::None); }},
+        {"culled_lights", []() { return create_many_lights_scene("culled_lights", 256, LightCulling::PerMesh); }},
+        {"clustered_lights", []() { return create_many_lights_scene("clustered_lights", 256, LightCulling::Clustered); }},
+        {"level_of_detail", create_level_of_detail_scene},
+        {"transparency", create_transparency_scene},
+        {"streaming_geometry", create_streaming_geometry_scene},
+        {"occlusion", create_occlusion_scene},
+        {"shadows", create_shadows_scene},
+        {"particles", create_particles_scene},
+        {"primitive_batch", create_primitive_batch_scene},
+        {"animation", create_animation_scene}};
+
+    std::printf("{\n  \"frames\": %zu,\n  \"scenes\": [", frame_count);
+    bool first{true};
+    [[maybe_unused]] bool allocation_free{true};
+    for (const auto &[scene_name, scene_factory] : scene_factories)
+    {
+        if (!scene_filter.empty() && scene_name != scene_filter)
+        {
+            continue;
+        }
+
+        BenchmarkScene benchmark_scene = scene_factory();
+        FrameStatistics statistics = run_benchmark(window, benchmark_scene, frame_count);
+
+        std::printf("%s\n    {\n", first ? "" : ",");
+        std::printf("      \"name\": \"%s\",\n", benchmark_scene.name.c_str());
+        std::printf("      \"mesh_count\": %zu,\n", benchmark_scene.mesh_count);
+        print_times("cpu_frame_time_ms", statistics.cpu_frame_times, false);
+        print_times("gpu_frame_time_ms", statistics.gpu_frame_times, false);
+        std::printf("      \"draw_calls\": %.1f,\n", statistics.draw_call_count);
+        std::printf("      \"triangles\": %.1f,\n", statistics.triangle_count);
+        std::printf("      \"state_changes\": %.1f,\n", statistics.state_change_count);
+        std::printf("      \"culled_meshes\": %.1f,\n", statistics.culled_mesh_count);
+#ifdef NDEBUG
+        std::printf("      \"occluded_meshes\": %.1f\n", statistics.occluded_mesh_count);
+#else
+        // Frames after the warm-up are expected to render without touching the heap.
+        std::printf("      \"occluded_meshes\": %.1f,\n", statistics.occluded_mesh_count);
+        std::printf("      \"max_frame_allocations\": %zu\n", statistics.max_frame_allocation_count);
+        if (statistics.max_frame_allocation_count != 0)
+        {
+            std::fprintf(stderr, "%s: a frame after the warm-up made %zu heap allocations\n",
+                         benchmark_scene.name.c_str(), statistics.max_frame_allocation_count);
+            allocation_free = false;
+        }
+#endif
+        std::printf("    }");
+        std::fflush(stdout);
+        first = false;
+    }
+    std::printf("\n  ]\n}\n");
+
+#ifdef NDEBUG
+    return 0;
+#else
+    return allocation_free ? 0 : -1;
+#endif
+}
@@ -10,13 +10,26 @@ uniform mat4 projection_matrix;
 uniform vec4 emission_color;
 uniform float point_size;
 
-uniform bool texture1_enabled;
-uniform bool texture1_transformation_enabled;
+#ifdef INSTANCING
+#ifdef INSTANCE_BATCH_SIZE
+attribute float instance_index;
+uniform mat4 instance_model_matrices[INSTANCE_BATCH_SIZE];
+uniform vec4 instance_colors[INSTANCE_BATCH_SIZE];
+uniform vec4 instance_texture_regions[INSTANCE_BATCH_SIZE];
+#else
+attribute mat4 instance_model_matrix;
+attribute vec4 instance_color;
+attribute vec4 instance_texture_region;
+#endif
+#endif
+
+#ifdef TEXTURE1_TRANSFORMATION
 uniform mat4 texture1_transformation_matrix;
+#endif
 
-uniform bool texture2_enabled;
-uniform bool texture2_transformation_enabled;
+#ifdef TEXTURE2_TRANSFORMATION
 uniform mat4 texture2_transformation_matrix;
+#endif
 
 varying vec4 fragment_view_position;
 varying vec4 fragment_color;
@@ -25,26 +38,42 @@ varying vec2 fragment_texture2_coordinates;
 
 void main()
 {
-    vec4 view_position = model_view_matrix * position;
+#ifdef INSTANCING
+#ifdef INSTANCE_BATCH_SIZE
+    int instance = int(instance_index);
+    mat4 instance_model_matrix = instance_model_matrices[instance];
+    vec4 instance_color = instance_colors[instance];
+    vec4 instance_texture_region = instance_texture_regions[instance];
+#endif
+    mat4 instance_model_view_matrix = model_view_matrix * instance_model_matrix;
+#else
+    mat4 instance_model_view_matrix = model_view_matrix;
+    vec4 instance_color = vec4(1.0);
+#endif
+
+    vec4 view_position = instance_model_view_matrix * position;
     fragment_view_position = view_position;
-    fragment_color = color * emission_color;
-
-    if (texture1_enabled) {
-        if (texture1_transformation_enabled) {
-            vec4 transformed_texture1_coordinates = texture1_transformation_matrix * vec4(texture1_coordinates.st, 0.0, 1.0);
-            fragment_texture1_coordinates = vec2(transformed_texture1_coordinates);
-        } else {
-            fragment_texture1_coordinates = vec2(texture1_coordinates);
-        }
-    }
-    if (texture2_enabled) {
-        if (texture2_transformation_enabled) {
-            vec4 transformed_texture2_coordinates = texture2_transformation_matrix * vec4(texture2_coordinates.st, 0.0, 1.0);
-            fragment_texture2_coordinates = vec2(transformed_texture2_coordinates);
-        } else {
-            fragment_texture2_coordinates = vec2(texture2_coordinates);
-        }
-    }
+    fragment_color = color * emission_color * instance_color;
+
+#ifdef TEXTURE1
+#ifdef TEXTURE1_TRANSFORMATION
+    vec4 transformed_texture1_coordinates = texture1_transformation_matrix * vec4(texture1_coordinates.st, 0.0, 1.0);
+    fragment_texture1_coordinates = vec2(transformed_texture1_coordinates);
+#else
+    fragment_texture1_coordinates = vec2(texture1_coordinates);
+#endif
+#ifdef INSTANCING
+    fragment_texture1_coordinates = instance_texture_region.xy + fragment_texture1_coordinates * instance_texture_region.zw;
+#endif
+#endif
+#ifdef TEXTURE2
+#ifdef TEXTURE2_TRANSFORMATION
+    vec4 transformed_texture2_coordinates = texture2_transformation_matrix * vec4(texture2_coordinates.st, 0.0, 1.0);
+    fragment_texture2_coordinates = vec2(transformed_texture2_coordinates);
+#else
+    fragment_texture2_coordinates = vec2(texture2_coordinates);
+#endif
+#endif
 
     gl_Position = projection_matrix * view_position;
     gl_PointSize = point_size;
@@ -0,0 +1,14 @@
+attribute vec4 position;
+
+uniform mat4 model_view_matrix;
+uniform mat4 projection_matrix;
+
+#if defined(GL_ES) || __VERSION__ >= 120
+invariant gl_Position;
+#endif
+
+void main()
+{
+    vec4 view_position = model_view_matrix * position;
+    gl_Position = projection_matrix * view_position;
+}
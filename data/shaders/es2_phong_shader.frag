@@ -1,11 +1,11 @@
-#ifndef DIRECTIONAL_LIGHT_COUNT
-    #define DIRECTIONAL_LIGHT_COUNT 1
+#ifndef DIRECTIONAL_LIGHT_CAPACITY
+    #define DIRECTIONAL_LIGHT_CAPACITY 1
 #endif
-#ifndef POINT_LIGHT_COUNT
-    #define POINT_LIGHT_COUNT 1
+#ifndef POINT_LIGHT_CAPACITY
+    #define POINT_LIGHT_CAPACITY 1
 #endif
-#ifndef SPOT_LIGHT_COUNT
-    #define SPOT_LIGHT_COUNT 1
+#ifndef SPOT_LIGHT_CAPACITY
+    #define SPOT_LIGHT_CAPACITY 1
 #endif
 
 #ifndef TEXTURING_MODE_ADDITION
@@ -43,71 +43,126 @@
 #ifndef FOG_DEPTH_RADIAL
     #define FOG_DEPTH_RADIAL 2
 #endif
+#ifndef TEXTURING_MODE1
+    #define TEXTURING_MODE1 TEXTURING_MODE_MODULATION
+#endif
+#ifndef TEXTURING_MODE2
+    #define TEXTURING_MODE2 TEXTURING_MODE_MODULATION
+#endif
+#ifndef FOG_TYPE
+    #define FOG_TYPE FOG_TYPE_EXP2
+#endif
+#ifndef FOG_DEPTH
+    #define FOG_DEPTH FOG_DEPTH_PLANAR
+#endif
 
 uniform vec3 ambient_light_color;
 
+uniform int directional_light_count;
+uniform int point_light_count;
+uniform int spot_light_count;
+
 uniform vec3 material_ambient_color;
 uniform vec4 material_diffuse_color;
 uniform vec4 material_emission_color;
 uniform vec3 material_specular_color;
 uniform float material_specular_exponent;
 
-#if DIRECTIONAL_LIGHT_COUNT > 0
-    uniform bool directional_light_enabled[DIRECTIONAL_LIGHT_COUNT];
-    uniform bool directional_light_two_sided[DIRECTIONAL_LIGHT_COUNT];
-    uniform vec3 directional_light_view_direction[DIRECTIONAL_LIGHT_COUNT];
-    uniform vec3 directional_light_ambient_color[DIRECTIONAL_LIGHT_COUNT];
-    uniform vec3 directional_light_diffuse_color[DIRECTIONAL_LIGHT_COUNT];
-    uniform vec3 directional_light_specular_color[DIRECTIONAL_LIGHT_COUNT];
-    uniform float directional_light_intensity[DIRECTIONAL_LIGHT_COUNT];
-#endif
-
-#if POINT_LIGHT_COUNT > 0
-    uniform bool point_light_enabled[POINT_LIGHT_COUNT];
-    uniform bool point_light_two_sided[POINT_LIGHT_COUNT];
-    uniform vec3 point_light_view_position[POINT_LIGHT_COUNT];
-    uniform vec3 point_light_ambient_color[POINT_LIGHT_COUNT];
-    uniform vec3 point_light_diffuse_color[POINT_LIGHT_COUNT];
-    uniform vec3 point_light_specular_color[POINT_LIGHT_COUNT];
-    uniform float point_light_intensity[POINT_LIGHT_COUNT];
-    uniform float point_light_constant_attenuation[POINT_LIGHT_COUNT];
-    uniform float point_light_linear_attenuation[POINT_LIGHT_COUNT];
-    uniform float point_light_quadratic_attenuation[POINT_LIGHT_COUNT];
-#endif
-
-#if SPOT_LIGHT_COUNT > 0
-    uniform bool spot_light_enabled[SPOT_LIGHT_COUNT];
-    uniform bool spot_light_two_sided[SPOT_LIGHT_COUNT];
-    uniform vec3 spot_light_view_position[SPOT_LIGHT_COUNT];
-    uniform vec3 spot_light_view_direction[SPOT_LIGHT_COUNT];
-    uniform vec3 spot_light_ambient_color[SPOT_LIGHT_COUNT];
-    uniform vec3 spot_light_diffuse_color[SPOT_LIGHT_COUNT];
-    uniform vec3 spot_light_specular_color[SPOT_LIGHT_COUNT];
-    uniform float spot_light_exponent[SPOT_LIGHT_COUNT];
-    uniform float spot_light_cutoff_angle_cosine[SPOT_LIGHT_COUNT];
-    uniform float spot_light_intensity[SPOT_LIGHT_COUNT];
-    uniform float spot_light_constant_attenuation[SPOT_LIGHT_COUNT];
-    uniform float spot_light_linear_attenuation[SPOT_LIGHT_COUNT];
-    uniform float spot_light_quadratic_attenuation[SPOT_LIGHT_COUNT];
+#if DIRECTIONAL_LIGHT_CAPACITY > 0
+    uniform bool directional_light_enabled[DIRECTIONAL_LIGHT_CAPACITY];
+    uniform bool directional_light_two_sided[DIRECTIONAL_LIGHT_CAPACITY];
+    uniform vec3 directional_light_view_direction[DIRECTIONAL_LIGHT_CAPACITY];
+    uniform vec3 directional_light_ambient_color[DIRECTIONAL_LIGHT_CAPACITY];
+    uniform vec3 directional_light_diffuse_color[DIRECTIONAL_LIGHT_CAPACITY];
+    uniform vec3 directional_light_specular_color[DIRECTIONAL_LIGHT_CAPACITY];
+    uniform float directional_light_intensity[DIRECTIONAL_LIGHT_CAPACITY];
+#ifdef SHADOWS
+    uniform int directional_light_shadow_map_begin[DIRECTIONAL_LIGHT_CAPACITY];
+    uniform int directional_light_shadow_map_end[DIRECTIONAL_LIGHT_CAPACITY];
 #endif
+#endif
+
+#ifdef CLUSTERED_LIGHTING
+    uniform sampler2D light_cluster_sampler;
+    uniform sampler2D light_index_sampler;
+    uniform sampler2D light_data_sampler;
+    uniform mat4 light_cluster_projection_matrix;
+    uniform float light_cluster_depth_scale;
+    uniform float light_cluster_depth_bias;
+    uniform float light_index_texture_height;
+    uniform float light_data_texture_height;
+
+    vec4 read_light_data(float light, float texel)
+    {
+        return texture2D(
+            light_data_sampler,
+            vec2((texel + 0.5) / float(LIGHT_DATA_TEXTURE_WIDTH), (light + 0.5) / light_data_texture_height));
+    }
 
+    float read_light_index(float position)
+    {
+        float texel = floor(position / 4.0);
+        float component = position - texel * 4.0;
+        float row = floor(texel / float(LIGHT_INDEX_TEXTURE_WIDTH));
+        float column = texel - row * float(LIGHT_INDEX_TEXTURE_WIDTH);
+        vec4 indices = texture2D(
+            light_index_sampler,
+            vec2((column + 0.5) / float(LIGHT_INDEX_TEXTURE_WIDTH), (row + 0.5) / light_index_texture_height));
+
+        return dot(indices, vec4(equal(vec4(component), vec4(0.0, 1.0, 2.0, 3.0))));
+    }
+#else
+#if POINT_LIGHT_CAPACITY > 0
+    uniform bool point_light_enabled[POINT_LIGHT_CAPACITY];
+    uniform bool point_light_two_sided[POINT_LIGHT_CAPACITY];
+    uniform vec3 point_light_view_position[POINT_LIGHT_CAPACITY];
+    uniform vec3 point_light_ambient_color[POINT_LIGHT_CAPACITY];
+    uniform vec3 point_light_diffuse_color[POINT_LIGHT_CAPACITY];
+    uniform vec3 point_light_specular_color[POINT_LIGHT_CAPACITY];
+    uniform float point_light_intensity[POINT_LIGHT_CAPACITY];
+    uniform float point_light_constant_attenuation[POINT_LIGHT_CAPACITY];
+    uniform float point_light_linear_attenuation[POINT_LIGHT_CAPACITY];
+    uniform float point_light_quadratic_attenuation[POINT_LIGHT_CAPACITY];
+#endif
+
+#if SPOT_LIGHT_CAPACITY > 0
+    uniform bool spot_light_enabled[SPOT_LIGHT_CAPACITY];
+    uniform bool spot_light_two_sided[SPOT_LIGHT_CAPACITY];
+    uniform vec3 spot_light_view_position[SPOT_LIGHT_CAPACITY];
+    uniform vec3 spot_light_view_direction[SPOT_LIGHT_CAPACITY];
+    uniform vec3 spot_light_ambient_color[SPOT_LIGHT_CAPACITY];
+    uniform vec3 spot_light_diffuse_color[SPOT_LIGHT_CAPACITY];
+    uniform vec3 spot_light_specular_color[SPOT_LIGHT_CAPACITY];
+    uniform float spot_light_exponent[SPOT_LIGHT_CAPACITY];
+    uniform float spot_light_cutoff_angle_cosine[SPOT_LIGHT_CAPACITY];
+    uniform float spot_light_intensity[SPOT_LIGHT_CAPACITY];
+    uniform float spot_light_constant_attenuation[SPOT_LIGHT_CAPACITY];
+    uniform float spot_light_linear_attenuation[SPOT_LIGHT_CAPACITY];
+    uniform float spot_light_quadratic_attenuation[SPOT_LIGHT_CAPACITY];
+#ifdef SHADOWS
+    uniform int spot_light_shadow_map_begin[SPOT_LIGHT_CAPACITY];
+    uniform int spot_light_shadow_map_end[SPOT_LIGHT_CAPACITY];
+#endif
+#endif
+#endif
+
+#ifdef TEXTURE1
 uniform sampler2D texture1_sampler;
-uniform bool texture1_enabled;
-uniform int texturing_mode1;
+#endif
+#ifdef TEXTURE1_NORMALS
 uniform sampler2D texture1_normals_sampler;
-uniform bool texture1_normals_enabled;
+#endif
 
+#ifdef TEXTURE2
 uniform sampler2D texture2_sampler;
-uniform bool texture2_enabled;
-uniform int texturing_mode2;
+#endif
 
-uniform bool fog_enabled;
-uniform int fog_type;
-uniform int fog_depth;
+#ifdef FOG
 uniform vec3 fog_color;
 uniform float fog_far_minus_near_plane;
 uniform float fog_far_plane;
 uniform float fog_density;
+#endif
 
 varying vec4 fragment_view_position;
 varying vec3 fragment_view_direction;
@@ -117,18 +172,67 @@ varying vec4 fragment_color;
 varying vec2 fragment_texture1_coordinates;
 varying vec2 fragment_texture2_coordinates;
 
+#ifdef SHADOWS
+uniform sampler2D shadow_atlas_sampler;
+uniform vec2 shadow_atlas_texel_size;
+uniform mat4 shadow_map_texture_matrix[SHADOW_MAP_CAPACITY];
+uniform vec4 shadow_map_region[SHADOW_MAP_CAPACITY];
+uniform float shadow_map_far_depth[SHADOW_MAP_CAPACITY];
+uniform float shadow_map_bias[SHADOW_MAP_CAPACITY];
+
+float read_shadow_depth(vec2 coordinates)
+{
+    return dot(texture2D(shadow_atlas_sampler, coordinates), vec4(1.0, 1.0 / 255.0, 1.0 / 65025.0, 1.0 / 16581375.0));
+}
+
+// The maps of a light are its cascades from near to far, and the first one that reaches the fragment is used.
+// The packed depths can not be filtered, so the four texels around the fragment are compared and their results
+// are interpolated.
+float calculate_shadow(int begin, int end)
+{
+    float depth = -fragment_view_position.z;
+    for (int m = 0; m < SHADOW_MAP_CAPACITY; ++m) {
+        if (m >= end) {
+            break;
+        }
+        if (m >= begin && depth <= shadow_map_far_depth[m]) {
+            vec4 shadow_position = shadow_map_texture_matrix[m] * fragment_view_position;
+            shadow_position.xyz /= shadow_position.w;
+            vec4 region = shadow_map_region[m];
+            if (shadow_position.w <= 0.0 || shadow_position.z > 1.0 ||
+                any(lessThan(shadow_position.xy, region.xy)) || any(greaterThan(shadow_position.xy, region.zw))) {
+                return 1.0;
+            }
+
+            float reference_depth = shadow_position.z - shadow_map_bias[m];
+            vec2 texel = shadow_position.xy / shadow_atlas_texel_size - 0.5;
+            vec2 weights = fract(texel);
+            vec2 coordinates = (floor(texel) + 0.5) * shadow_atlas_texel_size;
+            float lit00 = step(reference_depth, read_shadow_depth(coordinates));
+            float lit10 = step(reference_depth, read_shadow_depth(coordinates + vec2(shadow_atlas_texel_size.x, 0.0)));
+            float lit01 = step(reference_depth, read_shadow_depth(coordinates + vec2(0.0, shadow_atlas_texel_size.y)));
+            float lit11 = step(reference_depth, read_shadow_depth(coordinates + shadow_atlas_texel_size));
+
+            return mix(mix(lit00, lit10, weights.x), mix(lit01, lit11, weights.x), weights.y);
+        }
+    }
+
+    return 1.0;
+}
+#endif
+
 void main()
 {
     vec3 view_direction = normalize(fragment_view_direction);
     vec3 view_normal;
 
-    if (texture1_normals_enabled) {
-        view_normal = texture2D(texture1_normals_sampler, fragment_texture1_coordinates).rgb;
-        view_normal = view_normal * 2.0 - 1.0;
-        view_normal = normalize(fragment_view_tangent_binormal_normal * view_normal);
-    } else {
-        view_normal = normalize(fragment_view_normal);
-    }
+#ifdef TEXTURE1_NORMALS
+    view_normal = texture2D(texture1_normals_sampler, fragment_texture1_coordinates).rgb;
+    view_normal = view_normal * 2.0 - 1.0;
+    view_normal = normalize(fragment_view_tangent_binormal_normal * view_normal);
+#else
+    view_normal = normalize(fragment_view_normal);
+#endif
 
     vec4 front_color = material_emission_color;
     front_color.rgb += material_ambient_color * ambient_light_color;
@@ -136,8 +240,11 @@ void main()
 
     vec4 back_color = front_color;
 
-#if DIRECTIONAL_LIGHT_COUNT > 0
-    for (int i = 0; i < DIRECTIONAL_LIGHT_COUNT; i++) {
+#if DIRECTIONAL_LIGHT_CAPACITY > 0
+    for (int i = 0; i < DIRECTIONAL_LIGHT_CAPACITY; i++) {
+        if (i >= directional_light_count) {
+            break;
+        }
         if (directional_light_enabled[i]) {
             float n_dot_l = max(dot(view_normal, directional_light_view_direction[i]), 0.0);
             vec3 diffuse_color = material_diffuse_color.rgb * directional_light_diffuse_color[i];
@@ -148,7 +255,12 @@ void main()
             vec3 specular_color = material_specular_color.rgb * directional_light_specular_color[i];
             vec3 specular_term = pow(n_dot_h, material_specular_exponent) * specular_color;
 
-            front_color.rgb += directional_light_intensity[i] * (directional_light_ambient_color[i] + diffuse_term + specular_term);
+#ifdef SHADOWS
+            float shadow = calculate_shadow(directional_light_shadow_map_begin[i], directional_light_shadow_map_end[i]);
+#else
+            float shadow = 1.0;
+#endif
+            front_color.rgb += directional_light_intensity[i] * (directional_light_ambient_color[i] + shadow * (diffuse_term + specular_term));
 
             if (directional_light_two_sided[i]) {
                 vec3 inverted_view_normal = -view_normal;
@@ -160,14 +272,89 @@ void main()
                 n_dot_h = clamp(dot(view_direction, reflection_vector), 0.0, 1.0);
                 specular_term = pow(n_dot_h, material_specular_exponent) * specular_color;
 
-                back_color.rgb += directional_light_intensity[i] * (directional_light_ambient_color[i] + diffuse_term + specular_term);
+                back_color.rgb += directional_light_intensity[i] * (directional_light_ambient_color[i] + shadow * (diffuse_term + specular_term));
             }
         }
     }
 #endif
 
-#if POINT_LIGHT_COUNT > 0
-    for (int i = 0; i < POINT_LIGHT_COUNT; i++) {
+#ifdef CLUSTERED_LIGHTING
+    vec4 cluster_clip_position = light_cluster_projection_matrix * fragment_view_position;
+    vec2 cluster_tile = floor((cluster_clip_position.xy / cluster_clip_position.w * 0.5 + 0.5) *
+                              vec2(LIGHT_CLUSTER_TILE_COUNT_X, LIGHT_CLUSTER_TILE_COUNT_Y));
+    cluster_tile = clamp(cluster_tile, vec2(0.0), vec2(LIGHT_CLUSTER_TILE_COUNT_X - 1, LIGHT_CLUSTER_TILE_COUNT_Y - 1));
+    float cluster_slice = floor(log(max(-fragment_view_position.z, 1.0e-4)) * light_cluster_depth_scale + light_cluster_depth_bias);
+    cluster_slice = clamp(cluster_slice, 0.0, float(LIGHT_CLUSTER_SLICE_COUNT - 1));
+    vec4 cluster = texture2D(
+        light_cluster_sampler,
+        vec2((cluster_tile.x + 0.5) / float(LIGHT_CLUSTER_TILE_COUNT_X),
+             (cluster_slice * float(LIGHT_CLUSTER_TILE_COUNT_Y) + cluster_tile.y + 0.5) /
+                 float(LIGHT_CLUSTER_TILE_COUNT_Y * LIGHT_CLUSTER_SLICE_COUNT)));
+    int cluster_light_count = int(cluster.y + 0.5);
+
+    for (int i = 0; i < MAX_LIGHTS_PER_CLUSTER; ++i) {
+        if (i >= cluster_light_count) {
+            break;
+        }
+
+        float light = read_light_index(cluster.x + float(i));
+        vec4 light_view_position = read_light_data(light, 0.0);
+        vec4 light_view_direction = read_light_data(light, 1.0);
+        vec4 light_ambient_color = read_light_data(light, 2.0);
+        vec4 light_diffuse_color = read_light_data(light, 3.0);
+        vec4 light_specular_color = read_light_data(light, 4.0);
+        vec4 light_attenuation = read_light_data(light, 5.0);
+
+        vec3 light_vector = light_view_position.xyz + fragment_view_direction;
+
+        float light_vector_length = length(light_vector);
+        light_vector /= light_vector_length;
+
+        float attenuation_factor =
+            (1.0 / (light_attenuation.x                       +
+                    light_attenuation.y * light_vector_length +
+                    light_attenuation.z * light_vector_length * light_vector_length));
+        attenuation_factor *= light_ambient_color.a;
+
+        if (light_view_position.w > 0.5) {
+            float spot_factor = 0.0;
+            float vertex_direction_dot_spot_direction = max(dot(-light_vector, light_view_direction.xyz), 0.0);
+            if (light_view_direction.w <= vertex_direction_dot_spot_direction) {
+                spot_factor = pow(vertex_direction_dot_spot_direction, light_diffuse_color.a);
+            }
+            attenuation_factor *= spot_factor;
+        }
+
+        float n_dot_l = max(dot(view_normal, light_vector), 0.0);
+        vec3 diffuse_color = material_diffuse_color.rgb * light_diffuse_color.rgb;
+        vec3 diffuse_term = n_dot_l * diffuse_color;
+
+        vec3 reflection_vector = reflect(-light_vector, view_normal);
+        float n_dot_h = clamp(dot(view_direction, reflection_vector), 0.0, 1.0);
+        vec3 specular_color = material_specular_color.rgb * light_specular_color.rgb;
+        vec3 specular_term = pow(n_dot_h, material_specular_exponent) * specular_color;
+
+        front_color.rgb += attenuation_factor * (light_ambient_color.rgb + diffuse_term + specular_term);
+
+        if (light_specular_color.a > 0.5) {
+            vec3 inverted_view_normal = -view_normal;
+
+            n_dot_l = max(dot(inverted_view_normal, light_vector), 0.0);
+            diffuse_term = n_dot_l * diffuse_color;
+
+            reflection_vector = reflect(-light_vector, inverted_view_normal);
+            n_dot_h = clamp(dot(view_direction, reflection_vector), 0.0, 1.0);
+            specular_term = pow(n_dot_h, material_specular_exponent) * specular_color;
+
+            back_color.rgb += attenuation_factor * (light_ambient_color.rgb + diffuse_term + specular_term);
+        }
+    }
+#else
+#if POINT_LIGHT_CAPACITY > 0
+    for (int i = 0; i < POINT_LIGHT_CAPACITY; i++) {
+        if (i >= point_light_count) {
+            break;
+        }
         if (point_light_enabled[i]) {
             vec3 point_light_vector = point_light_view_position[i] + fragment_view_direction;
 
@@ -208,8 +395,11 @@ void main()
     }
 #endif
 
-#if SPOT_LIGHT_COUNT > 0
-    for (int i = 0; i < SPOT_LIGHT_COUNT; ++i) {
+#if SPOT_LIGHT_CAPACITY > 0
+    for (int i = 0; i < SPOT_LIGHT_CAPACITY; ++i) {
+        if (i >= spot_light_count) {
+            break;
+        }
         if (spot_light_enabled[i]) {
             vec3 spot_light_vector = spot_light_view_position[i] - fragment_view_direction;
 
@@ -239,7 +429,12 @@ void main()
             }
             attenuation_factor *= spot_factor;
 
-            front_color.rgb += attenuation_factor * (spot_light_ambient_color[i] + diffuse_term + specular_term);
+#ifdef SHADOWS
+            float shadow = calculate_shadow(spot_light_shadow_map_begin[i], spot_light_shadow_map_end[i]);
+#else
+            float shadow = 1.0;
+#endif
+            front_color.rgb += attenuation_factor * (spot_light_ambient_color[i] + shadow * (diffuse_term + specular_term));
 
             if (spot_light_two_sided[i]) {
                 vec3 inverted_view_normal = -view_normal;
@@ -251,10 +446,11 @@ void main()
                 n_dot_h = clamp(dot(view_direction, reflection_vector), 0.0, 1.0);
                 specular_term = pow(n_dot_h, material_specular_exponent) * specular_color;
 
-                back_color.rgb += attenuation_factor * (spot_light_ambient_color[i] + diffuse_term + specular_term);
+                back_color.rgb += attenuation_factor * (spot_light_ambient_color[i] + shadow * (diffuse_term + specular_term));
             }
         }
     }
+#endif
 #endif
 
     gl_FragColor = fragment_color;
@@ -264,57 +460,57 @@ void main()
         gl_FragColor *= back_color;
     }
 
-    if (texture1_enabled) {
-        if (texturing_mode1 == TEXTURING_MODE_ADDITION) {
-            gl_FragColor += texture2D(texture1_sampler, fragment_texture1_coordinates);
-        } else if (texturing_mode1 == TEXTURING_MODE_MODULATION) {
-            gl_FragColor *= texture2D(texture1_sampler, fragment_texture1_coordinates);
-        } else if (texturing_mode1 == TEXTURING_MODE_DECALING) {
-            vec4 texel_color = texture2D(texture1_sampler, fragment_texture1_coordinates);
-            gl_FragColor.rgb = mix(gl_FragColor.rgb, texel_color.rgb, texel_color.a);
-        } else if (texturing_mode1 == TEXTURING_MODE_SUBTRACTION) {
-            gl_FragColor -= texture2D(texture1_sampler, fragment_texture1_coordinates);
-        } else if (texturing_mode1 == TEXTURING_MODE_REVERSE_SUBTRACTION) {
-            gl_FragColor = texture2D(texture1_sampler, fragment_texture1_coordinates) - gl_FragColor;
-        }
-    }
+#ifdef TEXTURE1
+#if TEXTURING_MODE1 == TEXTURING_MODE_ADDITION
+    gl_FragColor += texture2D(texture1_sampler, fragment_texture1_coordinates);
+#elif TEXTURING_MODE1 == TEXTURING_MODE_MODULATION
+    gl_FragColor *= texture2D(texture1_sampler, fragment_texture1_coordinates);
+#elif TEXTURING_MODE1 == TEXTURING_MODE_DECALING
+    vec4 texture1_color = texture2D(texture1_sampler, fragment_texture1_coordinates);
+    gl_FragColor.rgb = mix(gl_FragColor.rgb, texture1_color.rgb, texture1_color.a);
+#elif TEXTURING_MODE1 == TEXTURING_MODE_SUBTRACTION
+    gl_FragColor -= texture2D(texture1_sampler, fragment_texture1_coordinates);
+#elif TEXTURING_MODE1 == TEXTURING_MODE_REVERSE_SUBTRACTION
+    gl_FragColor = texture2D(texture1_sampler, fragment_texture1_coordinates) - gl_FragColor;
+#endif
+#endif
 
-    if (texture2_enabled) {
-        if (texturing_mode2 == TEXTURING_MODE_ADDITION) {
-            gl_FragColor += texture2D(texture2_sampler, fragment_texture2_coordinates);
-        } else if (texturing_mode2 == TEXTURING_MODE_MODULATION) {
-            gl_FragColor *= texture2D(texture2_sampler, fragment_texture2_coordinates);
-        } else if (texturing_mode2 == TEXTURING_MODE_DECALING) {
-            vec4 texel_color = texture2D(texture2_sampler, fragment_texture2_coordinates);
-            gl_FragColor.rgb = mix(gl_FragColor.rgb, texel_color.rgb, texel_color.a);
-        } else if (texturing_mode2 == TEXTURING_MODE_SUBTRACTION) {
-            gl_FragColor -= texture2D(texture2_sampler, fragment_texture2_coordinates);
-        } else if (texturing_mode2 == TEXTURING_MODE_REVERSE_SUBTRACTION) {
-            gl_FragColor = texture2D(texture2_sampler, fragment_texture2_coordinates) - gl_FragColor;
-        }
-    }
+#ifdef TEXTURE2
+#if TEXTURING_MODE2 == TEXTURING_MODE_ADDITION
+    gl_FragColor += texture2D(texture2_sampler, fragment_texture2_coordinates);
+#elif TEXTURING_MODE2 == TEXTURING_MODE_MODULATION
+    gl_FragColor *= texture2D(texture2_sampler, fragment_texture2_coordinates);
+#elif TEXTURING_MODE2 == TEXTURING_MODE_DECALING
+    vec4 texture2_color = texture2D(texture2_sampler, fragment_texture2_coordinates);
+    gl_FragColor.rgb = mix(gl_FragColor.rgb, texture2_color.rgb, texture2_color.a);
+#elif TEXTURING_MODE2 == TEXTURING_MODE_SUBTRACTION
+    gl_FragColor -= texture2D(texture2_sampler, fragment_texture2_coordinates);
+#elif TEXTURING_MODE2 == TEXTURING_MODE_REVERSE_SUBTRACTION
+    gl_FragColor = texture2D(texture2_sampler, fragment_texture2_coordinates) - gl_FragColor;
+#endif
+#endif
 
-    if (fog_enabled) {
-        float fragment_depth;
-        if (fog_depth == FOG_DEPTH_PLANAR) {
-            fragment_depth = -(fragment_view_position.z / fragment_view_position.w);
-        } else if (fog_depth == FOG_DEPTH_PLANAR_ABSOLUTE) {
-            fragment_depth = abs(fragment_view_position.z / fragment_view_position.w);
-        } else if (fog_depth == FOG_DEPTH_RADIAL) {
-            fragment_depth = length(fragment_view_position.xyz / fragment_view_position.w);
-        }
+#ifdef FOG
+    float fragment_depth;
+#if FOG_DEPTH == FOG_DEPTH_PLANAR
+    fragment_depth = -(fragment_view_position.z / fragment_view_position.w);
+#elif FOG_DEPTH == FOG_DEPTH_PLANAR_ABSOLUTE
+    fragment_depth = abs(fragment_view_position.z / fragment_view_position.w);
+#elif FOG_DEPTH == FOG_DEPTH_RADIAL
+    fragment_depth = length(fragment_view_position.xyz / fragment_view_position.w);
+#endif
 
-        float fragment_fog_factor;
-        if (fog_type == FOG_TYPE_LINEAR) {
-            fragment_fog_factor = (fog_far_plane - fragment_depth) / fog_far_minus_near_plane;
-        } else if (fog_type == FOG_TYPE_EXP) {
-            fragment_fog_factor = exp(-1.0 * (fragment_depth * fog_density));
-        } else if (fog_type == FOG_TYPE_EXP2) {
-            fragment_fog_factor = fragment_depth * fog_density;
-            fragment_fog_factor = exp(-(fragment_fog_factor * fragment_fog_factor));
-        }
-        fragment_fog_factor = clamp(fragment_fog_factor, 0.0, 1.0);
+    float fragment_fog_factor;
+#if FOG_TYPE == FOG_TYPE_LINEAR
+    fragment_fog_factor = (fog_far_plane - fragment_depth) / fog_far_minus_near_plane;
+#elif FOG_TYPE == FOG_TYPE_EXP
+    fragment_fog_factor = exp(-1.0 * (fragment_depth * fog_density));
+#elif FOG_TYPE == FOG_TYPE_EXP2
+    fragment_fog_factor = fragment_depth * fog_density;
+    fragment_fog_factor = exp(-(fragment_fog_factor * fragment_fog_factor));
+#endif
+    fragment_fog_factor = clamp(fragment_fog_factor, 0.0, 1.0);
 
-        gl_FragColor.rgb = mix(fog_color, gl_FragColor.rgb, fragment_fog_factor);
-    }
+    gl_FragColor.rgb = mix(fog_color, gl_FragColor.rgb, fragment_fog_factor);
+#endif
 }
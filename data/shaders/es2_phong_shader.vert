@@ -11,14 +11,26 @@ uniform mat4 projection_matrix;
 uniform mat3 normal_matrix;
 uniform float point_size;
 
-uniform bool texture1_enabled;
-uniform bool texture1_transformation_enabled;
+#ifdef INSTANCING
+#ifdef INSTANCE_BATCH_SIZE
+attribute float instance_index;
+uniform mat4 instance_model_matrices[INSTANCE_BATCH_SIZE];
+uniform vec4 instance_colors[INSTANCE_BATCH_SIZE];
+uniform vec4 instance_texture_regions[INSTANCE_BATCH_SIZE];
+#else
+attribute mat4 instance_model_matrix;
+attribute vec4 instance_color;
+attribute vec4 instance_texture_region;
+#endif
+#endif
+
+#ifdef TEXTURE1_TRANSFORMATION
 uniform mat4 texture1_transformation_matrix;
-uniform bool texture1_normals_enabled;
+#endif
 
-uniform bool texture2_enabled;
-uniform bool texture2_transformation_enabled;
+#ifdef TEXTURE2_TRANSFORMATION
 uniform mat4 texture2_transformation_matrix;
+#endif
 
 varying vec4 fragment_view_position;
 varying vec3 fragment_view_direction;
@@ -28,36 +40,60 @@ varying vec2 fragment_texture2_coordinates;
 varying vec3 fragment_view_normal;
 varying mat3 fragment_view_tangent_binormal_normal;
 
+// The depth pre-pass computes the same position, so the shading pass can test for equal depth.
+#if defined(GL_ES) || __VERSION__ >= 120
+invariant gl_Position;
+#endif
+
 void main()
 {
-    vec4 view_position = model_view_matrix * position;
+#ifdef INSTANCING
+#ifdef INSTANCE_BATCH_SIZE
+    int instance = int(instance_index);
+    mat4 instance_model_matrix = instance_model_matrices[instance];
+    vec4 instance_color = instance_colors[instance];
+    vec4 instance_texture_region = instance_texture_regions[instance];
+#endif
+    mat4 instance_model_view_matrix = model_view_matrix * instance_model_matrix;
+    mat3 instance_normal_matrix =
+        normal_matrix * mat3(instance_model_matrix[0].xyz, instance_model_matrix[1].xyz, instance_model_matrix[2].xyz);
+#else
+    mat4 instance_model_view_matrix = model_view_matrix;
+    mat3 instance_normal_matrix = normal_matrix;
+    vec4 instance_color = vec4(1.0);
+#endif
+
+    vec4 view_position = instance_model_view_matrix * position;
     fragment_view_position = view_position;
     fragment_view_direction = -view_position.xyz;
-    fragment_view_normal = normalize(normal_matrix * normal);
+    fragment_view_normal = normalize(instance_normal_matrix * normal);
     fragment_view_tangent_binormal_normal =
         mat3(
-            normalize(normal_matrix * tangent),
-            normalize(normal_matrix * binormal),
+            normalize(instance_normal_matrix * tangent),
+            normalize(instance_normal_matrix * binormal),
             fragment_view_normal
         );
 
-    fragment_color = color;
-    if (texture1_enabled) {
-        if (texture1_transformation_enabled) {
-            vec4 transformed_texture1_coordinates = texture1_transformation_matrix * vec4(texture1_coordinates.st, 0.0, 1.0);
-            fragment_texture1_coordinates = vec2(transformed_texture1_coordinates);
-        } else {
-            fragment_texture1_coordinates = vec2(texture1_coordinates);
-        }
-    }
-    if (texture2_enabled) {
-        if (texture2_transformation_enabled) {
-            vec4 transformed_texture2_coordinates = texture2_transformation_matrix * vec4(texture2_coordinates.st, 0.0, 1.0);
-            fragment_texture2_coordinates = vec2(transformed_texture2_coordinates);
-        } else {
-            fragment_texture2_coordinates = vec2(texture2_coordinates);
-        }
-    }
+    fragment_color = color * instance_color;
+#if defined(TEXTURE1) || defined(TEXTURE1_NORMALS)
+#ifdef TEXTURE1_TRANSFORMATION
+    vec4 transformed_texture1_coordinates = texture1_transformation_matrix * vec4(texture1_coordinates.st, 0.0, 1.0);
+    fragment_texture1_coordinates = vec2(transformed_texture1_coordinates);
+#else
+    fragment_texture1_coordinates = vec2(texture1_coordinates);
+#endif
+#ifdef INSTANCING
+    fragment_texture1_coordinates = instance_texture_region.xy + fragment_texture1_coordinates * instance_texture_region.zw;
+#endif
+#endif
+#ifdef TEXTURE2
+#ifdef TEXTURE2_TRANSFORMATION
+    vec4 transformed_texture2_coordinates = texture2_transformation_matrix * vec4(texture2_coordinates.st, 0.0, 1.0);
+    fragment_texture2_coordinates = vec2(transformed_texture2_coordinates);
+#else
+    fragment_texture2_coordinates = vec2(texture2_coordinates);
+#endif
+#endif
 
     gl_Position = projection_matrix * view_position;
     gl_PointSize = point_size;
@@ -0,0 +1,8 @@
+// The identifier of the draw is spread over the four channels as bytes, which an unsigned byte target stores
+// exactly.
+uniform vec4 identifier;
+
+void main()
+{
+    gl_FragColor = identifier;
+}
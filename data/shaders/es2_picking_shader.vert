@@ -0,0 +1,10 @@
+attribute vec4 position;
+
+uniform mat4 model_view_projection_matrix;
+uniform float point_size;
+
+void main()
+{
+    gl_PointSize = point_size;
+    gl_Position = model_view_projection_matrix * position;
+}
@@ -0,0 +1,14 @@
+// ES2 can not sample depth textures, so the depth is spread over the four channels of the color attachment.
+// A depth of one would wrap around to zero and is kept just below it.
+vec4 pack_depth(float depth)
+{
+    vec4 packed_depth = fract(min(depth, 0.999999) * vec4(1.0, 255.0, 65025.0, 16581375.0));
+    packed_depth -= packed_depth.yzww * vec4(1.0 / 255.0, 1.0 / 255.0, 1.0 / 255.0, 0.0);
+
+    return packed_depth;
+}
+
+void main()
+{
+    gl_FragColor = pack_depth(gl_FragCoord.z);
+}
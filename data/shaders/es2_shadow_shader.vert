@@ -0,0 +1,8 @@
+attribute vec4 position;
+
+uniform mat4 model_view_projection_matrix;
+
+void main()
+{
+    gl_Position = model_view_projection_matrix * position;
+}
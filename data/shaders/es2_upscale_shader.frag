@@ -0,0 +1,10 @@
+#version 120
+
+uniform sampler2D source_sampler;
+
+varying vec2 fragment_texture_coordinates;
+
+void main()
+{
+    gl_FragColor = texture2D(source_sampler, fragment_texture_coordinates);
+}
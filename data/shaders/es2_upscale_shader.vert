@@ -0,0 +1,13 @@
+#version 120
+
+attribute vec4 position;
+
+uniform vec2 texture_coordinates_scale;
+
+varying vec2 fragment_texture_coordinates;
+
+void main()
+{
+    fragment_texture_coordinates = (position.xy * 0.5 + 0.5) * texture_coordinates_scale;
+    gl_Position = vec4(position.xy, 0.0, 1.0);
+}
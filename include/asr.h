@@ -3,6 +3,12 @@
 
 #include "objects/object.h"
 #include "objects/mesh.h"
+#include "objects/instanced_mesh.h"
+#include "objects/es2_instanced_mesh.h"
+#include "objects/lod_mesh.h"
+#include "objects/particle_system.h"
+#include "objects/primitive_batch.h"
+#include "objects/es2_primitive_batch.h"
 #include "objects/camera.h"
 #include "lights/light.h"
 #include "lights/ambient_light.h"
@@ -10,28 +16,75 @@
 #include "lights/point_light.h"
 #include "lights/spot_light.h"
 #include "geometries/vertex.h"
+#include "geometries/vertex_layout.h"
+#include "geometries/mesh_data.h"
 #include "geometries/geometry.h"
 #include "geometries/es2_geometry.h"
 #include "geometries/geometry_generators.h"
+#include "geometries/geometry_processing.h"
+#include "geometries/geometry_listener.h"
+#include "geometries/triangle_bvh.h"
+#include "textures/compressed_texture_data.h"
 #include "textures/texture.h"
 #include "textures/es2_texture.h"
+#include "textures/atlas_texture.h"
+#include "textures/texture_atlas.h"
+#include "textures/texture_loader.h"
+#include "textures/texture_cache.h"
 #include "materials/material.h"
 #include "materials/constant_material.h"
 #include "materials/es2_constant_material.h"
 #include "materials/phong_material.h"
 #include "materials/es2_phong_material.h"
+#include "scene/bounding_volume_hierarchy.h"
+#include "scene/transform_hierarchy.h"
+#include "scene/animation_clip.h"
+#include "scene/animation_system.h"
 #include "scene/scene.h"
+#include "scene/scene_snapshot.h"
+#include "scene/static_batcher.h"
 #include "window/window.h"
 #include "window/es2_sdl_window.h"
+#ifdef ASR_HEADLESS
+#include "window/es2_headless_window.h"
+#endif
+#include "renderer/render_stats.h"
 #include "renderer/shader.h"
+#include "renderer/es2_state_cache.h"
 #include "renderer/es2_shader.h"
+#include "renderer/es2_shader_cache.h"
+#include "renderer/light_arrays.h"
+#include "renderer/light_selection.h"
+#include "renderer/light_clusters.h"
+#include "renderer/es2_light_clusters.h"
+#include "renderer/es2_depth_pre_pass.h"
+#include "renderer/es2_occlusion_culling.h"
+#include "renderer/render_target.h"
+#include "renderer/es2_render_target.h"
+#include "renderer/es2_pixel_reader.h"
+#include "renderer/es2_upscale_pass.h"
+#include "renderer/shadow_map_arrays.h"
+#include "renderer/shadow_maps.h"
+#include "renderer/es2_shadow_pass.h"
+#include "renderer/pick_result.h"
+#include "renderer/es2_picking_pass.h"
+#include "renderer/frame_constants.h"
+#include "renderer/render_command_buffer.h"
 #include "renderer/renderer.h"
 #include "renderer/es2_renderer.h"
 #include "math/ray.h"
 #include "math/plane.h"
 #include "math/aabb.h"
+#include "math/frustum.h"
 #include "math/sphere.h"
 #include "utilities/utilities.h"
+#include "utilities/job_system.h"
+#include "utilities/frame_arena.h"
+#include "utilities/node_pool.h"
+#include "utilities/radix_sort.h"
+#include "utilities/mapped_file.h"
+#include "utilities/allocation_counter.h"
+#include "utilities/profiler.h"
 
 #include <imgui.h>
 
@@ -2,21 +2,36 @@
 #define ES2_GEOMETRY_HPP
 
 #include "geometries/geometry.h"
+#include "renderer/es2_state_cache.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 
 #include <string>
+#include <memory>
+#include <utility>
 #include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
 
 namespace asr
 {
     class ES2Geometry final : public Geometry
     {
     public:
-        explicit ES2Geometry(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices)
-            : Geometry(indices, vertices) {}
+        // Pass the vectors with std::move to hand them over without a copy.
+        ES2Geometry(std::vector<unsigned int> indices, std::vector<Vertex> vertices)
+            : Geometry(std::move(indices), std::move(vertices)) {}
+
+        ES2Geometry(std::vector<unsigned int> indices, std::vector<Vertex> vertices, const VertexLayout &vertex_layout)
+            : Geometry(std::move(indices), std::move(vertices), vertex_layout) {}
+
+        explicit ES2Geometry(std::shared_ptr<const MeshData> mesh_data)
+            : Geometry(std::move(mesh_data)) {}
 
         ES2Geometry(const ES2Geometry &other) = delete;
         ES2Geometry &operator=(const ES2Geometry &other) = delete;
@@ -25,6 +40,7 @@ namespace asr
         {
             if (_vertex_array_object != 0)
             {
+                ES2StateCache::get_instance().forget_vertex_array(_vertex_array_object);
 #ifdef __APPLE__
                 glDeleteVertexArraysAPPLE(1, &_vertex_array_object);
 #else
@@ -43,170 +59,239 @@ namespace asr
             }
         }
 
-        void update(const Material &material) final
+        void update(const Material & /* material */) final
         {
-            if (!(_requires_indices_update || _requires_vertices_update))
+            bool requires_vertex_array_update = _vertex_array_object == 0 || _requires_vertex_layout_update;
+            if (!(_requires_indices_update || _requires_vertices_update || requires_vertex_array_update))
             {
                 return;
             }
 
-#ifdef __APPLE__
-            glBindVertexArrayAPPLE(0);
-#else
-            glBindVertexArray(0);
-#endif
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            auto &state_cache = ES2StateCache::get_instance();
+            state_cache.bind_vertex_array(0);
 
-            if (_vertex_array_object != 0)
+            if (_requires_indices_update)
             {
-#ifdef __APPLE__
-                glDeleteVertexArraysAPPLE(1, &_vertex_array_object);
-#else
-                glDeleteVertexArrays(1, &_vertex_array_object);
-#endif
+                _update_index_buffer();
             }
-            if (_index_buffer_object != 0)
+            if (_requires_vertices_update)
             {
-                glDeleteBuffers(1, &_index_buffer_object);
+                _update_vertex_buffer();
             }
-            if (_vertex_buffer_object != 0)
+            if (requires_vertex_array_update)
             {
-                glDeleteBuffers(1, &_vertex_buffer_object);
+                _update_vertex_array();
+                _requires_vertex_layout_update = false;
             }
 
-            const auto *index_data = reinterpret_cast<const unsigned int *>(_indices.data());
-            const size_t index_data_size{_indices.size() * sizeof(unsigned int)};
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+
+        void use() final
+        {
+            if (_vertex_array_object != 0)
+            {
+                ES2StateCache::get_instance().bind_vertex_array(_vertex_array_object);
+                if (!_vertex_layout.has(VertexLayout::Color))
+                {
+                    glVertexAttrib4f(static_cast<GLuint>(VertexLayout::Color), 1.0f, 1.0f, 1.0f, 1.0f);
+                }
+            }
+        }
 
-            GLuint index_buffer_object{0};
-            glGenBuffers(1, &index_buffer_object);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_object);
-            glBufferData(
-                GL_ELEMENT_ARRAY_BUFFER,
-                static_cast<GLsizeiptr>(index_data_size), index_data,
-                _convert_usage_strategy_to_es2_buffer_usage_strategy(_indices_usage_strategy));
-            _index_buffer_object = index_buffer_object;
+    private:
+        GLuint _vertex_array_object{0};
+        GLuint _index_buffer_object{0};
+        GLuint _vertex_buffer_object{0};
 
-            _requires_indices_update = false;
+        std::vector<uint16_t> _short_indices;
 
-            const auto *vertex_data = reinterpret_cast<const float *>(_vertices.data());
-            const size_t vertex_data_size{_vertices.size() * sizeof(Vertex)};
+        size_t _index_buffer_capacity{0};
+        size_t _vertex_buffer_capacity{0};
+        GLenum _index_buffer_usage{GL_NONE};
+        GLenum _vertex_buffer_usage{GL_NONE};
 
-            GLuint vertex_buffer_object{0};
-            glGenBuffers(1, &vertex_buffer_object);
-            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object);
-            glBufferData(
-                GL_ARRAY_BUFFER,
-                static_cast<GLsizeiptr>(vertex_data_size), vertex_data,
-                _convert_usage_strategy_to_es2_buffer_usage_strategy(_vertices_usage_strategy));
-            _vertex_buffer_object = vertex_buffer_object;
+        void _update_index_buffer()
+        {
+            const auto *indices = _mesh_data ? _mesh_data->get_index_data() : _indices.data();
+            const size_t index_count{get_index_count()};
+            const void *index_data = indices;
+            _index_size = sizeof(unsigned int);
+            if (!_mesh_data && get_vertex_count() <= std::numeric_limits<uint16_t>::max() + static_cast<size_t>(1))
+            {
+                // Not every ES2 device supports 32-bit indices, and the short ones take half the memory. The
+                // conversion buffer keeps its capacity, so indices that are uploaded again every frame do not
+                // allocate. Mapped indices go to the driver as they are stored, without a copy.
+                _short_indices.assign(indices, indices + index_count);
+                index_data = _short_indices.data();
+                _index_size = sizeof(uint16_t);
+            }
 
-            _requires_vertices_update = false;
+            const size_t index_data_size{index_count * _index_size};
+            GLenum usage = _convert_usage_strategy_to_es2_buffer_usage_strategy(_indices_usage_strategy);
 
-            GLuint vertex_array_object{0};
-#ifdef __APPLE__
-            glGenVertexArraysAPPLE(1, &vertex_array_object);
-            glBindVertexArrayAPPLE(vertex_array_object);
-#else
-            glGenVertexArrays(1, &vertex_array_object);
-            glBindVertexArray(vertex_array_object);
-#endif
-            glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer_object);
+            if (_index_buffer_object == 0)
+            {
+                glGenBuffers(1, &_index_buffer_object);
+            }
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer_object);
 
-            auto &attributes = material.get_shader()->get_attributes();
+            if (index_data_size > _index_buffer_capacity || _index_buffer_usage != usage)
+            {
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(index_data_size), index_data, usage);
+                _index_buffer_capacity = index_data_size;
+                _index_buffer_usage = usage;
+            }
+            else
+            {
+                if (_indices_usage_strategy == StreamStrategy)
+                {
+                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(_index_buffer_capacity), nullptr, usage);
+                }
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(index_data_size), index_data);
+            }
+            ES2StateCache::get_instance().get_stats().uploaded_buffer_bytes += index_data_size;
+            if (_indices_usage_strategy == StaticStrategy)
+            {
+                std::vector<uint16_t>().swap(_short_indices);
+            }
+
+            _requires_indices_update = false;
+        }
 
-            GLsizei stride = sizeof(GLfloat) * 25;
+        void _update_vertex_buffer()
+        {
+            const size_t stride{_vertex_layout.get_stride()};
+            const size_t vertex_count{get_vertex_count()};
+            const size_t vertex_data_size{vertex_count * stride};
+            GLenum usage = _convert_usage_strategy_to_es2_buffer_usage_strategy(_vertices_usage_strategy);
 
-            int position_attribute_location{attributes.count("position") > 0 ? attributes.at("position") : -1};
-            if (position_attribute_location != -1)
+            if (_vertex_buffer_object == 0)
             {
-                glEnableVertexAttribArray(static_cast<GLuint>(position_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(position_attribute_location),
-                    3, GL_FLOAT, GL_FALSE, stride, static_cast<const GLvoid *>(nullptr));
+                glGenBuffers(1, &_vertex_buffer_object);
             }
+            glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer_object);
 
-            int color_attribute_location{attributes.count("color") > 0 ? attributes.at("color") : -1};
-            if (color_attribute_location != -1)
+            if (_mesh_data)
             {
-                glEnableVertexAttribArray(static_cast<GLuint>(color_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(color_attribute_location),
-                    4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 3));
+                // The vertices are packed already, so the mapped pages go to the driver without a copy.
+                glBufferData(
+                    GL_ARRAY_BUFFER,
+                    static_cast<GLsizeiptr>(_mesh_data->get_vertex_data_size()),
+                    _mesh_data->get_vertex_data(),
+                    usage);
+                _vertex_buffer_capacity = _mesh_data->get_vertex_data_size();
+                _vertex_buffer_usage = usage;
+                ES2StateCache::get_instance().get_stats().uploaded_buffer_bytes += _mesh_data->get_vertex_data_size();
+
+                set_requires_vertices_update(false);
+                return;
             }
 
-            int normal_attribute_location{attributes.count("normal") > 0 ? attributes.at("normal") : -1};
-            if (normal_attribute_location != -1)
+            bool requires_reallocation = vertex_data_size > _vertex_buffer_capacity || _vertex_buffer_usage != usage;
+            size_t range_begin = std::min(_vertices_update_range_begin, vertex_count);
+            size_t range_end = std::min(_vertices_update_range_end, vertex_count);
+            if (requires_reallocation || _vertices_usage_strategy == StreamStrategy)
             {
-                glEnableVertexAttribArray(static_cast<GLuint>(normal_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(normal_attribute_location),
-                    3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 7));
+                range_begin = 0;
+                range_end = vertex_count;
             }
+            const uint8_t *vertex_data = _begin_vertices_upload(range_begin, range_end);
 
-            int tangent_attribute_location{attributes.count("tangent") > 0 ? attributes.at("tangent") : -1};
-            if (tangent_attribute_location != -1)
+            if (requires_reallocation && _vertices_usage_strategy == StreamStrategy && _vertex_buffer_usage == usage)
             {
-                glEnableVertexAttribArray(static_cast<GLuint>(tangent_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(tangent_attribute_location),
-                    4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 10));
+                // Streamed vertices that grow, like a batch filling up over its first frames, double the buffer,
+                // so that it is reallocated a few times instead of every frame the count rises.
+                _vertex_buffer_capacity = std::max(vertex_data_size, _vertex_buffer_capacity * 2);
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_vertex_buffer_capacity), nullptr, usage);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(vertex_data_size), vertex_data);
             }
-
-            int binormal_attribute_location{attributes.count("binormal") > 0 ? attributes.at("binormal") : -1};
-            if (binormal_attribute_location != -1)
+            else if (requires_reallocation)
             {
-                glEnableVertexAttribArray(static_cast<GLuint>(binormal_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(binormal_attribute_location),
-                    3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 14));
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertex_data_size), vertex_data, usage);
+                _vertex_buffer_capacity = vertex_data_size;
+                _vertex_buffer_usage = usage;
             }
-
-            int texture1_coordinates_attribute_location{attributes.count("texture1_coordinates") > 0 ? attributes.at("texture1_coordinates") : -1};
-            if (texture1_coordinates_attribute_location != -1)
+            else if (_vertices_usage_strategy == StreamStrategy)
             {
-                glEnableVertexAttribArray(static_cast<GLuint>(texture1_coordinates_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(texture1_coordinates_attribute_location),
-                    4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 17));
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_vertex_buffer_capacity), nullptr, usage);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(vertex_data_size), vertex_data);
             }
-
-            int texture2_coordinates_attribute_location{attributes.count("texture2_coordinates") > 0 ? attributes.at("texture2_coordinates") : -1};
-            if (texture2_coordinates_attribute_location != -1)
+            else if (range_begin < range_end)
             {
-                glEnableVertexAttribArray(static_cast<GLuint>(texture2_coordinates_attribute_location));
-                glVertexAttribPointer(
-                    static_cast<GLuint>(texture2_coordinates_attribute_location),
-                    4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid *>(sizeof(GLfloat) * 21));
+                glBufferSubData(
+                    GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(range_begin * stride),
+                    static_cast<GLsizeiptr>((range_end - range_begin) * stride),
+                    vertex_data);
             }
-#ifdef __APPLE__
-            glBindVertexArrayAPPLE(0);
-#else
-            glBindVertexArray(0);
-#endif
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            ES2StateCache::get_instance().get_stats().uploaded_buffer_bytes += (range_end - range_begin) * stride;
 
-            _vertex_array_object = vertex_array_object;
+            _end_vertices_upload();
         }
 
-        void use() final
+        void _update_vertex_array()
         {
-            if (_vertex_array_object != 0)
+            auto &state_cache = ES2StateCache::get_instance();
+
+            if (_vertex_array_object == 0)
             {
 #ifdef __APPLE__
-                glBindVertexArrayAPPLE(_vertex_array_object);
+                glGenVertexArraysAPPLE(1, &_vertex_array_object);
 #else
-                glBindVertexArray(_vertex_array_object);
+                glGenVertexArrays(1, &_vertex_array_object);
 #endif
             }
+            state_cache.bind_vertex_array(_vertex_array_object);
+
+            glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer_object);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer_object);
+
+            auto stride = static_cast<GLsizei>(_vertex_layout.get_stride());
+            for (unsigned int attribute = 0; attribute < VertexLayout::AttributeCount; ++attribute)
+            {
+                if (!_vertex_layout.has(static_cast<VertexLayout::Attribute>(attribute)))
+                {
+                    glDisableVertexAttribArray(static_cast<GLuint>(attribute));
+                }
+            }
+            for (const auto &element : _vertex_layout.get_elements())
+            {
+                auto location = static_cast<GLuint>(element.attribute);
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(
+                    location,
+                    static_cast<GLint>(element.component_count),
+                    _convert_component_type_to_es2_type(element.component_type),
+                    element.component_type == VertexLayout::NormalizedUnsignedByte ||
+                            element.component_type == VertexLayout::NormalizedByte
+                        ? GL_TRUE
+                        : GL_FALSE,
+                    stride,
+                    reinterpret_cast<const GLvoid *>(element.offset));
+            }
+
+            state_cache.bind_vertex_array(0);
         }
 
-    private:
-        GLuint _vertex_array_object{0};
-        GLuint _index_buffer_object{0};
-        GLuint _vertex_buffer_object{0};
+
+        static GLenum _convert_component_type_to_es2_type(VertexLayout::ComponentType component_type)
+        {
+            switch (component_type)
+            {
+            case VertexLayout::Float:
+                return GL_FLOAT;
+            case VertexLayout::HalfFloat:
+                return GL_HALF_FLOAT;
+            case VertexLayout::NormalizedUnsignedByte:
+                return GL_UNSIGNED_BYTE;
+            case VertexLayout::NormalizedByte:
+                return GL_BYTE;
+            }
+
+            return GL_FLOAT;
+        }
 
         static GLenum _convert_usage_strategy_to_es2_buffer_usage_strategy(Geometry::UsageStrategy usage_strategy)
         {
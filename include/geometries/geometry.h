@@ -3,9 +3,20 @@
 
 #include "materials/material.h"
 #include "geometries/vertex.h"
+#include "geometries/vertex_layout.h"
+#include "geometries/mesh_data.h"
+#include "geometries/geometry_processing.h"
+#include "geometries/geometry_listener.h"
+#include "geometries/triangle_bvh.h"
+#include "math/aabb.h"
 
 #include <vector>
+#include <memory>
+#include <string>
 #include <utility>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
 
 #include <glm/glm.hpp>
 
@@ -25,6 +36,10 @@ namespace asr
             TriangleStrip
         };
 
+        static_assert(static_cast<unsigned int>(Triangles) == geometry_processing::TriangleIndices::List &&
+                      static_cast<unsigned int>(TriangleStrip) == geometry_processing::TriangleIndices::Strip &&
+                      static_cast<unsigned int>(TriangleFan) == geometry_processing::TriangleIndices::Fan);
+
         enum UsageStrategy
         {
             StaticStrategy,
@@ -32,13 +47,49 @@ namespace asr
             StreamStrategy
         };
 
-        explicit Geometry(std::vector<unsigned int> indices, std::vector<Vertex> vertices)
-            : _indices(std::move(indices)), _vertices(std::move(vertices))
+        explicit Geometry(std::vector<unsigned int> indices, std::vector<Vertex> vertices,
+                          VertexLayout vertex_layout = VertexLayout::create_default())
+            : _indices(std::move(indices)), _vertices(std::move(vertices)), _vertex_layout(std::move(vertex_layout))
+        {
+        }
+
+        // Uploads the blobs of the mesh data as they are. The index and vertex vectors stay empty, so the
+        // geometry can not be transformed or batched with others on the CPU side.
+        explicit Geometry(std::shared_ptr<const MeshData> mesh_data)
+            : _type{static_cast<Type>(mesh_data->get_type())},
+              _vertex_layout(mesh_data->get_vertex_layout()),
+              _mesh_data{std::move(mesh_data)}
         {
         }
 
         virtual ~Geometry() = default;
 
+        // Listeners, like the meshes that draw the geometry, are told when an edit of the vertices changes the
+        // bounds, so that the culling structures refit them. A listener has to be removed before it is destroyed.
+        void add_listener(GeometryListener &listener)
+        {
+            listener._geometry_listener_index = _listeners.size();
+            _listeners.push_back(&listener);
+        }
+
+        void remove_listener(GeometryListener &listener)
+        {
+            size_t index = listener._geometry_listener_index;
+            if (index >= _listeners.size() || _listeners[index] != &listener)
+            {
+                return;
+            }
+
+            _listeners[index] = _listeners.back();
+            _listeners[index]->_geometry_listener_index = index;
+            _listeners.pop_back();
+        }
+
+        [[nodiscard]] unsigned int get_id() const
+        {
+            return _id;
+        }
+
         [[nodiscard]] Type get_type() const
         {
             return _type;
@@ -47,6 +98,67 @@ namespace asr
         void set_type(Type type)
         {
             _type = type;
+            _triangle_bvh_requires_update = true;
+        }
+
+        [[nodiscard]] const std::shared_ptr<const MeshData> &get_mesh_data() const
+        {
+            return _mesh_data;
+        }
+
+        [[nodiscard]] size_t get_index_count() const
+        {
+            return _mesh_data ? _mesh_data->get_index_count() : _indices.size();
+        }
+
+        // The bytes per index in the uploaded index buffer. Backends store the indices in 16 bits when every
+        // vertex can be addressed that way.
+        [[nodiscard]] size_t get_index_size() const
+        {
+            return _index_size;
+        }
+
+        [[nodiscard]] size_t get_vertex_count() const
+        {
+            if (_mesh_data)
+            {
+                return _mesh_data->get_vertex_count();
+            }
+
+            return _vertices_packed ? _packed_vertex_count : _vertices.size();
+        }
+
+        // Stores the indices and the vertices packed with the vertex layout, which is how
+        // Geometry(mesh_data) reads them back.
+        bool write_mesh_file(const std::string &path)
+        {
+            const AABB &bounding_box = get_bounding_box();
+            if (_mesh_data)
+            {
+                return MeshData::write_mesh_file(
+                    path, static_cast<unsigned int>(_type), _vertex_layout,
+                    bounding_box.get_minimum(), bounding_box.get_maximum(),
+                    _mesh_data->get_index_data(), _mesh_data->get_index_count(),
+                    _mesh_data->get_vertex_data(), _mesh_data->get_vertex_count());
+            }
+
+            if (_vertices_packed)
+            {
+                return MeshData::write_mesh_file(
+                    path, static_cast<unsigned int>(_type), _vertex_layout,
+                    bounding_box.get_minimum(), bounding_box.get_maximum(),
+                    _indices.data(), _indices.size(),
+                    _packed_vertices.data(), _packed_vertex_count);
+            }
+
+            std::vector<uint8_t> packed_vertices(_vertices.size() * _vertex_layout.get_stride());
+            _vertex_layout.pack(_vertices, 0, _vertices.size(), packed_vertices.data());
+
+            return MeshData::write_mesh_file(
+                path, static_cast<unsigned int>(_type), _vertex_layout,
+                bounding_box.get_minimum(), bounding_box.get_maximum(),
+                _indices.data(), _indices.size(),
+                packed_vertices.data(), _vertices.size());
         }
 
         [[nodiscard]] const std::vector<unsigned int> &get_indices() const
@@ -63,6 +175,23 @@ namespace asr
         {
             _indices = indices;
             _requires_indices_update = true;
+            _triangle_bvh_requires_update = true;
+        }
+
+        void set_indices(std::vector<unsigned int> &&indices)
+        {
+            _indices = std::move(indices);
+            _requires_indices_update = true;
+            _triangle_bvh_requires_update = true;
+        }
+
+        // Returns the indices for changing them in place and marks them for the next upload.
+        unsigned int *edit_indices()
+        {
+            _requires_indices_update = true;
+            _triangle_bvh_requires_update = true;
+
+            return _indices.data();
         }
 
         [[nodiscard]] const std::vector<Vertex> &get_vertices() const
@@ -78,17 +207,154 @@ namespace asr
         void set_vertices(const std::vector<Vertex> &vertices)
         {
             _vertices = vertices;
-            _requires_vertices_update = true;
+            _vertices_packed = false;
+            set_requires_vertices_update(true);
+        }
+
+        void set_vertices(std::vector<Vertex> &&vertices)
+        {
+            _vertices = std::move(vertices);
+            _vertices_packed = false;
+            set_requires_vertices_update(true);
+        }
+
+        // Returns storage for vertex_count vertices that the caller packs with the vertex layout, for vertices
+        // that are rebuilt every frame, like particles, where filling Vertex structures first would double the
+        // work. The geometry draws these until set_vertices() is called. Packed vertices are not read back, so
+        // the caller passes their bounds along.
+        uint8_t *edit_packed_vertices(size_t vertex_count, const AABB &bounding_box)
+        {
+            _packed_vertices.resize(vertex_count * _vertex_layout.get_stride());
+            _packed_vertex_count = vertex_count;
+            _packed_vertices_bounding_box = bounding_box;
+            _vertices_packed = true;
+            set_requires_vertices_update(true);
+
+            return _packed_vertices.data();
+        }
+
+        [[nodiscard]] bool are_vertices_packed() const
+        {
+            return _vertices_packed;
+        }
+
+        // The bytes held between uploads for packing vertices that are not stored packed. Static geometries
+        // release them once they are uploaded.
+        [[nodiscard]] size_t get_vertex_upload_buffer_size() const
+        {
+            return _vertices_packed ? 0 : _packed_vertices.capacity();
+        }
+
+        // Returns the first of vertex_count vertices for changing them in place, and marks only that range for
+        // the next upload. The pointer stays valid until the vertices are replaced.
+        Vertex *edit_vertices(size_t first_vertex, size_t vertex_count)
+        {
+            set_requires_vertices_range_update(first_vertex, vertex_count);
+
+            return _vertices.data() + first_vertex;
         }
 
         void set_requires_indices_update(bool requires_indices_update)
         {
             _requires_indices_update = requires_indices_update;
+            _triangle_bvh_requires_update = _triangle_bvh_requires_update || requires_indices_update;
         }
 
         void set_requires_vertices_update(bool requires_vertices_update)
         {
             _requires_vertices_update = requires_vertices_update;
+            if (requires_vertices_update)
+            {
+                _invalidate_bounding_box();
+                _triangle_bvh_requires_update = true;
+                _vertices_update_range_begin = 0;
+                _vertices_update_range_end = std::numeric_limits<size_t>::max();
+            }
+            else
+            {
+                _vertices_update_range_begin = 0;
+                _vertices_update_range_end = 0;
+            }
+        }
+
+        void set_requires_vertices_range_update(size_t first_vertex, size_t vertex_count)
+        {
+            if (vertex_count == 0)
+            {
+                return;
+            }
+
+            size_t range_end = first_vertex + vertex_count;
+            if (_vertices_update_range_begin >= _vertices_update_range_end)
+            {
+                _vertices_update_range_begin = first_vertex;
+                _vertices_update_range_end = range_end;
+            }
+            else
+            {
+                _vertices_update_range_begin = std::min(_vertices_update_range_begin, first_vertex);
+                _vertices_update_range_end = std::max(_vertices_update_range_end, range_end);
+            }
+            _requires_vertices_update = true;
+            _invalidate_bounding_box();
+            _triangle_bvh_requires_update = true;
+        }
+
+        [[nodiscard]] bool requires_vertices_update() const
+        {
+            return _requires_vertices_update;
+        }
+
+        [[nodiscard]] bool requires_indices_update() const
+        {
+            return _requires_indices_update;
+        }
+
+        const AABB &get_bounding_box()
+        {
+            if (_bounding_box_requires_update)
+            {
+                _update_bounding_box();
+            }
+
+            return _bounding_box;
+        }
+
+        [[nodiscard]] unsigned int get_bounding_box_version()
+        {
+            if (_bounding_box_requires_update)
+            {
+                _update_bounding_box();
+            }
+
+            return _bounding_box_version;
+        }
+
+        // The triangles in the local space of the geometry, built on the first call after the vertices or the
+        // indices changed. Geometries that are not made of triangles have an empty one.
+        const TriangleBVH &get_triangle_bvh()
+        {
+            if (_triangle_bvh_requires_update)
+            {
+                _update_triangle_bvh();
+            }
+
+            return _triangle_bvh;
+        }
+
+        [[nodiscard]] const VertexLayout &get_vertex_layout() const
+        {
+            return _vertex_layout;
+        }
+
+        void set_vertex_layout(const VertexLayout &vertex_layout)
+        {
+            if (_vertex_layout != vertex_layout)
+            {
+                _vertex_layout = vertex_layout;
+                _requires_vertex_layout_update = true;
+                set_requires_vertices_update(true);
+            }
         }
 
         [[nodiscard]] UsageStrategy get_vertices_usage_strategy() const
@@ -101,7 +367,7 @@ namespace asr
             if (_vertices_usage_strategy != vertices_usage_strategy)
             {
                 _vertices_usage_strategy = vertices_usage_strategy;
-                _requires_vertices_update = true;
+                set_requires_vertices_update(true);
             }
         }
 
@@ -129,119 +395,215 @@ namespace asr
             _line_width = lineWidth;
         }
 
-        void transform(glm::mat4 transformation_matrix)
+        // The passes below split large meshes into ranges for the job system when one is given.
+        void transform(const glm::mat4 &transformation_matrix, JobSystem *job_system = nullptr)
         {
-            for (auto &vertex : _vertices)
+            geometry_processing::transform_vertices(_vertices, transformation_matrix, job_system);
+            set_requires_vertices_update(true);
+        }
+
+        // Reorders the triangles of a triangle list for the post-transform vertex cache. Best done once after
+        // creation and before optimize_vertex_fetch(), which depends on the order of the triangles.
+        void optimize_vertex_cache()
+        {
+            if (_type != Triangles)
             {
-                vertex.position = glm::vec3(transformation_matrix * glm::vec4(vertex.position, 1.0f));
+                return;
             }
-            _requires_vertices_update = true;
+
+            geometry_processing::optimize_vertex_cache(_indices, _vertices.size());
+            set_requires_indices_update(true);
+        }
+
+        // Orders the vertices the way the indices use them. Vertices edited by index afterwards have to be looked
+        // up through the new indices.
+        void optimize_vertex_fetch()
+        {
+            geometry_processing::optimize_vertex_fetch(_indices, _vertices);
+            set_requires_indices_update(true);
+            set_requires_vertices_update(true);
         }
 
-        void calculate_tangents_and_binormals()
+        void calculate_normals(JobSystem *job_system = nullptr)
         {
             if (_type != Triangles && _type != TriangleStrip && _type != TriangleFan)
             {
                 return;
             }
 
-            for (auto &vertex : _vertices)
+            geometry_processing::calculate_normals(static_cast<unsigned int>(_type), _indices, _vertices, job_system);
+            set_requires_vertices_update(true);
+        }
+
+        void calculate_tangents_and_binormals(JobSystem *job_system = nullptr)
+        {
+            if (_type != Triangles && _type != TriangleStrip && _type != TriangleFan)
             {
-                vertex.tangent = glm::vec4(0.0f);
-                vertex.binormal = glm::vec3(0.0f);
+                return;
             }
 
-            std::vector<unsigned int>::size_type index = _type == TriangleFan ? 1 : 0;
-            while (index < _indices.size())
-            {
-                std::vector<unsigned int>::size_type a_index, b_index, c_index;
-                switch (_type)
-                {
-                case Triangles:
-                    a_index = index;
-                    b_index = index + 1;
-                    c_index = index + 2;
-                    index += 3;
-                    break;
-                case TriangleStrip:
-                    a_index = index;
-                    b_index = index + 1;
-                    c_index = index + 2;
-                    ++index;
-                    break;
-                case TriangleFan:
-                    a_index = 0;
-                    b_index = index;
-                    c_index = index + 1;
-                    ++index;
-                    break;
-                default:
-                    return;
-                }
+            geometry_processing::calculate_tangents_and_binormals(static_cast<unsigned int>(_type), _indices, _vertices, job_system);
+            set_requires_vertices_update(true);
+        }
 
-                Vertex &a = _vertices[_indices[a_index]];
-                Vertex &b = _vertices[_indices[b_index]];
-                Vertex &c = _vertices[_indices[c_index]];
+        virtual void update(const Material &material) = 0;
 
-                glm::vec4 a_texture_coordinates = a.texture1_coordinates;
-                glm::vec4 b_texture_coordinates = b.texture1_coordinates;
-                glm::vec4 c_texture_coordinates = c.texture1_coordinates;
+        virtual void use() = 0;
 
-                glm::vec3 q1 = b.position - a.position;
-                glm::vec3 q2 = c.position - a.position;
+    protected:
+        inline static unsigned int _next_id{0};
+        const unsigned int _id{++_next_id};
 
-                float s1 = b_texture_coordinates.s - a_texture_coordinates.s;
-                float s2 = c_texture_coordinates.s - a_texture_coordinates.s;
-                float t1 = b_texture_coordinates.t - a_texture_coordinates.t;
-                float t2 = c_texture_coordinates.t - a_texture_coordinates.t;
+        Type _type{Triangles};
 
-                glm::vec3 tangent = glm::normalize((q1 * t2) - (q2 * t1));
-                glm::vec3 binormal = glm::normalize((q2 * s1) - (q1 * s2));
+        std::vector<unsigned int> _indices;
+        bool _requires_indices_update{true};
+        size_t _index_size{sizeof(unsigned int)};
+        std::vector<Vertex> _vertices;
+        bool _requires_vertices_update{true};
+        size_t _vertices_update_range_begin{0};
+        size_t _vertices_update_range_end{std::numeric_limits<size_t>::max()};
+        std::vector<uint8_t> _packed_vertices;
+        size_t _packed_vertex_count{0};
+        bool _vertices_packed{false};
+        AABB _packed_vertices_bounding_box{glm::vec3{0.0f}, glm::vec3{0.0f}};
+
+        VertexLayout _vertex_layout;
+        bool _requires_vertex_layout_update{true};
+
+        UsageStrategy _vertices_usage_strategy{StaticStrategy};
+        UsageStrategy _indices_usage_strategy{StaticStrategy};
+
+        float _line_width{1.0f};
 
-                a.tangent += glm::vec4(tangent, 0.0f);
-                b.tangent += glm::vec4(tangent, 0.0f);
-                c.tangent += glm::vec4(tangent, 0.0f);
+        std::shared_ptr<const MeshData> _mesh_data;
 
-                a.binormal += binormal;
-                b.binormal += binormal;
-                c.binormal += binormal;
+        AABB _bounding_box{glm::vec3{0.0f}, glm::vec3{0.0f}};
+        bool _bounding_box_requires_update{true};
+        unsigned int _bounding_box_version{0};
+        std::vector<GeometryListener *> _listeners;
+
+        TriangleBVH _triangle_bvh;
+        bool _triangle_bvh_requires_update{true};
+
+        // The listeners are told once until the bounds are calculated again, however often the vertices are
+        // edited in between.
+        void _invalidate_bounding_box()
+        {
+            if (_bounding_box_requires_update)
+            {
+                return;
             }
 
-            for (auto &vertex : _vertices)
+            _bounding_box_requires_update = true;
+            for (GeometryListener *listener : _listeners)
             {
-                glm::vec3 normal = vertex.normal;
-                glm::vec3 tangent = vertex.tangent;
-                glm::vec3 binormal = vertex.binormal;
+                listener->on_geometry_bounds_changed(*this);
+            }
+        }
 
-                tangent = glm::normalize(tangent - (normal * glm::dot(tangent, normal)));
-                glm::vec4 tangent_with_determinant = glm::vec4(tangent, 0.0f);
+        // Returns the packed vertices from range_begin up to range_end for an upload. Vertices that are not
+        // stored packed are packed into the upload buffer, which only holds the range and keeps its capacity for
+        // the next upload of dynamic and streamed vertices.
+        const uint8_t *_begin_vertices_upload(size_t range_begin, size_t range_end)
+        {
+            const size_t stride{_vertex_layout.get_stride()};
+            if (_vertices_packed)
+            {
+                return _packed_vertices.data() + range_begin * stride;
+            }
 
-                bool mirrored = glm::dot(glm::cross(normal, tangent), binormal) < 0.0f;
-                tangent_with_determinant[3] = mirrored ? 1.0f : -1.0f;
+            _packed_vertices.resize((range_end - range_begin) * stride);
+            _vertex_layout.pack(_vertices, range_begin, range_end, _packed_vertices.data());
 
-                vertex.tangent = tangent_with_determinant;
-                vertex.binormal = glm::cross(normal, tangent) * tangent_with_determinant[3];
+            return _packed_vertices.data();
+        }
+
+        void _end_vertices_upload()
+        {
+            if (!_vertices_packed && _vertices_usage_strategy == StaticStrategy)
+            {
+                std::vector<uint8_t>().swap(_packed_vertices);
             }
 
-            _requires_vertices_update = true;
+            set_requires_vertices_update(false);
         }
 
-        virtual void update(const Material &material) = 0;
-
-        virtual void use() = 0;
+        void _update_bounding_box()
+        {
+            glm::vec3 minimum{0.0f};
+            glm::vec3 maximum{0.0f};
+            if (_mesh_data)
+            {
+                minimum = _mesh_data->get_minimum();
+                maximum = _mesh_data->get_maximum();
+            }
+            else if (_vertices_packed)
+            {
+                minimum = _packed_vertices_bounding_box.get_minimum();
+                maximum = _packed_vertices_bounding_box.get_maximum();
+            }
+            else if (!_vertices.empty())
+            {
+                AABB bounds = geometry_processing::calculate_bounds(_vertices);
+                minimum = bounds.get_minimum();
+                maximum = bounds.get_maximum();
+            }
 
-    protected:
-        Type _type{Triangles};
+            _bounding_box.set_minimum(minimum);
+            _bounding_box.set_maximum(maximum);
+            _bounding_box_requires_update = false;
+            ++_bounding_box_version;
+        }
 
-        std::vector<unsigned int> _indices;
-        bool _requires_indices_update{true};
-        std::vector<Vertex> _vertices;
-        bool _requires_vertices_update{true};
+        void _update_triangle_bvh()
+        {
+            std::vector<glm::vec3> positions;
+            std::vector<unsigned int> indices;
+            if (_mesh_data || _vertices_packed)
+            {
+                const uint8_t *packed_vertices = _mesh_data ? _mesh_data->get_vertex_data() : _packed_vertices.data();
+                size_t stride = _vertex_layout.get_stride();
+                positions.resize(get_vertex_count());
+                for (size_t i = 0; i < positions.size(); ++i)
+                {
+                    positions[i] = glm::vec3(_vertex_layout.unpack(packed_vertices + i * stride, VertexLayout::Position));
+                }
+            }
+            else
+            {
+                positions.resize(_vertices.size());
+                for (size_t i = 0; i < positions.size(); ++i)
+                {
+                    positions[i] = _vertices[i].position;
+                }
+            }
+            if (_mesh_data)
+            {
+                indices.assign(_mesh_data->get_index_data(), _mesh_data->get_index_data() + _mesh_data->get_index_count());
+            }
+            else
+            {
+                indices = _indices;
+            }
 
-        UsageStrategy _vertices_usage_strategy{StaticStrategy};
-        UsageStrategy _indices_usage_strategy{StaticStrategy};
+            // Strips and fans are unrolled into a list, so the hierarchy reports triangles the way
+            // TriangleIndices counts them.
+            if (_type != Triangles)
+            {
+                geometry_processing::TriangleIndices triangles{static_cast<unsigned int>(_type), indices};
+                std::vector<unsigned int> triangle_list(triangles.size() * 3);
+                for (size_t triangle = 0; triangle < triangles.size(); ++triangle)
+                {
+                    triangles.get(triangle, triangle_list[triangle * 3], triangle_list[triangle * 3 + 1],
+                                  triangle_list[triangle * 3 + 2]);
+                }
+                indices = std::move(triangle_list);
+            }
 
-        float _line_width{1.0f};
+            _triangle_bvh.build(positions, indices);
+            _triangle_bvh_requires_update = false;
+        }
     };
 }
 
@@ -37,7 +37,7 @@ namespace asr::geometry_generators
             indices.push_back(static_cast<unsigned int>(i));
         }
 
-        return std::make_pair(indices, vertices);
+        return std::make_pair(std::move(indices), std::move(vertices));
     }
 
     static geometry_data_type generate_circle_geometry_data(float radius, unsigned int segment_count)
@@ -62,7 +62,7 @@ namespace asr::geometry_generators
             indices.push_back(i);
         }
 
-        return std::make_pair(indices, vertices);
+        return std::make_pair(std::move(indices), std::move(vertices));
     }
 
     static geometry_data_type generate_plane_geometry_data(float width, float height, unsigned int width_segments_count, unsigned int height_segments_count)
@@ -113,7 +113,7 @@ namespace asr::geometry_generators
             }
         }
 
-        return std::make_pair(indices, vertices);
+        return std::make_pair(std::move(indices), std::move(vertices));
     }
 
     static geometry_data_type generate_rectangle_geometry_data(
@@ -167,7 +167,7 @@ namespace asr::geometry_generators
             }
         }
 
-        return std::make_pair(indices, vertices);
+        return std::make_pair(std::move(indices), std::move(vertices));
     }
 
     static geometry_data_type generate_box_geometry_data(
@@ -381,7 +381,7 @@ namespace asr::geometry_generators
             }
         }
 
-        return std::make_pair(indices, vertices);
+        return std::make_pair(std::move(indices), std::move(vertices));
     }
 
     static geometry_data_type generate_sphere_geometry_data(float radius, unsigned int segment_count, unsigned int ring_count)
@@ -435,7 +435,7 @@ namespace asr::geometry_generators
             }
         }
 
-        return std::make_pair(indices, vertices);
+        return std::make_pair(std::move(indices), std::move(vertices));
     }
 }
 
@@ -0,0 +1,26 @@
+#ifndef GEOMETRY_LISTENER_H
+#define GEOMETRY_LISTENER_H
+
+#include <cstddef>
+
+namespace asr
+{
+    class Geometry;
+
+    // Listens to the bounds of one geometry at a time. The geometry keeps the place of the listener in its
+    // list, so that adding and removing listeners takes constant time however many meshes share it.
+    class GeometryListener
+    {
+    public:
+        virtual ~GeometryListener() = default;
+
+        virtual void on_geometry_bounds_changed(Geometry &geometry) = 0;
+
+    private:
+        friend class Geometry;
+
+        size_t _geometry_listener_index{0};
+    };
+}
+
+#endif
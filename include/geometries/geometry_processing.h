@@ -0,0 +1,949 @@
+#ifndef GEOMETRY_PROCESSING_H
+#define GEOMETRY_PROCESSING_H
+
+#include "geometries/vertex.h"
+#include "math/aabb.h"
+#include "utilities/job_system.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+
+#if !defined(ASR_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ASR_SIMD_SSE2
+#include <emmintrin.h>
+#elif !defined(ASR_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define ASR_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// Passes over large meshes that split the work into ranges for a JobSystem when one is given and process four
+// floats at a time with SSE2 or NEON where the target has them. The results do not depend on the number of
+// threads: vertices that are shared by several triangles sum up their contributions in the order of the
+// triangles, the same way a single thread would. Define ASR_NO_SIMD to fall back to the scalar loops.
+namespace asr::geometry_processing
+{
+    static const size_t GRAIN_SIZE{16384};
+
+    // Positions stored as separate x, y and z arrays, which lets the vectorised loops work on four vertices
+    // at once.
+    struct PositionStreams
+    {
+        float *x;
+        float *y;
+        float *z;
+        size_t count;
+    };
+
+    template <typename Function>
+    static void _for_each_range(size_t count, JobSystem *job_system, const Function &function)
+    {
+        if (job_system != nullptr)
+        {
+            job_system->parallel_for(count, GRAIN_SIZE, function);
+        }
+        else if (count > 0)
+        {
+            function(static_cast<size_t>(0), count);
+        }
+    }
+
+    static void transform_positions(const PositionStreams &positions, const glm::mat4 &transformation_matrix,
+                                    JobSystem *job_system = nullptr)
+    {
+        const float *m = glm::value_ptr(transformation_matrix);
+        _for_each_range(positions.count, job_system, [&](size_t begin, size_t end) {
+            size_t i = begin;
+#if defined(ASR_SIMD_SSE2)
+            __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+            __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+            __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+            __m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]);
+            for (; i + 4 <= end; i += 4)
+            {
+                __m128 x = _mm_loadu_ps(positions.x + i);
+                __m128 y = _mm_loadu_ps(positions.y + i);
+                __m128 z = _mm_loadu_ps(positions.z + i);
+                _mm_storeu_ps(positions.x + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), _mm_add_ps(_mm_mul_ps(m8, z), m12)));
+                _mm_storeu_ps(positions.y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), _mm_add_ps(_mm_mul_ps(m9, z), m13)));
+                _mm_storeu_ps(positions.z + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)), _mm_add_ps(_mm_mul_ps(m10, z), m14)));
+            }
+#elif defined(ASR_SIMD_NEON)
+            for (; i + 4 <= end; i += 4)
+            {
+                float32x4_t x = vld1q_f32(positions.x + i);
+                float32x4_t y = vld1q_f32(positions.y + i);
+                float32x4_t z = vld1q_f32(positions.z + i);
+                vst1q_f32(positions.x + i, vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[12]), x, m[0]), y, m[4]), z, m[8]));
+                vst1q_f32(positions.y + i, vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[13]), x, m[1]), y, m[5]), z, m[9]));
+                vst1q_f32(positions.z + i, vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[14]), x, m[2]), y, m[6]), z, m[10]));
+            }
+#endif
+            for (; i < end; ++i)
+            {
+                float x = positions.x[i];
+                float y = positions.y[i];
+                float z = positions.z[i];
+                positions.x[i] = m[0] * x + m[4] * y + m[8] * z + m[12];
+                positions.y[i] = m[1] * x + m[5] * y + m[9] * z + m[13];
+                positions.z[i] = m[2] * x + m[6] * y + m[10] * z + m[14];
+            }
+        });
+    }
+
+    static AABB calculate_bounds(const PositionStreams &positions, JobSystem *job_system = nullptr)
+    {
+        if (positions.count == 0)
+        {
+            return AABB{glm::vec3{0.0f}, glm::vec3{0.0f}};
+        }
+
+        size_t range_count = (positions.count + GRAIN_SIZE - 1) / GRAIN_SIZE;
+        std::vector<glm::vec3> minimums(range_count);
+        std::vector<glm::vec3> maximums(range_count);
+        _for_each_range(positions.count, job_system, [&](size_t begin, size_t end) {
+            glm::vec3 minimum{positions.x[begin], positions.y[begin], positions.z[begin]};
+            glm::vec3 maximum{minimum};
+            size_t i = begin;
+#if defined(ASR_SIMD_SSE2)
+            if (end - begin >= 4)
+            {
+                __m128 minimum_x = _mm_loadu_ps(positions.x + i), maximum_x = minimum_x;
+                __m128 minimum_y = _mm_loadu_ps(positions.y + i), maximum_y = minimum_y;
+                __m128 minimum_z = _mm_loadu_ps(positions.z + i), maximum_z = minimum_z;
+                for (i += 4; i + 4 <= end; i += 4)
+                {
+                    __m128 x = _mm_loadu_ps(positions.x + i);
+                    __m128 y = _mm_loadu_ps(positions.y + i);
+                    __m128 z = _mm_loadu_ps(positions.z + i);
+                    minimum_x = _mm_min_ps(minimum_x, x);
+                    maximum_x = _mm_max_ps(maximum_x, x);
+                    minimum_y = _mm_min_ps(minimum_y, y);
+                    maximum_y = _mm_max_ps(maximum_y, y);
+                    minimum_z = _mm_min_ps(minimum_z, z);
+                    maximum_z = _mm_max_ps(maximum_z, z);
+                }
+
+                alignas(16) float lanes[6][4];
+                _mm_store_ps(lanes[0], minimum_x);
+                _mm_store_ps(lanes[1], minimum_y);
+                _mm_store_ps(lanes[2], minimum_z);
+                _mm_store_ps(lanes[3], maximum_x);
+                _mm_store_ps(lanes[4], maximum_y);
+                _mm_store_ps(lanes[5], maximum_z);
+                for (unsigned int lane = 0; lane < 4; ++lane)
+                {
+                    minimum = glm::min(minimum, glm::vec3{lanes[0][lane], lanes[1][lane], lanes[2][lane]});
+                    maximum = glm::max(maximum, glm::vec3{lanes[3][lane], lanes[4][lane], lanes[5][lane]});
+                }
+            }
+#elif defined(ASR_SIMD_NEON)
+            if (end - begin >= 4)
+            {
+                float32x4_t minimum_x = vld1q_f32(positions.x + i), maximum_x = minimum_x;
+                float32x4_t minimum_y = vld1q_f32(positions.y + i), maximum_y = minimum_y;
+                float32x4_t minimum_z = vld1q_f32(positions.z + i), maximum_z = minimum_z;
+                for (i += 4; i + 4 <= end; i += 4)
+                {
+                    float32x4_t x = vld1q_f32(positions.x + i);
+                    float32x4_t y = vld1q_f32(positions.y + i);
+                    float32x4_t z = vld1q_f32(positions.z + i);
+                    minimum_x = vminq_f32(minimum_x, x);
+                    maximum_x = vmaxq_f32(maximum_x, x);
+                    minimum_y = vminq_f32(minimum_y, y);
+                    maximum_y = vmaxq_f32(maximum_y, y);
+                    minimum_z = vminq_f32(minimum_z, z);
+                    maximum_z = vmaxq_f32(maximum_z, z);
+                }
+
+                float lanes[6][4];
+                vst1q_f32(lanes[0], minimum_x);
+                vst1q_f32(lanes[1], minimum_y);
+                vst1q_f32(lanes[2], minimum_z);
+                vst1q_f32(lanes[3], maximum_x);
+                vst1q_f32(lanes[4], maximum_y);
+                vst1q_f32(lanes[5], maximum_z);
+                for (unsigned int lane = 0; lane < 4; ++lane)
+                {
+                    minimum = glm::min(minimum, glm::vec3{lanes[0][lane], lanes[1][lane], lanes[2][lane]});
+                    maximum = glm::max(maximum, glm::vec3{lanes[3][lane], lanes[4][lane], lanes[5][lane]});
+                }
+            }
+#endif
+            for (; i < end; ++i)
+            {
+                glm::vec3 position{positions.x[i], positions.y[i], positions.z[i]};
+                minimum = glm::min(minimum, position);
+                maximum = glm::max(maximum, position);
+            }
+
+            minimums[begin / GRAIN_SIZE] = minimum;
+            maximums[begin / GRAIN_SIZE] = maximum;
+        });
+
+        glm::vec3 minimum{minimums.front()};
+        glm::vec3 maximum{maximums.front()};
+        for (size_t i = 1; i < range_count; ++i)
+        {
+            minimum = glm::min(minimum, minimums[i]);
+            maximum = glm::max(maximum, maximums[i]);
+        }
+
+        return AABB{minimum, maximum};
+    }
+
+    static void transform_vertices(std::vector<Vertex> &vertices, const glm::mat4 &transformation_matrix,
+                                   JobSystem *job_system = nullptr)
+    {
+        const float *m = glm::value_ptr(transformation_matrix);
+        _for_each_range(vertices.size(), job_system, [&](size_t begin, size_t end) {
+#if defined(ASR_SIMD_SSE2)
+            __m128 column0 = _mm_loadu_ps(m);
+            __m128 column1 = _mm_loadu_ps(m + 4);
+            __m128 column2 = _mm_loadu_ps(m + 8);
+            __m128 column3 = _mm_loadu_ps(m + 12);
+            alignas(16) float result[4];
+            for (size_t i = begin; i < end; ++i)
+            {
+                glm::vec3 &position = vertices[i].position;
+                __m128 transformed = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(position.x)), _mm_mul_ps(column1, _mm_set1_ps(position.y))),
+                    _mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(position.z)), column3));
+                _mm_store_ps(result, transformed);
+                position = glm::vec3{result[0], result[1], result[2]};
+            }
+#elif defined(ASR_SIMD_NEON)
+            float32x4_t column0 = vld1q_f32(m);
+            float32x4_t column1 = vld1q_f32(m + 4);
+            float32x4_t column2 = vld1q_f32(m + 8);
+            float32x4_t column3 = vld1q_f32(m + 12);
+            float result[4];
+            for (size_t i = begin; i < end; ++i)
+            {
+                glm::vec3 &position = vertices[i].position;
+                float32x4_t transformed = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(column3, column0, position.x), column1, position.y), column2, position.z);
+                vst1q_f32(result, transformed);
+                position = glm::vec3{result[0], result[1], result[2]};
+            }
+#else
+            for (size_t i = begin; i < end; ++i)
+            {
+                glm::vec3 &position = vertices[i].position;
+                position = glm::vec3{
+                    m[0] * position.x + m[4] * position.y + m[8] * position.z + m[12],
+                    m[1] * position.x + m[5] * position.y + m[9] * position.z + m[13],
+                    m[2] * position.x + m[6] * position.y + m[10] * position.z + m[14]};
+            }
+#endif
+        });
+    }
+
+    static AABB calculate_bounds(const std::vector<Vertex> &vertices, JobSystem *job_system = nullptr)
+    {
+        if (vertices.empty())
+        {
+            return AABB{glm::vec3{0.0f}, glm::vec3{0.0f}};
+        }
+
+        size_t range_count = (vertices.size() + GRAIN_SIZE - 1) / GRAIN_SIZE;
+        std::vector<glm::vec3> minimums(range_count);
+        std::vector<glm::vec3> maximums(range_count);
+        _for_each_range(vertices.size(), job_system, [&](size_t begin, size_t end) {
+            glm::vec3 minimum{vertices[begin].position};
+            glm::vec3 maximum{minimum};
+#if defined(ASR_SIMD_SSE2)
+            __m128 minimum_lanes = _mm_setr_ps(minimum.x, minimum.y, minimum.z, 0.0f);
+            __m128 maximum_lanes = minimum_lanes;
+            for (size_t i = begin + 1; i < end; ++i)
+            {
+                const glm::vec3 &position = vertices[i].position;
+                __m128 lanes = _mm_setr_ps(position.x, position.y, position.z, 0.0f);
+                minimum_lanes = _mm_min_ps(minimum_lanes, lanes);
+                maximum_lanes = _mm_max_ps(maximum_lanes, lanes);
+            }
+
+            alignas(16) float result[2][4];
+            _mm_store_ps(result[0], minimum_lanes);
+            _mm_store_ps(result[1], maximum_lanes);
+            minimum = glm::vec3{result[0][0], result[0][1], result[0][2]};
+            maximum = glm::vec3{result[1][0], result[1][1], result[1][2]};
+#else
+            for (size_t i = begin + 1; i < end; ++i)
+            {
+                minimum = glm::min(minimum, vertices[i].position);
+                maximum = glm::max(maximum, vertices[i].position);
+            }
+#endif
+
+            minimums[begin / GRAIN_SIZE] = minimum;
+            maximums[begin / GRAIN_SIZE] = maximum;
+        });
+
+        glm::vec3 minimum{minimums.front()};
+        glm::vec3 maximum{maximums.front()};
+        for (size_t i = 1; i < range_count; ++i)
+        {
+            minimum = glm::min(minimum, minimums[i]);
+            maximum = glm::max(maximum, maximums[i]);
+        }
+
+        return AABB{minimum, maximum};
+    }
+
+    // The triangles of an index list, strip or fan. Other index lists have no triangles.
+    class TriangleIndices
+    {
+    public:
+        // The values match Geometry::Type.
+        enum Type
+        {
+            List = 4,
+            Fan = 5,
+            Strip = 6
+        };
+
+        TriangleIndices(unsigned int type, const std::vector<unsigned int> &indices) : _type{type}, _indices{indices}
+        {
+            if (type == List)
+            {
+                _count = indices.size() / 3;
+            }
+            else if ((type == Strip || type == Fan) && indices.size() >= 3)
+            {
+                _count = indices.size() - 2;
+            }
+        }
+
+        [[nodiscard]] size_t size() const
+        {
+            return _count;
+        }
+
+        void get(size_t triangle, unsigned int &a, unsigned int &b, unsigned int &c) const
+        {
+            switch (_type)
+            {
+            case Strip:
+                a = _indices[triangle];
+                b = _indices[triangle + 1];
+                c = _indices[triangle + 2];
+                break;
+            case Fan:
+                a = _indices[0];
+                b = _indices[triangle + 1];
+                c = _indices[triangle + 2];
+                break;
+            default:
+                a = _indices[triangle * 3];
+                b = _indices[triangle * 3 + 1];
+                c = _indices[triangle * 3 + 2];
+                break;
+            }
+        }
+
+    private:
+        unsigned int _type;
+        const std::vector<unsigned int> &_indices;
+        size_t _count{0};
+    };
+
+    // The triangles around every vertex in ascending order, as offsets into one array of triangle indices.
+    struct VertexTriangles
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+    };
+
+    static VertexTriangles _collect_vertex_triangles(const TriangleIndices &triangles, size_t vertex_count)
+    {
+        VertexTriangles vertex_triangles;
+        vertex_triangles.offsets.assign(vertex_count + 1, 0);
+        auto &offsets = vertex_triangles.offsets;
+        for (size_t triangle = 0; triangle < triangles.size(); ++triangle)
+        {
+            unsigned int a, b, c;
+            triangles.get(triangle, a, b, c);
+            ++offsets[a + 1];
+            ++offsets[b + 1];
+            ++offsets[c + 1];
+        }
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+
+        vertex_triangles.triangles.resize(offsets.back());
+        std::vector<uint32_t> positions(offsets.begin(), offsets.end() - 1);
+        for (size_t triangle = 0; triangle < triangles.size(); ++triangle)
+        {
+            unsigned int a, b, c;
+            triangles.get(triangle, a, b, c);
+            vertex_triangles.triangles[positions[a]++] = static_cast<uint32_t>(triangle);
+            vertex_triangles.triangles[positions[b]++] = static_cast<uint32_t>(triangle);
+            vertex_triangles.triangles[positions[c]++] = static_cast<uint32_t>(triangle);
+        }
+
+        return vertex_triangles;
+    }
+
+    // Sets the normals to the area-weighted average of the normals of the triangles around each vertex, taking
+    // clockwise triangles as front-facing like the generators and the default material. Vertices that belong
+    // to no triangle keep their normals.
+    static void calculate_normals(unsigned int type, const std::vector<unsigned int> &indices,
+                                  std::vector<Vertex> &vertices, JobSystem *job_system = nullptr)
+    {
+        TriangleIndices triangles{type, indices};
+        std::vector<glm::vec3> face_normals(triangles.size());
+        _for_each_range(triangles.size(), job_system, [&](size_t begin, size_t end) {
+            for (size_t triangle = begin; triangle < end; ++triangle)
+            {
+                unsigned int a, b, c;
+                triangles.get(triangle, a, b, c);
+                const glm::vec3 &position = vertices[a].position;
+                face_normals[triangle] = glm::cross(vertices[c].position - position, vertices[b].position - position);
+            }
+        });
+
+        VertexTriangles vertex_triangles = _collect_vertex_triangles(triangles, vertices.size());
+        _for_each_range(vertices.size(), job_system, [&](size_t begin, size_t end) {
+            for (size_t vertex = begin; vertex < end; ++vertex)
+            {
+                uint32_t first = vertex_triangles.offsets[vertex];
+                uint32_t last = vertex_triangles.offsets[vertex + 1];
+                if (first == last)
+                {
+                    continue;
+                }
+
+                glm::vec3 normal{0.0f};
+                for (uint32_t i = first; i < last; ++i)
+                {
+                    normal += face_normals[vertex_triangles.triangles[i]];
+                }
+                float length_squared = glm::dot(normal, normal);
+                vertices[vertex].normal = length_squared > 0.0f ? normal / std::sqrt(length_squared) : glm::vec3{0.0f};
+            }
+        });
+    }
+
+    // Calculates the tangents from the first texture coordinates, with the handedness in w, and the binormals
+    // from the normals and the tangents.
+    static void calculate_tangents_and_binormals(unsigned int type, const std::vector<unsigned int> &indices,
+                                                 std::vector<Vertex> &vertices, JobSystem *job_system = nullptr)
+    {
+        TriangleIndices triangles{type, indices};
+        std::vector<glm::vec3> face_tangents(triangles.size());
+        std::vector<glm::vec3> face_binormals(triangles.size());
+        _for_each_range(triangles.size(), job_system, [&](size_t begin, size_t end) {
+            for (size_t triangle = begin; triangle < end; ++triangle)
+            {
+                unsigned int a_index, b_index, c_index;
+                triangles.get(triangle, a_index, b_index, c_index);
+                const Vertex &a = vertices[a_index];
+                const Vertex &b = vertices[b_index];
+                const Vertex &c = vertices[c_index];
+
+                glm::vec3 q1 = b.position - a.position;
+                glm::vec3 q2 = c.position - a.position;
+
+                float s1 = b.texture1_coordinates.s - a.texture1_coordinates.s;
+                float s2 = c.texture1_coordinates.s - a.texture1_coordinates.s;
+                float t1 = b.texture1_coordinates.t - a.texture1_coordinates.t;
+                float t2 = c.texture1_coordinates.t - a.texture1_coordinates.t;
+
+                face_tangents[triangle] = glm::normalize((q1 * t2) - (q2 * t1));
+                face_binormals[triangle] = glm::normalize((q2 * s1) - (q1 * s2));
+            }
+        });
+
+        VertexTriangles vertex_triangles = _collect_vertex_triangles(triangles, vertices.size());
+        _for_each_range(vertices.size(), job_system, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                glm::vec3 tangent{0.0f};
+                glm::vec3 binormal{0.0f};
+                for (uint32_t j = vertex_triangles.offsets[i]; j < vertex_triangles.offsets[i + 1]; ++j)
+                {
+                    tangent += face_tangents[vertex_triangles.triangles[j]];
+                    binormal += face_binormals[vertex_triangles.triangles[j]];
+                }
+
+                Vertex &vertex = vertices[i];
+                glm::vec3 normal = vertex.normal;
+                tangent = glm::normalize(tangent - (normal * glm::dot(tangent, normal)));
+
+                bool mirrored = glm::dot(glm::cross(normal, tangent), binormal) < 0.0f;
+                float determinant = mirrored ? 1.0f : -1.0f;
+
+                vertex.tangent = glm::vec4(tangent, determinant);
+                vertex.binormal = glm::cross(normal, tangent) * determinant;
+            }
+        });
+    }
+
+    namespace vertex_cache
+    {
+        static const size_t CACHE_SIZE{32};
+        static const float CACHE_DECAY_POWER{1.5f};
+        static const float LAST_TRIANGLE_SCORE{0.75f};
+        static const float VALENCE_BOOST_SCALE{2.0f};
+        static const float VALENCE_BOOST_POWER{0.5f};
+
+        static float _calculate_vertex_score(int cache_position, uint32_t remaining_triangle_count)
+        {
+            if (remaining_triangle_count == 0)
+            {
+                return -1.0f;
+            }
+
+            float score{0.0f};
+            if (cache_position >= 0)
+            {
+                if (cache_position < 3)
+                {
+                    score = LAST_TRIANGLE_SCORE;
+                }
+                else
+                {
+                    float scale = 1.0f / static_cast<float>(CACHE_SIZE - 3);
+                    score = std::pow(1.0f - static_cast<float>(cache_position - 3) * scale, CACHE_DECAY_POWER);
+                }
+            }
+
+            return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remaining_triangle_count), -VALENCE_BOOST_POWER);
+        }
+    }
+
+    // The share of vertices a FIFO post-transform cache of the given size would have to transform again, per
+    // triangle of a triangle list. 0.5 is the best a regular grid can get to and 3 means no reuse at all.
+    static float calculate_average_cache_miss_ratio(const std::vector<unsigned int> &indices, size_t vertex_count,
+                                                    size_t cache_size = vertex_cache::CACHE_SIZE)
+    {
+        if (indices.size() < 3)
+        {
+            return 0.0f;
+        }
+
+        std::vector<size_t> cache_times(vertex_count, 0);
+        size_t time{cache_size};
+        size_t miss_count{0};
+        for (unsigned int index : indices)
+        {
+            if (time - cache_times[index] >= cache_size)
+            {
+                cache_times[index] = ++time;
+                ++miss_count;
+            }
+        }
+
+        return static_cast<float>(miss_count) / static_cast<float>(indices.size() / 3);
+    }
+
+    // Reorders the triangles of a triangle list for the post-transform vertex cache with the linear-speed
+    // algorithm of Tom Forsyth. Each step emits the triangle with the best score, which favours the vertices
+    // in the simulated cache and the vertices with few triangles left, so the mesh is covered in strips that
+    // stay close to what was transformed last.
+    static void optimize_vertex_cache(std::vector<unsigned int> &indices, size_t vertex_count)
+    {
+        TriangleIndices triangles{TriangleIndices::List, indices};
+        size_t triangle_count = triangles.size();
+        if (triangle_count == 0)
+        {
+            return;
+        }
+
+        VertexTriangles vertex_triangles = _collect_vertex_triangles(triangles, vertex_count);
+        std::vector<uint32_t> remaining_triangle_counts(vertex_count);
+        std::vector<float> vertex_scores(vertex_count);
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex)
+        {
+            remaining_triangle_counts[vertex] = vertex_triangles.offsets[vertex + 1] - vertex_triangles.offsets[vertex];
+            vertex_scores[vertex] = vertex_cache::_calculate_vertex_score(-1, remaining_triangle_counts[vertex]);
+        }
+
+        std::vector<float> triangle_scores(triangle_count);
+        std::vector<bool> emitted_triangles(triangle_count, false);
+        size_t best_triangle{0};
+        for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+        {
+            unsigned int a, b, c;
+            triangles.get(triangle, a, b, c);
+            triangle_scores[triangle] = vertex_scores[a] + vertex_scores[b] + vertex_scores[c];
+            if (triangle_scores[triangle] > triangle_scores[best_triangle])
+            {
+                best_triangle = triangle;
+            }
+        }
+
+        std::vector<unsigned int> optimized_indices;
+        optimized_indices.reserve(triangle_count * 3);
+        std::vector<unsigned int> cache;
+        std::vector<unsigned int> next_cache;
+        cache.reserve(vertex_cache::CACHE_SIZE + 3);
+        next_cache.reserve(vertex_cache::CACHE_SIZE + 3);
+        size_t next_unemitted_triangle{0};
+        while (optimized_indices.size() < triangle_count * 3)
+        {
+            if (best_triangle == triangle_count)
+            {
+                while (emitted_triangles[next_unemitted_triangle])
+                {
+                    ++next_unemitted_triangle;
+                }
+                best_triangle = next_unemitted_triangle;
+            }
+
+            unsigned int corners[3];
+            triangles.get(best_triangle, corners[0], corners[1], corners[2]);
+            emitted_triangles[best_triangle] = true;
+
+            next_cache.clear();
+            for (unsigned int corner : corners)
+            {
+                optimized_indices.push_back(corner);
+                next_cache.push_back(corner);
+
+                // The triangles that are left come first in the range of every vertex.
+                uint32_t *first = vertex_triangles.triangles.data() + vertex_triangles.offsets[corner];
+                uint32_t *last = first + remaining_triangle_counts[corner];
+                std::iter_swap(std::find(first, last, static_cast<uint32_t>(best_triangle)), last - 1);
+                --remaining_triangle_counts[corner];
+            }
+            for (unsigned int vertex : cache)
+            {
+                if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                {
+                    next_cache.push_back(vertex);
+                }
+            }
+
+            best_triangle = triangle_count;
+            float best_score{-1.0f};
+            for (size_t position = 0; position < next_cache.size(); ++position)
+            {
+                unsigned int vertex = next_cache[position];
+                int cache_position = position < vertex_cache::CACHE_SIZE ? static_cast<int>(position) : -1;
+
+                float score = vertex_cache::_calculate_vertex_score(cache_position, remaining_triangle_counts[vertex]);
+                float score_change = score - vertex_scores[vertex];
+                vertex_scores[vertex] = score;
+
+                uint32_t first = vertex_triangles.offsets[vertex];
+                for (uint32_t i = first; i < first + remaining_triangle_counts[vertex]; ++i)
+                {
+                    uint32_t triangle = vertex_triangles.triangles[i];
+                    triangle_scores[triangle] += score_change;
+                    if (triangle_scores[triangle] > best_score)
+                    {
+                        best_score = triangle_scores[triangle];
+                        best_triangle = triangle;
+                    }
+                }
+            }
+
+            next_cache.resize(std::min(next_cache.size(), vertex_cache::CACHE_SIZE));
+            std::swap(cache, next_cache);
+        }
+
+        indices = std::move(optimized_indices);
+    }
+
+    // Orders the vertices the way the indices first refer to them, so the vertex fetches walk through memory
+    // instead of jumping around it. Vertices that no index refers to are moved to the end.
+    static void optimize_vertex_fetch(std::vector<unsigned int> &indices, std::vector<Vertex> &vertices)
+    {
+        const auto unassigned = std::numeric_limits<unsigned int>::max();
+        std::vector<unsigned int> remap(vertices.size(), unassigned);
+        unsigned int next_vertex{0};
+        for (unsigned int &index : indices)
+        {
+            if (remap[index] == unassigned)
+            {
+                remap[index] = next_vertex++;
+            }
+            index = remap[index];
+        }
+
+        std::vector<Vertex> optimized_vertices(vertices.size());
+        for (size_t vertex = 0; vertex < vertices.size(); ++vertex)
+        {
+            if (remap[vertex] == unassigned)
+            {
+                remap[vertex] = next_vertex++;
+            }
+            optimized_vertices[remap[vertex]] = vertices[vertex];
+        }
+
+        vertices = std::move(optimized_vertices);
+    }
+
+    // A symmetric 4x4 matrix that sums the squared distances to a set of planes, stored as its upper triangle.
+    struct Quadric
+    {
+        std::array<double, 10> q{};
+
+        static Quadric from_plane(const glm::vec3 &normal, float distance, float weight)
+        {
+            double a = normal.x, b = normal.y, c = normal.z, d = distance, w = weight;
+            Quadric quadric;
+            quadric.q = {w * a * a, w * a * b, w * a * c, w * a * d,
+                         w * b * b, w * b * c, w * b * d,
+                         w * c * c, w * c * d,
+                         w * d * d};
+
+            return quadric;
+        }
+
+        Quadric &operator+=(const Quadric &other)
+        {
+            for (size_t i = 0; i < q.size(); ++i)
+            {
+                q[i] += other.q[i];
+            }
+
+            return *this;
+        }
+
+        [[nodiscard]] double evaluate(const glm::vec3 &point) const
+        {
+            double x = point.x, y = point.y, z = point.z;
+            return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x +
+                   q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y +
+                   q[7] * z * z + 2.0 * q[8] * z +
+                   q[9];
+        }
+    };
+
+    // Reduces a triangle mesh to about the target number of indices with quadric error metrics (Garland and
+    // Heckbert). The cheapest edge is collapsed into one of its ends first, so the vertices that remain keep
+    // their positions and attributes, until the target is reached or the next collapse would move the surface
+    // by more than the square root of the maximum error. Vertices on open edges, which include the seams where
+    // vertices are duplicated for different texture coordinates or normals, are never removed, and collapses
+    // that would flip a triangle are skipped. Returns a triangle list with the vertices that are still used.
+    static std::pair<std::vector<unsigned int>, std::vector<Vertex>> simplify(
+        unsigned int type, const std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+        size_t target_index_count, float max_error = std::numeric_limits<float>::max())
+    {
+        if (type != TriangleIndices::List && type != TriangleIndices::Fan && type != TriangleIndices::Strip)
+        {
+            std::cerr << "Failed to simplify a geometry, it does not consist of triangles." << std::endl;
+            std::exit(-1);
+        }
+
+        TriangleIndices source_triangles{type, indices};
+        std::vector<std::array<unsigned int, 3>> triangles(source_triangles.size());
+        for (size_t triangle = 0; triangle < triangles.size(); ++triangle)
+        {
+            auto &corners = triangles[triangle];
+            source_triangles.get(triangle, corners[0], corners[1], corners[2]);
+            if (type == TriangleIndices::Strip && triangle % 2 == 1)
+            {
+                std::swap(corners[1], corners[2]);
+            }
+        }
+
+        size_t vertex_count = vertices.size();
+        std::vector<Quadric> quadrics(vertex_count);
+        std::vector<std::vector<uint32_t>> vertex_triangles(vertex_count);
+        std::unordered_map<uint64_t, unsigned int> edge_triangle_counts;
+        std::vector<bool> removed_triangles(triangles.size(), false);
+        size_t triangle_count = triangles.size();
+        for (size_t triangle = 0; triangle < triangles.size(); ++triangle)
+        {
+            const auto &corners = triangles[triangle];
+            if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+            {
+                removed_triangles[triangle] = true;
+                --triangle_count;
+                continue;
+            }
+
+            const glm::vec3 &a = vertices[corners[0]].position;
+            glm::vec3 normal = glm::cross(vertices[corners[2]].position - a, vertices[corners[1]].position - a);
+            float length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                normal /= length;
+            }
+            Quadric quadric = Quadric::from_plane(normal, -glm::dot(normal, a), length * 0.5f);
+            for (size_t i = 0; i < 3; ++i)
+            {
+                unsigned int from = corners[i];
+                unsigned int to = corners[(i + 1) % 3];
+                quadrics[from] += quadric;
+                vertex_triangles[from].push_back(static_cast<uint32_t>(triangle));
+                ++edge_triangle_counts[(static_cast<uint64_t>(std::min(from, to)) << 32u) | std::max(from, to)];
+            }
+        }
+
+        std::vector<bool> locked_vertices(vertex_count, false);
+        for (const auto &[edge, count] : edge_triangle_counts)
+        {
+            if (count != 2)
+            {
+                locked_vertices[static_cast<size_t>(edge >> 32u)] = true;
+                locked_vertices[static_cast<size_t>(edge & 0xFFFFFFFFu)] = true;
+            }
+        }
+
+        struct Collapse
+        {
+            double error;
+            unsigned int from;
+            unsigned int to;
+            unsigned int from_version;
+            unsigned int to_version;
+
+            bool operator>(const Collapse &other) const
+            {
+                return error > other.error;
+            }
+        };
+
+        std::vector<bool> removed_vertices(vertex_count, false);
+        std::vector<unsigned int> versions(vertex_count, 0);
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses;
+        auto add_collapse = [&](unsigned int a, unsigned int b) {
+            Quadric quadric = quadrics[a];
+            quadric += quadrics[b];
+            double a_error = locked_vertices[a] ? std::numeric_limits<double>::infinity() : quadric.evaluate(vertices[b].position);
+            double b_error = locked_vertices[b] ? std::numeric_limits<double>::infinity() : quadric.evaluate(vertices[a].position);
+            if (a_error <= b_error && !locked_vertices[a])
+            {
+                collapses.push(Collapse{std::max(a_error, 0.0), a, b, versions[a], versions[b]});
+            }
+            else if (!locked_vertices[b])
+            {
+                collapses.push(Collapse{std::max(b_error, 0.0), b, a, versions[b], versions[a]});
+            }
+        };
+        for (const auto &entry : edge_triangle_counts)
+        {
+            add_collapse(static_cast<unsigned int>(entry.first >> 32u), static_cast<unsigned int>(entry.first & 0xFFFFFFFFu));
+        }
+
+        auto flips = [&](unsigned int from, unsigned int to) {
+            const glm::vec3 &target = vertices[to].position;
+            for (uint32_t triangle : vertex_triangles[from])
+            {
+                const auto &corners = triangles[triangle];
+                if (removed_triangles[triangle] || corners[0] == to || corners[1] == to || corners[2] == to)
+                {
+                    continue;
+                }
+
+                glm::vec3 positions[3];
+                glm::vec3 collapsed_positions[3];
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    positions[i] = vertices[corners[i]].position;
+                    collapsed_positions[i] = corners[i] == from ? target : positions[i];
+                }
+                glm::vec3 normal = glm::cross(positions[2] - positions[0], positions[1] - positions[0]);
+                glm::vec3 collapsed_normal = glm::cross(collapsed_positions[2] - collapsed_positions[0],
+                                                        collapsed_positions[1] - collapsed_positions[0]);
+                if (glm::dot(normal, collapsed_normal) <= 0.0f)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        double squared_max_error = static_cast<double>(max_error) * static_cast<double>(max_error);
+        while (triangle_count * 3 > target_index_count && !collapses.empty())
+        {
+            Collapse collapse = collapses.top();
+            collapses.pop();
+            if (removed_vertices[collapse.from] || removed_vertices[collapse.to] ||
+                versions[collapse.from] != collapse.from_version || versions[collapse.to] != collapse.to_version)
+            {
+                continue;
+            }
+            if (collapse.error > squared_max_error)
+            {
+                break;
+            }
+            if (flips(collapse.from, collapse.to))
+            {
+                continue;
+            }
+
+            auto &target_triangles = vertex_triangles[collapse.to];
+            for (uint32_t triangle : vertex_triangles[collapse.from])
+            {
+                auto &corners = triangles[triangle];
+                if (removed_triangles[triangle])
+                {
+                    continue;
+                }
+                if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+                {
+                    removed_triangles[triangle] = true;
+                    --triangle_count;
+                    continue;
+                }
+
+                std::replace(corners.begin(), corners.end(), collapse.from, collapse.to);
+                target_triangles.push_back(triangle);
+            }
+            target_triangles.erase(std::remove_if(target_triangles.begin(), target_triangles.end(), [&](uint32_t triangle) {
+                return removed_triangles[triangle];
+            }), target_triangles.end());
+            vertex_triangles[collapse.from].clear();
+            removed_vertices[collapse.from] = true;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            ++versions[collapse.to];
+
+            for (uint32_t triangle : target_triangles)
+            {
+                for (unsigned int corner : triangles[triangle])
+                {
+                    if (corner != collapse.to)
+                    {
+                        add_collapse(collapse.to, corner);
+                    }
+                }
+            }
+        }
+
+        std::vector<unsigned int> remap(vertex_count, std::numeric_limits<unsigned int>::max());
+        std::vector<unsigned int> simplified_indices;
+        std::vector<Vertex> simplified_vertices;
+        simplified_indices.reserve(triangle_count * 3);
+        for (size_t triangle = 0; triangle < triangles.size(); ++triangle)
+        {
+            if (removed_triangles[triangle])
+            {
+                continue;
+            }
+            for (unsigned int corner : triangles[triangle])
+            {
+                if (remap[corner] == std::numeric_limits<unsigned int>::max())
+                {
+                    remap[corner] = static_cast<unsigned int>(simplified_vertices.size());
+                    simplified_vertices.push_back(vertices[corner]);
+                }
+                simplified_indices.push_back(remap[corner]);
+            }
+        }
+
+        return std::make_pair(std::move(simplified_indices), std::move(simplified_vertices));
+    }
+}
+
+#endif
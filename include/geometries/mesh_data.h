@@ -0,0 +1,246 @@
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#include "geometries/vertex_layout.h"
+#include "utilities/mapped_file.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace asr
+{
+    // Indices and packed vertices stored the way the GPU reads them. The blobs point straight into a
+    // memory-mapped mesh file, so they are handed to the buffer uploads without being copied on the CPU side,
+    // and the mapping is released together with this object.
+    //
+    // A mesh file starts with a 64 byte little-endian header: the identifier, the version, the geometry type,
+    // the number of layout elements, the vertex stride, the vertex and index counts, the bounding box and the
+    // offsets of the index and vertex blobs. The layout elements follow as four 32-bit values each (attribute,
+    // component count, component type and offset), then the 32-bit indices and the packed vertices, both
+    // aligned to 16 bytes. Quantised layouts, like VertexLayout::create_compact(), are stored as they are.
+    class MeshData
+    {
+    public:
+        static std::shared_ptr<MeshData> read_mesh_file(const std::string &path)
+        {
+            auto mesh_data = std::make_shared<MeshData>();
+            if (!mesh_data->open_mesh_file(path))
+            {
+                std::exit(-1);
+            }
+
+            return mesh_data;
+        }
+
+        static bool write_mesh_file(const std::string &path, unsigned int type, const VertexLayout &vertex_layout,
+                                    const glm::vec3 &minimum, const glm::vec3 &maximum,
+                                    const unsigned int *indices, size_t index_count,
+                                    const uint8_t *packed_vertices, size_t vertex_count)
+        {
+            const auto &elements = vertex_layout.get_elements();
+            size_t index_offset = _align(HEADER_SIZE + elements.size() * ELEMENT_SIZE);
+            size_t vertex_offset = _align(index_offset + index_count * sizeof(uint32_t));
+
+            std::vector<uint8_t> header(index_offset, 0);
+            std::memcpy(header.data(), IDENTIFIER, sizeof(IDENTIFIER));
+            _write_uint32(header.data() + 4, VERSION);
+            _write_uint32(header.data() + 8, type);
+            _write_uint32(header.data() + 12, static_cast<uint32_t>(elements.size()));
+            _write_uint32(header.data() + 16, static_cast<uint32_t>(vertex_layout.get_stride()));
+            _write_uint32(header.data() + 20, static_cast<uint32_t>(vertex_count));
+            _write_uint32(header.data() + 24, static_cast<uint32_t>(index_count));
+            std::memcpy(header.data() + 28, glm::value_ptr(minimum), 3 * sizeof(float));
+            std::memcpy(header.data() + 40, glm::value_ptr(maximum), 3 * sizeof(float));
+            _write_uint32(header.data() + 52, static_cast<uint32_t>(index_offset));
+            _write_uint32(header.data() + 56, static_cast<uint32_t>(vertex_offset));
+            for (size_t i = 0; i < elements.size(); ++i)
+            {
+                uint8_t *element = header.data() + HEADER_SIZE + i * ELEMENT_SIZE;
+                _write_uint32(element, static_cast<uint32_t>(elements[i].attribute));
+                _write_uint32(element + 4, elements[i].component_count);
+                _write_uint32(element + 8, static_cast<uint32_t>(elements[i].component_type));
+                _write_uint32(element + 12, static_cast<uint32_t>(elements[i].offset));
+            }
+
+            std::ofstream file_stream{path, std::ios::binary};
+            if (!file_stream.is_open())
+            {
+                std::cerr << "Failed to open the file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            std::vector<uint8_t> padding(vertex_offset - index_offset - index_count * sizeof(uint32_t), 0);
+            file_stream.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+            file_stream.write(reinterpret_cast<const char *>(indices), static_cast<std::streamsize>(index_count * sizeof(uint32_t)));
+            file_stream.write(reinterpret_cast<const char *>(padding.data()), static_cast<std::streamsize>(padding.size()));
+            file_stream.write(reinterpret_cast<const char *>(packed_vertices),
+                              static_cast<std::streamsize>(vertex_count * vertex_layout.get_stride()));
+            if (!file_stream)
+            {
+                std::cerr << "Failed to write the file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            return true;
+        }
+
+        bool open_mesh_file(const std::string &path)
+        {
+            _index_data = nullptr;
+            _vertex_data = nullptr;
+            if (!_file.open(path))
+            {
+                std::cerr << "Failed to open the file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            const uint8_t *data = _file.get_data();
+            size_t size = _file.get_size();
+            if (size < HEADER_SIZE || std::memcmp(data, IDENTIFIER, sizeof(IDENTIFIER)) != 0 ||
+                _read_uint32(data + 4) != VERSION)
+            {
+                std::cerr << "Invalid mesh file: '" << path << "'" << std::endl;
+                _file.close();
+                return false;
+            }
+
+            _type = _read_uint32(data + 8);
+            uint32_t element_count = _read_uint32(data + 12);
+            uint32_t stride = _read_uint32(data + 16);
+            _vertex_count = _read_uint32(data + 20);
+            _index_count = _read_uint32(data + 24);
+            std::memcpy(glm::value_ptr(_minimum), data + 28, 3 * sizeof(float));
+            std::memcpy(glm::value_ptr(_maximum), data + 40, 3 * sizeof(float));
+            size_t index_offset = _read_uint32(data + 52);
+            size_t vertex_offset = _read_uint32(data + 56);
+
+            _vertex_layout = VertexLayout{};
+            bool valid_layout = HEADER_SIZE + element_count * ELEMENT_SIZE <= size;
+            for (uint32_t i = 0; valid_layout && i < element_count; ++i)
+            {
+                const uint8_t *element = data + HEADER_SIZE + i * ELEMENT_SIZE;
+                uint32_t attribute = _read_uint32(element);
+                uint32_t component_type = _read_uint32(element + 8);
+                valid_layout = attribute < VertexLayout::AttributeCount && component_type <= VertexLayout::NormalizedByte;
+                if (valid_layout)
+                {
+                    _vertex_layout.add(static_cast<VertexLayout::Attribute>(attribute), _read_uint32(element + 4),
+                                       static_cast<VertexLayout::ComponentType>(component_type));
+                    valid_layout = _vertex_layout.get_elements().back().offset == _read_uint32(element + 12);
+                }
+            }
+            if (!valid_layout || _vertex_layout.get_stride() != stride)
+            {
+                std::cerr << "Unsupported vertex layout in the mesh file: '" << path << "'" << std::endl;
+                _file.close();
+                return false;
+            }
+
+            if (index_offset % BLOB_ALIGNMENT != 0 || vertex_offset % BLOB_ALIGNMENT != 0 ||
+                index_offset + static_cast<size_t>(_index_count) * sizeof(uint32_t) > size ||
+                vertex_offset + static_cast<size_t>(_vertex_count) * stride > size)
+            {
+                std::cerr << "Truncated mesh file: '" << path << "'" << std::endl;
+                _file.close();
+                return false;
+            }
+
+            _index_data = reinterpret_cast<const unsigned int *>(data + index_offset);
+            _vertex_data = data + vertex_offset;
+
+            return true;
+        }
+
+        [[nodiscard]] unsigned int get_type() const
+        {
+            return _type;
+        }
+
+        [[nodiscard]] const VertexLayout &get_vertex_layout() const
+        {
+            return _vertex_layout;
+        }
+
+        [[nodiscard]] const glm::vec3 &get_minimum() const
+        {
+            return _minimum;
+        }
+
+        [[nodiscard]] const glm::vec3 &get_maximum() const
+        {
+            return _maximum;
+        }
+
+        [[nodiscard]] const unsigned int *get_index_data() const
+        {
+            return _index_data;
+        }
+
+        [[nodiscard]] size_t get_index_count() const
+        {
+            return _index_count;
+        }
+
+        [[nodiscard]] const uint8_t *get_vertex_data() const
+        {
+            return _vertex_data;
+        }
+
+        [[nodiscard]] size_t get_vertex_count() const
+        {
+            return _vertex_count;
+        }
+
+        [[nodiscard]] size_t get_vertex_data_size() const
+        {
+            return _vertex_count * _vertex_layout.get_stride();
+        }
+
+    private:
+        inline static const uint8_t IDENTIFIER[4]{'A', 'S', 'R', 'M'};
+        inline static const uint32_t VERSION = 1;
+        inline static const size_t HEADER_SIZE = 64;
+        inline static const size_t ELEMENT_SIZE = 16;
+        inline static const size_t BLOB_ALIGNMENT = 16;
+
+        MappedFile _file;
+
+        unsigned int _type{0};
+        VertexLayout _vertex_layout;
+        glm::vec3 _minimum{0.0f};
+        glm::vec3 _maximum{0.0f};
+        const unsigned int *_index_data{nullptr};
+        size_t _index_count{0};
+        const uint8_t *_vertex_data{nullptr};
+        size_t _vertex_count{0};
+
+        static size_t _align(size_t offset)
+        {
+            return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+        }
+
+        static uint32_t _read_uint32(const uint8_t *data)
+        {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+
+            return value;
+        }
+
+        static void _write_uint32(uint8_t *data, uint32_t value)
+        {
+            std::memcpy(data, &value, sizeof(value));
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,367 @@
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include "math/ray.h"
+#include "utilities/job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // A bounding volume hierarchy over the triangles of a geometry for exact ray queries. It is built once
+    // with binned surface area splits and stores the triangles in leaf order, so a query reads them without
+    // going through the indices. Queries visit the nearer child first and skip every node farther away than
+    // the nearest hit so far. The hierarchy is not changed by queries, so any number of threads can query it
+    // at the same time.
+    class TriangleBVH
+    {
+    public:
+        inline static const size_t LEAF_TRIANGLE_COUNT = 4;
+        inline static const size_t BIN_COUNT = 12;
+        inline static const size_t MAX_DEPTH = 62;
+
+        struct Hit
+        {
+            bool hit{false};
+            float distance{INFINITY};
+            // The index of the triangle in the indices the hierarchy was built from, counted in triangles.
+            size_t triangle{0};
+            glm::vec2 barycentric_coordinates{0.0f};
+        };
+
+        TriangleBVH() = default;
+
+        TriangleBVH(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices)
+        {
+            build(positions, indices);
+        }
+
+        // The indices hold three vertices per triangle. Triangles that refer past the positions are left out.
+        void build(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices)
+        {
+            _nodes.clear();
+            _triangles.clear();
+            _triangle_ids.clear();
+
+            std::vector<Triangle> triangles;
+            std::vector<uint32_t> triangle_ids;
+            triangles.reserve(indices.size() / 3);
+            triangle_ids.reserve(indices.size() / 3);
+            for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                if (indices[i] < positions.size() && indices[i + 1] < positions.size() && indices[i + 2] < positions.size())
+                {
+                    triangles.push_back(Triangle{positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]]});
+                    triangle_ids.push_back(static_cast<uint32_t>(i / 3));
+                }
+            }
+            if (triangles.empty())
+            {
+                return;
+            }
+
+            std::vector<glm::vec3> centroids(triangles.size());
+            std::vector<uint32_t> order(triangles.size());
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                centroids[i] = (triangles[i].a + triangles[i].b + triangles[i].c) / 3.0f;
+                order[i] = static_cast<uint32_t>(i);
+            }
+
+            struct Task
+            {
+                uint32_t node;
+                uint32_t begin;
+                uint32_t end;
+                uint32_t depth;
+            };
+
+            _nodes.reserve(2 * (triangles.size() / LEAF_TRIANGLE_COUNT) + 1);
+            _nodes.emplace_back();
+            std::vector<Task> tasks{{0, 0, static_cast<uint32_t>(triangles.size()), 0}};
+            while (!tasks.empty())
+            {
+                Task task = tasks.back();
+                tasks.pop_back();
+
+                glm::vec3 minimum{INFINITY};
+                glm::vec3 maximum{-INFINITY};
+                glm::vec3 centroid_minimum{INFINITY};
+                glm::vec3 centroid_maximum{-INFINITY};
+                for (uint32_t i = task.begin; i < task.end; ++i)
+                {
+                    const Triangle &triangle = triangles[order[i]];
+                    minimum = glm::min(minimum, glm::min(triangle.a, glm::min(triangle.b, triangle.c)));
+                    maximum = glm::max(maximum, glm::max(triangle.a, glm::max(triangle.b, triangle.c)));
+                    centroid_minimum = glm::min(centroid_minimum, centroids[order[i]]);
+                    centroid_maximum = glm::max(centroid_maximum, centroids[order[i]]);
+                }
+                _nodes[task.node].minimum = minimum;
+                _nodes[task.node].maximum = maximum;
+
+                uint32_t count = task.end - task.begin;
+                glm::vec3 extent = centroid_maximum - centroid_minimum;
+                int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+                if (count <= LEAF_TRIANGLE_COUNT || task.depth >= MAX_DEPTH || !(extent[axis] > 0.0f))
+                {
+                    _nodes[task.node].first = task.begin;
+                    _nodes[task.node].count = count;
+                    continue;
+                }
+
+                uint32_t middle = _partition(triangles, centroids, order, task.begin, task.end, axis,
+                                             centroid_minimum[axis], extent[axis]);
+
+                auto left = static_cast<uint32_t>(_nodes.size());
+                _nodes.emplace_back();
+                _nodes.emplace_back();
+                _nodes[task.node].first = left;
+                _nodes[task.node].count = 0;
+                tasks.push_back(Task{left + 1, middle, task.end, task.depth + 1});
+                tasks.push_back(Task{left, task.begin, middle, task.depth + 1});
+            }
+
+            _triangles.reserve(triangles.size());
+            _triangle_ids.reserve(triangles.size());
+            for (uint32_t index : order)
+            {
+                _triangles.push_back(triangles[index]);
+                _triangle_ids.push_back(triangle_ids[index]);
+            }
+        }
+
+        [[nodiscard]] size_t get_triangle_count() const
+        {
+            return _triangles.size();
+        }
+
+        [[nodiscard]] size_t get_node_count() const
+        {
+            return _nodes.size();
+        }
+
+        [[nodiscard]] bool is_empty() const
+        {
+            return _nodes.empty();
+        }
+
+        // The nearest hit closer than the maximum distance. Distances are measured in the units of the ray
+        // direction, like the other ray tests.
+        [[nodiscard]] Hit raycast(const Ray &ray, float maximum_distance = INFINITY) const
+        {
+            Hit hit;
+            hit.distance = maximum_distance;
+            if (_nodes.empty())
+            {
+                return hit;
+            }
+
+            const glm::vec3 &origin = ray.get_origin();
+            const glm::vec3 &direction = ray.get_direction();
+            glm::vec3 inverse_direction{1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z};
+
+            // Every level pops one node and pushes at most two, so the depth bounds the stack.
+            uint32_t stack[MAX_DEPTH + 2];
+            size_t stack_size{0};
+            if (_intersect_node(_nodes[0], origin, inverse_direction) < hit.distance)
+            {
+                stack[stack_size++] = 0;
+            }
+            while (stack_size > 0)
+            {
+                const Node &node = _nodes[stack[--stack_size]];
+                if (node.count > 0)
+                {
+                    for (uint32_t i = node.first; i < node.first + node.count; ++i)
+                    {
+                        const Triangle &triangle = _triangles[i];
+                        glm::vec2 barycentric_coordinates;
+                        auto [intersects, distance] = ray.intersects_with_triangle(triangle.a, triangle.b, triangle.c,
+                                                                                   barycentric_coordinates);
+                        if (intersects && distance < hit.distance)
+                        {
+                            hit.hit = true;
+                            hit.distance = distance;
+                            hit.triangle = _triangle_ids[i];
+                            hit.barycentric_coordinates = barycentric_coordinates;
+                        }
+                    }
+                    continue;
+                }
+
+                uint32_t near_child = node.first;
+                uint32_t far_child = node.first + 1;
+                float near_distance = _intersect_node(_nodes[near_child], origin, inverse_direction);
+                float far_distance = _intersect_node(_nodes[far_child], origin, inverse_direction);
+                if (far_distance < near_distance)
+                {
+                    std::swap(near_child, far_child);
+                    std::swap(near_distance, far_distance);
+                }
+                // The stack is read from the back, so the far child goes in first.
+                if (far_distance < hit.distance)
+                {
+                    stack[stack_size++] = far_child;
+                }
+                if (near_distance < hit.distance)
+                {
+                    stack[stack_size++] = near_child;
+                }
+            }
+
+            return hit;
+        }
+
+        // Answers many rays at once, in ranges across the job system when one is given.
+        void raycast(const std::vector<Ray> &rays, std::vector<Hit> &hits, JobSystem *job_system = nullptr) const
+        {
+            hits.resize(rays.size());
+            auto raycast_range = [this, &rays, &hits](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    hits[i] = raycast(rays[i]);
+                }
+            };
+
+            if (job_system != nullptr)
+            {
+                job_system->parallel_for(rays.size(), RAY_GRAIN_SIZE, raycast_range);
+            }
+            else
+            {
+                raycast_range(0, rays.size());
+            }
+        }
+
+    private:
+        inline static const size_t RAY_GRAIN_SIZE = 64;
+
+        // Interior nodes keep their children next to each other starting at first. Leaves keep count triangles
+        // starting at first.
+        struct Node
+        {
+            glm::vec3 minimum{0.0f};
+            uint32_t first{0};
+            glm::vec3 maximum{0.0f};
+            uint32_t count{0};
+        };
+
+        struct Triangle
+        {
+            glm::vec3 a;
+            glm::vec3 b;
+            glm::vec3 c;
+        };
+
+        std::vector<Node> _nodes;
+        std::vector<Triangle> _triangles;
+        std::vector<uint32_t> _triangle_ids;
+
+        // The distance at which the ray enters the node, or infinity if it misses it.
+        static float _intersect_node(const Node &node, const glm::vec3 &origin, const glm::vec3 &inverse_direction)
+        {
+            float near_distance = 0.0f;
+            float far_distance = INFINITY;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float first = (node.minimum[axis] - origin[axis]) * inverse_direction[axis];
+                float second = (node.maximum[axis] - origin[axis]) * inverse_direction[axis];
+                near_distance = fmaxf(near_distance, fminf(first, second));
+                far_distance = fminf(far_distance, fmaxf(first, second));
+            }
+
+            return near_distance <= far_distance ? near_distance : INFINITY;
+        }
+
+        static float _area(const glm::vec3 &minimum, const glm::vec3 &maximum)
+        {
+            glm::vec3 extent = glm::max(maximum - minimum, glm::vec3{0.0f});
+
+            return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+        }
+
+        // Sorts the centroids of the range into bins along the axis, splits where the surface area heuristic is
+        // lowest and returns the first triangle of the right side. Ranges that do not split fall back to the
+        // median.
+        static uint32_t _partition(const std::vector<Triangle> &triangles, const std::vector<glm::vec3> &centroids,
+                                   std::vector<uint32_t> &order, uint32_t begin, uint32_t end, int axis,
+                                   float centroid_minimum, float centroid_extent)
+        {
+            struct Bin
+            {
+                glm::vec3 minimum{INFINITY};
+                glm::vec3 maximum{-INFINITY};
+                uint32_t count{0};
+            };
+
+            Bin bins[BIN_COUNT];
+            float bin_scale = static_cast<float>(BIN_COUNT) / centroid_extent;
+            auto get_bin = [&](uint32_t index) {
+                auto bin = static_cast<size_t>((centroids[index][axis] - centroid_minimum) * bin_scale);
+                return std::min(bin, BIN_COUNT - 1);
+            };
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                const Triangle &triangle = triangles[order[i]];
+                Bin &bin = bins[get_bin(order[i])];
+                bin.minimum = glm::min(bin.minimum, glm::min(triangle.a, glm::min(triangle.b, triangle.c)));
+                bin.maximum = glm::max(bin.maximum, glm::max(triangle.a, glm::max(triangle.b, triangle.c)));
+                ++bin.count;
+            }
+
+            float right_costs[BIN_COUNT];
+            glm::vec3 minimum{INFINITY};
+            glm::vec3 maximum{-INFINITY};
+            uint32_t count{0};
+            for (size_t i = BIN_COUNT - 1; i > 0; --i)
+            {
+                minimum = glm::min(minimum, bins[i].minimum);
+                maximum = glm::max(maximum, bins[i].maximum);
+                count += bins[i].count;
+                right_costs[i] = static_cast<float>(count) * _area(minimum, maximum);
+            }
+
+            size_t best_split{0};
+            float best_cost{INFINITY};
+            minimum = glm::vec3{INFINITY};
+            maximum = glm::vec3{-INFINITY};
+            count = 0;
+            for (size_t split = 1; split < BIN_COUNT; ++split)
+            {
+                minimum = glm::min(minimum, bins[split - 1].minimum);
+                maximum = glm::max(maximum, bins[split - 1].maximum);
+                count += bins[split - 1].count;
+                float cost = static_cast<float>(count) * _area(minimum, maximum) + right_costs[split];
+                if (count > 0 && count < end - begin && cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_split = split;
+                }
+            }
+
+            if (best_split != 0)
+            {
+                auto middle = std::partition(order.begin() + begin, order.begin() + end, [&](uint32_t index) {
+                    return get_bin(index) < best_split;
+                });
+
+                return static_cast<uint32_t>(middle - order.begin());
+            }
+
+            uint32_t middle = begin + (end - begin) / 2;
+            std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                             [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+            return middle;
+        }
+    };
+}
+
+#endif
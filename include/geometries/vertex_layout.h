@@ -0,0 +1,440 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include "geometries/vertex.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+
+namespace asr
+{
+    class VertexLayout
+    {
+    public:
+        enum Attribute
+        {
+            Position,
+            Color,
+            Normal,
+            Tangent,
+            Binormal,
+            Texture1Coordinates,
+            Texture2Coordinates,
+            AttributeCount
+        };
+
+        enum InstanceAttribute
+        {
+            InstanceIndex = AttributeCount,
+            InstanceModelMatrix,
+            InstanceColor = InstanceModelMatrix + 4,
+            InstanceTextureRegion,
+            InstanceAttributeEnd
+        };
+
+        enum AttributeMask : unsigned int
+        {
+            PositionAttribute = 1u << Position,
+            ColorAttribute = 1u << Color,
+            NormalAttribute = 1u << Normal,
+            TangentAttribute = 1u << Tangent,
+            BinormalAttribute = 1u << Binormal,
+            Texture1CoordinatesAttribute = 1u << Texture1Coordinates,
+            Texture2CoordinatesAttribute = 1u << Texture2Coordinates,
+            AllAttributes = (1u << AttributeCount) - 1u
+        };
+
+        enum ComponentType
+        {
+            Float,
+            HalfFloat,
+            NormalizedUnsignedByte,
+            NormalizedByte
+        };
+
+        struct Element
+        {
+            Attribute attribute;
+            unsigned int component_count;
+            ComponentType component_type;
+            size_t offset;
+        };
+
+        VertexLayout() = default;
+
+        static VertexLayout create_default()
+        {
+            VertexLayout layout;
+            layout.add(Position, 3, Float)
+                .add(Color, 4, Float)
+                .add(Normal, 3, Float)
+                .add(Tangent, 4, Float)
+                .add(Binormal, 3, Float)
+                .add(Texture1Coordinates, 4, Float)
+                .add(Texture2Coordinates, 4, Float);
+
+            return layout;
+        }
+
+        static VertexLayout create_compact(unsigned int attributes)
+        {
+            VertexLayout layout;
+            if ((attributes & PositionAttribute) != 0)
+            {
+                layout.add(Position, 3, Float);
+            }
+            if ((attributes & ColorAttribute) != 0)
+            {
+                layout.add(Color, 4, NormalizedUnsignedByte);
+            }
+            if ((attributes & NormalAttribute) != 0)
+            {
+                layout.add(Normal, 3, NormalizedByte);
+            }
+            if ((attributes & TangentAttribute) != 0)
+            {
+                layout.add(Tangent, 4, NormalizedByte);
+            }
+            if ((attributes & BinormalAttribute) != 0)
+            {
+                layout.add(Binormal, 3, NormalizedByte);
+            }
+            if ((attributes & Texture1CoordinatesAttribute) != 0)
+            {
+                layout.add(Texture1Coordinates, 2, Float);
+            }
+            if ((attributes & Texture2CoordinatesAttribute) != 0)
+            {
+                layout.add(Texture2Coordinates, 2, Float);
+            }
+
+            return layout;
+        }
+
+        VertexLayout &add(Attribute attribute, unsigned int component_count, ComponentType component_type)
+        {
+            component_count = std::max(1u, std::min(component_count, get_max_component_count(attribute)));
+
+            _elements.push_back(Element{attribute, component_count, component_type, _stride});
+            _stride += _align(component_count * get_component_size(component_type));
+            _attributes |= 1u << attribute;
+
+            return *this;
+        }
+
+        [[nodiscard]] const std::vector<Element> &get_elements() const
+        {
+            return _elements;
+        }
+
+        [[nodiscard]] size_t get_stride() const
+        {
+            return _stride;
+        }
+
+        [[nodiscard]] unsigned int get_attributes() const
+        {
+            return _attributes;
+        }
+
+        [[nodiscard]] bool has(Attribute attribute) const
+        {
+            return (_attributes & (1u << attribute)) != 0;
+        }
+
+        // Packs the vertices from first_vertex up to last_vertex, the first of them at the start of the
+        // destination.
+        void pack(const std::vector<Vertex> &vertices, size_t first_vertex, size_t last_vertex, uint8_t *destination) const
+        {
+            for (size_t i = first_vertex; i < last_vertex; ++i)
+            {
+                const Vertex &vertex = vertices[i];
+                uint8_t *vertex_destination = destination + (i - first_vertex) * _stride;
+                for (const auto &element : _elements)
+                {
+                    _pack_element(element, _get_source(vertex, element.attribute), vertex_destination + element.offset);
+                }
+            }
+        }
+
+        // Reads an attribute of a packed vertex back. Components and attributes the layout does not store are
+        // zero.
+        [[nodiscard]] glm::vec4 unpack(const uint8_t *packed_vertex, Attribute attribute) const
+        {
+            glm::vec4 value{0.0f};
+            for (const auto &element : _elements)
+            {
+                if (element.attribute == attribute)
+                {
+                    _unpack_element(element, packed_vertex + element.offset, glm::value_ptr(value));
+                    break;
+                }
+            }
+
+            return value;
+        }
+
+        bool operator==(const VertexLayout &other) const
+        {
+            if (_stride != other._stride || _elements.size() != other._elements.size())
+            {
+                return false;
+            }
+            for (size_t i = 0; i < _elements.size(); ++i)
+            {
+                const auto &a = _elements[i];
+                const auto &b = other._elements[i];
+                if (a.attribute != b.attribute || a.component_count != b.component_count ||
+                    a.component_type != b.component_type || a.offset != b.offset)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool operator!=(const VertexLayout &other) const
+        {
+            return !(*this == other);
+        }
+
+        static const char *get_attribute_name(Attribute attribute)
+        {
+            switch (attribute)
+            {
+            case Position:
+                return "position";
+            case Color:
+                return "color";
+            case Normal:
+                return "normal";
+            case Tangent:
+                return "tangent";
+            case Binormal:
+                return "binormal";
+            case Texture1Coordinates:
+                return "texture1_coordinates";
+            case Texture2Coordinates:
+                return "texture2_coordinates";
+            case AttributeCount:
+                break;
+            }
+
+            return "";
+        }
+
+        static const char *get_instance_attribute_name(InstanceAttribute instance_attribute)
+        {
+            switch (instance_attribute)
+            {
+            case InstanceIndex:
+                return "instance_index";
+            case InstanceModelMatrix:
+                return "instance_model_matrix";
+            case InstanceColor:
+                return "instance_color";
+            case InstanceTextureRegion:
+                return "instance_texture_region";
+            case InstanceAttributeEnd:
+                break;
+            }
+
+            return "";
+        }
+
+        static unsigned int get_max_component_count(Attribute attribute)
+        {
+            switch (attribute)
+            {
+            case Position:
+            case Normal:
+            case Binormal:
+                return 3;
+            case Color:
+            case Tangent:
+            case Texture1Coordinates:
+            case Texture2Coordinates:
+                return 4;
+            case AttributeCount:
+                break;
+            }
+
+            return 0;
+        }
+
+        static size_t get_component_size(ComponentType component_type)
+        {
+            switch (component_type)
+            {
+            case Float:
+                return sizeof(float);
+            case HalfFloat:
+                return sizeof(uint16_t);
+            case NormalizedUnsignedByte:
+                return sizeof(uint8_t);
+            case NormalizedByte:
+                return sizeof(int8_t);
+            }
+
+            return sizeof(float);
+        }
+
+        static uint16_t convert_float_to_half_float(float value)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            auto sign = static_cast<uint16_t>((bits >> 16u) & 0x8000u);
+            int32_t exponent = static_cast<int32_t>((bits >> 23u) & 0xFFu) - 127 + 15;
+            uint32_t mantissa = bits & 0x7FFFFFu;
+
+            if (exponent <= 0)
+            {
+                if (exponent < -10)
+                {
+                    return sign;
+                }
+                mantissa |= 0x800000u;
+                auto shift = static_cast<uint32_t>(14 - exponent);
+                return static_cast<uint16_t>(sign | (mantissa >> shift));
+            }
+            if (exponent >= 31)
+            {
+                bool is_nan = ((bits >> 23u) & 0xFFu) == 0xFFu && mantissa != 0;
+                return static_cast<uint16_t>(sign | 0x7C00u | (is_nan ? 0x200u : 0u));
+            }
+
+            return static_cast<uint16_t>(sign | (static_cast<uint32_t>(exponent) << 10u) | (mantissa >> 13u));
+        }
+
+        static float convert_half_float_to_float(uint16_t half)
+        {
+            uint32_t sign = (half & 0x8000u) << 16u;
+            uint32_t exponent = (half >> 10u) & 0x1Fu;
+            uint32_t mantissa = half & 0x3FFu;
+
+            uint32_t bits;
+            if (exponent == 0)
+            {
+                float value = std::ldexp(static_cast<float>(mantissa), -24);
+                return sign != 0 ? -value : value;
+            }
+            if (exponent == 31)
+            {
+                bits = sign | 0x7F800000u | (mantissa << 13u);
+            }
+            else
+            {
+                bits = sign | ((exponent + 127 - 15) << 23u) | (mantissa << 13u);
+            }
+
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+
+            return value;
+        }
+
+    private:
+        std::vector<Element> _elements;
+        size_t _stride{0};
+        unsigned int _attributes{0};
+
+        static size_t _align(size_t size)
+        {
+            return (size + 3u) & ~static_cast<size_t>(3u);
+        }
+
+        static const float *_get_source(const Vertex &vertex, Attribute attribute)
+        {
+            switch (attribute)
+            {
+            case Position:
+                return glm::value_ptr(vertex.position);
+            case Color:
+                return glm::value_ptr(vertex.color);
+            case Normal:
+                return glm::value_ptr(vertex.normal);
+            case Tangent:
+                return glm::value_ptr(vertex.tangent);
+            case Binormal:
+                return glm::value_ptr(vertex.binormal);
+            case Texture1Coordinates:
+                return glm::value_ptr(vertex.texture1_coordinates);
+            case Texture2Coordinates:
+                return glm::value_ptr(vertex.texture2_coordinates);
+            case AttributeCount:
+                break;
+            }
+
+            return glm::value_ptr(vertex.position);
+        }
+
+        static void _pack_element(const Element &element, const float *source, uint8_t *destination)
+        {
+            for (unsigned int i = 0; i < element.component_count; ++i)
+            {
+                switch (element.component_type)
+                {
+                case Float:
+                    std::memcpy(destination + i * sizeof(float), &source[i], sizeof(float));
+                    break;
+                case HalfFloat:
+                {
+                    uint16_t half = convert_float_to_half_float(source[i]);
+                    std::memcpy(destination + i * sizeof(uint16_t), &half, sizeof(uint16_t));
+                    break;
+                }
+                case NormalizedUnsignedByte:
+                    destination[i] = static_cast<uint8_t>(std::lround(std::clamp(source[i], 0.0f, 1.0f) * 255.0f));
+                    break;
+                case NormalizedByte:
+                {
+                    auto value = static_cast<int8_t>(std::lround(std::clamp(source[i], -1.0f, 1.0f) * 127.0f));
+                    std::memcpy(destination + i, &value, sizeof(int8_t));
+                    break;
+                }
+                }
+            }
+        }
+
+        static void _unpack_element(const Element &element, const uint8_t *source, float *destination)
+        {
+            for (unsigned int i = 0; i < element.component_count; ++i)
+            {
+                switch (element.component_type)
+                {
+                case Float:
+                    std::memcpy(&destination[i], source + i * sizeof(float), sizeof(float));
+                    break;
+                case HalfFloat:
+                {
+                    uint16_t half;
+                    std::memcpy(&half, source + i * sizeof(uint16_t), sizeof(uint16_t));
+                    destination[i] = convert_half_float_to_float(half);
+                    break;
+                }
+                case NormalizedUnsignedByte:
+                    destination[i] = static_cast<float>(source[i]) / 255.0f;
+                    break;
+                case NormalizedByte:
+                {
+                    int8_t value;
+                    std::memcpy(&value, source + i, sizeof(int8_t));
+                    destination[i] = std::max(static_cast<float>(value) / 127.0f, -1.0f);
+                    break;
+                }
+                }
+            }
+        }
+    };
+}
+
+#endif
@@ -5,11 +5,16 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cstddef>
+
 namespace asr
 {
     class DirectionalLight : public Light
     {
     public:
+        inline static const size_t MAX_SHADOW_CASCADE_COUNT = 4;
+
         const glm::vec3 &get_direction() const
         {
             return _direction;
@@ -26,9 +31,35 @@ namespace asr
             return _world_direction;
         }
 
+        // The view frustum is split into this many cascades up to the shadow distance, each with a shadow map
+        // of its own, so that the near cascades spend their texels on a small part of the scene.
+        size_t get_shadow_cascade_count() const
+        {
+            return _shadow_cascade_count;
+        }
+
+        void set_shadow_cascade_count(size_t shadow_cascade_count)
+        {
+            _shadow_cascade_count = std::clamp(shadow_cascade_count, static_cast<size_t>(1), MAX_SHADOW_CASCADE_COUNT);
+        }
+
+        // Fragments farther from the camera than this are not shadowed.
+        float get_shadow_distance() const
+        {
+            return _shadow_distance;
+        }
+
+        void set_shadow_distance(float shadow_distance)
+        {
+            _shadow_distance = shadow_distance;
+        }
+
     private:
         glm::vec3 _direction{0.0f, 1.0f, 0.0f};
         glm::vec3 _world_direction{0.0f, 1.0f, 0.0f};
+
+        size_t _shadow_cascade_count{3};
+        float _shadow_distance{50.0f};
     };
 }
 
@@ -5,6 +5,9 @@
 
 #include <glm/glm.hpp>
 
+#include <cmath>
+#include <algorithm>
+
 namespace asr
 {
     class Light : public Object
@@ -70,6 +73,62 @@ namespace asr
             _two_sided = two_sided;
         }
 
+        // Only directional and spot lights cast shadows, and only while the renderer has shadow mapping enabled.
+        bool is_casting_shadows() const
+        {
+            return _casting_shadows;
+        }
+
+        void set_casting_shadows(bool casting_shadows)
+        {
+            _casting_shadows = casting_shadows;
+        }
+
+        // Subtracted from the depth of a fragment before it is compared with the shadow map, in the depth range
+        // of the map, so that surfaces do not shadow themselves.
+        float get_shadow_bias() const
+        {
+            return _shadow_bias;
+        }
+
+        void set_shadow_bias(float shadow_bias)
+        {
+            _shadow_bias = shadow_bias;
+        }
+
+    protected:
+        // Beyond its influence radius a light adds less than this fraction of a fully lit color.
+        inline static const float INFLUENCE_THRESHOLD = 1.0f / 256.0f;
+
+        // Solves constant + linear * d + quadratic * d^2 = brightness / INFLUENCE_THRESHOLD for the distance,
+        // where the brightness is the strongest color channel the light can add. Lights that do not fall off
+        // reach as far as their culling range.
+        [[nodiscard]] float _calculate_influence_radius(float constant_attenuation, float linear_attenuation,
+                                                        float quadratic_attenuation, float culling_range) const
+        {
+            glm::vec3 color = _ambient_color + _diffuse_color + _specular_color;
+            float brightness = _intensity * std::max(color.r, std::max(color.g, color.b));
+            float attenuation = brightness / INFLUENCE_THRESHOLD;
+            if (attenuation <= constant_attenuation)
+            {
+                return 0.0f;
+            }
+
+            float radius = culling_range;
+            if (quadratic_attenuation > 0.0f)
+            {
+                float discriminant = linear_attenuation * linear_attenuation +
+                                     4.0f * quadratic_attenuation * (attenuation - constant_attenuation);
+                radius = (std::sqrt(discriminant) - linear_attenuation) / (2.0f * quadratic_attenuation);
+            }
+            else if (linear_attenuation > 0.0f)
+            {
+                radius = (attenuation - constant_attenuation) / linear_attenuation;
+            }
+
+            return std::min(radius, culling_range);
+        }
+
     private:
         bool _enabled{true};
 
@@ -80,6 +139,9 @@ namespace asr
         float _intensity{1.0f};
 
         bool _two_sided{false};
+
+        bool _casting_shadows{false};
+        float _shadow_bias{0.0005f};
     };
 }
 
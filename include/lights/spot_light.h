@@ -68,6 +68,12 @@ namespace asr
             _culling_range = culling_range;
         }
 
+        // The distance past which the light is too dim to matter, never farther than the culling range.
+        float get_influence_radius() const
+        {
+            return _calculate_influence_radius(_constant_attenuation, _linear_attenuation, _quadratic_attenuation, _culling_range);
+        }
+
         const glm::vec3 &get_direction() const
         {
             return _direction;
@@ -6,6 +6,9 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <iterator>
+
 namespace asr
 {
     class ConstantMaterial : public Material
@@ -19,6 +22,7 @@ namespace asr
         void set_emission_color(const glm::vec4 &emission_color)
         {
             _emission_color = emission_color;
+            _mark_changed();
         }
 
         [[nodiscard]] const std::shared_ptr<Texture> &get_texture_1() const
@@ -29,6 +33,7 @@ namespace asr
         void set_texture_1(const std::shared_ptr<Texture> &texture_1)
         {
             _texture1 = texture_1;
+            _mark_changed();
         }
 
         [[nodiscard]] const std::shared_ptr<Texture> &get_texture_2() const
@@ -39,6 +44,17 @@ namespace asr
         void set_texture_2(const std::shared_ptr<Texture> &texture_2)
         {
             _texture2 = texture_2;
+            _mark_changed();
+        }
+
+        [[nodiscard]] const Texture *get_primary_texture() const override
+        {
+            return _texture1.get();
+        }
+
+        ConstantMaterial *as_constant_material() final
+        {
+            return this;
         }
 
     protected:
@@ -46,6 +62,21 @@ namespace asr
 
         std::shared_ptr<Texture> _texture1;
         std::shared_ptr<Texture> _texture2;
+
+        unsigned int _texture_versions[2]{};
+
+        // Textures change their uniforms without the material, so their versions are compared on every update.
+        void _track_texture_versions()
+        {
+            unsigned int texture_versions[2]{
+                _texture1 ? _texture1->get_version() : 0u,
+                _texture2 ? _texture2->get_version() : 0u};
+            if (!std::equal(std::begin(texture_versions), std::end(texture_versions), std::begin(_texture_versions)))
+            {
+                std::copy(std::begin(texture_versions), std::end(texture_versions), std::begin(_texture_versions));
+                _mark_changed();
+            }
+        }
     };
 }
 
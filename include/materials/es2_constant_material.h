@@ -2,9 +2,12 @@
 #define ES2_CONSTANT_MATERIAL_H
 
 #include "materials/constant_material.h"
+#include "objects/es2_instanced_mesh.h"
+#include "renderer/frame_constants.h"
 
-#include "utilities/utilities.h"
 #include "renderer/es2_shader.h"
+#include "renderer/es2_shader_cache.h"
+#include "renderer/es2_state_cache.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
@@ -15,6 +18,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>
+#include <cstdint>
 
 namespace asr
 {
@@ -23,43 +28,11 @@ namespace asr
     public:
         ES2ConstantMaterial()
         {
-            std::string vertex_shader_source{file_utilities::read_text_file("data/shaders/es2_constant_shader.vert")};
-            std::string fragment_shader_source{file_utilities::read_text_file("data/shaders/es2_constant_shader.frag")};
-            std::vector<std::string> attributes{
-                "position",
-                "color",
-                "texture1_coordinates",
-                "texture2_coordinates"};
-            std::vector<std::string> uniforms{
-                "model_view_matrix",
-                "projection_matrix",
-                "emission_color",
-                "point_size",
-
-                "texture1_sampler",
-                "texture1_enabled",
-                "texture1_transformation_enabled",
-                "texture1_transformation_matrix",
-                "texturing_mode1",
-
-                "texture2_sampler",
-                "texture2_enabled",
-                "texture2_transformation_enabled",
-                "texture2_transformation_matrix",
-                "texturing_mode2",
-
-                "fog_enabled",
-                "fog_type",
-                "fog_depth",
-                "fog_color",
-                "fog_far_minus_near_plane",
-                "fog_far_plane",
-                "fog_density"};
-
-            _shader = std::make_shared<ES2Shader>(vertex_shader_source, fragment_shader_source, attributes, uniforms);
+            _acquire_shader();
         }
 
-        void update(std::shared_ptr<Scene> scene, std::shared_ptr<Mesh> mesh) final
+        void update(const FrameConstants &frame_constants, const glm::mat4 &world_matrix,
+                    const LightSelection & /* light_selection */) final
         {
             if (_shader->is_dead())
             {
@@ -72,90 +45,61 @@ namespace asr
                 {
                     return;
                 }
+                _shader->use();
             }
 
+            auto &state_cache = ES2StateCache::get_instance();
+
             if (!_prefer_line_width_from_geometry)
             {
-                glLineWidth(static_cast<GLfloat>(_line_width));
+                state_cache.set_line_width(_line_width);
             }
 
-            glDepthMask(static_cast<GLboolean>(_depth_mask_enabled));
+            state_cache.set_depth_mask_enabled(_depth_mask_enabled);
+            state_cache.set_depth_test_enabled(_depth_test_enabled);
             if (_depth_test_enabled)
             {
-                glEnable(GL_DEPTH_TEST);
-            }
-            else
-            {
-                glDisable(GL_DEPTH_TEST);
-            }
-            if (_depth_test_enabled)
-            {
-                glDepthFunc(_convert_depth_test_func_to_es2_depth_test_func(_depth_test_function));
+                state_cache.set_depth_function(_convert_depth_test_func_to_es2_depth_test_func(_depth_test_function));
             }
 
+            state_cache.set_blending_enabled(_blending_enabled);
             if (_blending_enabled)
             {
-                glEnable(GL_BLEND);
-            }
-            else
-            {
-                glDisable(GL_BLEND);
-            }
-            if (_blending_enabled)
-            {
-                glBlendEquationSeparate(_convert_blending_equation_to_es2_blending_equation(_color_blending_equation),
-                                        _convert_blending_equation_to_es2_blending_equation(_alpha_blending_equation));
-                glBlendFuncSeparate(_convert_blending_func_to_es2_blending_func(_source_color_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_destination_color_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_source_alpha_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_destination_alpha_blending_function));
-                glBlendColor(static_cast<GLclampf>(_blending_constant_color[0]),
-                             static_cast<GLclampf>(_blending_constant_color[1]),
-                             static_cast<GLclampf>(_blending_constant_color[2]),
-                             static_cast<GLclampf>(_blending_constant_color[3]));
+                state_cache.set_blending_equations(
+                    _convert_blending_equation_to_es2_blending_equation(_color_blending_equation),
+                    _convert_blending_equation_to_es2_blending_equation(_alpha_blending_equation));
+                state_cache.set_blending_functions(
+                    _convert_blending_func_to_es2_blending_func(_source_color_blending_function),
+                    _convert_blending_func_to_es2_blending_func(_destination_color_blending_function),
+                    _convert_blending_func_to_es2_blending_func(_source_alpha_blending_function),
+                    _convert_blending_func_to_es2_blending_func(_destination_alpha_blending_function));
+                state_cache.set_blending_constant_color(_blending_constant_color);
             }
 
+            state_cache.set_face_culling_enabled(_face_culling_enabled);
             if (_face_culling_enabled)
             {
-                glEnable(GL_CULL_FACE);
-            }
-            else
-            {
-                glDisable(GL_CULL_FACE);
-            }
-            if (_face_culling_enabled)
-            {
-                glCullFace(_convert_cull_face_mode_to_es2_cull_face_mode(_cull_face_mode));
-                glCullFace(_convert_front_face_order_to_es2_front_face_order(_front_face_order));
+                state_cache.set_cull_face_mode(_convert_cull_face_mode_to_es2_cull_face_mode(_cull_face_mode));
+                state_cache.set_front_face_order(_convert_front_face_order_to_es2_front_face_order(_front_face_order));
             }
 
+            state_cache.set_polygon_offset_enabled(_polygon_offset_enabled);
             if (_polygon_offset_enabled)
             {
-                glEnable(GL_POLYGON_OFFSET_FILL);
-            }
-            else
-            {
-                glDisable(GL_POLYGON_OFFSET_FILL);
-            }
-            if (_polygon_offset_enabled)
-            {
-                glPolygonOffset(static_cast<GLfloat>(_polygon_offset_factor),
-                                static_cast<GLfloat>(_polygon_offset_units));
+                state_cache.set_polygon_offset(_polygon_offset_factor, _polygon_offset_units);
             }
 
-            auto camera = scene->get_camera();
-
             glm::mat4 model_view_matrix;
             if (is_overlay())
             {
-                model_view_matrix = mesh->get_world_matrix();
+                model_view_matrix = world_matrix;
                 model_view_matrix[3][2] = 0.0f;
             }
             else
             {
-                model_view_matrix = camera->get_view_matrix() * mesh->get_world_matrix();
+                model_view_matrix = frame_constants.get_view_matrix() * world_matrix;
             }
-            int model_view_matrix_uniform_location{_shader->get_uniforms().at("model_view_matrix")};
+            int model_view_matrix_uniform_location{_shader->get_uniform_location(ModelViewMatrixUniform)};
             glUniformMatrix4fv(
                 model_view_matrix_uniform_location,
                 1, GL_FALSE,
@@ -164,115 +108,85 @@ namespace asr
             glm::mat4 projection_matrix;
             if (is_overlay())
             {
-                projection_matrix = camera->get_orthographic_projection_matrix();
+                projection_matrix = frame_constants.get_orthographic_projection_matrix();
             }
             else
             {
-                projection_matrix = camera->get_projection_matrix();
+                projection_matrix = frame_constants.get_projection_matrix();
             }
-            int projection_matrix_uniform_location{_shader->get_uniforms().at("projection_matrix")};
+            int projection_matrix_uniform_location{_shader->get_uniform_location(ProjectionMatrixUniform)};
             glUniformMatrix4fv(
                 projection_matrix_uniform_location,
                 1, GL_FALSE,
                 glm::value_ptr(projection_matrix));
 
-            if (_point_sizing_enabled && !_prefer_point_size_from_geometry)
+            // The uniforms of the material are only uploaded again when it changed or another material used the
+            // shader in between.
+            _track_texture_versions();
+            if (_shader->get_uploaded_material_version() != _version)
             {
-                int point_size_uniform_location{_shader->get_uniforms().at("point_size")};
-                glUniform1f(point_size_uniform_location, _point_size);
-            }
-
-            int emission_color_uniform_location{_shader->get_uniforms().at("emission_color")};
-            glUniform4fv(
-                emission_color_uniform_location,
-                1, glm::value_ptr(_emission_color));
+                if (_point_sizing_enabled && !_prefer_point_size_from_geometry)
+                {
+                    int point_size_uniform_location{_shader->get_uniform_location(PointSizeUniform)};
+                    glUniform1f(point_size_uniform_location, _point_size);
+                }
 
-            if (_texture1)
-            {
-                int texture1_enabled_uniform_location{_shader->get_uniforms().at("texture1_enabled")};
-                glUniform1i(
-                    texture1_enabled_uniform_location,
-                    static_cast<GLint>(_texture1->is_enabled()));
+                int emission_color_uniform_location{_shader->get_uniform_location(EmissionColorUniform)};
+                glUniform4fv(
+                    emission_color_uniform_location,
+                    1, glm::value_ptr(_emission_color));
 
-                if (_texture1->is_enabled())
+                if (_texture1 && _texture1->is_enabled())
                 {
-                    int texture1_sampler_uniform_location{_shader->get_uniforms().at("texture1_sampler")};
+                    int texture1_sampler_uniform_location{_shader->get_uniform_location(Texture1SamplerUniform)};
                     glUniform1i(texture1_sampler_uniform_location, 0);
 
-                    int texturing_mode1_uniform_location{_shader->get_uniforms().at("texturing_mode1")};
-                    glUniform1i(
-                        texturing_mode1_uniform_location,
-                        static_cast<GLint>(_texture1->get_mode()));
-
-                    int texture1_transformation_enabled_uniform_location{_shader->get_uniforms().at("texture1_transformation_enabled")};
-                    glUniform1i(
-                        texture1_transformation_enabled_uniform_location,
-                        static_cast<GLint>(_texture1->is_transformation_enabled()));
-
-                    int texture1_transformation_matrix_uniform_location{_shader->get_uniforms().at("texture1_transformation_matrix")};
+                    int texture1_transformation_matrix_uniform_location{_shader->get_uniform_location(Texture1TransformationMatrixUniform)};
                     glUniformMatrix4fv(
                         texture1_transformation_matrix_uniform_location,
                         1, GL_FALSE,
-                        glm::value_ptr(_texture1->get_transformation_matrix()));
+                        glm::value_ptr(_texture1->get_region_transformation_matrix()));
                 }
-            }
 
-            if (_texture2)
-            {
-                int texture2_enabled_uniform_location{_shader->get_uniforms().at("texture2_enabled")};
-                glUniform1i(
-                    texture2_enabled_uniform_location,
-                    static_cast<GLint>(_texture2->is_enabled()));
-
-                if (_texture2->is_enabled())
+                if (_texture2 && _texture2->is_enabled())
                 {
-                    int texture2_sampler_uniform_location{_shader->get_uniforms().at("texture2_sampler")};
+                    int texture2_sampler_uniform_location{_shader->get_uniform_location(Texture2SamplerUniform)};
                     glUniform1i(texture2_sampler_uniform_location, 1);
 
-                    int texturing_mode2_uniform_location{_shader->get_uniforms().at("texturing_mode2")};
-                    glUniform1i(
-                        texturing_mode2_uniform_location,
-                        static_cast<GLint>(_texture2->get_mode()));
-
-                    int texture2_transformation_enabled_uniform_location{_shader->get_uniforms().at("texture2_transformation_enabled")};
-                    glUniform1i(
-                        texture2_transformation_enabled_uniform_location,
-                        static_cast<GLint>(_texture2->is_transformation_enabled()));
-
-                    int texture2_transformation_matrix_uniform_location{_shader->get_uniforms().at("texture2_transformation_matrix")};
+                    int texture2_transformation_matrix_uniform_location{_shader->get_uniform_location(Texture2TransformationMatrixUniform)};
                     glUniformMatrix4fv(
                         texture2_transformation_matrix_uniform_location,
                         1, GL_FALSE,
-                        glm::value_ptr(_texture2->get_transformation_matrix()));
+                        glm::value_ptr(_texture2->get_region_transformation_matrix()));
                 }
-            }
-
-            int fog_enabled_uniform_location{_shader->get_uniforms().at("fog_enabled")};
-            glUniform1i(fog_enabled_uniform_location, static_cast<GLint>(_fog_enabled));
-
-            int fog_type_uniform_location{_shader->get_uniforms().at("fog_type")};
-            glUniform1i(fog_type_uniform_location, static_cast<GLint>(_fog_type));
 
-            int fog_depth_uniform_location{_shader->get_uniforms().at("fog_depth")};
-            glUniform1i(fog_depth_uniform_location, static_cast<GLint>(_fog_depth));
+                if (_fog_enabled)
+                {
+                    int fog_color_uniform_location{_shader->get_uniform_location(FogColorUniform)};
+                    glUniform3fv(
+                        fog_color_uniform_location,
+                        1, glm::value_ptr(_fog_color));
 
-            int fog_color_uniform_location{_shader->get_uniforms().at("fog_color")};
-            glUniform3fv(
-                fog_color_uniform_location,
-                1, glm::value_ptr(_fog_color));
+                    int fog_far_minus_near_plane_uniform_location{_shader->get_uniform_location(FogFarMinusNearPlaneUniform)};
+                    glUniform1f(fog_far_minus_near_plane_uniform_location, _fog_far_plane - _fog_near_plane);
 
-            int fog_far_minus_near_plane_uniform_location{_shader->get_uniforms().at("fog_far_minus_near_plane")};
-            glUniform1f(fog_far_minus_near_plane_uniform_location, _fog_far_plane - _fog_near_plane);
+                    int fog_far_plane_uniform_location{_shader->get_uniform_location(FogFarPlaneUniform)};
+                    glUniform1f(fog_far_plane_uniform_location, _fog_far_plane);
 
-            int fog_far_plane_uniform_location{_shader->get_uniforms().at("fog_far_plane")};
-            glUniform1f(fog_far_plane_uniform_location, _fog_far_plane);
+                    int fog_density_uniform_location{_shader->get_uniform_location(FogDensityUniform)};
+                    glUniform1f(fog_density_uniform_location, _fog_density);
+                }
 
-            int fog_density_uniform_location{_shader->get_uniforms().at("fog_density")};
-            glUniform1f(fog_density_uniform_location, _fog_density);
+                _shader->set_uploaded_material_version(_version);
+            }
         }
 
         void use() final
         {
+            if (_update_feature_defines_if_necessary() || _shader_instancing_enabled != _instancing_enabled)
+            {
+                _acquire_shader();
+            }
             _shader->use();
 
             if (_texture1)
@@ -288,6 +202,116 @@ namespace asr
         }
 
     private:
+        enum UniformSlot
+        {
+            ModelViewMatrixUniform,
+            ProjectionMatrixUniform,
+            EmissionColorUniform,
+            PointSizeUniform,
+
+            Texture1SamplerUniform,
+            Texture1TransformationMatrixUniform,
+
+            Texture2SamplerUniform,
+            Texture2TransformationMatrixUniform,
+
+            FogColorUniform,
+            FogFarMinusNearPlaneUniform,
+            FogFarPlaneUniform,
+            FogDensityUniform
+        };
+
+        bool _shader_instancing_enabled{false};
+        ES2ShaderCache::defines_type _feature_defines;
+        uint64_t _feature_defines_version{0};
+        std::shared_ptr<Shader> _previous_shader;
+
+        // The textures and the fog are compiled into the shader like in ES2PhongMaterial.
+        bool _update_feature_defines_if_necessary()
+        {
+            _track_texture_versions();
+            if (_feature_defines_version == _version)
+            {
+                return false;
+            }
+            _feature_defines_version = _version;
+
+            ES2ShaderCache::defines_type feature_defines;
+            if (_texture1 && _texture1->is_enabled())
+            {
+                feature_defines["TEXTURE1"] = "1";
+                feature_defines["TEXTURING_MODE1"] = std::to_string(static_cast<int>(_texture1->get_mode()));
+                if (_texture1->is_transformation_enabled() || _texture1->has_region())
+                {
+                    feature_defines["TEXTURE1_TRANSFORMATION"] = "1";
+                }
+            }
+            if (_texture2 && _texture2->is_enabled())
+            {
+                feature_defines["TEXTURE2"] = "1";
+                feature_defines["TEXTURING_MODE2"] = std::to_string(static_cast<int>(_texture2->get_mode()));
+                if (_texture2->is_transformation_enabled() || _texture2->has_region())
+                {
+                    feature_defines["TEXTURE2_TRANSFORMATION"] = "1";
+                }
+            }
+            if (_fog_enabled)
+            {
+                feature_defines["FOG"] = "1";
+                feature_defines["FOG_TYPE"] = std::to_string(static_cast<int>(_fog_type));
+                feature_defines["FOG_DEPTH"] = std::to_string(static_cast<int>(_fog_depth));
+            }
+
+            if (feature_defines == _feature_defines)
+            {
+                return false;
+            }
+            _feature_defines = std::move(feature_defines);
+
+            return true;
+        }
+
+        void _acquire_shader()
+        {
+            std::vector<std::string> attributes{
+                "position",
+                "color",
+                "texture1_coordinates",
+                "texture2_coordinates"};
+            std::vector<std::string> uniforms{
+                "model_view_matrix",
+                "projection_matrix",
+                "emission_color",
+                "point_size",
+
+                "texture1_sampler",
+                "texture1_transformation_matrix",
+
+                "texture2_sampler",
+                "texture2_transformation_matrix",
+
+                "fog_color",
+                "fog_far_minus_near_plane",
+                "fog_far_plane",
+                "fog_density"};
+
+            ES2ShaderCache::defines_type defines{_feature_defines};
+            if (_instancing_enabled)
+            {
+                defines["INSTANCING"] = "1";
+                if (!ES2InstancedMesh::is_hardware_instancing_supported())
+                {
+                    defines["INSTANCE_BATCH_SIZE"] = std::to_string(ES2InstancedMesh::MAX_BATCHED_INSTANCES);
+                }
+            }
+
+            _previous_shader = std::move(_shader);
+            _shader = ES2ShaderCache::get_instance().get_shader(
+                "data/shaders/es2_constant_shader.vert", "data/shaders/es2_constant_shader.frag",
+                attributes, uniforms, defines);
+            _shader_instancing_enabled = _instancing_enabled;
+        }
+
         static GLenum _convert_depth_test_func_to_es2_depth_test_func(Material::DepthTestFunction depth_test_function)
         {
             switch (depth_test_function)
@@ -2,9 +2,16 @@
 #define ES2_PHONG_MATERIAL_H
 
 #include "materials/phong_material.h"
+#include "objects/es2_instanced_mesh.h"
+#include "renderer/frame_constants.h"
+#include "renderer/light_selection.h"
 
-#include "utilities/utilities.h"
 #include "renderer/es2_shader.h"
+#include "renderer/es2_shader_cache.h"
+#include "renderer/es2_state_cache.h"
+#include "renderer/es2_light_clusters.h"
+#include "renderer/es2_shadow_pass.h"
+#include "utilities/profiler.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
@@ -16,6 +23,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>
+#include <cstdint>
 #include <cstddef>
 
 namespace asr
@@ -25,76 +34,11 @@ namespace asr
     public:
         ES2PhongMaterial()
         {
-            _vertex_shader_source = file_utilities::read_text_file("data/shaders/es2_phong_shader.vert");
-            _fragment_shader_source = file_utilities::read_text_file("data/shaders/es2_phong_shader.frag");
-
-            std::vector<std::string> attributes{
-                "position",
-                "color",
-                "normal",
-                "tangent",
-                "binormal",
-                "texture1_coordinates",
-                "texture2_coordinates"};
-            std::vector<std::string> uniforms{
-                "model_view_matrix",
-                "projection_matrix",
-                "normal_matrix",
-                "point_size",
-
-                "ambient_light_color",
-
-                "material_ambient_color",
-                "material_diffuse_color",
-                "material_emission_color",
-                "material_specular_color",
-                "material_specular_exponent",
-
-                "directional_light_enabled[0]",
-                "directional_light_two_sided[0]",
-                "directional_light_view_direction[0]",
-                "directional_light_ambient_color[0]",
-                "directional_light_diffuse_color[0]",
-                "directional_light_specular_color[0]",
-                "directional_light_intensity[0]",
-
-                "point_light_enabled[0]",
-                "point_light_two_sided[0]",
-                "point_light_view_position[0]",
-                "point_light_ambient_color[0]",
-                "point_light_diffuse_color[0]",
-                "point_light_specular_color[0]",
-                "point_light_intensity[0]",
-                "point_light_constant_attenuation[0]",
-                "point_light_linear_attenuation[0]",
-                "point_light_quadratic_attenuation[0]",
-
-                "texture1_sampler",
-                "texture1_enabled",
-                "texture1_transformation_enabled",
-                "texture1_transformation_matrix",
-                "texturing_mode1",
-                "texture1_normals_sampler",
-                "texture1_normals_enabled",
-
-                "texture2_sampler",
-                "texture2_enabled",
-                "texture2_transformation_enabled",
-                "texture2_transformation_matrix",
-                "texturing_mode2",
-
-                "fog_enabled",
-                "fog_type",
-                "fog_depth",
-                "fog_color",
-                "fog_far_minus_near_plane",
-                "fog_far_plane",
-                "fog_density"};
-
-            _shader = std::make_shared<ES2Shader>(_vertex_shader_source, _fragment_shader_source, attributes, uniforms);
+            _acquire_shader();
         }
 
-        void update(std::shared_ptr<Scene> scene, std::shared_ptr<Mesh> mesh) final
+        void update(const FrameConstants &frame_constants, const glm::mat4 &world_matrix,
+                    const LightSelection &light_selection) final
         {
             if (_shader->is_dead())
             {
@@ -107,96 +51,67 @@ namespace asr
                 {
                     return;
                 }
+                _shader->use();
             }
 
+            auto &state_cache = ES2StateCache::get_instance();
+
             if (!_prefer_line_width_from_geometry)
             {
-                glLineWidth(static_cast<GLfloat>(_line_width));
+                state_cache.set_line_width(_line_width);
             }
 
-            glDepthMask(static_cast<GLboolean>(_depth_mask_enabled));
+            state_cache.set_depth_mask_enabled(_depth_mask_enabled);
+            state_cache.set_depth_test_enabled(_depth_test_enabled);
             if (_depth_test_enabled)
             {
-                glEnable(GL_DEPTH_TEST);
-            }
-            else
-            {
-                glDisable(GL_DEPTH_TEST);
-            }
-            if (_depth_test_enabled)
-            {
-                glDepthFunc(_convert_depth_test_func_to_es2_depth_test_func(_depth_test_function));
+                state_cache.set_depth_function(_convert_depth_test_func_to_es2_depth_test_func(_depth_test_function));
             }
 
+            state_cache.set_blending_enabled(_blending_enabled);
             if (_blending_enabled)
             {
-                glEnable(GL_BLEND);
-            }
-            else
-            {
-                glDisable(GL_BLEND);
-            }
-            if (_blending_enabled)
-            {
-                glBlendEquationSeparate(_convert_blending_equation_to_es2_blending_equation(_color_blending_equation),
-                                        _convert_blending_equation_to_es2_blending_equation(_alpha_blending_equation));
-                glBlendFuncSeparate(_convert_blending_func_to_es2_blending_func(_source_color_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_destination_color_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_source_alpha_blending_function),
-                                    _convert_blending_func_to_es2_blending_func(_destination_alpha_blending_function));
-                glBlendColor(static_cast<GLclampf>(_blending_constant_color[0]),
-                             static_cast<GLclampf>(_blending_constant_color[1]),
-                             static_cast<GLclampf>(_blending_constant_color[2]),
-                             static_cast<GLclampf>(_blending_constant_color[3]));
+                state_cache.set_blending_equations(
+                    _convert_blending_equation_to_es2_blending_equation(_color_blending_equation),
+                    _convert_blending_equation_to_es2_blending_equation(_alpha_blending_equation));
+                state_cache.set_blending_functions(
+                    _convert_blending_func_to_es2_blending_func(_source_color_blending_function),
+                    _convert_blending_func_to_es2_blending_func(_destination_color_blending_function),
+                    _convert_blending_func_to_es2_blending_func(_source_alpha_blending_function),
+                    _convert_blending_func_to_es2_blending_func(_destination_alpha_blending_function));
+                state_cache.set_blending_constant_color(_blending_constant_color);
             }
 
+            state_cache.set_face_culling_enabled(_face_culling_enabled);
             if (_face_culling_enabled)
             {
-                glEnable(GL_CULL_FACE);
-            }
-            else
-            {
-                glDisable(GL_CULL_FACE);
-            }
-            if (_face_culling_enabled)
-            {
-                glCullFace(_convert_cull_face_mode_to_es2_cull_face_mode(_cull_face_mode));
-                glFrontFace(_convert_front_face_order_to_es2_front_face_order(_front_face_order));
+                state_cache.set_cull_face_mode(_convert_cull_face_mode_to_es2_cull_face_mode(_cull_face_mode));
+                state_cache.set_front_face_order(_convert_front_face_order_to_es2_front_face_order(_front_face_order));
             }
 
+            state_cache.set_polygon_offset_enabled(_polygon_offset_enabled);
             if (_polygon_offset_enabled)
             {
-                glEnable(GL_POLYGON_OFFSET_FILL);
-            }
-            else
-            {
-                glDisable(GL_POLYGON_OFFSET_FILL);
-            }
-            if (_polygon_offset_enabled)
-            {
-                glPolygonOffset(static_cast<GLfloat>(_polygon_offset_factor),
-                                static_cast<GLfloat>(_polygon_offset_units));
+                state_cache.set_polygon_offset(_polygon_offset_factor, _polygon_offset_units);
             }
 
-            _update_light_uniforms_if_necessary(scene);
+            _update_lighting_if_necessary(frame_constants, light_selection);
             if (_shader->is_dead())
             {
                 return;
             }
 
-            auto camera = scene->get_camera();
-
             glm::mat4 model_view_matrix;
             if (is_overlay())
             {
-                model_view_matrix = mesh->get_world_matrix();
+                model_view_matrix = world_matrix;
                 model_view_matrix[3][2] = 0.0f;
             }
             else
             {
-                model_view_matrix = camera->get_view_matrix() * mesh->get_world_matrix();
+                model_view_matrix = frame_constants.get_view_matrix() * world_matrix;
             }
-            int model_view_matrix_uniform_location{_shader->get_uniforms().at("model_view_matrix")};
+            int model_view_matrix_uniform_location{_shader->get_uniform_location(ModelViewMatrixUniform)};
             glUniformMatrix4fv(
                 model_view_matrix_uniform_location,
                 1, GL_FALSE,
@@ -205,299 +120,220 @@ namespace asr
             glm::mat4 projection_matrix;
             if (is_overlay())
             {
-                projection_matrix = camera->get_orthographic_projection_matrix();
+                projection_matrix = frame_constants.get_orthographic_projection_matrix();
             }
             else
             {
-                projection_matrix = camera->get_projection_matrix();
+                projection_matrix = frame_constants.get_projection_matrix();
             }
-            int projection_matrix_uniform_location{_shader->get_uniforms().at("projection_matrix")};
+            int projection_matrix_uniform_location{_shader->get_uniform_location(ProjectionMatrixUniform)};
             glUniformMatrix4fv(
                 projection_matrix_uniform_location,
                 1, GL_FALSE,
                 glm::value_ptr(projection_matrix));
 
             glm::mat3 normal_matrix = glm::inverseTranspose(glm::mat3(model_view_matrix));
-            int normal_matrix_uniform_location{_shader->get_uniforms().at("normal_matrix")};
+            int normal_matrix_uniform_location{_shader->get_uniform_location(NormalMatrixUniform)};
             glUniformMatrix3fv(
                 normal_matrix_uniform_location,
                 1, GL_FALSE,
                 glm::value_ptr(normal_matrix));
 
-            if (_point_sizing_enabled && !_prefer_point_size_from_geometry)
-            {
-                int point_size_uniform_location{_shader->get_uniforms().at("point_size")};
-                glUniform1f(point_size_uniform_location, _point_size);
-            }
-
-            int ambient_light_color_uniform_location{_shader->get_uniforms().at("ambient_light_color")};
-            glUniform3fv(
-                ambient_light_color_uniform_location,
-                1, glm::value_ptr(scene->get_ambient_light()->get_ambient_color()));
-
-            int material_ambient_color_uniform_location{_shader->get_uniforms().at("material_ambient_color")};
-            glUniform3fv(
-                material_ambient_color_uniform_location,
-                1, glm::value_ptr(_ambient_color));
-
-            int material_diffuse_color_uniform_location{_shader->get_uniforms().at("material_diffuse_color")};
-            glUniform4fv(
-                material_diffuse_color_uniform_location,
-                1, glm::value_ptr(_diffuse_color));
-
-            int material_emission_color_uniform_location{_shader->get_uniforms().at("material_emission_color")};
-            glUniform4fv(
-                material_emission_color_uniform_location,
-                1, glm::value_ptr(_emission_color));
-
-            int material_specular_color_uniform_location{_shader->get_uniforms().at("material_specular_color")};
-            glUniform3fv(
-                material_specular_color_uniform_location,
-                1, glm::value_ptr(_specular_color));
-
-            int material_specular_exponent_uniform_location{_shader->get_uniforms().at("material_specular_exponent")};
-            glUniform1f(material_specular_exponent_uniform_location, _specular_exponent);
-
-            auto &directional_lights = scene->get_directional_lights();
-            for (std::vector<std::shared_ptr<DirectionalLight>>::size_type i = 0; i < directional_lights.size(); ++i)
+            // The uniforms of the material are only uploaded again when it changed or another material used the
+            // shader in between.
+            _track_texture_versions();
+            bool material_changed = _shader->get_uploaded_material_version() != _version;
+            if (material_changed)
             {
-                const auto &directional_light = directional_lights[i];
-
-                int uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_enabled", i));
-                glUniform1i(uniform_location, directional_light->is_enabled());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_two_sided", i));
-                glUniform1i(uniform_location, directional_light->is_two_sided());
+                if (_point_sizing_enabled && !_prefer_point_size_from_geometry)
+                {
+                    int point_size_uniform_location{_shader->get_uniform_location(PointSizeUniform)};
+                    glUniform1f(point_size_uniform_location, _point_size);
+                }
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_view_direction", i));
+                int material_ambient_color_uniform_location{_shader->get_uniform_location(MaterialAmbientColorUniform)};
                 glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(camera->get_view_matrix() * glm::vec4(directional_light->get_world_direction(), 0.0f)));
+                    material_ambient_color_uniform_location,
+                    1, glm::value_ptr(_ambient_color));
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_ambient_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(directional_light->get_ambient_color()));
+                int material_diffuse_color_uniform_location{_shader->get_uniform_location(MaterialDiffuseColorUniform)};
+                glUniform4fv(
+                    material_diffuse_color_uniform_location,
+                    1, glm::value_ptr(_diffuse_color));
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_diffuse_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(directional_light->get_diffuse_color()));
+                int material_emission_color_uniform_location{_shader->get_uniform_location(MaterialEmissionColorUniform)};
+                glUniform4fv(
+                    material_emission_color_uniform_location,
+                    1, glm::value_ptr(_emission_color));
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_specular_color", i));
+                int material_specular_color_uniform_location{_shader->get_uniform_location(MaterialSpecularColorUniform)};
                 glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(directional_light->get_specular_color()));
+                    material_specular_color_uniform_location,
+                    1, glm::value_ptr(_specular_color));
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("directional_light_intensity", i));
-                glUniform1f(uniform_location, directional_light->get_intensity());
+                int material_specular_exponent_uniform_location{_shader->get_uniform_location(MaterialSpecularExponentUniform)};
+                glUniform1f(material_specular_exponent_uniform_location, _specular_exponent);
             }
 
-            auto &point_lights = scene->get_point_lights();
-            for (std::vector<std::shared_ptr<PointLight>>::size_type i = 0; i < point_lights.size(); ++i)
+            bool lights_changed = _shader->get_uploaded_lights_version() != frame_constants.get_lights_version();
+            if (lights_changed)
             {
-                const auto &point_light = point_lights[i];
-
-                int uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_enabled", i));
-                glUniform1i(uniform_location, point_light->is_enabled());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_two_sided", i));
-                glUniform1i(uniform_location, point_light->is_two_sided());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_view_position", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(camera->get_view_matrix() * point_light->get_world_matrix() * glm::vec4(point_light->get_position(), 1.0f)));
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_ambient_color", i));
+                int ambient_light_color_uniform_location{_shader->get_uniform_location(AmbientLightColorUniform)};
                 glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(point_light->get_ambient_color()));
+                    ambient_light_color_uniform_location,
+                    1, glm::value_ptr(frame_constants.get_ambient_light_color()));
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_diffuse_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(point_light->get_diffuse_color()));
+                glUniform1i(_shader->get_uniform_location(DirectionalLightCountUniform),
+                            static_cast<GLint>(frame_constants.get_directional_lights().size()));
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_specular_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(point_light->get_specular_color()));
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_intensity", i));
-                glUniform1f(uniform_location, point_light->get_intensity());
+                const auto &directional_lights = frame_constants.get_directional_lights();
+                if (!directional_lights.empty())
+                {
+                    auto count = static_cast<GLsizei>(directional_lights.size());
+                    glUniform1iv(_shader->get_uniform_location(DirectionalLightEnabledUniform), count, directional_lights.enabled.data());
+                    glUniform1iv(_shader->get_uniform_location(DirectionalLightTwoSidedUniform), count, directional_lights.two_sided.data());
+                    glUniform3fv(_shader->get_uniform_location(DirectionalLightViewDirectionUniform), count, glm::value_ptr(directional_lights.view_directions[0]));
+                    glUniform3fv(_shader->get_uniform_location(DirectionalLightAmbientColorUniform), count, glm::value_ptr(directional_lights.ambient_colors[0]));
+                    glUniform3fv(_shader->get_uniform_location(DirectionalLightDiffuseColorUniform), count, glm::value_ptr(directional_lights.diffuse_colors[0]));
+                    glUniform3fv(_shader->get_uniform_location(DirectionalLightSpecularColorUniform), count, glm::value_ptr(directional_lights.specular_colors[0]));
+                    glUniform1fv(_shader->get_uniform_location(DirectionalLightIntensityUniform), count, directional_lights.intensities.data());
+                }
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_constant_attenuation", i));
-                glUniform1f(uniform_location, point_light->get_constant_attenuation());
+                if (_shader_clustered_lighting_enabled)
+                {
+                    const auto &light_clusters = frame_constants.get_light_clusters();
+                    glUniform1i(_shader->get_uniform_location(LightClusterSamplerUniform), static_cast<GLint>(ES2LightClusters::CLUSTER_TEXTURE_UNIT));
+                    glUniform1i(_shader->get_uniform_location(LightIndexSamplerUniform), static_cast<GLint>(ES2LightClusters::LIGHT_INDEX_TEXTURE_UNIT));
+                    glUniform1i(_shader->get_uniform_location(LightDataSamplerUniform), static_cast<GLint>(ES2LightClusters::LIGHT_DATA_TEXTURE_UNIT));
+                    glUniformMatrix4fv(_shader->get_uniform_location(LightClusterProjectionMatrixUniform), 1, GL_FALSE,
+                                       glm::value_ptr(frame_constants.get_projection_matrix()));
+                    glUniform1f(_shader->get_uniform_location(LightClusterDepthScaleUniform), light_clusters.get_depth_scale());
+                    glUniform1f(_shader->get_uniform_location(LightClusterDepthBiasUniform), light_clusters.get_depth_bias());
+                    glUniform1f(_shader->get_uniform_location(LightIndexTextureHeightUniform),
+                                static_cast<GLfloat>(light_clusters.get_light_index_texels().size() / LightClusters::LIGHT_INDEX_TEXTURE_WIDTH));
+                    glUniform1f(_shader->get_uniform_location(LightDataTextureHeightUniform),
+                                static_cast<GLfloat>(light_clusters.get_light_data_texels().size() / LightClusters::LIGHT_DATA_TEXTURE_WIDTH));
+                }
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_linear_attenuation", i));
-                glUniform1f(uniform_location, point_light->get_linear_attenuation());
+                if (_shader_shadows_enabled)
+                {
+                    const auto &shadow_maps = frame_constants.get_shadow_maps();
+                    auto count = static_cast<GLsizei>(shadow_maps.size());
+                    glUniform1i(_shader->get_uniform_location(ShadowAtlasSamplerUniform), static_cast<GLint>(ES2ShadowPass::ATLAS_TEXTURE_UNIT));
+                    glUniform2f(_shader->get_uniform_location(ShadowAtlasTexelSizeUniform),
+                                1.0f / static_cast<GLfloat>(shadow_maps.get_atlas_width()),
+                                1.0f / static_cast<GLfloat>(shadow_maps.get_atlas_height()));
+                    glUniformMatrix4fv(_shader->get_uniform_location(ShadowMapTextureMatrixUniform), count, GL_FALSE,
+                                       glm::value_ptr(shadow_maps.texture_matrices[0]));
+                    glUniform4fv(_shader->get_uniform_location(ShadowMapRegionUniform), count, glm::value_ptr(shadow_maps.regions[0]));
+                    glUniform1fv(_shader->get_uniform_location(ShadowMapFarDepthUniform), count, shadow_maps.far_depths.data());
+                    glUniform1fv(_shader->get_uniform_location(ShadowMapBiasUniform), count, shadow_maps.biases.data());
+                    if (!directional_lights.empty())
+                    {
+                        auto directional_light_count = static_cast<GLsizei>(directional_lights.size());
+                        glUniform1iv(_shader->get_uniform_location(DirectionalLightShadowMapBeginUniform), directional_light_count,
+                                     directional_lights.shadow_map_begins.data());
+                        glUniform1iv(_shader->get_uniform_location(DirectionalLightShadowMapEndUniform), directional_light_count,
+                                     directional_lights.shadow_map_ends.data());
+                    }
+                }
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("point_light_quadratic_attenuation", i));
-                glUniform1f(uniform_location, point_light->get_quadratic_attenuation());
+                _shader->set_uploaded_lights_version(frame_constants.get_lights_version());
             }
 
-            auto &spot_lights = scene->get_spot_lights();
-            for (std::vector<std::shared_ptr<SpotLight>>::size_type i = 0; i < spot_lights.size(); ++i)
+            if (!_shader_clustered_lighting_enabled && (lights_changed || !_shader->is_light_selection_uploaded(light_selection)))
             {
-                const auto &spot_light = spot_lights[i];
-
-                int uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_enabled", i));
-                glUniform1i(uniform_location, spot_light->is_enabled());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_two_sided", i));
-                glUniform1i(uniform_location, spot_light->is_two_sided());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_view_position", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(camera->get_view_matrix() * spot_light->get_world_matrix() * glm::vec4(spot_light->get_position(), 1.0f)));
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_view_direction", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(camera->get_view_matrix() * glm::vec4(spot_light->get_world_direction(), 0.0f)));
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_ambient_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(spot_light->get_ambient_color()));
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_diffuse_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(spot_light->get_diffuse_color()));
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_specular_color", i));
-                glUniform3fv(
-                    uniform_location,
-                    1, glm::value_ptr(spot_light->get_specular_color()));
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_exponent", i));
-                glUniform1f(uniform_location, spot_light->get_exponent());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_cutoff_angle_cosine", i));
-                glUniform1f(uniform_location, spot_light->get_cutoff_angle());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_intensity", i));
-                glUniform1f(uniform_location, spot_light->get_intensity());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_constant_attenuation", i));
-                glUniform1f(uniform_location, spot_light->get_constant_attenuation());
-
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_linear_attenuation", i));
-                glUniform1f(uniform_location, spot_light->get_linear_attenuation());
+                const LightArrays *point_lights = &frame_constants.get_point_lights();
+                const LightArrays *spot_lights = &frame_constants.get_spot_lights();
+                if (light_selection.selected)
+                {
+                    _gather_lights(*point_lights, light_selection.point_light_indices, light_selection.point_light_count,
+                                   _selected_point_lights);
+                    _gather_lights(*spot_lights, light_selection.spot_light_indices, light_selection.spot_light_count,
+                                   _selected_spot_lights);
+                    point_lights = &_selected_point_lights;
+                    spot_lights = &_selected_spot_lights;
+                }
 
-                uniform_location = _shader->get_uniforms().at(_uniform_at_index("spot_light_quadratic_attenuation", i));
-                glUniform1f(uniform_location, spot_light->get_quadratic_attenuation());
+                glUniform1i(_shader->get_uniform_location(PointLightCountUniform), static_cast<GLint>(point_lights->size()));
+                glUniform1i(_shader->get_uniform_location(SpotLightCountUniform), static_cast<GLint>(spot_lights->size()));
+                _upload_point_lights(*point_lights);
+                _upload_spot_lights(*spot_lights);
+                _shader->set_uploaded_light_selection(light_selection);
             }
 
             if (_texture1)
             {
                 _texture1->update(0);
+            }
+            if (_texture2)
+            {
+                _texture2->update(1);
+            }
+            if (_texture1_normals)
+            {
+                _texture1_normals->update(2);
+            }
 
-                int texture1_enabled_uniform_location{_shader->get_uniforms().at("texture1_enabled")};
-                glUniform1i(
-                    texture1_enabled_uniform_location,
-                    static_cast<GLint>(_texture1->is_enabled()));
-
-                if (_texture1->is_enabled())
+            if (material_changed)
+            {
+                if (_texture1 && _texture1->is_enabled())
                 {
-                    int texture1_sampler_uniform_location{_shader->get_uniforms().at("texture1_sampler")};
+                    int texture1_sampler_uniform_location{_shader->get_uniform_location(Texture1SamplerUniform)};
                     glUniform1i(texture1_sampler_uniform_location, 0);
 
-                    int texturing_mode1_uniform_location{_shader->get_uniforms().at("texturing_mode1")};
-                    glUniform1i(
-                        texturing_mode1_uniform_location,
-                        static_cast<GLint>(_texture1->get_mode()));
-
-                    int texture1_transformation_enabled_uniform_location{_shader->get_uniforms().at("texture1_transformation_enabled")};
-                    glUniform1i(
-                        texture1_transformation_enabled_uniform_location,
-                        static_cast<GLint>(_texture1->is_transformation_enabled()));
-
-                    int texture1_transformation_matrix_uniform_location{_shader->get_uniforms().at("texture1_transformation_matrix")};
+                    int texture1_transformation_matrix_uniform_location{_shader->get_uniform_location(Texture1TransformationMatrixUniform)};
                     glUniformMatrix4fv(
                         texture1_transformation_matrix_uniform_location,
                         1, GL_FALSE,
-                        glm::value_ptr(_texture1->get_transformation_matrix()));
+                        glm::value_ptr(_texture1->get_region_transformation_matrix()));
                 }
-            }
-
-            if (_texture2)
-            {
-                _texture2->update(1);
 
-                int texture2_enabled_uniform_location{_shader->get_uniforms().at("texture2_enabled")};
-                glUniform1i(
-                    texture2_enabled_uniform_location,
-                    static_cast<GLint>(_texture2->is_enabled()));
-
-                if (_texture2->is_enabled())
+                if (_texture2 && _texture2->is_enabled())
                 {
-                    int texture2_sampler_uniform_location{_shader->get_uniforms().at("texture2_sampler")};
+                    int texture2_sampler_uniform_location{_shader->get_uniform_location(Texture2SamplerUniform)};
                     glUniform1i(texture2_sampler_uniform_location, 1);
 
-                    int texturing_mode2_uniform_location{_shader->get_uniforms().at("texturing_mode2")};
-                    glUniform1i(
-                        texturing_mode2_uniform_location,
-                        static_cast<GLint>(_texture2->get_mode()));
-
-                    int texture2_transformation_enabled_uniform_location{_shader->get_uniforms().at("texture2_transformation_enabled")};
-                    glUniform1i(
-                        texture2_transformation_enabled_uniform_location,
-                        static_cast<GLint>(_texture2->is_transformation_enabled()));
-
-                    int texture2_transformation_matrix_uniform_location{_shader->get_uniforms().at("texture2_transformation_matrix")};
+                    int texture2_transformation_matrix_uniform_location{_shader->get_uniform_location(Texture2TransformationMatrixUniform)};
                     glUniformMatrix4fv(
                         texture2_transformation_matrix_uniform_location,
                         1, GL_FALSE,
-                        glm::value_ptr(_texture2->get_transformation_matrix()));
+                        glm::value_ptr(_texture2->get_region_transformation_matrix()));
                 }
-            }
 
-            if (_texture1_normals)
-            {
-                _texture1_normals->update(2);
-
-                int texture1_normals_enabled_uniform_location{_shader->get_uniforms().at("texture1_normals_enabled")};
-                glUniform1i(
-                    texture1_normals_enabled_uniform_location,
-                    static_cast<GLint>(_texture1_normals->is_enabled()));
-
-                if (_texture1_normals->is_enabled())
+                if (_texture1_normals && _texture1_normals->is_enabled())
                 {
-                    int texture1_normals_sampler_uniform_location{_shader->get_uniforms().at("texture1_normals_sampler")};
+                    int texture1_normals_sampler_uniform_location{_shader->get_uniform_location(Texture1NormalsSamplerUniform)};
                     glUniform1i(texture1_normals_sampler_uniform_location, 2);
                 }
-            }
-
-            int fog_enabled_uniform_location{_shader->get_uniforms().at("fog_enabled")};
-            glUniform1i(fog_enabled_uniform_location, static_cast<GLint>(_fog_enabled));
 
-            int fog_type_uniform_location{_shader->get_uniforms().at("fog_type")};
-            glUniform1i(fog_type_uniform_location, static_cast<GLint>(_fog_type));
-
-            int fog_depth_uniform_location{_shader->get_uniforms().at("fog_depth")};
-            glUniform1i(fog_depth_uniform_location, static_cast<GLint>(_fog_depth));
+                if (_fog_enabled)
+                {
+                    int fog_color_uniform_location{_shader->get_uniform_location(FogColorUniform)};
+                    glUniform3fv(
+                        fog_color_uniform_location,
+                        1, glm::value_ptr(_fog_color));
 
-            int fog_color_uniform_location{_shader->get_uniforms().at("fog_color")};
-            glUniform3fv(
-                fog_color_uniform_location,
-                1, glm::value_ptr(_fog_color));
+                    int fog_far_minus_near_plane_uniform_location{_shader->get_uniform_location(FogFarMinusNearPlaneUniform)};
+                    glUniform1f(fog_far_minus_near_plane_uniform_location, _fog_far_plane - _fog_near_plane);
 
-            int fog_far_minus_near_plane_uniform_location{_shader->get_uniforms().at("fog_far_minus_near_plane")};
-            glUniform1f(fog_far_minus_near_plane_uniform_location, _fog_far_plane - _fog_near_plane);
+                    int fog_far_plane_uniform_location{_shader->get_uniform_location(FogFarPlaneUniform)};
+                    glUniform1f(fog_far_plane_uniform_location, _fog_far_plane);
 
-            int fog_far_plane_uniform_location{_shader->get_uniforms().at("fog_far_plane")};
-            glUniform1f(fog_far_plane_uniform_location, _fog_far_plane);
+                    int fog_density_uniform_location{_shader->get_uniform_location(FogDensityUniform)};
+                    glUniform1f(fog_density_uniform_location, _fog_density);
+                }
 
-            int fog_density_uniform_location{_shader->get_uniforms().at("fog_density")};
-            glUniform1f(fog_density_uniform_location, _fog_density);
+                _shader->set_uploaded_material_version(_version);
+            }
         }
 
         void use() final
         {
+            if (_update_feature_defines_if_necessary() || _shader_instancing_enabled != _instancing_enabled)
+            {
+                _acquire_shader();
+            }
             _shader->use();
 
             if (_texture1)
@@ -515,133 +351,402 @@ namespace asr
         }
 
     private:
-        static std::string _uniform_at_index(const std::string &uniform, size_t slot)
-        {
-            return uniform + "[" + std::to_string(slot) + "]";
-        }
+        inline static const size_t DEFAULT_LIGHT_CAPACITY = 4;
 
-        void _update_light_uniforms_if_necessary(const std::shared_ptr<Scene> &scene)
+        enum UniformSlot
         {
-            auto directional_light_count = scene->get_directional_lights().size();
-            auto point_light_count = scene->get_point_lights().size();
-            auto spot_light_count = scene->get_spot_lights().size();
-
-            if (_previous_directional_light_count != directional_light_count ||
-                _previous_point_light_count != point_light_count ||
-                _previous_spot_light_count != spot_light_count)
-            {
-                std::vector<std::string> uniforms{
-                    "model_view_matrix",
-                    "projection_matrix",
-                    "normal_matrix",
-                    "point_size",
-
-                    "ambient_light_color",
-
-                    "material_ambient_color",
-                    "material_diffuse_color",
-                    "material_emission_color",
-                    "material_specular_color",
-                    "material_specular_exponent",
-
-                    "texture1_sampler",
-                    "texture1_enabled",
-                    "texture1_transformation_enabled",
-                    "texture1_transformation_matrix",
-                    "texturing_mode1",
-                    "texture1_normals_sampler",
-                    "texture1_normals_enabled",
-
-                    "texture2_sampler",
-                    "texture2_enabled",
-                    "texture2_transformation_enabled",
-                    "texture2_transformation_matrix",
-                    "texturing_mode2",
-
-                    "fog_enabled",
-                    "fog_type",
-                    "fog_depth",
-                    "fog_color",
-                    "fog_far_minus_near_plane",
-                    "fog_far_plane",
-                    "fog_density"};
-
-                std::vector<std::string> directional_light_uniforms{
-                    "directional_light_enabled",
-                    "directional_light_two_sided",
-                    "directional_light_view_direction",
-                    "directional_light_ambient_color",
-                    "directional_light_diffuse_color",
-                    "directional_light_specular_color",
-                    "directional_light_intensity"};
-
-                std::vector<std::string> point_light_uniforms{
-                    "point_light_enabled",
-                    "point_light_two_sided",
-                    "point_light_view_position",
-                    "point_light_ambient_color",
-                    "point_light_diffuse_color",
-                    "point_light_specular_color",
-                    "point_light_intensity",
-                    "point_light_constant_attenuation",
-                    "point_light_linear_attenuation",
-                    "point_light_quadratic_attenuation"};
-
-                std::vector<std::string> spot_light_uniforms{
-                    "spot_light_enabled",
-                    "spot_light_two_sided",
-                    "spot_light_view_position",
-                    "spot_light_view_direction",
-                    "spot_light_ambient_color",
-                    "spot_light_diffuse_color",
-                    "spot_light_specular_color",
-                    "spot_light_exponent",
-                    "spot_light_cutoff_angle_cosine",
-                    "spot_light_intensity",
-                    "spot_light_constant_attenuation",
-                    "spot_light_linear_attenuation",
-                    "spot_light_quadratic_attenuation"};
-
-                auto &uniform_map = _shader->get_uniforms();
-                uniform_map.clear();
-
-                for (const auto &uniform : uniforms)
-                {
-                    uniform_map[uniform] = -1;
-                }
-                for (const auto &uniform : directional_light_uniforms)
+            ModelViewMatrixUniform,
+            ProjectionMatrixUniform,
+            NormalMatrixUniform,
+            PointSizeUniform,
+
+            AmbientLightColorUniform,
+            DirectionalLightCountUniform,
+            PointLightCountUniform,
+            SpotLightCountUniform,
+
+            MaterialAmbientColorUniform,
+            MaterialDiffuseColorUniform,
+            MaterialEmissionColorUniform,
+            MaterialSpecularColorUniform,
+            MaterialSpecularExponentUniform,
+
+            DirectionalLightEnabledUniform,
+            DirectionalLightTwoSidedUniform,
+            DirectionalLightViewDirectionUniform,
+            DirectionalLightAmbientColorUniform,
+            DirectionalLightDiffuseColorUniform,
+            DirectionalLightSpecularColorUniform,
+            DirectionalLightIntensityUniform,
+
+            PointLightEnabledUniform,
+            PointLightTwoSidedUniform,
+            PointLightViewPositionUniform,
+            PointLightAmbientColorUniform,
+            PointLightDiffuseColorUniform,
+            PointLightSpecularColorUniform,
+            PointLightIntensityUniform,
+            PointLightConstantAttenuationUniform,
+            PointLightLinearAttenuationUniform,
+            PointLightQuadraticAttenuationUniform,
+
+            SpotLightEnabledUniform,
+            SpotLightTwoSidedUniform,
+            SpotLightViewPositionUniform,
+            SpotLightViewDirectionUniform,
+            SpotLightAmbientColorUniform,
+            SpotLightDiffuseColorUniform,
+            SpotLightSpecularColorUniform,
+            SpotLightExponentUniform,
+            SpotLightCutoffAngleCosineUniform,
+            SpotLightIntensityUniform,
+            SpotLightConstantAttenuationUniform,
+            SpotLightLinearAttenuationUniform,
+            SpotLightQuadraticAttenuationUniform,
+
+            LightClusterSamplerUniform,
+            LightIndexSamplerUniform,
+            LightDataSamplerUniform,
+            LightClusterProjectionMatrixUniform,
+            LightClusterDepthScaleUniform,
+            LightClusterDepthBiasUniform,
+            LightIndexTextureHeightUniform,
+            LightDataTextureHeightUniform,
+
+            ShadowAtlasSamplerUniform,
+            ShadowAtlasTexelSizeUniform,
+            ShadowMapTextureMatrixUniform,
+            ShadowMapRegionUniform,
+            ShadowMapFarDepthUniform,
+            ShadowMapBiasUniform,
+            DirectionalLightShadowMapBeginUniform,
+            DirectionalLightShadowMapEndUniform,
+            SpotLightShadowMapBeginUniform,
+            SpotLightShadowMapEndUniform,
+
+            Texture1SamplerUniform,
+            Texture1TransformationMatrixUniform,
+            Texture1NormalsSamplerUniform,
+
+            Texture2SamplerUniform,
+            Texture2TransformationMatrixUniform,
+
+            FogColorUniform,
+            FogFarMinusNearPlaneUniform,
+            FogFarPlaneUniform,
+            FogDensityUniform
+        };
+
+        // The light arrays of the shaders have a fixed capacity and the lights in use are passed as count
+        // uniforms, so adding or removing lights only switches to another shader when a capacity is exceeded.
+        // The capacities then double, which keeps the number of variants that are ever compiled small. With
+        // clustered lighting, point and spot lights are read from the cluster textures instead. Lights that are
+        // selected per mesh only have to fit the selection. Shadows are compiled in while the frame has shadow
+        // maps, and overlays never receive them.
+        void _update_lighting_if_necessary(const FrameConstants &frame_constants, const LightSelection &light_selection)
+        {
+            bool clustered_lighting_enabled = frame_constants.is_clustered_lighting_enabled();
+            bool shadows_enabled = !frame_constants.get_shadow_maps().empty() && !_overlay;
+            size_t directional_light_capacity =
+                _calculate_light_capacity(_directional_light_capacity, frame_constants.get_directional_lights().size());
+            size_t point_light_capacity = _point_light_capacity;
+            size_t spot_light_capacity = _spot_light_capacity;
+            if (!clustered_lighting_enabled)
+            {
+                size_t point_light_count = light_selection.selected ? light_selection.point_light_count : frame_constants.get_point_lights().size();
+                size_t spot_light_count = light_selection.selected ? light_selection.spot_light_count : frame_constants.get_spot_lights().size();
+                point_light_capacity = _calculate_light_capacity(point_light_capacity, point_light_count);
+                spot_light_capacity = _calculate_light_capacity(spot_light_capacity, spot_light_count);
+            }
+
+            if (_directional_light_capacity != directional_light_capacity ||
+                _point_light_capacity != point_light_capacity ||
+                _spot_light_capacity != spot_light_capacity ||
+                _shader_clustered_lighting_enabled != clustered_lighting_enabled ||
+                _shader_shadows_enabled != shadows_enabled)
+            {
+                ASR_PROFILE_SCOPE("ES2PhongMaterial::update_lighting");
+
+                _directional_light_capacity = directional_light_capacity;
+                _point_light_capacity = point_light_capacity;
+                _spot_light_capacity = spot_light_capacity;
+                _clustered_lighting_enabled = clustered_lighting_enabled;
+                _shadows_enabled = shadows_enabled;
+
+                _acquire_shader();
+                if (!_shader->is_compiled() && !_shader->is_dead())
                 {
-                    for (size_t i = 0; i < directional_light_count; ++i)
-                    {
-                        uniform_map[_uniform_at_index(uniform, i)] = -1;
-                    }
+                    _shader->compile();
                 }
-                for (const auto &uniform : point_light_uniforms)
+                _shader->use();
+            }
+        }
+
+        void _upload_point_lights(const LightArrays &point_lights)
+        {
+            if (point_lights.empty())
+            {
+                return;
+            }
+
+            auto count = static_cast<GLsizei>(point_lights.size());
+            glUniform1iv(_shader->get_uniform_location(PointLightEnabledUniform), count, point_lights.enabled.data());
+            glUniform1iv(_shader->get_uniform_location(PointLightTwoSidedUniform), count, point_lights.two_sided.data());
+            glUniform3fv(_shader->get_uniform_location(PointLightViewPositionUniform), count, glm::value_ptr(point_lights.view_positions[0]));
+            glUniform3fv(_shader->get_uniform_location(PointLightAmbientColorUniform), count, glm::value_ptr(point_lights.ambient_colors[0]));
+            glUniform3fv(_shader->get_uniform_location(PointLightDiffuseColorUniform), count, glm::value_ptr(point_lights.diffuse_colors[0]));
+            glUniform3fv(_shader->get_uniform_location(PointLightSpecularColorUniform), count, glm::value_ptr(point_lights.specular_colors[0]));
+            glUniform1fv(_shader->get_uniform_location(PointLightIntensityUniform), count, point_lights.intensities.data());
+            glUniform1fv(_shader->get_uniform_location(PointLightConstantAttenuationUniform), count, point_lights.constant_attenuations.data());
+            glUniform1fv(_shader->get_uniform_location(PointLightLinearAttenuationUniform), count, point_lights.linear_attenuations.data());
+            glUniform1fv(_shader->get_uniform_location(PointLightQuadraticAttenuationUniform), count, point_lights.quadratic_attenuations.data());
+        }
+
+        void _upload_spot_lights(const LightArrays &spot_lights)
+        {
+            if (spot_lights.empty())
+            {
+                return;
+            }
+
+            auto count = static_cast<GLsizei>(spot_lights.size());
+            glUniform1iv(_shader->get_uniform_location(SpotLightEnabledUniform), count, spot_lights.enabled.data());
+            glUniform1iv(_shader->get_uniform_location(SpotLightTwoSidedUniform), count, spot_lights.two_sided.data());
+            glUniform3fv(_shader->get_uniform_location(SpotLightViewPositionUniform), count, glm::value_ptr(spot_lights.view_positions[0]));
+            glUniform3fv(_shader->get_uniform_location(SpotLightViewDirectionUniform), count, glm::value_ptr(spot_lights.view_directions[0]));
+            glUniform3fv(_shader->get_uniform_location(SpotLightAmbientColorUniform), count, glm::value_ptr(spot_lights.ambient_colors[0]));
+            glUniform3fv(_shader->get_uniform_location(SpotLightDiffuseColorUniform), count, glm::value_ptr(spot_lights.diffuse_colors[0]));
+            glUniform3fv(_shader->get_uniform_location(SpotLightSpecularColorUniform), count, glm::value_ptr(spot_lights.specular_colors[0]));
+            glUniform1fv(_shader->get_uniform_location(SpotLightExponentUniform), count, spot_lights.exponents.data());
+            glUniform1fv(_shader->get_uniform_location(SpotLightCutoffAngleCosineUniform), count, spot_lights.cutoff_angle_cosines.data());
+            glUniform1fv(_shader->get_uniform_location(SpotLightIntensityUniform), count, spot_lights.intensities.data());
+            glUniform1fv(_shader->get_uniform_location(SpotLightConstantAttenuationUniform), count, spot_lights.constant_attenuations.data());
+            glUniform1fv(_shader->get_uniform_location(SpotLightLinearAttenuationUniform), count, spot_lights.linear_attenuations.data());
+            glUniform1fv(_shader->get_uniform_location(SpotLightQuadraticAttenuationUniform), count, spot_lights.quadratic_attenuations.data());
+            if (_shader_shadows_enabled)
+            {
+                glUniform1iv(_shader->get_uniform_location(SpotLightShadowMapBeginUniform), count, spot_lights.shadow_map_begins.data());
+                glUniform1iv(_shader->get_uniform_location(SpotLightShadowMapEndUniform), count, spot_lights.shadow_map_ends.data());
+            }
+        }
+
+        static void _gather_lights(const LightArrays &lights, const uint32_t *light_indices, uint32_t light_count,
+                                   LightArrays &gathered_lights)
+        {
+            gathered_lights.resize(light_count);
+            for (uint32_t i = 0; i < light_count; ++i)
+            {
+                uint32_t light = light_indices[i];
+                gathered_lights.enabled[i] = lights.enabled[light];
+                gathered_lights.two_sided[i] = lights.two_sided[light];
+                gathered_lights.world_positions[i] = lights.world_positions[light];
+                gathered_lights.view_positions[i] = lights.view_positions[light];
+                gathered_lights.view_directions[i] = lights.view_directions[light];
+                gathered_lights.ambient_colors[i] = lights.ambient_colors[light];
+                gathered_lights.diffuse_colors[i] = lights.diffuse_colors[light];
+                gathered_lights.specular_colors[i] = lights.specular_colors[light];
+                gathered_lights.exponents[i] = lights.exponents[light];
+                gathered_lights.cutoff_angle_cosines[i] = lights.cutoff_angle_cosines[light];
+                gathered_lights.intensities[i] = lights.intensities[light];
+                gathered_lights.constant_attenuations[i] = lights.constant_attenuations[light];
+                gathered_lights.linear_attenuations[i] = lights.linear_attenuations[light];
+                gathered_lights.quadratic_attenuations[i] = lights.quadratic_attenuations[light];
+                gathered_lights.influence_radii[i] = lights.influence_radii[light];
+                gathered_lights.shadow_map_begins[i] = lights.shadow_map_begins[light];
+                gathered_lights.shadow_map_ends[i] = lights.shadow_map_ends[light];
+            }
+        }
+
+        static size_t _calculate_light_capacity(size_t light_capacity, size_t light_count)
+        {
+            while (light_capacity < light_count)
+            {
+                light_capacity *= 2;
+            }
+
+            return light_capacity;
+        }
+
+        // The textures and the fog the material uses are compiled into its shader, so every fragment skips the
+        // features that are off instead of branching on them. Toggling a feature switches to another variant
+        // from the shader cache, and the previous one is kept, so switching back does not compile it again.
+        bool _update_feature_defines_if_necessary()
+        {
+            _track_texture_versions();
+            if (_feature_defines_version == _version)
+            {
+                return false;
+            }
+            _feature_defines_version = _version;
+
+            ES2ShaderCache::defines_type feature_defines;
+            if (_texture1 && _texture1->is_enabled())
+            {
+                feature_defines["TEXTURE1"] = "1";
+                feature_defines["TEXTURING_MODE1"] = std::to_string(static_cast<int>(_texture1->get_mode()));
+                if (_texture1->is_transformation_enabled() || _texture1->has_region())
                 {
-                    for (size_t i = 0; i < point_light_count; ++i)
-                    {
-                        uniform_map[_uniform_at_index(uniform, i)] = -1;
-                    }
+                    feature_defines["TEXTURE1_TRANSFORMATION"] = "1";
                 }
-                for (const auto &uniform : spot_light_uniforms)
+            }
+            if (_texture1_normals && _texture1_normals->is_enabled())
+            {
+                feature_defines["TEXTURE1_NORMALS"] = "1";
+            }
+            if (_texture2 && _texture2->is_enabled())
+            {
+                feature_defines["TEXTURE2"] = "1";
+                feature_defines["TEXTURING_MODE2"] = std::to_string(static_cast<int>(_texture2->get_mode()));
+                if (_texture2->is_transformation_enabled() || _texture2->has_region())
                 {
-                    for (size_t i = 0; i < spot_light_count; ++i)
-                    {
-                        uniform_map[_uniform_at_index(uniform, i)] = -1;
-                    }
+                    feature_defines["TEXTURE2_TRANSFORMATION"] = "1";
                 }
+            }
+            if (_fog_enabled)
+            {
+                feature_defines["FOG"] = "1";
+                feature_defines["FOG_TYPE"] = std::to_string(static_cast<int>(_fog_type));
+                feature_defines["FOG_DEPTH"] = std::to_string(static_cast<int>(_fog_depth));
+            }
 
-                _shader->set_fragment_shader_source(
-                    "#define DIRECTIONAL_LIGHT_COUNT " + std::to_string(directional_light_count) + "\n" +
-                    "#define POINT_LIGHT_COUNT " + std::to_string(point_light_count) + "\n" +
-                    "#define SPOT_LIGHT_COUNT " + std::to_string(spot_light_count) + "\n\n" +
-                    _fragment_shader_source);
-                _shader->compile();
+            if (feature_defines == _feature_defines)
+            {
+                return false;
+            }
+            _feature_defines = std::move(feature_defines);
+
+            return true;
+        }
+
+        void _acquire_shader()
+        {
+            std::vector<std::string> attributes{
+                "position",
+                "color",
+                "normal",
+                "tangent",
+                "binormal",
+                "texture1_coordinates",
+                "texture2_coordinates"};
+
+            std::vector<std::string> uniforms{
+                "model_view_matrix",
+                "projection_matrix",
+                "normal_matrix",
+                "point_size",
+
+                "ambient_light_color",
+                "directional_light_count",
+                "point_light_count",
+                "spot_light_count",
+
+                "material_ambient_color",
+                "material_diffuse_color",
+                "material_emission_color",
+                "material_specular_color",
+                "material_specular_exponent",
 
-                _previous_directional_light_count = directional_light_count;
-                _previous_point_light_count = point_light_count;
-                _previous_spot_light_count = spot_light_count;
+                "directional_light_enabled[0]",
+                "directional_light_two_sided[0]",
+                "directional_light_view_direction[0]",
+                "directional_light_ambient_color[0]",
+                "directional_light_diffuse_color[0]",
+                "directional_light_specular_color[0]",
+                "directional_light_intensity[0]",
+
+                "point_light_enabled[0]",
+                "point_light_two_sided[0]",
+                "point_light_view_position[0]",
+                "point_light_ambient_color[0]",
+                "point_light_diffuse_color[0]",
+                "point_light_specular_color[0]",
+                "point_light_intensity[0]",
+                "point_light_constant_attenuation[0]",
+                "point_light_linear_attenuation[0]",
+                "point_light_quadratic_attenuation[0]",
+
+                "spot_light_enabled[0]",
+                "spot_light_two_sided[0]",
+                "spot_light_view_position[0]",
+                "spot_light_view_direction[0]",
+                "spot_light_ambient_color[0]",
+                "spot_light_diffuse_color[0]",
+                "spot_light_specular_color[0]",
+                "spot_light_exponent[0]",
+                "spot_light_cutoff_angle_cosine[0]",
+                "spot_light_intensity[0]",
+                "spot_light_constant_attenuation[0]",
+                "spot_light_linear_attenuation[0]",
+                "spot_light_quadratic_attenuation[0]",
+
+                "light_cluster_sampler",
+                "light_index_sampler",
+                "light_data_sampler",
+                "light_cluster_projection_matrix",
+                "light_cluster_depth_scale",
+                "light_cluster_depth_bias",
+                "light_index_texture_height",
+                "light_data_texture_height",
+
+                "shadow_atlas_sampler",
+                "shadow_atlas_texel_size",
+                "shadow_map_texture_matrix[0]",
+                "shadow_map_region[0]",
+                "shadow_map_far_depth[0]",
+                "shadow_map_bias[0]",
+                "directional_light_shadow_map_begin[0]",
+                "directional_light_shadow_map_end[0]",
+                "spot_light_shadow_map_begin[0]",
+                "spot_light_shadow_map_end[0]",
+
+                "texture1_sampler",
+                "texture1_transformation_matrix",
+                "texture1_normals_sampler",
+
+                "texture2_sampler",
+                "texture2_transformation_matrix",
+
+                "fog_color",
+                "fog_far_minus_near_plane",
+                "fog_far_plane",
+                "fog_density"};
+
+            ES2ShaderCache::defines_type defines{
+                {"DIRECTIONAL_LIGHT_CAPACITY", std::to_string(_directional_light_capacity)},
+                {"POINT_LIGHT_CAPACITY", std::to_string(_point_light_capacity)},
+                {"SPOT_LIGHT_CAPACITY", std::to_string(_spot_light_capacity)}};
+            if (_clustered_lighting_enabled)
+            {
+                defines["CLUSTERED_LIGHTING"] = "1";
+                defines["LIGHT_CLUSTER_TILE_COUNT_X"] = std::to_string(LightClusters::TILE_COUNT_X);
+                defines["LIGHT_CLUSTER_TILE_COUNT_Y"] = std::to_string(LightClusters::TILE_COUNT_Y);
+                defines["LIGHT_CLUSTER_SLICE_COUNT"] = std::to_string(LightClusters::SLICE_COUNT);
+                defines["MAX_LIGHTS_PER_CLUSTER"] = std::to_string(LightClusters::MAX_LIGHTS_PER_CLUSTER);
+                defines["LIGHT_INDEX_TEXTURE_WIDTH"] = std::to_string(LightClusters::LIGHT_INDEX_TEXTURE_WIDTH);
+                defines["LIGHT_DATA_TEXTURE_WIDTH"] = std::to_string(LightClusters::LIGHT_DATA_TEXTURE_WIDTH);
             }
+            if (_shadows_enabled)
+            {
+                defines["SHADOWS"] = "1";
+                defines["SHADOW_MAP_CAPACITY"] = std::to_string(ShadowMapArrays::MAX_COUNT);
+            }
+            defines.insert(_feature_defines.begin(), _feature_defines.end());
+            if (_instancing_enabled)
+            {
+                defines["INSTANCING"] = "1";
+                if (!ES2InstancedMesh::is_hardware_instancing_supported())
+                {
+                    defines["INSTANCE_BATCH_SIZE"] = std::to_string(ES2InstancedMesh::MAX_BATCHED_INSTANCES);
+                }
+            }
+
+            _previous_shader = std::move(_shader);
+            _shader = ES2ShaderCache::get_instance().get_shader(
+                "data/shaders/es2_phong_shader.vert", "data/shaders/es2_phong_shader.frag",
+                attributes, uniforms, defines);
+            _shader_instancing_enabled = _instancing_enabled;
+            _shader_clustered_lighting_enabled = _clustered_lighting_enabled;
+            _shader_shadows_enabled = _shadows_enabled;
         }
 
         static GLenum _convert_depth_test_func_to_es2_depth_test_func(Material::DepthTestFunction depth_test_function)
@@ -751,12 +856,20 @@ namespace asr
             return GL_CW;
         }
 
-        std::string _vertex_shader_source;
-        std::string _fragment_shader_source;
-
-        size_t _previous_directional_light_count{1};
-        size_t _previous_point_light_count{1};
-        size_t _previous_spot_light_count{0};
+        size_t _directional_light_capacity{DEFAULT_LIGHT_CAPACITY};
+        size_t _point_light_capacity{DEFAULT_LIGHT_CAPACITY};
+        size_t _spot_light_capacity{DEFAULT_LIGHT_CAPACITY};
+        bool _clustered_lighting_enabled{false};
+        bool _shadows_enabled{false};
+        bool _shader_instancing_enabled{false};
+        bool _shader_clustered_lighting_enabled{false};
+        bool _shader_shadows_enabled{false};
+        ES2ShaderCache::defines_type _feature_defines;
+        uint64_t _feature_defines_version{0};
+        std::shared_ptr<Shader> _previous_shader;
+
+        LightArrays _selected_point_lights;
+        LightArrays _selected_spot_lights;
     };
 }
 
@@ -2,16 +2,19 @@
 #define MATERIAL_H
 
 #include "renderer/shader.h"
-#include "scene/scene.h"
-#include "objects/mesh.h"
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <memory>
 
 namespace asr
 {
-    class Mesh;
+    class FrameConstants;
+    class Texture;
+    class PhongMaterial;
+    class ConstantMaterial;
+    struct LightSelection;
 
     class Material
     {
@@ -116,6 +119,7 @@ namespace asr
         void set_point_sizing_enabled(bool point_sizing_enabled)
         {
             _point_sizing_enabled = point_sizing_enabled;
+            _mark_changed();
         }
 
         [[nodiscard]] float get_point_size() const
@@ -126,6 +130,7 @@ namespace asr
         void set_point_size(float point_size)
         {
             _point_size = point_size;
+            _mark_changed();
         }
 
         [[nodiscard]] bool prefer_point_size_from_geometry() const
@@ -136,6 +141,7 @@ namespace asr
         void set_prefer_point_size_from_geometry(bool prefer_point_size_from_geometry)
         {
             _prefer_point_size_from_geometry = prefer_point_size_from_geometry;
+            _mark_changed();
         }
 
         [[nodiscard]] bool is_depth_mask_enabled() const
@@ -316,6 +322,7 @@ namespace asr
         void set_fog_enabled(bool fog_enabled)
         {
             _fog_enabled = fog_enabled;
+            _mark_changed();
         }
 
         [[nodiscard]] FogType get_fog_type() const
@@ -326,6 +333,7 @@ namespace asr
         void set_fog_type(FogType fog_type)
         {
             _fog_type = fog_type;
+            _mark_changed();
         }
 
         [[nodiscard]] FogDepth get_fog_depth() const
@@ -336,6 +344,7 @@ namespace asr
         void set_fog_depth(FogDepth fog_depth)
         {
             _fog_depth = fog_depth;
+            _mark_changed();
         }
 
         [[nodiscard]] const glm::vec3 &get_fog_color() const
@@ -346,6 +355,7 @@ namespace asr
         void set_fog_color(const glm::vec3 &fog_color)
         {
             _fog_color = fog_color;
+            _mark_changed();
         }
 
         [[nodiscard]] float get_fog_near_plane() const
@@ -356,6 +366,7 @@ namespace asr
         void set_fog_near_plane(float fog_near_plane)
         {
             _fog_near_plane = fog_near_plane;
+            _mark_changed();
         }
 
         [[nodiscard]] float get_fog_far_plane() const
@@ -366,6 +377,7 @@ namespace asr
         void set_fog_far_plane(float fog_far_plane)
         {
             _fog_far_plane = fog_far_plane;
+            _mark_changed();
         }
 
         [[nodiscard]] float get_fog_density() const
@@ -376,6 +388,7 @@ namespace asr
         void set_fog_density(float fog_density)
         {
             _fog_density = fog_density;
+            _mark_changed();
         }
 
         [[nodiscard]] bool is_transparent() const
@@ -385,7 +398,11 @@ namespace asr
 
         void set_transparent(bool transparent)
         {
-            _transparent = transparent;
+            if (_transparent != transparent)
+            {
+                _transparent = transparent;
+                ++_bucket_version;
+            }
         }
 
         [[nodiscard]] bool is_overlay() const
@@ -395,7 +412,11 @@ namespace asr
 
         void set_overlay(bool overlay)
         {
-            _overlay = overlay;
+            if (_overlay != overlay)
+            {
+                _overlay = overlay;
+                ++_bucket_version;
+            }
         }
 
         [[nodiscard]] int get_overlay_priority() const
@@ -405,14 +426,83 @@ namespace asr
 
         void set_overlay_priority(int overlay_priority)
         {
-            _overlay_priority = overlay_priority;
+            if (_overlay_priority != overlay_priority)
+            {
+                _overlay_priority = overlay_priority;
+                ++_bucket_version;
+            }
         }
 
-        virtual void update(std::shared_ptr<Scene> scene, std::shared_ptr<Mesh> mesh) = 0;
+        [[nodiscard]] bool is_instancing_enabled() const
+        {
+            return _instancing_enabled;
+        }
+
+        void set_instancing_enabled(bool instancing_enabled)
+        {
+            _instancing_enabled = instancing_enabled;
+        }
+
+        [[nodiscard]] static unsigned int get_bucket_version()
+        {
+            return _bucket_version;
+        }
+
+        // Changes with every parameter that is uploaded as a uniform. The versions of all materials are taken
+        // from one clock, so a shader that remembers the version it was last set up with knows whether the
+        // uniforms of a material are still in place.
+        [[nodiscard]] uint64_t get_version() const
+        {
+            return _version;
+        }
+
+        [[nodiscard]] uint32_t get_render_state_key() const
+        {
+            uint32_t key{0};
+            key = (key << 1u) | static_cast<uint32_t>(_depth_mask_enabled);
+            key = (key << 1u) | static_cast<uint32_t>(_depth_test_enabled);
+            key = (key << 3u) | static_cast<uint32_t>(_depth_test_function);
+            key = (key << 1u) | static_cast<uint32_t>(_blending_enabled);
+            key = (key << 2u) | static_cast<uint32_t>(_color_blending_equation);
+            key = (key << 2u) | static_cast<uint32_t>(_alpha_blending_equation);
+            key = (key << 4u) | static_cast<uint32_t>(_source_color_blending_function);
+            key = (key << 4u) | static_cast<uint32_t>(_destination_color_blending_function);
+            key = (key << 4u) | static_cast<uint32_t>(_source_alpha_blending_function);
+            key = (key << 4u) | static_cast<uint32_t>(_destination_alpha_blending_function);
+            key = (key << 1u) | static_cast<uint32_t>(_face_culling_enabled);
+            key = (key << 2u) | static_cast<uint32_t>(_cull_face_mode);
+            key = (key << 1u) | static_cast<uint32_t>(_front_face_order);
+            key = (key << 1u) | static_cast<uint32_t>(_polygon_offset_enabled);
+
+            return key;
+        }
+
+        [[nodiscard]] virtual const Texture *get_primary_texture() const
+        {
+            return nullptr;
+        }
+
+        virtual PhongMaterial *as_phong_material()
+        {
+            return nullptr;
+        }
+
+        virtual ConstantMaterial *as_constant_material()
+        {
+            return nullptr;
+        }
+
+        virtual void update(const FrameConstants &frame_constants, const glm::mat4 &world_matrix,
+                            const LightSelection &light_selection) = 0;
 
         virtual void use() = 0;
 
     protected:
+        inline static unsigned int _bucket_version{0};
+
+        inline static uint64_t _version_clock{0};
+        uint64_t _version{++_version_clock};
+
         std::shared_ptr<Shader> _shader;
 
         float _line_width{1.0f};
@@ -455,6 +545,13 @@ namespace asr
         bool _transparent{false};
         bool _overlay{false};
         int _overlay_priority{0};
+
+        bool _instancing_enabled{false};
+
+        void _mark_changed()
+        {
+            _version = ++_version_clock;
+        }
     };
 }
 
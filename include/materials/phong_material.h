@@ -6,6 +6,9 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <iterator>
+
 namespace asr
 {
     class PhongMaterial : public Material
@@ -19,6 +22,7 @@ namespace asr
         void set_ambient_color(const glm::vec3 &ambient_color)
         {
             _ambient_color = ambient_color;
+            _mark_changed();
         }
 
         [[nodiscard]] const glm::vec4 &get_diffuse_color() const
@@ -29,6 +33,7 @@ namespace asr
         void set_diffuse_color(const glm::vec4 &diffuse_color)
         {
             _diffuse_color = diffuse_color;
+            _mark_changed();
         }
 
         [[nodiscard]] const glm::vec4 &get_emission_color() const
@@ -39,6 +44,7 @@ namespace asr
         void set_emission_color(const glm::vec4 &emission_color)
         {
             _emission_color = emission_color;
+            _mark_changed();
         }
 
         [[nodiscard]] const glm::vec3 &get_specular_color() const
@@ -49,6 +55,7 @@ namespace asr
         void set_specular_color(const glm::vec3 &specular_color)
         {
             _specular_color = specular_color;
+            _mark_changed();
         }
 
         [[nodiscard]] float get_specular_exponent() const
@@ -59,6 +66,7 @@ namespace asr
         void set_specular_exponent(float specular_exponent)
         {
             _specular_exponent = specular_exponent;
+            _mark_changed();
         }
 
         [[nodiscard]] const std::shared_ptr<Texture> &get_texture_1() const
@@ -69,6 +77,7 @@ namespace asr
         void set_texture_1(const std::shared_ptr<Texture> &texture_1)
         {
             _texture1 = texture_1;
+            _mark_changed();
         }
 
         [[nodiscard]] const std::shared_ptr<Texture> &get_texture_1_normals() const
@@ -79,6 +88,7 @@ namespace asr
         void set_texture_1_normals(const std::shared_ptr<Texture> &texture_1_normals)
         {
             _texture1_normals = texture_1_normals;
+            _mark_changed();
         }
 
         [[nodiscard]] const std::shared_ptr<Texture> &get_texture_2() const
@@ -89,6 +99,17 @@ namespace asr
         void set_texture_2(const std::shared_ptr<Texture> &texture_2)
         {
             _texture2 = texture_2;
+            _mark_changed();
+        }
+
+        [[nodiscard]] const Texture *get_primary_texture() const override
+        {
+            return _texture1.get();
+        }
+
+        PhongMaterial *as_phong_material() final
+        {
+            return this;
         }
 
     protected:
@@ -103,6 +124,22 @@ namespace asr
         std::shared_ptr<Texture> _texture1_normals;
 
         std::shared_ptr<Texture> _texture2;
+
+        unsigned int _texture_versions[3]{};
+
+        // Textures change their uniforms without the material, so their versions are compared on every update.
+        void _track_texture_versions()
+        {
+            unsigned int texture_versions[3]{
+                _texture1 ? _texture1->get_version() : 0u,
+                _texture1_normals ? _texture1_normals->get_version() : 0u,
+                _texture2 ? _texture2->get_version() : 0u};
+            if (!std::equal(std::begin(texture_versions), std::end(texture_versions), std::begin(_texture_versions)))
+            {
+                std::copy(std::begin(texture_versions), std::end(texture_versions), std::begin(_texture_versions));
+                _mark_changed();
+            }
+        }
     };
 }
 
@@ -75,6 +75,12 @@ namespace asr
             return _size_halved;
         }
 
+        void expand(const AABB &other)
+        {
+            set_minimum(glm::min(_minimum, other._minimum));
+            set_maximum(glm::max(_maximum, other._maximum));
+        }
+
         void transform(glm::mat4 transformation_matrix)
         {
             glm::vec4 points[] = {
@@ -141,7 +147,7 @@ namespace asr
 
         void _update_supporting_values()
         {
-            _center = _maximum + _minimum * 0.5f;
+            _center = (_maximum + _minimum) * 0.5f;
             _size = _maximum - _minimum;
             _size_halved = _size * 0.5f;
 
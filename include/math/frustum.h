@@ -0,0 +1,86 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "math/plane.h"
+#include "math/aabb.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace asr
+{
+    class Frustum
+    {
+    public:
+        Frustum()
+        {
+            update(glm::mat4{1.0f});
+        }
+
+        explicit Frustum(const glm::mat4 &view_projection_matrix)
+        {
+            update(view_projection_matrix);
+        }
+
+        [[nodiscard]] const std::vector<Plane> &get_planes() const
+        {
+            return _planes;
+        }
+
+        void update(const glm::mat4 &view_projection_matrix)
+        {
+            glm::vec4 row_x{view_projection_matrix[0][0], view_projection_matrix[1][0], view_projection_matrix[2][0], view_projection_matrix[3][0]};
+            glm::vec4 row_y{view_projection_matrix[0][1], view_projection_matrix[1][1], view_projection_matrix[2][1], view_projection_matrix[3][1]};
+            glm::vec4 row_z{view_projection_matrix[0][2], view_projection_matrix[1][2], view_projection_matrix[2][2], view_projection_matrix[3][2]};
+            glm::vec4 row_w{view_projection_matrix[0][3], view_projection_matrix[1][3], view_projection_matrix[2][3], view_projection_matrix[3][3]};
+
+            _planes.clear();
+            _add_plane(row_w + row_x);
+            _add_plane(row_w - row_x);
+            _add_plane(row_w + row_y);
+            _add_plane(row_w - row_y);
+            _add_plane(row_w + row_z);
+            _add_plane(row_w - row_z);
+        }
+
+        [[nodiscard]] bool intersects(const AABB &box) const
+        {
+            const glm::vec3 &minimum = box.get_minimum();
+            const glm::vec3 &maximum = box.get_maximum();
+            for (const auto &plane : _planes)
+            {
+                const glm::vec3 &normal = plane.get_normal();
+                glm::vec3 positive_vertex{
+                    normal.x >= 0.0f ? maximum.x : minimum.x,
+                    normal.y >= 0.0f ? maximum.y : minimum.y,
+                    normal.z >= 0.0f ? maximum.z : minimum.z};
+                if (glm::dot(normal, positive_vertex) + plane.get_distance() < 0.0f)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+    private:
+        std::vector<Plane> _planes;
+
+        void _add_plane(const glm::vec4 &coefficients)
+        {
+            glm::vec3 normal{coefficients};
+            float length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                _planes.emplace_back(normal / length, coefficients.w / length);
+            }
+            else
+            {
+                _planes.emplace_back(normal, coefficients.w);
+            }
+        }
+    };
+}
+
+#endif
@@ -3,11 +3,13 @@
 
 #include "math/plane.h"
 #include "math/sphere.h"
+#include "math/aabb.h"
 
 #include <glm/glm.hpp>
 
 #include <utility>
 #include <cmath>
+#include <cfloat>
 
 namespace asr
 {
@@ -82,6 +84,90 @@ namespace asr
             return std::make_pair(intersects, distance);
         }
 
+        [[nodiscard]] intersection_test_result_type intersects_with_aabb(const AABB &box) const
+        {
+            return intersects_with_aabb(box.get_minimum(), box.get_maximum());
+        }
+
+        [[nodiscard]] intersection_test_result_type intersects_with_aabb(const glm::vec3 &minimum, const glm::vec3 &maximum) const
+        {
+            float near_distance = -INFINITY;
+            float far_distance = INFINITY;
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (fabsf(_direction[axis]) < FLT_EPSILON)
+                {
+                    if (_origin[axis] < minimum[axis] || _origin[axis] > maximum[axis])
+                    {
+                        return std::make_pair(false, 0.0f);
+                    }
+                    continue;
+                }
+
+                float inverse_direction = 1.0f / _direction[axis];
+                float first = (minimum[axis] - _origin[axis]) * inverse_direction;
+                float second = (maximum[axis] - _origin[axis]) * inverse_direction;
+                if (first > second)
+                {
+                    std::swap(first, second);
+                }
+
+                near_distance = fmaxf(near_distance, first);
+                far_distance = fminf(far_distance, second);
+                if (near_distance > far_distance || far_distance < 0.0f)
+                {
+                    return std::make_pair(false, 0.0f);
+                }
+            }
+
+            return std::make_pair(true, fmaxf(near_distance, 0.0f));
+        }
+
+        [[nodiscard]] intersection_test_result_type intersects_with_triangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) const
+        {
+            glm::vec2 barycentric_coordinates;
+            return intersects_with_triangle(a, b, c, barycentric_coordinates);
+        }
+
+        // Hits both sides of the triangle. The barycentric coordinates are the weights of b and c at the hit.
+        [[nodiscard]] intersection_test_result_type intersects_with_triangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c,
+                                                                             glm::vec2 &barycentric_coordinates) const
+        {
+            glm::vec3 edge1 = b - a;
+            glm::vec3 edge2 = c - a;
+            glm::vec3 p = glm::cross(_direction, edge2);
+            float determinant = glm::dot(edge1, p);
+            if (fabsf(determinant) < FLT_MIN)
+            {
+                return std::make_pair(false, 0.0f);
+            }
+
+            float inverse_determinant = 1.0f / determinant;
+            glm::vec3 t = _origin - a;
+            float u = glm::dot(t, p) * inverse_determinant;
+            if (u < 0.0f || u > 1.0f)
+            {
+                return std::make_pair(false, 0.0f);
+            }
+
+            glm::vec3 q = glm::cross(t, edge1);
+            float v = glm::dot(_direction, q) * inverse_determinant;
+            if (v < 0.0f || u + v > 1.0f)
+            {
+                return std::make_pair(false, 0.0f);
+            }
+
+            float distance = glm::dot(edge2, q) * inverse_determinant;
+            if (distance < 0.0f)
+            {
+                return std::make_pair(false, 0.0f);
+            }
+            barycentric_coordinates = glm::vec2(u, v);
+
+            return std::make_pair(true, distance);
+        }
+
     private:
         glm::vec3 _origin;
         glm::vec3 _direction;
@@ -202,28 +202,6 @@ namespace asr
             return _view_projection_matrix;
         }
 
-        void set_model_matrix_requires_update(bool model_matrix_requires_update) final
-        {
-            Object::set_model_matrix_requires_update(model_matrix_requires_update);
-
-            if (model_matrix_requires_update)
-            {
-                _view_matrix_requires_update = true;
-                _view_projection_matrix_requires_update = true;
-            }
-        }
-
-        void set_world_matrix_requires_update(bool world_matrix_requires_update) final
-        {
-            Object::set_world_matrix_requires_update(world_matrix_requires_update);
-
-            if (world_matrix_requires_update)
-            {
-                _view_matrix_requires_update = true;
-                _view_projection_matrix_requires_update = true;
-            }
-        }
-
         bool is_view_matrix_requires_update() const
         {
             return _view_matrix_requires_update;
@@ -302,6 +280,7 @@ namespace asr
 
         bool _view_matrix_requires_update{true};
         glm::mat4 _view_matrix{1.0f};
+        unsigned int _view_matrix_world_matrix_version{0};
         bool _projection_matrix_requires_update{true};
         glm::mat4 _projection_matrix{1.0f};
         bool _view_projection_matrix_requires_update{true};
@@ -309,12 +288,13 @@ namespace asr
 
         void _update_view_matrix_if_necessary()
         {
-            if (_view_matrix_requires_update)
+            _update_world_matrix_if_necessary();
+            if (_view_matrix_requires_update || _view_matrix_world_matrix_version != _world_matrix_version)
             {
-                _update_world_matrix_if_necessary();
-
                 _view_matrix = glm::inverse(_world_matrix);
+                _view_matrix_world_matrix_version = _world_matrix_version;
                 _view_matrix_requires_update = false;
+                _view_projection_matrix_requires_update = true;
             }
         }
 
@@ -344,11 +324,10 @@ namespace asr
 
         void _update_view_projection_matrix_if_necessary()
         {
+            _update_view_matrix_if_necessary();
+            _update_projection_matrix_if_necessary();
             if (_view_projection_matrix_requires_update)
             {
-                _update_view_matrix_if_necessary();
-                _update_projection_matrix_if_necessary();
-
                 _view_projection_matrix = _projection_matrix * _view_matrix;
                 _view_projection_matrix_requires_update = false;
             }
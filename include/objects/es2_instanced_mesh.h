@@ -0,0 +1,485 @@
+#ifndef ES2_INSTANCED_MESH_H
+#define ES2_INSTANCED_MESH_H
+
+#include "objects/instanced_mesh.h"
+#include "geometries/vertex_layout.h"
+#include "renderer/es2_state_cache.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace asr
+{
+    // Uses ARB_instanced_arrays when available. On plain ES2 the geometry is replicated MAX_BATCHED_INSTANCES
+    // times with a per-copy index, and instance data is uploaded as uniform arrays, one draw call per batch.
+    class ES2InstancedMesh final : public InstancedMesh
+    {
+    public:
+        inline static const unsigned int MAX_BATCHED_INSTANCES = 16;
+
+        ES2InstancedMesh(std::shared_ptr<Geometry> geometry, std::shared_ptr<Material> material,
+                         const glm::vec3 &position = glm::vec4(0.0f),
+                         const glm::vec3 &rotation = glm::vec4(0.0f),
+                         const glm::vec3 &scale = glm::vec4(1.0f),
+                         std::weak_ptr<Object> parent = {})
+            : InstancedMesh(std::move(geometry), std::move(material), position, rotation, scale, std::move(parent))
+        {
+        }
+
+        ES2InstancedMesh(const ES2InstancedMesh &other) = delete;
+        ES2InstancedMesh &operator=(const ES2InstancedMesh &other) = delete;
+
+        ~ES2InstancedMesh() final
+        {
+            if (_batch_vertex_array_object != 0)
+            {
+                ES2StateCache::get_instance().forget_vertex_array(_batch_vertex_array_object);
+#ifdef __APPLE__
+                glDeleteVertexArraysAPPLE(1, &_batch_vertex_array_object);
+#else
+                glDeleteVertexArrays(1, &_batch_vertex_array_object);
+#endif
+            }
+
+            if (_batch_index_buffer_object != 0)
+            {
+                glDeleteBuffers(1, &_batch_index_buffer_object);
+            }
+
+            if (_batch_vertex_buffer_object != 0)
+            {
+                glDeleteBuffers(1, &_batch_vertex_buffer_object);
+            }
+
+            if (_instance_buffer_object != 0)
+            {
+                glDeleteBuffers(1, &_instance_buffer_object);
+            }
+        }
+
+        static bool is_hardware_instancing_supported()
+        {
+            static const bool hardware_instancing_supported = [] {
+                if (!(GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced))
+                {
+                    return false;
+                }
+
+                GLint max_vertex_attributes{0};
+                glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &max_vertex_attributes);
+                return max_vertex_attributes >= static_cast<GLint>(VertexLayout::InstanceAttributeEnd);
+            }();
+
+            return hardware_instancing_supported;
+        }
+
+        void update() final
+        {
+            if (is_hardware_instancing_supported())
+            {
+                if (_requires_instances_update)
+                {
+                    _update_instance_buffer();
+                }
+            }
+            else if (_is_batchable(get_geometry()->get_type()) && _requires_batch_update())
+            {
+                _update_batch_buffers();
+            }
+
+            _requires_instances_update = false;
+        }
+
+        size_t draw() final
+        {
+            if (_instance_transforms.empty())
+            {
+                return 0;
+            }
+
+            const auto &geometry = get_geometry();
+            GLenum mode = _convert_geometry_type_to_es2_geometry_type(geometry->get_type());
+            auto index_count = static_cast<GLsizei>(geometry->get_index_count());
+
+            if (is_hardware_instancing_supported())
+            {
+                _draw_instanced(mode, index_count);
+                return 1;
+            }
+
+            return _draw_batched(mode, index_count);
+        }
+
+    private:
+        inline static const size_t INSTANCE_FLOAT_COUNT = 24;
+
+        GLuint _instance_buffer_object{0};
+        size_t _instance_buffer_capacity{0};
+        std::vector<float> _packed_instances;
+
+        GLuint _batch_vertex_array_object{0};
+        GLuint _batch_vertex_buffer_object{0};
+        GLuint _batch_index_buffer_object{0};
+        VertexLayout _batch_vertex_layout;
+        size_t _batch_source_vertex_count{0};
+        size_t _batch_source_index_count{0};
+        std::vector<uint8_t> _packed_vertices;
+        std::vector<uint8_t> _batch_vertices;
+        std::vector<unsigned int> _batch_indices;
+        size_t _batch_index_size{sizeof(unsigned int)};
+
+        int _uniform_program{-1};
+        GLint _instance_model_matrices_uniform_location{-1};
+        GLint _instance_colors_uniform_location{-1};
+        GLint _instance_texture_regions_uniform_location{-1};
+
+        void _update_instance_buffer()
+        {
+            size_t instance_count{_instance_transforms.size()};
+            _packed_instances.resize(instance_count * INSTANCE_FLOAT_COUNT);
+            for (size_t i = 0; i < instance_count; ++i)
+            {
+                float *destination = _packed_instances.data() + i * INSTANCE_FLOAT_COUNT;
+                std::memcpy(destination, glm::value_ptr(_instance_transforms[i]), 16 * sizeof(float));
+                std::memcpy(destination + 16, glm::value_ptr(_instance_colors[i]), 4 * sizeof(float));
+                std::memcpy(destination + 20, glm::value_ptr(_instance_texture_regions[i]), 4 * sizeof(float));
+            }
+
+            if (_instance_buffer_object == 0)
+            {
+                glGenBuffers(1, &_instance_buffer_object);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, _instance_buffer_object);
+
+            size_t instance_data_size{_packed_instances.size() * sizeof(float)};
+            if (instance_data_size > _instance_buffer_capacity)
+            {
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instance_data_size), _packed_instances.data(), GL_DYNAMIC_DRAW);
+                _instance_buffer_capacity = instance_data_size;
+            }
+            else
+            {
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_instance_buffer_capacity), nullptr, GL_DYNAMIC_DRAW);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(instance_data_size), _packed_instances.data());
+            }
+            ES2StateCache::get_instance().get_stats().uploaded_buffer_bytes += instance_data_size;
+
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        [[nodiscard]] bool _requires_batch_update() const
+        {
+            const auto &geometry = get_geometry();
+
+            return _batch_vertex_array_object == 0 ||
+                   geometry->requires_vertices_update() ||
+                   geometry->requires_indices_update() ||
+                   geometry->get_vertex_count() != _batch_source_vertex_count ||
+                   geometry->get_index_count() != _batch_source_index_count ||
+                   geometry->get_vertex_layout() != _batch_vertex_layout;
+        }
+
+        void _update_batch_buffers()
+        {
+            const auto &geometry = get_geometry();
+            const auto &vertex_layout = geometry->get_vertex_layout();
+            const size_t vertex_count{geometry->get_vertex_count()};
+            const size_t index_count{geometry->get_index_count()};
+
+            const size_t vertex_stride{vertex_layout.get_stride()};
+            const size_t batch_vertex_stride{vertex_stride + sizeof(float)};
+
+            const uint8_t *packed_vertices;
+            const unsigned int *indices;
+            if (const auto &mesh_data = geometry->get_mesh_data())
+            {
+                packed_vertices = mesh_data->get_vertex_data();
+                indices = mesh_data->get_index_data();
+            }
+            else
+            {
+                const auto &vertices = geometry->get_vertices();
+                _packed_vertices.resize(vertex_count * vertex_stride);
+                vertex_layout.pack(vertices, 0, vertex_count, _packed_vertices.data());
+                packed_vertices = _packed_vertices.data();
+                indices = geometry->get_indices().data();
+            }
+
+            _batch_vertices.resize(vertex_count * batch_vertex_stride * MAX_BATCHED_INSTANCES);
+            _batch_indices.clear();
+            _batch_indices.reserve(index_count * MAX_BATCHED_INSTANCES);
+            for (unsigned int copy = 0; copy < MAX_BATCHED_INSTANCES; ++copy)
+            {
+                auto instance_index = static_cast<float>(copy);
+                for (size_t i = 0; i < vertex_count; ++i)
+                {
+                    uint8_t *destination = _batch_vertices.data() + (copy * vertex_count + i) * batch_vertex_stride;
+                    std::memcpy(destination, packed_vertices + i * vertex_stride, vertex_stride);
+                    std::memcpy(destination + vertex_stride, &instance_index, sizeof(float));
+                }
+
+                auto first_vertex = static_cast<unsigned int>(copy * vertex_count);
+                for (size_t i = 0; i < index_count; ++i)
+                {
+                    _batch_indices.push_back(first_vertex + indices[i]);
+                }
+            }
+
+            auto &state_cache = ES2StateCache::get_instance();
+            state_cache.bind_vertex_array(0);
+
+            if (_batch_vertex_buffer_object == 0)
+            {
+                glGenBuffers(1, &_batch_vertex_buffer_object);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, _batch_vertex_buffer_object);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_batch_vertices.size()), _batch_vertices.data(), GL_STATIC_DRAW);
+
+            if (_batch_index_buffer_object == 0)
+            {
+                glGenBuffers(1, &_batch_index_buffer_object);
+            }
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _batch_index_buffer_object);
+            const void *batch_index_data = _batch_indices.data();
+            _batch_index_size = sizeof(unsigned int);
+            std::vector<uint16_t> short_batch_indices;
+            if (vertex_count * MAX_BATCHED_INSTANCES <= std::numeric_limits<uint16_t>::max() + static_cast<size_t>(1))
+            {
+                short_batch_indices.assign(_batch_indices.begin(), _batch_indices.end());
+                batch_index_data = short_batch_indices.data();
+                _batch_index_size = sizeof(uint16_t);
+            }
+            glBufferData(
+                GL_ELEMENT_ARRAY_BUFFER,
+                static_cast<GLsizeiptr>(_batch_indices.size() * _batch_index_size),
+                batch_index_data,
+                GL_STATIC_DRAW);
+            state_cache.get_stats().uploaded_buffer_bytes +=
+                _batch_vertices.size() + _batch_indices.size() * _batch_index_size;
+
+            if (_batch_vertex_array_object == 0)
+            {
+#ifdef __APPLE__
+                glGenVertexArraysAPPLE(1, &_batch_vertex_array_object);
+#else
+                glGenVertexArrays(1, &_batch_vertex_array_object);
+#endif
+            }
+            state_cache.bind_vertex_array(_batch_vertex_array_object);
+
+            glBindBuffer(GL_ARRAY_BUFFER, _batch_vertex_buffer_object);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _batch_index_buffer_object);
+
+            auto stride = static_cast<GLsizei>(batch_vertex_stride);
+            for (unsigned int attribute = 0; attribute < VertexLayout::AttributeCount; ++attribute)
+            {
+                if (!vertex_layout.has(static_cast<VertexLayout::Attribute>(attribute)))
+                {
+                    glDisableVertexAttribArray(static_cast<GLuint>(attribute));
+                }
+            }
+            for (const auto &element : vertex_layout.get_elements())
+            {
+                auto location = static_cast<GLuint>(element.attribute);
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(
+                    location,
+                    static_cast<GLint>(element.component_count),
+                    _convert_component_type_to_es2_type(element.component_type),
+                    element.component_type == VertexLayout::NormalizedUnsignedByte ||
+                            element.component_type == VertexLayout::NormalizedByte
+                        ? GL_TRUE
+                        : GL_FALSE,
+                    stride,
+                    reinterpret_cast<const GLvoid *>(element.offset));
+            }
+            auto instance_index_location = static_cast<GLuint>(VertexLayout::InstanceIndex);
+            glEnableVertexAttribArray(instance_index_location);
+            glVertexAttribPointer(
+                instance_index_location, 1, GL_FLOAT, GL_FALSE,
+                stride, reinterpret_cast<const GLvoid *>(vertex_stride));
+
+            state_cache.bind_vertex_array(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+            _batch_vertex_layout = vertex_layout;
+            _batch_source_vertex_count = vertex_count;
+            _batch_source_index_count = index_count;
+        }
+
+        void _draw_instanced(GLenum mode, GLsizei index_count)
+        {
+            get_geometry()->use();
+
+            glBindBuffer(GL_ARRAY_BUFFER, _instance_buffer_object);
+
+            auto stride = static_cast<GLsizei>(INSTANCE_FLOAT_COUNT * sizeof(float));
+            for (unsigned int column = 0; column < 4; ++column)
+            {
+                auto location = static_cast<GLuint>(VertexLayout::InstanceModelMatrix + column);
+                glEnableVertexAttribArray(location);
+                glVertexAttribPointer(
+                    location, 4, GL_FLOAT, GL_FALSE,
+                    stride, reinterpret_cast<const GLvoid *>(column * 4 * sizeof(float)));
+                glVertexAttribDivisorARB(location, 1);
+            }
+            auto color_location = static_cast<GLuint>(VertexLayout::InstanceColor);
+            glEnableVertexAttribArray(color_location);
+            glVertexAttribPointer(
+                color_location, 4, GL_FLOAT, GL_FALSE,
+                stride, reinterpret_cast<const GLvoid *>(16 * sizeof(float)));
+            glVertexAttribDivisorARB(color_location, 1);
+            auto texture_region_location = static_cast<GLuint>(VertexLayout::InstanceTextureRegion);
+            glEnableVertexAttribArray(texture_region_location);
+            glVertexAttribPointer(
+                texture_region_location, 4, GL_FLOAT, GL_FALSE,
+                stride, reinterpret_cast<const GLvoid *>(20 * sizeof(float)));
+            glVertexAttribDivisorARB(texture_region_location, 1);
+
+            glDrawElementsInstancedARB(
+                mode, index_count, _convert_index_size_to_es2_index_type(get_geometry()->get_index_size()), nullptr,
+                static_cast<GLsizei>(_instance_transforms.size()));
+
+            for (auto location = static_cast<GLuint>(VertexLayout::InstanceModelMatrix);
+                 location <= static_cast<GLuint>(VertexLayout::InstanceTextureRegion); ++location)
+            {
+                glVertexAttribDivisorARB(location, 0);
+                glDisableVertexAttribArray(location);
+            }
+
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        size_t _draw_batched(GLenum mode, GLsizei index_count)
+        {
+            const auto &shader = get_material()->get_shader();
+            if (!shader->is_compiled())
+            {
+                return 0;
+            }
+            if (_uniform_program != shader->get_program())
+            {
+                auto program = static_cast<GLuint>(shader->get_program());
+                _instance_model_matrices_uniform_location = glGetUniformLocation(program, "instance_model_matrices[0]");
+                _instance_colors_uniform_location = glGetUniformLocation(program, "instance_colors[0]");
+                _instance_texture_regions_uniform_location = glGetUniformLocation(program, "instance_texture_regions[0]");
+                _uniform_program = shader->get_program();
+            }
+
+            const auto &geometry = get_geometry();
+            bool batchable = _is_batchable(geometry->get_type()) && _batch_vertex_array_object != 0;
+            if (batchable)
+            {
+                ES2StateCache::get_instance().bind_vertex_array(_batch_vertex_array_object);
+                if (!_batch_vertex_layout.has(VertexLayout::Color))
+                {
+                    glVertexAttrib4f(static_cast<GLuint>(VertexLayout::Color), 1.0f, 1.0f, 1.0f, 1.0f);
+                }
+            }
+            else
+            {
+                geometry->use();
+            }
+
+            size_t draw_call_count{0};
+            size_t instance_count{_instance_transforms.size()};
+            for (size_t first_instance = 0; first_instance < instance_count; first_instance += MAX_BATCHED_INSTANCES)
+            {
+                auto batch_size = static_cast<GLsizei>(std::min<size_t>(MAX_BATCHED_INSTANCES, instance_count - first_instance));
+
+                glUniformMatrix4fv(
+                    _instance_model_matrices_uniform_location,
+                    batch_size, GL_FALSE,
+                    glm::value_ptr(_instance_transforms[first_instance]));
+                glUniform4fv(
+                    _instance_colors_uniform_location,
+                    batch_size, glm::value_ptr(_instance_colors[first_instance]));
+                glUniform4fv(
+                    _instance_texture_regions_uniform_location,
+                    batch_size, glm::value_ptr(_instance_texture_regions[first_instance]));
+
+                if (batchable)
+                {
+                    glDrawElements(mode, index_count * batch_size, _convert_index_size_to_es2_index_type(_batch_index_size), nullptr);
+                    ++draw_call_count;
+                }
+                else
+                {
+                    for (GLsizei i = 0; i < batch_size; ++i)
+                    {
+                        glVertexAttrib1f(static_cast<GLuint>(VertexLayout::InstanceIndex), static_cast<GLfloat>(i));
+                        glDrawElements(mode, index_count, _convert_index_size_to_es2_index_type(geometry->get_index_size()), nullptr);
+                    }
+                    draw_call_count += static_cast<size_t>(batch_size);
+                }
+            }
+
+            return draw_call_count;
+        }
+
+        static bool _is_batchable(Geometry::Type type)
+        {
+            return type == Geometry::Type::Points || type == Geometry::Type::Lines || type == Geometry::Type::Triangles;
+        }
+
+        static GLenum _convert_component_type_to_es2_type(VertexLayout::ComponentType component_type)
+        {
+            switch (component_type)
+            {
+            case VertexLayout::Float:
+                return GL_FLOAT;
+            case VertexLayout::HalfFloat:
+                return GL_HALF_FLOAT;
+            case VertexLayout::NormalizedUnsignedByte:
+                return GL_UNSIGNED_BYTE;
+            case VertexLayout::NormalizedByte:
+                return GL_BYTE;
+            }
+
+            return GL_FLOAT;
+        }
+
+        static GLenum _convert_index_size_to_es2_index_type(size_t index_size)
+        {
+            return index_size == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        }
+
+        static GLenum _convert_geometry_type_to_es2_geometry_type(Geometry::Type type)
+        {
+            switch (type)
+            {
+            case Geometry::Type::Points:
+                return GL_POINTS;
+            case Geometry::Type::Lines:
+                return GL_LINES;
+            case Geometry::Type::LineLoop:
+                return GL_LINE_LOOP;
+            case Geometry::Type::LineStrip:
+                return GL_LINE_STRIP;
+            case Geometry::Type::Triangles:
+                return GL_TRIANGLES;
+            case Geometry::Type::TriangleFan:
+                return GL_TRIANGLE_FAN;
+            case Geometry::Type::TriangleStrip:
+                return GL_TRIANGLE_STRIP;
+            }
+
+            return GL_TRIANGLES;
+        }
+    };
+}
+
+#endif
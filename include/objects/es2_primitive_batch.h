@@ -0,0 +1,25 @@
+#ifndef ES2_PRIMITIVE_BATCH_H
+#define ES2_PRIMITIVE_BATCH_H
+
+#include "objects/primitive_batch.h"
+#include "geometries/es2_geometry.h"
+
+#include <memory>
+#include <vector>
+
+namespace asr
+{
+    class ES2PrimitiveBatch final : public PrimitiveBatch
+    {
+    public:
+        using PrimitiveBatch::PrimitiveBatch;
+
+    protected:
+        std::shared_ptr<Geometry> _create_geometry() final
+        {
+            return std::make_shared<ES2Geometry>(std::vector<unsigned int>{}, std::vector<Vertex>{});
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef INSTANCED_MESH_H
+#define INSTANCED_MESH_H
+
+#include "objects/mesh.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace asr
+{
+    // Draws one geometry many times with per-instance transforms, colors and texture regions. Instance
+    // transforms are applied in the space of the mesh itself and should not scale non-uniformly, since normals
+    // are not re-inverted per instance. A texture region maps the first texture's coordinates to the part of a
+    // texture atlas an instance shows, as offset and scale. The material switches to its instancing shader variant and should not be shared with
+    // regular meshes.
+    class InstancedMesh : public Mesh
+    {
+    public:
+        InstancedMesh(std::shared_ptr<Geometry> geometry, std::shared_ptr<Material> material,
+                      const glm::vec3 &position = glm::vec4(0.0f),
+                      const glm::vec3 &rotation = glm::vec4(0.0f),
+                      const glm::vec3 &scale = glm::vec4(1.0f),
+                      std::weak_ptr<Object> parent = {})
+            : Mesh(std::move(geometry), std::move(material), position, rotation, scale, std::move(parent))
+        {
+            get_material()->set_instancing_enabled(true);
+        }
+
+        InstancedMesh *as_instanced_mesh() final
+        {
+            return this;
+        }
+
+        [[nodiscard]] size_t get_instance_count() const
+        {
+            return _instance_transforms.size();
+        }
+
+        [[nodiscard]] const std::vector<glm::mat4> &get_instance_transforms() const
+        {
+            return _instance_transforms;
+        }
+
+        [[nodiscard]] const std::vector<glm::vec4> &get_instance_colors() const
+        {
+            return _instance_colors;
+        }
+
+        [[nodiscard]] const std::vector<glm::vec4> &get_instance_texture_regions() const
+        {
+            return _instance_texture_regions;
+        }
+
+        size_t add_instance(const glm::mat4 &transform, const glm::vec4 &color = glm::vec4(1.0f),
+                            const glm::vec4 &texture_region = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f))
+        {
+            _instance_transforms.push_back(transform);
+            _instance_colors.push_back(color);
+            _instance_texture_regions.push_back(texture_region);
+            _requires_instances_update = true;
+            invalidate_world_bounding_box();
+
+            return _instance_transforms.size() - 1;
+        }
+
+        void set_instance_transform(size_t index, const glm::mat4 &transform)
+        {
+            _instance_transforms[index] = transform;
+            _requires_instances_update = true;
+            invalidate_world_bounding_box();
+        }
+
+        void set_instance_color(size_t index, const glm::vec4 &color)
+        {
+            _instance_colors[index] = color;
+            _requires_instances_update = true;
+        }
+
+        void set_instance_texture_region(size_t index, const glm::vec4 &texture_region)
+        {
+            _instance_texture_regions[index] = texture_region;
+            _requires_instances_update = true;
+        }
+
+        void remove_instance(size_t index)
+        {
+            _instance_transforms.erase(_instance_transforms.begin() + static_cast<std::ptrdiff_t>(index));
+            _instance_colors.erase(_instance_colors.begin() + static_cast<std::ptrdiff_t>(index));
+            _instance_texture_regions.erase(_instance_texture_regions.begin() + static_cast<std::ptrdiff_t>(index));
+            _requires_instances_update = true;
+            invalidate_world_bounding_box();
+        }
+
+        void clear_instances()
+        {
+            _instance_transforms.clear();
+            _instance_colors.clear();
+            _instance_texture_regions.clear();
+            _requires_instances_update = true;
+            invalidate_world_bounding_box();
+        }
+
+        [[nodiscard]] bool requires_instances_update() const
+        {
+            return _requires_instances_update;
+        }
+
+        void set_requires_instances_update(bool requires_instances_update)
+        {
+            _requires_instances_update = requires_instances_update;
+        }
+
+        virtual void update() = 0;
+
+        // Returns the number of draw calls that were issued.
+        virtual size_t draw() = 0;
+
+    protected:
+        std::vector<glm::mat4> _instance_transforms;
+        std::vector<glm::vec4> _instance_colors;
+        std::vector<glm::vec4> _instance_texture_regions;
+
+        bool _requires_instances_update{true};
+
+        void _update_world_bounding_box() override
+        {
+            const AABB &bounding_box = get_geometry()->get_bounding_box();
+            const glm::mat4 &world_matrix = get_world_matrix();
+            if (_instance_transforms.empty())
+            {
+                _world_bounding_box = bounding_box;
+                _world_bounding_box.transform(world_matrix);
+                return;
+            }
+
+            for (size_t i = 0; i < _instance_transforms.size(); ++i)
+            {
+                AABB instance_bounding_box{bounding_box};
+                instance_bounding_box.transform(world_matrix * _instance_transforms[i]);
+                if (i == 0)
+                {
+                    _world_bounding_box = instance_bounding_box;
+                }
+                else
+                {
+                    _world_bounding_box.expand(instance_bounding_box);
+                }
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef LOD_MESH_H
+#define LOD_MESH_H
+
+#include "objects/mesh.h"
+#include "objects/camera.h"
+#include "geometries/geometry.h"
+#include "materials/material.h"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+namespace asr
+{
+    // A mesh with several versions of its geometry, from the most detailed one it is created with to the
+    // coarsest one added last. They can be generated with fewer segments or simplified with
+    // geometry_processing::simplify(). The renderer selects a level every frame from the size the mesh covers
+    // on the screen, measured as the projected diameter of its bounding sphere relative to the viewport height.
+    // A level is kept until the size passes its threshold by the hysteresis, so meshes close to a threshold do
+    // not switch back and forth. The bounds of the most detailed level are used for culling at every level.
+    class LODMesh : public Mesh
+    {
+    public:
+        inline static const float DEFAULT_HYSTERESIS = 0.1f;
+
+        LODMesh(const std::shared_ptr<Geometry> &geometry, std::shared_ptr<Material> material,
+                const glm::vec3 &position = glm::vec4(0.0f),
+                const glm::vec3 &rotation = glm::vec4(0.0f),
+                const glm::vec3 &scale = glm::vec4(1.0f),
+                std::weak_ptr<Object> parent = {})
+            : Mesh(geometry, std::move(material), position, rotation, scale, std::move(parent))
+        {
+            _levels.push_back(Level{geometry, std::numeric_limits<float>::infinity()});
+        }
+
+        LODMesh *as_lod_mesh() final
+        {
+            return this;
+        }
+
+        // The geometry is drawn once the mesh covers less than the screen size, which has to be smaller than
+        // the one of the previous level.
+        void add_level(std::shared_ptr<Geometry> geometry, float screen_size)
+        {
+            if (screen_size >= _levels.back().screen_size)
+            {
+                std::cerr << "Failed to add a level of detail, its screen size has to be smaller than the one of the previous level." << std::endl;
+                std::exit(-1);
+            }
+
+            _levels.push_back(Level{std::move(geometry), screen_size});
+        }
+
+        [[nodiscard]] size_t get_level_count() const
+        {
+            return _levels.size();
+        }
+
+        [[nodiscard]] const std::shared_ptr<Geometry> &get_level_geometry(size_t level) const
+        {
+            return _levels[level].geometry;
+        }
+
+        [[nodiscard]] float get_level_screen_size(size_t level) const
+        {
+            return _levels[level].screen_size;
+        }
+
+        [[nodiscard]] size_t get_level() const
+        {
+            return _level;
+        }
+
+        void set_level(size_t level)
+        {
+            if (_level != level)
+            {
+                _level = level;
+                _set_geometry(_levels[level].geometry);
+            }
+        }
+
+        [[nodiscard]] float get_hysteresis() const
+        {
+            return _hysteresis;
+        }
+
+        void set_hysteresis(float hysteresis)
+        {
+            _hysteresis = hysteresis;
+        }
+
+        // The screen size measured by the last select_level().
+        [[nodiscard]] float get_screen_size() const
+        {
+            return _screen_size;
+        }
+
+        float calculate_screen_size(Camera &camera)
+        {
+            const AABB &bounding_box = get_world_bounding_box();
+            glm::vec3 center = (bounding_box.get_minimum() + bounding_box.get_maximum()) * 0.5f;
+            float radius = glm::length(bounding_box.get_maximum() - bounding_box.get_minimum()) * 0.5f;
+
+            // The projection scales the view space height to the two units of the viewport in clip space.
+            float scale = camera.get_projection_matrix()[1][1];
+            if (!camera.is_perspective())
+            {
+                return radius * scale;
+            }
+
+            float distance = glm::length(center - camera.get_world_position());
+            if (distance <= radius)
+            {
+                return std::numeric_limits<float>::infinity();
+            }
+
+            return radius * scale / distance;
+        }
+
+        size_t select_level(Camera &camera)
+        {
+            _screen_size = calculate_screen_size(camera);
+
+            size_t level = _level;
+            while (level > 0 && _screen_size >= _levels[level].screen_size * (1.0f + _hysteresis))
+            {
+                --level;
+            }
+            while (level + 1 < _levels.size() && _screen_size < _levels[level + 1].screen_size * (1.0f - _hysteresis))
+            {
+                ++level;
+            }
+            set_level(level);
+
+            return _level;
+        }
+
+    protected:
+        void _update_world_bounding_box() override
+        {
+            _world_bounding_box = _levels.front().geometry->get_bounding_box();
+            _world_bounding_box.transform(get_world_matrix());
+        }
+
+    private:
+        struct Level
+        {
+            std::shared_ptr<Geometry> geometry;
+            float screen_size;
+        };
+
+        std::vector<Level> _levels;
+        size_t _level{0};
+        float _hysteresis{DEFAULT_HYSTERESIS};
+        float _screen_size{0.0f};
+    };
+}
+
+#endif
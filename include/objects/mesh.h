@@ -3,14 +3,27 @@
 
 #include "objects/object.h"
 #include "geometries/geometry.h"
+#include "geometries/geometry_listener.h"
 #include "materials/material.h"
+#include "math/aabb.h"
+#include "math/ray.h"
+#include "geometries/triangle_bvh.h"
+#include "utilities/job_system.h"
+
+#include <glm/glm.hpp>
 
 #include <memory>
 #include <utility>
+#include <vector>
+#include <cstddef>
 
 namespace asr
 {
-    class Mesh : public Object
+    class InstancedMesh;
+    class LODMesh;
+    class ParticleSystem;
+
+    class Mesh : public Object, public GeometryListener
     {
     public:
         Mesh(std::shared_ptr<Geometry> geometry, std::shared_ptr<Material> material,
@@ -22,6 +35,23 @@ namespace asr
               _geometry{std::move(geometry)},
               _material{std::move(material)}
         {
+            // The world bounds are calculated from this geometry, also by meshes that switch between several.
+            if (_geometry)
+            {
+                _geometry->add_listener(*this);
+            }
+            _bounds_geometry = _geometry;
+        }
+
+        Mesh(const Mesh &other) = delete;
+        Mesh &operator=(const Mesh &other) = delete;
+
+        ~Mesh() override
+        {
+            if (_bounds_geometry != nullptr)
+            {
+                _bounds_geometry->remove_listener(*this);
+            }
         }
 
         const std::shared_ptr<Geometry> &get_geometry() const
@@ -34,9 +64,144 @@ namespace asr
             return _material;
         }
 
+        Mesh *as_mesh() final
+        {
+            return this;
+        }
+
+        virtual InstancedMesh *as_instanced_mesh()
+        {
+            return nullptr;
+        }
+
+        virtual LODMesh *as_lod_mesh()
+        {
+            return nullptr;
+        }
+
+        virtual ParticleSystem *as_particle_system()
+        {
+            return nullptr;
+        }
+
+        const AABB &get_world_bounding_box()
+        {
+            unsigned int bounding_box_version = _geometry->get_bounding_box_version();
+            unsigned int world_matrix_version = get_world_matrix_version();
+            if (_world_bounding_box_requires_update ||
+                _world_bounding_box_geometry_version != bounding_box_version ||
+                _world_bounding_box_world_matrix_version != world_matrix_version)
+            {
+                _update_world_bounding_box();
+                _world_bounding_box_geometry_version = bounding_box_version;
+                _world_bounding_box_world_matrix_version = world_matrix_version;
+                _world_bounding_box_requires_update = false;
+            }
+
+            return _world_bounding_box;
+        }
+
+        // Intersects a ray in world space with the triangles of the geometry. The ray is moved into the local
+        // space of the mesh instead of moving the triangles, so the distance is measured along the world ray.
+        // The instances of instanced meshes are not tested.
+        TriangleBVH::Hit intersect_ray(const Ray &ray)
+        {
+            return _geometry->get_triangle_bvh().raycast(_transform_ray(glm::inverse(get_world_matrix()), ray));
+        }
+
+        void intersect_rays(const std::vector<Ray> &rays, std::vector<TriangleBVH::Hit> &hits, JobSystem *job_system = nullptr)
+        {
+            glm::mat4 inverse_world_matrix = glm::inverse(get_world_matrix());
+            std::vector<Ray> local_rays;
+            local_rays.reserve(rays.size());
+            for (const Ray &ray : rays)
+            {
+                local_rays.push_back(_transform_ray(inverse_world_matrix, ray));
+            }
+
+            _geometry->get_triangle_bvh().raycast(local_rays, hits, job_system);
+        }
+
+        // Opaque meshes draw themselves into the shadow maps of the lights they are in while this is set.
+        [[nodiscard]] bool is_casting_shadows() const
+        {
+            return _casting_shadows;
+        }
+
+        void set_casting_shadows(bool casting_shadows)
+        {
+            if (_casting_shadows != casting_shadows)
+            {
+                _casting_shadows = casting_shadows;
+                invalidate_world_bounding_box();
+            }
+        }
+
+        void invalidate_world_bounding_box()
+        {
+            _world_bounding_box_requires_update = true;
+            _notify_transformed();
+        }
+
+        void on_geometry_bounds_changed(Geometry & /* geometry */) final
+        {
+            invalidate_world_bounding_box();
+        }
+
+        [[nodiscard]] int get_bounding_volume_proxy() const
+        {
+            return _bounding_volume_proxy;
+        }
+
+        void set_bounding_volume_proxy(int bounding_volume_proxy)
+        {
+            _bounding_volume_proxy = bounding_volume_proxy;
+        }
+
+        [[nodiscard]] size_t get_render_list_index() const
+        {
+            return _render_list_index;
+        }
+
+        void set_render_list_index(size_t render_list_index)
+        {
+            _render_list_index = render_list_index;
+        }
+
+    protected:
+        AABB _world_bounding_box{glm::vec3{0.0f}, glm::vec3{0.0f}};
+        bool _world_bounding_box_requires_update{true};
+
+        virtual void _update_world_bounding_box()
+        {
+            _world_bounding_box = _geometry->get_bounding_box();
+            _world_bounding_box.transform(get_world_matrix());
+        }
+
+        void _set_geometry(std::shared_ptr<Geometry> geometry)
+        {
+            _geometry = std::move(geometry);
+        }
+
+        // The direction is transformed without normalising it, which keeps the distances of the world ray.
+        static Ray _transform_ray(const glm::mat4 &matrix, const Ray &ray)
+        {
+            return Ray{glm::vec3(matrix * glm::vec4(ray.get_origin(), 1.0f)),
+                       glm::vec3(matrix * glm::vec4(ray.get_direction(), 0.0f))};
+        }
+
     private:
         std::shared_ptr<Geometry> _geometry;
         std::shared_ptr<Material> _material;
+        std::shared_ptr<Geometry> _bounds_geometry;
+
+        size_t _render_list_index{0};
+        unsigned int _world_bounding_box_geometry_version{0};
+        unsigned int _world_bounding_box_world_matrix_version{0};
+
+        int _bounding_volume_proxy{-1};
+
+        bool _casting_shadows{true};
     };
 }
 
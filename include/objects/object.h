@@ -1,6 +1,9 @@
 #ifndef OBJECT_H
 #define OBJECT_H
 
+#include "scene/scene_graph_listener.h"
+#include "scene/transform_hierarchy.h"
+
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -14,6 +17,8 @@
 
 namespace asr
 {
+    class Mesh;
+
     class Object : public std::enable_shared_from_this<Object>
     {
     public:
@@ -26,12 +31,25 @@ namespace asr
             : _name{std::move(name)},
               _position{position}, _rotation{rotation}, _scale{scale},
               _world_position(position), _world_rotation(rotation), _world_scale(scale),
-              _parent{std::move(parent)}
+              _parent{std::move(parent)}, _parent_object{_parent.lock().get()}
         {
             _update_quaternion_from_rotation();
         }
 
-        virtual ~Object() = default;
+        virtual ~Object()
+        {
+            if (_transform_hierarchy != nullptr)
+            {
+                _transform_hierarchy->destroy(_transform_handle);
+            }
+            for (const auto &child : _children)
+            {
+                if (child->_parent_object == this)
+                {
+                    child->_parent_object = nullptr;
+                }
+            }
+        }
 
         const std::string &get_name() const
         {
@@ -48,10 +66,22 @@ namespace asr
             return _parent;
         }
 
+        // The parent without touching the reference counts, for walking up the hierarchy.
+        [[nodiscard]] Object *get_parent_object() const
+        {
+            return _parent_object;
+        }
+
         void set_parent(const std::weak_ptr<Object> &parent)
         {
-            if (_parent.lock() != parent.lock()) {
+            const auto new_parent = parent.lock();
+            if (_parent_object != new_parent.get() || _parent.lock() != new_parent) {
                 _parent = parent;
+                _parent_object = new_parent.get();
+                if (_transform_hierarchy != nullptr)
+                {
+                    _transform_hierarchy->set_parent(_transform_handle, _get_parent_transform_handle());
+                }
                 set_world_matrix_requires_update(true);
             }
         }
@@ -59,17 +89,50 @@ namespace asr
         void add_child(const std::shared_ptr<Object> &child)
         {
             child->set_parent(shared_from_this());
+            child->_child_position = _children.size();
             _children.push_back(child);
+            child->set_transform_hierarchy(_transform_hierarchy);
+            child->set_scene_graph_listener(_scene_graph_listener);
         }
 
-        std::shared_ptr<Object> get_child(std::vector<std::shared_ptr<Object>>::size_type position) const
+        const std::shared_ptr<Object> &get_child(std::vector<std::shared_ptr<Object>>::size_type position) const
         {
             return _children[position];
         }
 
+        [[nodiscard]] size_t get_child_count() const
+        {
+            return _children.size();
+        }
+
+        // The last child takes the place of the removed one, so removing does not shift the other children and
+        // does not keep their order.
         void remove_child(std::vector<std::shared_ptr<Object>>::size_type position)
         {
-            _children.erase(_children.begin() + static_cast<std::vector<std::shared_ptr<Object>>::difference_type>(position));
+            // The removed child may outlive this object, so it must not keep pointing at it.
+            Object &child = *_children[position];
+            child.set_scene_graph_listener(nullptr);
+            child.set_transform_hierarchy(nullptr);
+            child._parent.reset();
+            child._parent_object = nullptr;
+            child._child_position = 0;
+            child.set_world_matrix_requires_update(true);
+            if (position + 1 != _children.size())
+            {
+                _children[position] = std::move(_children.back());
+                _children[position]->_child_position = position;
+            }
+            _children.pop_back();
+        }
+
+        // Does nothing when the object is not a child of this one.
+        void remove_child(const Object &child)
+        {
+            if (child._parent_object == this && child._child_position < _children.size() &&
+                _children[child._child_position].get() == &child)
+            {
+                remove_child(child._child_position);
+            }
         }
 
         const std::vector<std::shared_ptr<Object>> &get_children() const
@@ -77,6 +140,87 @@ namespace asr
             return _children;
         }
 
+        // Visits the object and its descendants depth first, parents before their children, without copying
+        // shared pointers.
+        template <typename Function>
+        void traverse(const Function &function)
+        {
+            function(*this);
+            for (const auto &child : _children)
+            {
+                child->traverse(function);
+            }
+        }
+
+        [[nodiscard]] SceneGraphListener *get_scene_graph_listener() const
+        {
+            return _scene_graph_listener;
+        }
+
+        void set_scene_graph_listener(SceneGraphListener *scene_graph_listener)
+        {
+            if (_scene_graph_listener == scene_graph_listener)
+            {
+                return;
+            }
+
+            if (_scene_graph_listener != nullptr)
+            {
+                _scene_graph_listener->on_object_detached(*this);
+            }
+            _scene_graph_listener = scene_graph_listener;
+            if (_scene_graph_listener != nullptr)
+            {
+                _scene_graph_listener->on_object_attached(*this);
+            }
+
+            for (const auto &child : _children)
+            {
+                child->set_scene_graph_listener(scene_graph_listener);
+            }
+        }
+
+        [[nodiscard]] TransformHierarchy *get_transform_hierarchy() const
+        {
+            return _transform_hierarchy;
+        }
+
+        [[nodiscard]] TransformHierarchy::handle_type get_transform_handle() const
+        {
+            return _transform_handle;
+        }
+
+        void set_transform_hierarchy(TransformHierarchy *transform_hierarchy)
+        {
+            if (_transform_hierarchy == transform_hierarchy)
+            {
+                return;
+            }
+
+            if (_transform_hierarchy != nullptr)
+            {
+                _transform_hierarchy->destroy(_transform_handle);
+                _transform_handle = TransformHierarchy::NULL_HANDLE;
+            }
+            _transform_hierarchy = transform_hierarchy;
+            if (_transform_hierarchy != nullptr)
+            {
+                _transform_handle = _transform_hierarchy->create(_get_parent_transform_handle());
+                _transform_hierarchy->set_local_transform(_transform_handle, _position, _quaternion_rotation, _scale);
+            }
+            set_world_matrix_requires_update(true);
+
+            for (const auto &child : _children)
+            {
+                child->set_transform_hierarchy(transform_hierarchy);
+            }
+        }
+
+        virtual Mesh *as_mesh()
+        {
+            return nullptr;
+        }
+
         glm::vec3 &get_position()
         {
             return _position;
@@ -100,11 +244,14 @@ namespace asr
 
         glm::vec3 &get_rotation()
         {
+            _update_rotation_if_necessary();
+
             return _rotation;
         }
 
         void set_rotation(const glm::vec3 &rotation)
         {
+            _update_rotation_if_necessary();
             if (_rotation != rotation) {
                 _rotation = rotation;
                 _update_quaternion_from_rotation();
@@ -115,6 +262,7 @@ namespace asr
         void add_to_rotation(const glm::vec3 &rotation)
         {
             if (rotation != glm::vec3(0.0f)) {
+                _update_rotation_if_necessary();
                 _rotation += rotation;
                 _update_quaternion_from_rotation();
                 set_model_matrix_requires_update(true);
@@ -156,6 +304,17 @@ namespace asr
             }
         }
 
+        // Replaces the whole local transform at once, as an animation does every frame. The Euler angles are
+        // only derived from the quaternion when they are read next.
+        void set_local_transform(const glm::vec3 &position, const glm::quat &quaternion_rotation, const glm::vec3 &scale)
+        {
+            _position = position;
+            _quaternion_rotation = quaternion_rotation;
+            _scale = scale;
+            _rotation_requires_update = true;
+            set_model_matrix_requires_update(true);
+        }
+
         float get_x() const
         {
             return _position.x;
@@ -220,11 +379,14 @@ namespace asr
 
         float get_rotation_x() const
         {
+            _update_rotation_if_necessary();
+
             return _rotation.x;
         }
 
         void set_rotation_x(float rotation_x)
         {
+            _update_rotation_if_necessary();
             if (_rotation.x != rotation_x) {
                 _rotation.x = rotation_x;
                 _update_quaternion_from_rotation();
@@ -235,6 +397,7 @@ namespace asr
         void add_to_rotation_x(float rotation_x)
         {
             if (rotation_x != 0.0f) {
+                _update_rotation_if_necessary();
                 _rotation.x += rotation_x;
                 _update_quaternion_from_rotation();
                 set_model_matrix_requires_update(true);
@@ -243,11 +406,14 @@ namespace asr
 
         float get_rotation_y() const
         {
+            _update_rotation_if_necessary();
+
             return _rotation.y;
         }
 
         void set_rotation_y(float rotation_y)
         {
+            _update_rotation_if_necessary();
             if (_rotation.y != rotation_y) {
                 _rotation.y = rotation_y;
                 _update_quaternion_from_rotation();
@@ -258,6 +424,7 @@ namespace asr
         void add_to_rotation_y(float rotation_y)
         {
             if (rotation_y != 0.0f) {
+                _update_rotation_if_necessary();
                 _rotation.y += rotation_y;
                 _update_quaternion_from_rotation();
                 set_model_matrix_requires_update(true);
@@ -266,11 +433,14 @@ namespace asr
 
         float get_rotation_z() const
         {
+            _update_rotation_if_necessary();
+
             return _rotation.z;
         }
 
         void set_rotation_z(float rotation_z)
         {
+            _update_rotation_if_necessary();
             if (_rotation.z != rotation_z) {
                 _rotation.z = rotation_z;
                 _update_quaternion_from_rotation();
@@ -281,6 +451,7 @@ namespace asr
         void add_to_rotation_z(float rotation_z)
         {
             if (rotation_z != 0.0f) {
+                _update_rotation_if_necessary();
                 _rotation.z += rotation_z;
                 _update_quaternion_from_rotation();
                 set_model_matrix_requires_update(true);
@@ -352,25 +523,25 @@ namespace asr
 
         const glm::vec3 &get_world_position()
         {
-            _update_world_matrix_if_necessary();
+            _update_world_position_if_necessary();
             return _world_position;
         }
 
         const glm::vec3 &get_world_rotation()
         {
-            _update_world_matrix_if_necessary();
+            _update_world_rotation_if_necessary();
             return _world_rotation;
         }
 
         const glm::vec3 &get_world_scale()
         {
-            _update_world_matrix_if_necessary();
+            _update_world_scale_if_necessary();
             return _world_scale;
         }
 
         const glm::quat &get_world_quaternion_rotation()
         {
-            _update_world_matrix_if_necessary();
+            _update_world_rotation_if_necessary();
             return _world_quaternion_rotation;
         }
 
@@ -462,15 +633,14 @@ namespace asr
             return _model_matrix_requires_update;
         }
 
-        virtual void set_model_matrix_requires_update(bool model_matrix_requires_update)
+        void set_model_matrix_requires_update(bool model_matrix_requires_update)
         {
             _model_matrix_requires_update = model_matrix_requires_update;
             if (_model_matrix_requires_update) {
-                _world_matrix_requires_update = true;
-
-                for (const auto &child : _children) {
-                    child->set_model_matrix_requires_update(true);
+                if (_transform_hierarchy != nullptr) {
+                    _transform_hierarchy->set_local_transform(_transform_handle, _position, _quaternion_rotation, _scale);
                 }
+                set_world_matrix_requires_update(true);
             }
         }
 
@@ -479,21 +649,51 @@ namespace asr
             return _world_matrix_requires_update;
         }
 
-        virtual void set_world_matrix_requires_update(bool world_matrix_requires_update)
+        // Descendants are not visited here. They notice the change through the world matrix version of their
+        // parent the next time their own world matrix is read, and the scene graph listener receives the node
+        // once per frame to resolve the whole subtree in hierarchy order.
+        void set_world_matrix_requires_update(bool world_matrix_requires_update)
         {
             _world_matrix_requires_update = world_matrix_requires_update;
             if (_world_matrix_requires_update) {
-                for (const auto &child : _children) {
-                    child->set_world_matrix_requires_update(true);
-                }
+                _notify_transformed();
             }
         }
 
+        [[nodiscard]] unsigned int get_world_matrix_version()
+        {
+            _update_world_matrix_if_necessary();
+
+            return _world_matrix_version;
+        }
+
+        [[nodiscard]] bool is_transform_update_pending() const
+        {
+            return _transform_update_pending;
+        }
+
+        void set_transform_update_pending(bool transform_update_pending)
+        {
+            _transform_update_pending = transform_update_pending;
+        }
+
+        // The place of the object in the queue of the scene graph listener while its update is pending.
+        [[nodiscard]] size_t get_transform_update_index() const
+        {
+            return _transform_update_index;
+        }
+
+        void set_transform_update_index(size_t transform_update_index)
+        {
+            _transform_update_index = transform_update_index;
+        }
+
     protected:
         std::string _name;
 
         glm::vec3 _position;
-        glm::vec3 _rotation;
+        mutable glm::vec3 _rotation;
+        mutable bool _rotation_requires_update{false};
         glm::vec3 _scale;
         glm::quat _quaternion_rotation{1.0f, 0.0f, 0.0f, 0.0f};
 
@@ -505,12 +705,25 @@ namespace asr
         glm::vec3 _up{0.0f, 1.0f, 0.0f};
 
         std::weak_ptr<Object> _parent;
+        Object *_parent_object{nullptr};
+        size_t _child_position{0};
         std::vector<std::shared_ptr<Object>> _children;
+        SceneGraphListener *_scene_graph_listener{nullptr};
+
+        TransformHierarchy *_transform_hierarchy{nullptr};
+        TransformHierarchy::handle_type _transform_handle{TransformHierarchy::NULL_HANDLE};
 
         bool _model_matrix_requires_update{true};
         glm::mat4 _model_matrix{1.0f};
         bool _world_matrix_requires_update{true};
         glm::mat4 _world_matrix{1.0f};
+        unsigned int _world_matrix_version{0};
+        bool _world_position_requires_update{true};
+        bool _world_scale_requires_update{true};
+        bool _world_rotation_requires_update{true};
+        unsigned int _parent_world_matrix_version{0};
+        bool _transform_update_pending{false};
+        size_t _transform_update_index{0};
 
         void _update_model_matrix_if_necessary()
         {
@@ -524,27 +737,65 @@ namespace asr
 
         void _update_world_matrix_if_necessary()
         {
-            if (_world_matrix_requires_update) {
-                _update_model_matrix_if_necessary();
+            // Between the once per frame resolve and the next change the matrices of the whole scene are
+            // current, so culling, sorting and recording read them without walking up to the root.
+            if (_scene_graph_listener != nullptr && _transform_hierarchy == nullptr && !_world_matrix_requires_update &&
+                _scene_graph_listener->are_world_matrices_resolved()) {
+                return;
+            }
 
-                if (const auto parent = _parent.lock()) {
-                    _world_matrix = parent->get_world_matrix() * _model_matrix;
-                } else {
-                    _world_matrix = _model_matrix;
+            if (_transform_hierarchy != nullptr) {
+                unsigned int hierarchy_world_version = _transform_hierarchy->get_world_version(_transform_handle);
+                if (_parent_world_matrix_version != hierarchy_world_version) {
+                    _parent_world_matrix_version = hierarchy_world_version;
+                    _world_matrix_requires_update = true;
+                }
+                if (_world_matrix_requires_update) {
+                    _world_matrix = _transform_hierarchy->get_world_matrix(_transform_handle);
+                }
+            } else if (Object *parent = _parent_object) {
+                const glm::mat4 &parent_world_matrix = parent->get_world_matrix();
+                if (_parent_world_matrix_version != parent->_world_matrix_version) {
+                    _parent_world_matrix_version = parent->_world_matrix_version;
+                    _world_matrix_requires_update = true;
                 }
+                if (_world_matrix_requires_update) {
+                    _update_model_matrix_if_necessary();
+                    _world_matrix = parent_world_matrix * _model_matrix;
+                }
+            } else if (_world_matrix_requires_update) {
+                _update_model_matrix_if_necessary();
+                _world_matrix = _model_matrix;
+            }
+
+            if (_world_matrix_requires_update) {
                 _world_matrix_requires_update = false;
+                ++_world_matrix_version;
 
-                /* Position */
+                _world_position_requires_update = true;
+                _world_scale_requires_update = true;
+                _world_rotation_requires_update = true;
+            }
+        }
 
+        void _update_world_position_if_necessary()
+        {
+            _update_world_matrix_if_necessary();
+            if (_world_position_requires_update) {
                 _world_position =
                     glm::vec3(
                         _world_matrix[3][0],
                         _world_matrix[3][1],
                         _world_matrix[3][2]
                     );
+                _world_position_requires_update = false;
+            }
+        }
 
-                /* Scale */
-
+        void _update_world_scale_if_necessary()
+        {
+            _update_world_matrix_if_necessary();
+            if (_world_scale_requires_update) {
                 _world_scale.x =
                     _world_matrix[0][0] * _world_matrix[0][0] +
                     _world_matrix[0][1] * _world_matrix[0][1] +
@@ -563,9 +814,14 @@ namespace asr
                 _world_scale.x = sqrtf(_world_scale.x);
                 _world_scale.y = sqrtf(_world_scale.y);
                 _world_scale.z = sqrtf(_world_scale.z);
+                _world_scale_requires_update = false;
+            }
+        }
 
-                /* Rotation */
-
+        void _update_world_rotation_if_necessary()
+        {
+            _update_world_matrix_if_necessary();
+            if (_world_rotation_requires_update) {
                 _world_quaternion_rotation = glm::quat(_world_matrix);
 
                 float sqx = _world_quaternion_rotation[0] * _world_quaternion_rotation[0];
@@ -592,9 +848,28 @@ namespace asr
                                 _world_quaternion_rotation[0] * _world_quaternion_rotation[1]),
                         sqw + sqx - sqy - sqz
                     );
+                _world_rotation_requires_update = false;
             }
         }
 
+        void _notify_transformed()
+        {
+            if (!_transform_update_pending && _scene_graph_listener != nullptr) {
+                _transform_update_pending = true;
+                _scene_graph_listener->on_object_transformed(*this);
+            }
+        }
+
+        TransformHierarchy::handle_type _get_parent_transform_handle() const
+        {
+            const Object *parent = _parent_object;
+            if (parent && parent->_transform_hierarchy == _transform_hierarchy) {
+                return parent->_transform_handle;
+            }
+
+            return TransformHierarchy::NULL_HANDLE;
+        }
+
         void _update_quaternion_from_rotation()
         {
             float c1 = cosf(_rotation.x * 0.5f);
@@ -615,34 +890,48 @@ namespace asr
 
         void _update_rotation_from_quaternion()
         {
-            glm::quat normalized_quaternion = glm::normalize(_quaternion_rotation);
+            _quaternion_rotation = glm::normalize(_quaternion_rotation);
+            _rotation = _calculate_rotation(_quaternion_rotation);
+            _rotation_requires_update = false;
+        }
 
+        void _update_rotation_if_necessary() const
+        {
+            if (_rotation_requires_update) {
+                _rotation = _calculate_rotation(glm::normalize(_quaternion_rotation));
+                _rotation_requires_update = false;
+            }
+        }
+
+        static glm::vec3 _calculate_rotation(const glm::quat &normalized_quaternion)
+        {
             float sqx = normalized_quaternion[0] * normalized_quaternion[0];
             float sqy = normalized_quaternion[1] * normalized_quaternion[1];
             float sqz = normalized_quaternion[2] * normalized_quaternion[2];
             float sqw = normalized_quaternion[3] * normalized_quaternion[3];
 
-            _rotation.x =
+            glm::vec3 rotation;
+            rotation.x =
                 atan2f(
                     2.0f * (normalized_quaternion[0] * normalized_quaternion[3] -
                             normalized_quaternion[1] * normalized_quaternion[2]),
                     sqw - sqx - sqy + sqz
                 );
-            _rotation.y =
+            rotation.y =
                 asinf(
                     fminf(fmaxf((
                         2.0f * (normalized_quaternion[0] * normalized_quaternion[2] +
                                 normalized_quaternion[1] * normalized_quaternion[3])
                     ), 0.0f), 1.0f)
                 );
-            _rotation.z =
+            rotation.z =
                 atan2f(
                     2.0f * (normalized_quaternion[2] * normalized_quaternion[3] -
                             normalized_quaternion[0] * normalized_quaternion[1]),
                     sqw + sqx - sqy - sqz
                 );
 
-            _quaternion_rotation = normalized_quaternion;
+            return rotation;
         }
     };
 }
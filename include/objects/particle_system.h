@@ -0,0 +1,488 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include "objects/mesh.h"
+#include "geometries/geometry.h"
+#include "geometries/geometry_processing.h"
+#include "geometries/vertex_layout.h"
+#include "materials/material.h"
+#include "math/aabb.h"
+#include "utilities/job_system.h"
+#include "utilities/radix_sort.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Point sprites simulated on the CPU in separate arrays per component, so the update runs four particles
+    // at a time with SSE2 or NEON and splits into ranges for a JobSystem. Particles are spawned in a box
+    // around the origin of the system with random velocities and lifetimes, accelerate uniformly and fade
+    // from the start to the end color. Only positions and packed colors, 16 bytes per particle, are streamed
+    // to the geometry, which the renderer requests for visible systems once per frame. With sorting
+    // enabled the particles are written back to front for alpha blending, otherwise in the order they are
+    // stored, which suits additive blending. The geometry should be empty and not shared with other meshes;
+    // the system switches it to points with a compact layout that are streamed.
+    class ParticleSystem : public Mesh
+    {
+    public:
+        ParticleSystem(std::shared_ptr<Geometry> geometry, std::shared_ptr<Material> material, size_t max_particle_count,
+                       const glm::vec3 &position = glm::vec4(0.0f),
+                       const glm::vec3 &rotation = glm::vec4(0.0f),
+                       const glm::vec3 &scale = glm::vec4(1.0f),
+                       std::weak_ptr<Object> parent = {})
+            : Mesh(std::move(geometry), std::move(material), position, rotation, scale, std::move(parent)),
+              _max_particle_count{max_particle_count}
+        {
+            const auto &particle_geometry = get_geometry();
+            particle_geometry->set_type(Geometry::Points);
+            particle_geometry->set_vertex_layout(
+                VertexLayout::create_compact(VertexLayout::PositionAttribute | VertexLayout::ColorAttribute));
+            particle_geometry->set_vertices_usage_strategy(Geometry::StreamStrategy);
+
+            for (auto *component : {&_positions_x, &_positions_y, &_positions_z,
+                                    &_velocities_x, &_velocities_y, &_velocities_z, &_ages, &_lifetimes})
+            {
+                component->resize(max_particle_count);
+            }
+        }
+
+        ParticleSystem *as_particle_system() final
+        {
+            return this;
+        }
+
+        [[nodiscard]] size_t get_particle_count() const
+        {
+            return _particle_count;
+        }
+
+        [[nodiscard]] size_t get_max_particle_count() const
+        {
+            return _max_particle_count;
+        }
+
+        // Particles spawned per second by update().
+        [[nodiscard]] float get_spawn_rate() const
+        {
+            return _spawn_rate;
+        }
+
+        void set_spawn_rate(float spawn_rate)
+        {
+            _spawn_rate = spawn_rate;
+        }
+
+        // Half the size of the box that particles are spawned in.
+        [[nodiscard]] const glm::vec3 &get_emission_extent() const
+        {
+            return _emission_extent;
+        }
+
+        void set_emission_extent(const glm::vec3 &emission_extent)
+        {
+            _emission_extent = emission_extent;
+        }
+
+        [[nodiscard]] const glm::vec3 &get_minimum_velocity() const
+        {
+            return _minimum_velocity;
+        }
+
+        void set_minimum_velocity(const glm::vec3 &minimum_velocity)
+        {
+            _minimum_velocity = minimum_velocity;
+        }
+
+        [[nodiscard]] const glm::vec3 &get_maximum_velocity() const
+        {
+            return _maximum_velocity;
+        }
+
+        void set_maximum_velocity(const glm::vec3 &maximum_velocity)
+        {
+            _maximum_velocity = maximum_velocity;
+        }
+
+        [[nodiscard]] float get_minimum_lifetime() const
+        {
+            return _minimum_lifetime;
+        }
+
+        void set_minimum_lifetime(float minimum_lifetime)
+        {
+            _minimum_lifetime = minimum_lifetime;
+        }
+
+        [[nodiscard]] float get_maximum_lifetime() const
+        {
+            return _maximum_lifetime;
+        }
+
+        void set_maximum_lifetime(float maximum_lifetime)
+        {
+            _maximum_lifetime = maximum_lifetime;
+        }
+
+        [[nodiscard]] const glm::vec3 &get_acceleration() const
+        {
+            return _acceleration;
+        }
+
+        void set_acceleration(const glm::vec3 &acceleration)
+        {
+            _acceleration = acceleration;
+        }
+
+        [[nodiscard]] const glm::vec4 &get_start_color() const
+        {
+            return _start_color;
+        }
+
+        void set_start_color(const glm::vec4 &start_color)
+        {
+            _start_color = start_color;
+            _requires_vertices_write = true;
+        }
+
+        [[nodiscard]] const glm::vec4 &get_end_color() const
+        {
+            return _end_color;
+        }
+
+        void set_end_color(const glm::vec4 &end_color)
+        {
+            _end_color = end_color;
+            _requires_vertices_write = true;
+        }
+
+        [[nodiscard]] bool is_sorting_enabled() const
+        {
+            return _sorting_enabled;
+        }
+
+        void set_sorting_enabled(bool sorting_enabled)
+        {
+            _sorting_enabled = sorting_enabled;
+            _requires_vertices_write = true;
+        }
+
+        void set_random_seed(unsigned int random_seed)
+        {
+            _random.seed(random_seed);
+        }
+
+        // Spawns up to count particles with the emitter parameters, as many as fit into the maximum count.
+        void emit(size_t count)
+        {
+            std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+            count = std::min(count, _max_particle_count - _particle_count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                glm::vec3 position{
+                    (unit(_random) * 2.0f - 1.0f) * _emission_extent.x,
+                    (unit(_random) * 2.0f - 1.0f) * _emission_extent.y,
+                    (unit(_random) * 2.0f - 1.0f) * _emission_extent.z};
+                glm::vec3 velocity{
+                    _minimum_velocity.x + unit(_random) * (_maximum_velocity.x - _minimum_velocity.x),
+                    _minimum_velocity.y + unit(_random) * (_maximum_velocity.y - _minimum_velocity.y),
+                    _minimum_velocity.z + unit(_random) * (_maximum_velocity.z - _minimum_velocity.z)};
+                float lifetime = _minimum_lifetime + unit(_random) * (_maximum_lifetime - _minimum_lifetime);
+                _spawn(position, velocity, lifetime);
+            }
+            if (count > 0)
+            {
+                invalidate_world_bounding_box();
+            }
+        }
+
+        // Spawns one particle in the space of the system. Returns false when the system is full.
+        bool emit(const glm::vec3 &position, const glm::vec3 &velocity, float lifetime)
+        {
+            if (_particle_count == _max_particle_count)
+            {
+                return false;
+            }
+
+            _spawn(position, velocity, lifetime);
+            invalidate_world_bounding_box();
+
+            return true;
+        }
+
+        void clear()
+        {
+            _particle_count = 0;
+            _bounds = AABB{glm::vec3{0.0f}, glm::vec3{0.0f}};
+            _requires_vertices_write = true;
+            invalidate_world_bounding_box();
+        }
+
+        // Advances the particles, removes the ones that outlived their lifetime and spawns new ones at the
+        // spawn rate.
+        void update(float delta_time, JobSystem *job_system = nullptr)
+        {
+            _for_each_range(_particle_count, job_system, [&](size_t begin, size_t end) {
+                _integrate(_positions_x.data(), _velocities_x.data(), _acceleration.x, delta_time, begin, end);
+                _integrate(_positions_y.data(), _velocities_y.data(), _acceleration.y, delta_time, begin, end);
+                _integrate(_positions_z.data(), _velocities_z.data(), _acceleration.z, delta_time, begin, end);
+                _advance(_ages.data(), delta_time, begin, end);
+            });
+
+            for (size_t i = 0; i < _particle_count;)
+            {
+                if (_ages[i] < _lifetimes[i])
+                {
+                    ++i;
+                    continue;
+                }
+
+                size_t last = --_particle_count;
+                _positions_x[i] = _positions_x[last];
+                _positions_y[i] = _positions_y[last];
+                _positions_z[i] = _positions_z[last];
+                _velocities_x[i] = _velocities_x[last];
+                _velocities_y[i] = _velocities_y[last];
+                _velocities_z[i] = _velocities_z[last];
+                _ages[i] = _ages[last];
+                _lifetimes[i] = _lifetimes[last];
+            }
+
+            _spawn_accumulator += _spawn_rate * delta_time;
+            auto spawn_count = static_cast<size_t>(_spawn_accumulator);
+            _spawn_accumulator -= static_cast<float>(spawn_count);
+            emit(spawn_count);
+
+            geometry_processing::PositionStreams positions{
+                _positions_x.data(), _positions_y.data(), _positions_z.data(), _particle_count};
+            _bounds = geometry_processing::calculate_bounds(positions, job_system);
+            _requires_vertices_write = true;
+            invalidate_world_bounding_box();
+        }
+
+        // Streams the particles to the geometry if they changed, or if the camera moved while sorting is
+        // enabled. The renderer calls it for the visible systems before their draws are recorded.
+        void write_vertices(const glm::vec3 &camera_position, JobSystem *job_system = nullptr)
+        {
+            glm::vec3 local_camera_position = glm::vec3(glm::inverse(get_world_matrix()) * glm::vec4(camera_position, 1.0f));
+            if (!_requires_vertices_write && (!_sorting_enabled || local_camera_position == _sort_position))
+            {
+                return;
+            }
+
+            if (_sorting_enabled)
+            {
+                _sort(local_camera_position, job_system);
+            }
+
+            float start_color[4]{_start_color.r, _start_color.g, _start_color.b, _start_color.a};
+            float color_change[4]{
+                _end_color.r - _start_color.r, _end_color.g - _start_color.g,
+                _end_color.b - _start_color.b, _end_color.a - _start_color.a};
+            uint8_t *vertices = get_geometry()->edit_packed_vertices(_particle_count, _bounds);
+            _for_each_range(_particle_count, job_system, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    float position[3]{_positions_x[i], _positions_y[i], _positions_z[i]};
+                    float age = std::min(_ages[i] / _lifetimes[i], 1.0f);
+
+                    uint8_t *vertex = vertices + i * VERTEX_SIZE;
+                    std::memcpy(vertex, position, sizeof(position));
+                    for (size_t component = 0; component < 4; ++component)
+                    {
+                        float color = std::min(std::max(start_color[component] + color_change[component] * age, 0.0f), 1.0f);
+                        vertex[sizeof(position) + component] = static_cast<uint8_t>(color * 255.0f + 0.5f);
+                    }
+                }
+            });
+
+            _sort_position = local_camera_position;
+            _requires_vertices_write = false;
+        }
+
+    protected:
+        void _update_world_bounding_box() override
+        {
+            _world_bounding_box = _bounds;
+            _world_bounding_box.transform(get_world_matrix());
+        }
+
+    private:
+        inline static const size_t VERTEX_SIZE = 3 * sizeof(float) + 4;
+        inline static const size_t UPDATE_GRAIN_SIZE = 16384;
+
+        size_t _max_particle_count;
+        size_t _particle_count{0};
+
+        std::vector<float> _positions_x;
+        std::vector<float> _positions_y;
+        std::vector<float> _positions_z;
+        std::vector<float> _velocities_x;
+        std::vector<float> _velocities_y;
+        std::vector<float> _velocities_z;
+        std::vector<float> _ages;
+        std::vector<float> _lifetimes;
+
+        float _spawn_rate{0.0f};
+        float _spawn_accumulator{0.0f};
+        glm::vec3 _emission_extent{0.0f};
+        glm::vec3 _minimum_velocity{-1.0f};
+        glm::vec3 _maximum_velocity{1.0f};
+        float _minimum_lifetime{1.0f};
+        float _maximum_lifetime{1.0f};
+        glm::vec3 _acceleration{0.0f};
+        glm::vec4 _start_color{1.0f};
+        glm::vec4 _end_color{1.0f, 1.0f, 1.0f, 0.0f};
+        std::mt19937 _random{};
+
+        AABB _bounds{glm::vec3{0.0f}, glm::vec3{0.0f}};
+
+        bool _sorting_enabled{false};
+        bool _requires_vertices_write{true};
+        glm::vec3 _sort_position{0.0f};
+        std::vector<std::pair<uint32_t, uint32_t>> _sort_keys;
+        std::vector<std::pair<uint32_t, uint32_t>> _sort_scratch;
+        std::vector<float> _sorted_component;
+
+        template <typename Function>
+        static void _for_each_range(size_t count, JobSystem *job_system, const Function &function)
+        {
+            if (job_system != nullptr)
+            {
+                job_system->parallel_for(count, UPDATE_GRAIN_SIZE, function);
+            }
+            else if (count > 0)
+            {
+                function(static_cast<size_t>(0), count);
+            }
+        }
+
+        static void _integrate(float *positions, float *velocities, float acceleration, float delta_time, size_t begin, size_t end)
+        {
+            float velocity_change = acceleration * delta_time;
+            size_t i = begin;
+#if defined(ASR_SIMD_SSE2)
+            __m128 velocity_changes = _mm_set1_ps(velocity_change);
+            __m128 delta_times = _mm_set1_ps(delta_time);
+            for (; i + 4 <= end; i += 4)
+            {
+                __m128 velocity = _mm_add_ps(_mm_loadu_ps(velocities + i), velocity_changes);
+                _mm_storeu_ps(velocities + i, velocity);
+                _mm_storeu_ps(positions + i, _mm_add_ps(_mm_loadu_ps(positions + i), _mm_mul_ps(velocity, delta_times)));
+            }
+#elif defined(ASR_SIMD_NEON)
+            float32x4_t velocity_changes = vdupq_n_f32(velocity_change);
+            float32x4_t delta_times = vdupq_n_f32(delta_time);
+            for (; i + 4 <= end; i += 4)
+            {
+                float32x4_t velocity = vaddq_f32(vld1q_f32(velocities + i), velocity_changes);
+                vst1q_f32(velocities + i, velocity);
+                vst1q_f32(positions + i, vaddq_f32(vld1q_f32(positions + i), vmulq_f32(velocity, delta_times)));
+            }
+#endif
+            for (; i < end; ++i)
+            {
+                velocities[i] += velocity_change;
+                positions[i] += velocities[i] * delta_time;
+            }
+        }
+
+        static void _advance(float *ages, float delta_time, size_t begin, size_t end)
+        {
+            size_t i = begin;
+#if defined(ASR_SIMD_SSE2)
+            __m128 delta_times = _mm_set1_ps(delta_time);
+            for (; i + 4 <= end; i += 4)
+            {
+                _mm_storeu_ps(ages + i, _mm_add_ps(_mm_loadu_ps(ages + i), delta_times));
+            }
+#elif defined(ASR_SIMD_NEON)
+            float32x4_t delta_times = vdupq_n_f32(delta_time);
+            for (; i + 4 <= end; i += 4)
+            {
+                vst1q_f32(ages + i, vaddq_f32(vld1q_f32(ages + i), delta_times));
+            }
+#endif
+            for (; i < end; ++i)
+            {
+                ages[i] += delta_time;
+            }
+        }
+
+        void _spawn(const glm::vec3 &position, const glm::vec3 &velocity, float lifetime)
+        {
+            size_t i = _particle_count++;
+            _positions_x[i] = position.x;
+            _positions_y[i] = position.y;
+            _positions_z[i] = position.z;
+            _velocities_x[i] = velocity.x;
+            _velocities_y[i] = velocity.y;
+            _velocities_z[i] = velocity.z;
+            _ages[i] = 0.0f;
+            _lifetimes[i] = lifetime;
+
+            if (_particle_count == 1)
+            {
+                _bounds = AABB{position, position};
+            }
+            else
+            {
+                _bounds.set_minimum(glm::min(_bounds.get_minimum(), position));
+                _bounds.set_maximum(glm::max(_bounds.get_maximum(), position));
+            }
+            _requires_vertices_write = true;
+        }
+
+        // Stores the particles back to front by an ascending key. The bits of a non-negative float compare
+        // like the float itself, so inverting the ones of the squared distance puts the farthest first. The
+        // particles stay in that order, so the next frame, in which they have barely moved, reads them almost
+        // sequentially.
+        void _sort(const glm::vec3 &camera_position, JobSystem *job_system)
+        {
+            _sort_keys.resize(_particle_count);
+            _sort_scratch.resize(_particle_count);
+            _sorted_component.resize(_particle_count);
+            _for_each_range(_particle_count, job_system, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    float x = _positions_x[i] - camera_position.x;
+                    float y = _positions_y[i] - camera_position.y;
+                    float z = _positions_z[i] - camera_position.z;
+                    float squared_distance = x * x + y * y + z * z;
+
+                    uint32_t bits;
+                    std::memcpy(&bits, &squared_distance, sizeof(bits));
+                    _sort_keys[i] = std::make_pair(~bits, static_cast<uint32_t>(i));
+                }
+            });
+
+            radix_sort(_sort_keys.data(), _sort_scratch.data(), _particle_count, [](const std::pair<uint32_t, uint32_t> &key) {
+                return key.first;
+            });
+
+            for (auto *component : {&_positions_x, &_positions_y, &_positions_z,
+                                    &_velocities_x, &_velocities_y, &_velocities_z, &_ages, &_lifetimes})
+            {
+                _for_each_range(_particle_count, job_system, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        _sorted_component[i] = (*component)[_sort_keys[i].second];
+                    }
+                });
+                std::copy(_sorted_component.begin(), _sorted_component.end(), component->begin());
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,397 @@
+#ifndef PRIMITIVE_BATCH_H
+#define PRIMITIVE_BATCH_H
+
+#include "objects/object.h"
+#include "objects/mesh.h"
+#include "geometries/geometry.h"
+#include "geometries/vertex_layout.h"
+#include "materials/material.h"
+#include "math/aabb.h"
+#include "utilities/node_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace asr
+{
+    // Immediate-mode drawing of points, lines, triangles, rectangles, circles and textured quads that change
+    // every frame, like the series of a live chart. The shapes added between begin() and end() are appended
+    // to a layer per material and primitive type, and end() streams every layer into one geometry, so a frame
+    // costs a draw per layer instead of a mesh, a geometry and a buffer per shape. The layers keep the
+    // capacity of their vertices, so once the batch has grown to its size, recording allocates nothing.
+    //
+    // The layers are child meshes of the batch, which has to be owned by a shared pointer when shapes of a
+    // new material or primitive type are added. They do not cast shadows, and the renderer skips the layers
+    // that stayed empty for a frame. Rectangles, circles, quads and wide lines lie in the XY plane of the
+    // batch.
+    class PrimitiveBatch : public Object
+    {
+    public:
+        inline static const unsigned int DEFAULT_CIRCLE_SEGMENT_COUNT = 32;
+
+        explicit PrimitiveBatch(const glm::vec3 &position = glm::vec3(0.0f),
+                                const glm::vec3 &rotation = glm::vec3(0.0f),
+                                const glm::vec3 &scale = glm::vec3(1.0f),
+                                std::weak_ptr<Object> parent = {})
+            : Object("", position, rotation, scale, std::move(parent))
+        {
+            set_circle_segment_count(DEFAULT_CIRCLE_SEGMENT_COUNT);
+        }
+
+        [[nodiscard]] const std::shared_ptr<Material> &get_material() const
+        {
+            return _material;
+        }
+
+        // The material of the shapes added next. Shapes added with another material before stay in its layers.
+        void set_material(std::shared_ptr<Material> material)
+        {
+            if (_material != material)
+            {
+                _material = std::move(material);
+                _triangle_layer = NO_LAYER;
+                _line_layer = NO_LAYER;
+                _point_layer = NO_LAYER;
+            }
+        }
+
+        [[nodiscard]] const glm::vec4 &get_color() const
+        {
+            return _color;
+        }
+
+        void set_color(const glm::vec4 &color)
+        {
+            _color = color;
+            for (size_t component = 0; component < 4; ++component)
+            {
+                float value = std::min(std::max(color[static_cast<int>(component)], 0.0f), 1.0f);
+                _packed_color[component] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+            }
+        }
+
+        // Lines without a width are drawn as lines of a pixel, wider ones as quads of this width.
+        [[nodiscard]] float get_line_width() const
+        {
+            return _line_width;
+        }
+
+        void set_line_width(float line_width)
+        {
+            _line_width = std::max(line_width, 0.0f);
+        }
+
+        // The z coordinate of the shapes in the XY plane.
+        [[nodiscard]] float get_depth() const
+        {
+            return _depth;
+        }
+
+        void set_depth(float depth)
+        {
+            _depth = depth;
+        }
+
+        [[nodiscard]] unsigned int get_circle_segment_count() const
+        {
+            return static_cast<unsigned int>(_unit_circle.size());
+        }
+
+        void set_circle_segment_count(unsigned int circle_segment_count)
+        {
+            circle_segment_count = std::max(circle_segment_count, 3u);
+            if (_unit_circle.size() == circle_segment_count)
+            {
+                return;
+            }
+
+            _unit_circle.resize(circle_segment_count);
+            for (unsigned int i = 0; i < circle_segment_count; ++i)
+            {
+                float angle = 2.0f * static_cast<float>(M_PI) * static_cast<float>(i) / static_cast<float>(circle_segment_count);
+                _unit_circle[i] = glm::vec2{std::cos(angle), std::sin(angle)};
+            }
+        }
+
+        [[nodiscard]] size_t get_layer_count() const
+        {
+            return _layers.size();
+        }
+
+        // The vertices added since begin() in all layers.
+        [[nodiscard]] size_t get_vertex_count() const
+        {
+            size_t vertex_count{0};
+            for (const Layer &layer : _layers)
+            {
+                vertex_count += layer.vertices.size();
+            }
+
+            return vertex_count;
+        }
+
+        // Drops the shapes of the last frame. The layers and their storage are kept for the next shapes.
+        void begin()
+        {
+            for (Layer &layer : _layers)
+            {
+                layer.vertices.clear();
+            }
+        }
+
+        void add_point(const glm::vec3 &position)
+        {
+            Layer &layer = _acquire_layer(Geometry::Points, _point_layer);
+            _add_vertex(layer, position);
+        }
+
+        void add_line(const glm::vec3 &start, const glm::vec3 &end)
+        {
+            if (_line_width > 0.0f)
+            {
+                _add_wide_line(start, end);
+                return;
+            }
+
+            Layer &layer = _acquire_layer(Geometry::Lines, _line_layer);
+            _add_vertex(layer, start);
+            _add_vertex(layer, end);
+        }
+
+        // Joins the points with lines, and the last point with the first one if the polyline is closed.
+        void add_polyline(const glm::vec3 *points, size_t point_count, bool closed = false)
+        {
+            for (size_t i = 1; i < point_count; ++i)
+            {
+                add_line(points[i - 1], points[i]);
+            }
+            if (closed && point_count > 2)
+            {
+                add_line(points[point_count - 1], points[0]);
+            }
+        }
+
+        void add_polyline(const std::vector<glm::vec3> &points, bool closed = false)
+        {
+            add_polyline(points.data(), points.size(), closed);
+        }
+
+        void add_triangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+        {
+            Layer &layer = _acquire_layer(Geometry::Triangles, _triangle_layer);
+            _add_vertex(layer, a);
+            _add_vertex(layer, b);
+            _add_vertex(layer, c);
+        }
+
+        void add_rectangle(const glm::vec2 &minimum, const glm::vec2 &maximum)
+        {
+            add_quad(minimum, maximum, glm::vec4{0.0f, 0.0f, 1.0f, 1.0f});
+        }
+
+        void add_rectangle_outline(const glm::vec2 &minimum, const glm::vec2 &maximum)
+        {
+            glm::vec3 corners[4]{
+                glm::vec3{minimum.x, minimum.y, _depth}, glm::vec3{maximum.x, minimum.y, _depth},
+                glm::vec3{maximum.x, maximum.y, _depth}, glm::vec3{minimum.x, maximum.y, _depth}};
+            add_polyline(corners, 4, true);
+        }
+
+        // A rectangle that samples the region of a texture, in the format of Texture::get_region(), like a glyph
+        // in a font atlas.
+        void add_quad(const glm::vec2 &minimum, const glm::vec2 &maximum, const glm::vec4 &texture_region)
+        {
+            float minimum_u = texture_region.x;
+            float minimum_v = texture_region.y;
+            float maximum_u = texture_region.x + texture_region.z;
+            float maximum_v = texture_region.y + texture_region.w;
+
+            Layer &layer = _acquire_layer(Geometry::Triangles, _triangle_layer);
+            _add_vertex(layer, glm::vec3{minimum.x, minimum.y, _depth}, minimum_u, minimum_v);
+            _add_vertex(layer, glm::vec3{maximum.x, minimum.y, _depth}, maximum_u, minimum_v);
+            _add_vertex(layer, glm::vec3{maximum.x, maximum.y, _depth}, maximum_u, maximum_v);
+            _add_vertex(layer, glm::vec3{minimum.x, minimum.y, _depth}, minimum_u, minimum_v);
+            _add_vertex(layer, glm::vec3{maximum.x, maximum.y, _depth}, maximum_u, maximum_v);
+            _add_vertex(layer, glm::vec3{minimum.x, maximum.y, _depth}, minimum_u, maximum_v);
+        }
+
+        void add_circle(const glm::vec2 &center, float radius)
+        {
+            Layer &layer = _acquire_layer(Geometry::Triangles, _triangle_layer);
+            glm::vec3 center_position{center.x, center.y, _depth};
+            for (size_t i = 0; i < _unit_circle.size(); ++i)
+            {
+                const glm::vec2 &first = _unit_circle[i];
+                const glm::vec2 &second = _unit_circle[(i + 1) % _unit_circle.size()];
+                _add_vertex(layer, center_position);
+                _add_vertex(layer, glm::vec3{center.x + first.x * radius, center.y + first.y * radius, _depth});
+                _add_vertex(layer, glm::vec3{center.x + second.x * radius, center.y + second.y * radius, _depth});
+            }
+        }
+
+        void add_circle_outline(const glm::vec2 &center, float radius)
+        {
+            for (size_t i = 0; i < _unit_circle.size(); ++i)
+            {
+                const glm::vec2 &first = _unit_circle[i];
+                const glm::vec2 &second = _unit_circle[(i + 1) % _unit_circle.size()];
+                add_line(glm::vec3{center.x + first.x * radius, center.y + first.y * radius, _depth},
+                         glm::vec3{center.x + second.x * radius, center.y + second.y * radius, _depth});
+            }
+        }
+
+        // Streams the layers to their geometries.
+        void end()
+        {
+            for (Layer &layer : _layers)
+            {
+                if (layer.vertices.empty() && layer.streamed_vertex_count == 0)
+                {
+                    continue;
+                }
+
+                AABB bounding_box{glm::vec3{0.0f}, glm::vec3{0.0f}};
+                if (!layer.vertices.empty())
+                {
+                    bounding_box = AABB{layer.minimum, layer.maximum};
+                }
+                uint8_t *vertices = layer.mesh->get_geometry()->edit_packed_vertices(layer.vertices.size(), bounding_box);
+                if (!layer.vertices.empty())
+                {
+                    std::memcpy(vertices, layer.vertices.data(), layer.vertices.size() * sizeof(BatchVertex));
+                }
+                layer.streamed_vertex_count = layer.vertices.size();
+                layer.mesh->invalidate_world_bounding_box();
+            }
+        }
+
+    protected:
+        virtual std::shared_ptr<Geometry> _create_geometry() = 0;
+
+    private:
+        inline static const size_t NO_LAYER = std::numeric_limits<size_t>::max();
+
+        // Packed in the compact layout of positions, colors and the first texture coordinates.
+        struct BatchVertex
+        {
+            float position[3];
+            uint8_t color[4];
+            float texture_coordinates[2];
+        };
+        static_assert(sizeof(BatchVertex) == 24, "The vertices of a batch have to match the compact layout.");
+
+        struct Layer
+        {
+            std::shared_ptr<Material> material;
+            Geometry::Type type;
+            std::shared_ptr<Mesh> mesh;
+            std::vector<BatchVertex> vertices;
+            glm::vec3 minimum{0.0f};
+            glm::vec3 maximum{0.0f};
+            size_t streamed_vertex_count{0};
+        };
+
+        std::vector<Layer> _layers;
+        size_t _triangle_layer{NO_LAYER};
+        size_t _line_layer{NO_LAYER};
+        size_t _point_layer{NO_LAYER};
+
+        std::shared_ptr<Material> _material;
+        glm::vec4 _color{1.0f};
+        uint8_t _packed_color[4]{255, 255, 255, 255};
+        float _line_width{0.0f};
+        float _depth{0.0f};
+        std::vector<glm::vec2> _unit_circle;
+
+        Layer &_acquire_layer(Geometry::Type type, size_t &layer_index)
+        {
+            if (layer_index != NO_LAYER)
+            {
+                return _layers[layer_index];
+            }
+
+            if (!_material)
+            {
+                std::cerr << "Failed to add a shape to the primitive batch '" << get_name() << "', no material was set." << std::endl;
+                std::exit(-1);
+            }
+
+            for (size_t i = 0; i < _layers.size(); ++i)
+            {
+                if (_layers[i].material == _material && _layers[i].type == type)
+                {
+                    layer_index = i;
+                    return _layers[i];
+                }
+            }
+
+            auto geometry = _create_geometry();
+            geometry->set_type(type);
+            geometry->set_vertex_layout(VertexLayout::create_compact(
+                VertexLayout::PositionAttribute | VertexLayout::ColorAttribute | VertexLayout::Texture1CoordinatesAttribute));
+            geometry->set_vertices_usage_strategy(Geometry::StreamStrategy);
+            auto mesh = create_node<Mesh>(std::move(geometry), _material);
+            mesh->set_casting_shadows(false);
+            add_child(mesh);
+
+            layer_index = _layers.size();
+            _layers.push_back(Layer{_material, type, std::move(mesh), {}});
+
+            return _layers.back();
+        }
+
+        void _add_vertex(Layer &layer, const glm::vec3 &position, float u = 0.0f, float v = 0.0f)
+        {
+            if (layer.vertices.empty())
+            {
+                layer.minimum = position;
+                layer.maximum = position;
+            }
+            else
+            {
+                layer.minimum = glm::min(layer.minimum, position);
+                layer.maximum = glm::max(layer.maximum, position);
+            }
+
+            layer.vertices.push_back(BatchVertex{
+                {position.x, position.y, position.z},
+                {_packed_color[0], _packed_color[1], _packed_color[2], _packed_color[3]},
+                {u, v}});
+        }
+
+        // Widened along the normal of the line in the XY plane, without joints between the lines of a polyline.
+        void _add_wide_line(const glm::vec3 &start, const glm::vec3 &end)
+        {
+            glm::vec2 direction{end.x - start.x, end.y - start.y};
+            float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+            if (length <= 0.0f)
+            {
+                return;
+            }
+
+            float half_width = _line_width * 0.5f / length;
+            glm::vec3 offset{-direction.y * half_width, direction.x * half_width, 0.0f};
+
+            Layer &layer = _acquire_layer(Geometry::Triangles, _triangle_layer);
+            _add_vertex(layer, start - offset);
+            _add_vertex(layer, end - offset);
+            _add_vertex(layer, end + offset);
+            _add_vertex(layer, start - offset);
+            _add_vertex(layer, end + offset);
+            _add_vertex(layer, start + offset);
+        }
+    };
+}
+
+#endif
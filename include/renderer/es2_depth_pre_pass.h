@@ -0,0 +1,196 @@
+#ifndef ES2_DEPTH_PRE_PASS_H
+#define ES2_DEPTH_PRE_PASS_H
+
+#include "renderer/render_command_buffer.h"
+#include "renderer/render_stats.h"
+#include "renderer/es2_shader.h"
+#include "renderer/es2_shader_cache.h"
+#include "renderer/es2_state_cache.h"
+#include "renderer/es2_occlusion_culling.h"
+#include "materials/material.h"
+#include "geometries/geometry.h"
+#include "utilities/profiler.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Fills the depth buffer with the opaque meshes before they are shaded, using a shader that only transforms
+    // positions. The shading pass then draws the same meshes with an equal depth test, so every covered fragment
+    // is rejected before the expensive fragment shader runs.
+    class ES2DepthPrePass
+    {
+    public:
+        // Meshes that blend, offset their depth, do not write depth or are drawn as lines or points keep their
+        // own depth test. So do instanced meshes, whose batched path uploads its transforms to the material's
+        // shader.
+        static bool is_eligible(const RenderCommandBuffer::Command &command)
+        {
+            const Material &material = *command.material;
+            if (command.instanced_mesh != nullptr ||
+                material.is_overlay() || material.is_transparent() || material.is_blending_enabled() ||
+                material.is_polygon_offset_enabled() || !material.is_depth_test_enabled() || !material.is_depth_mask_enabled())
+            {
+                return false;
+            }
+
+            Material::DepthTestFunction depth_test_function = material.get_depth_test_function();
+            if (depth_test_function != Material::DepthTestFunction::Less &&
+                depth_test_function != Material::DepthTestFunction::LowerOrEqual)
+            {
+                return false;
+            }
+
+            Geometry::Type type = command.geometry->get_type();
+            return type == Geometry::Type::Triangles || type == Geometry::Type::TriangleFan || type == Geometry::Type::TriangleStrip;
+        }
+
+        // Returns false when the depth shader is not available, in which case the shading pass has to keep the
+        // depth tests of the materials. Meshes the occlusion culling skips are left out.
+        bool execute(const RenderCommandBuffer &command_buffer, RenderStats &stats,
+                     const ES2OcclusionCulling *occlusion_culling = nullptr)
+        {
+            ASR_PROFILE_SCOPE("Renderer::depth_pre_pass");
+
+            if (!_shader)
+            {
+                _shader = ES2ShaderCache::get_instance().get_shader(
+                    "data/shaders/es2_depth_shader.vert", "data/shaders/es2_depth_shader.frag",
+                    {"position"}, {"model_view_matrix", "projection_matrix"});
+            }
+            if (!_shader->is_compiled() && !_shader->is_dead())
+            {
+                _shader->compile();
+            }
+            if (_shader->is_dead())
+            {
+                return false;
+            }
+
+            auto &state_cache = ES2StateCache::get_instance();
+            _shader->use();
+            state_cache.set_color_mask_enabled(false);
+            state_cache.set_depth_mask_enabled(true);
+            state_cache.set_depth_test_enabled(true);
+            state_cache.set_depth_function(GL_LESS);
+            state_cache.set_blending_enabled(false);
+            state_cache.set_polygon_offset_enabled(false);
+
+            const FrameConstants &frame_constants = command_buffer.get_frame_constants();
+            glUniformMatrix4fv(_shader->get_uniform_location(ProjectionMatrixUniform), 1, GL_FALSE,
+                               glm::value_ptr(frame_constants.get_projection_matrix()));
+
+            const auto &commands = command_buffer.get_commands();
+            for (size_t i = 0; i < commands.size(); ++i)
+            {
+                const auto &command = commands[i];
+                if (!is_eligible(command) || (occlusion_culling != nullptr && occlusion_culling->is_occluded(i)))
+                {
+                    continue;
+                }
+
+                const Material &material = *command.material;
+                state_cache.set_face_culling_enabled(material.is_face_culling_enabled());
+                if (material.is_face_culling_enabled())
+                {
+                    state_cache.set_cull_face_mode(_convert_cull_face_mode_to_es2_cull_face_mode(material.get_cull_face_mode()));
+                    state_cache.set_front_face_order(_convert_front_face_order_to_es2_front_face_order(material.get_front_face_order()));
+                }
+
+                glm::mat4 model_view_matrix = frame_constants.get_view_matrix() * command_buffer.get_world_matrix(command);
+                glUniformMatrix4fv(_shader->get_uniform_location(ModelViewMatrixUniform), 1, GL_FALSE,
+                                   glm::value_ptr(model_view_matrix));
+
+                Geometry &geometry = *command.geometry;
+                geometry.update(material);
+                geometry.use();
+                if (command.indexed)
+                {
+                    glDrawElements(
+                        _convert_geometry_type_to_es2_geometry_type(geometry.get_type()),
+                        static_cast<GLsizei>(command.index_count),
+                        _convert_index_size_to_es2_index_type(geometry.get_index_size()),
+                        nullptr);
+                }
+                else
+                {
+                    glDrawArrays(
+                        _convert_geometry_type_to_es2_geometry_type(geometry.get_type()),
+                        0, static_cast<GLsizei>(command.index_count));
+                }
+                ++stats.draw_call_count;
+            }
+
+            state_cache.set_color_mask_enabled(true);
+
+            return true;
+        }
+
+    private:
+        enum UniformSlot
+        {
+            ModelViewMatrixUniform,
+            ProjectionMatrixUniform
+        };
+
+        std::shared_ptr<Shader> _shader;
+
+        static GLenum _convert_index_size_to_es2_index_type(size_t index_size)
+        {
+            return index_size == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        }
+
+        static GLenum _convert_geometry_type_to_es2_geometry_type(Geometry::Type type)
+        {
+            switch (type)
+            {
+            case Geometry::Type::TriangleFan:
+                return GL_TRIANGLE_FAN;
+            case Geometry::Type::TriangleStrip:
+                return GL_TRIANGLE_STRIP;
+            default:
+                return GL_TRIANGLES;
+            }
+        }
+
+        static GLenum _convert_cull_face_mode_to_es2_cull_face_mode(Material::CullFaceMode cull_face_mode)
+        {
+            switch (cull_face_mode)
+            {
+            case Material::CullFaceMode::CullFrontFaces:
+                return GL_FRONT;
+            case Material::CullFaceMode::CullBackFaces:
+                return GL_BACK;
+            case Material::CullFaceMode::CullFrontAndBackFaces:
+                return GL_FRONT_AND_BACK;
+            }
+
+            return GL_BACK;
+        }
+
+        static GLenum _convert_front_face_order_to_es2_front_face_order(Material::FrontFaceOrder front_face_order)
+        {
+            switch (front_face_order)
+            {
+            case Material::FrontFaceOrder::Clockwise:
+                return GL_CW;
+            case Material::FrontFaceOrder::Counterclockwise:
+                return GL_CCW;
+            }
+
+            return GL_CW;
+        }
+    };
+}
+
+#endif
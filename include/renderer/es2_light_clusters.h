@@ -0,0 +1,120 @@
+#ifndef ES2_LIGHT_CLUSTERS_H
+#define ES2_LIGHT_CLUSTERS_H
+
+#include "renderer/light_clusters.h"
+#include "renderer/es2_state_cache.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace asr
+{
+    // Keeps the binned lights in float data textures on texture units that the materials leave alone.
+    class ES2LightClusters
+    {
+    public:
+        inline static const unsigned int CLUSTER_TEXTURE_UNIT = 3;
+        inline static const unsigned int LIGHT_INDEX_TEXTURE_UNIT = 4;
+        inline static const unsigned int LIGHT_DATA_TEXTURE_UNIT = 5;
+
+        static bool is_supported()
+        {
+            return GLEW_ARB_texture_float;
+        }
+
+        ES2LightClusters() = default;
+
+        ES2LightClusters(const ES2LightClusters &other) = delete;
+        ES2LightClusters &operator=(const ES2LightClusters &other) = delete;
+
+        ~ES2LightClusters()
+        {
+            for (DataTexture *data_texture : {&_cluster_texture, &_light_index_texture, &_light_data_texture})
+            {
+                if (data_texture->texture != 0)
+                {
+                    ES2StateCache::get_instance().forget_texture(data_texture->texture);
+                    glDeleteTextures(1, &data_texture->texture);
+                }
+            }
+        }
+
+        void update(const LightClusters &light_clusters)
+        {
+            if (light_clusters.get_version() == _uploaded_version)
+            {
+                return;
+            }
+
+            _upload(_cluster_texture, CLUSTER_TEXTURE_UNIT, light_clusters.get_cluster_texels(), LightClusters::TILE_COUNT_X);
+            _upload(_light_index_texture, LIGHT_INDEX_TEXTURE_UNIT, light_clusters.get_light_index_texels(),
+                    LightClusters::LIGHT_INDEX_TEXTURE_WIDTH);
+            _upload(_light_data_texture, LIGHT_DATA_TEXTURE_UNIT, light_clusters.get_light_data_texels(),
+                    LightClusters::LIGHT_DATA_TEXTURE_WIDTH);
+            _uploaded_version = light_clusters.get_version();
+        }
+
+        void use()
+        {
+            auto &state_cache = ES2StateCache::get_instance();
+            state_cache.bind_texture(CLUSTER_TEXTURE_UNIT, _cluster_texture.texture);
+            state_cache.bind_texture(LIGHT_INDEX_TEXTURE_UNIT, _light_index_texture.texture);
+            state_cache.bind_texture(LIGHT_DATA_TEXTURE_UNIT, _light_data_texture.texture);
+        }
+
+    private:
+        struct DataTexture
+        {
+            GLuint texture{0};
+            size_t width{0};
+            size_t height{0};
+        };
+
+        DataTexture _cluster_texture;
+        DataTexture _light_index_texture;
+        DataTexture _light_data_texture;
+        unsigned int _uploaded_version{0};
+
+        static void _upload(DataTexture &data_texture, unsigned int unit, const std::vector<glm::vec4> &texels, size_t width)
+        {
+            auto &state_cache = ES2StateCache::get_instance();
+
+            if (data_texture.texture == 0)
+            {
+                glGenTextures(1, &data_texture.texture);
+                state_cache.bind_texture(unit, data_texture.texture);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            }
+            state_cache.bind_texture(unit, data_texture.texture);
+
+            size_t height = texels.size() / width;
+            if (data_texture.width != width || data_texture.height != height)
+            {
+                glTexImage2D(
+                    GL_TEXTURE_2D, 0, GL_RGBA32F_ARB,
+                    static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+                    0, GL_RGBA, GL_FLOAT, texels.data());
+                data_texture.width = width;
+                data_texture.height = height;
+            }
+            else
+            {
+                glTexSubImage2D(
+                    GL_TEXTURE_2D, 0, 0, 0,
+                    static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+                    GL_RGBA, GL_FLOAT, texels.data());
+            }
+            state_cache.get_stats().uploaded_texture_bytes += texels.size() * sizeof(glm::vec4);
+        }
+    };
+}
+
+#endif
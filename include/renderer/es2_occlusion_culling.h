@@ -0,0 +1,429 @@
+#ifndef ES2_OCCLUSION_CULLING_H
+#define ES2_OCCLUSION_CULLING_H
+
+#include "renderer/render_command_buffer.h"
+#include "renderer/render_stats.h"
+#include "renderer/frame_constants.h"
+#include "renderer/es2_shader.h"
+#include "renderer/es2_shader_cache.h"
+#include "renderer/es2_state_cache.h"
+#include "materials/material.h"
+#include "geometries/geometry.h"
+#include "geometries/vertex_layout.h"
+#include "objects/mesh.h"
+#include "math/aabb.h"
+#include "utilities/profiler.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Skips the opaque meshes that were hidden behind others in the previous frames. The results of occlusion
+    // queries are only read once they are available, so the GPU is never waited for and a mesh is drawn, or
+    // skipped, by the last result that arrived. Visible meshes are queried with their own draws every few frames.
+    // Hidden ones are not drawn, instead their world bounds are drawn with color and depth writes disabled after
+    // all opaque meshes, and they are drawn again from the frame after any of those pixels passed the depth test.
+    // Meshes that enter the view or whose bounds reach the near plane count as visible.
+    class ES2OcclusionCulling
+    {
+    public:
+        inline static const unsigned int VISIBLE_QUERY_INTERVAL = 8;
+
+        static bool is_supported()
+        {
+            return GLEW_VERSION_1_5 || GLEW_ARB_occlusion_query || GLEW_ARB_occlusion_query2;
+        }
+
+        // Only meshes that cost more to draw than their bounds are worth a query. Their depth has to be tested
+        // and written, so that they hide others as well.
+        static bool is_eligible(const RenderCommandBuffer::Command &command, size_t minimum_triangle_count)
+        {
+            const Material &material = *command.material;
+            if (material.is_overlay() || material.is_transparent() || material.is_blending_enabled() ||
+                !material.is_depth_test_enabled() || !material.is_depth_mask_enabled())
+            {
+                return false;
+            }
+
+            switch (command.geometry->get_type())
+            {
+            case Geometry::Type::Triangles:
+                return command.index_count / 3 >= minimum_triangle_count;
+            case Geometry::Type::TriangleFan:
+            case Geometry::Type::TriangleStrip:
+                return command.index_count >= minimum_triangle_count + 2;
+            default:
+                return false;
+            }
+        }
+
+        ES2OcclusionCulling() = default;
+
+        ES2OcclusionCulling(const ES2OcclusionCulling &other) = delete;
+        ES2OcclusionCulling &operator=(const ES2OcclusionCulling &other) = delete;
+
+        ~ES2OcclusionCulling()
+        {
+            for (auto &[mesh, occludee] : _occludees)
+            {
+                _free_queries.push_back(occludee.query);
+            }
+            if (!_free_queries.empty())
+            {
+                glDeleteQueries(static_cast<GLsizei>(_free_queries.size()), _free_queries.data());
+            }
+
+            if (_vertex_array_object != 0)
+            {
+                ES2StateCache::get_instance().forget_vertex_array(_vertex_array_object);
+#ifdef __APPLE__
+                glDeleteVertexArraysAPPLE(1, &_vertex_array_object);
+#else
+                glDeleteVertexArrays(1, &_vertex_array_object);
+#endif
+                glDeleteBuffers(1, &_vertex_buffer_object);
+                glDeleteBuffers(1, &_index_buffer_object);
+            }
+        }
+
+        // Decides which commands are drawn from the results that arrived since the last frame.
+        void begin(const RenderCommandBuffer &command_buffer, size_t minimum_triangle_count, RenderStats &stats)
+        {
+            ASR_PROFILE_SCOPE("Renderer::occlusion_culling");
+
+            ++_frame;
+            const auto &commands = command_buffer.get_commands();
+            _decisions.assign(commands.size(), Draw);
+
+            const FrameConstants &frame_constants = command_buffer.get_frame_constants();
+            glm::mat4 view_projection_matrix = frame_constants.get_projection_matrix() * frame_constants.get_view_matrix();
+            for (size_t i = 0; i < commands.size(); ++i)
+            {
+                const auto &command = commands[i];
+                if (!is_eligible(command, minimum_triangle_count))
+                {
+                    continue;
+                }
+
+                auto [entry, inserted] = _occludees.try_emplace(command.mesh);
+                Occludee &occludee = entry->second;
+                if (inserted)
+                {
+                    occludee.query = _acquire_query();
+                }
+                _read_result(occludee);
+
+                const AABB &bounding_box = command_buffer.get_world_bounding_box(command);
+                if (occludee.last_frame + 1 != _frame || _reaches_near_plane(bounding_box, view_projection_matrix))
+                {
+                    occludee.visible = true;
+                }
+                occludee.last_frame = _frame;
+
+                if (occludee.visible)
+                {
+                    // The queries of visible meshes are spread over the interval by their addresses.
+                    auto phase = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(command.mesh) / sizeof(Mesh));
+                    if (!occludee.query_pending && (_frame + phase) % VISIBLE_QUERY_INTERVAL == 0)
+                    {
+                        _decisions[i] = DrawWithQuery;
+                    }
+                }
+                else
+                {
+                    _decisions[i] = occludee.query_pending ? Occluded : OccludedWithQuery;
+                    ++stats.occluded_mesh_count;
+                }
+            }
+
+            if (_frame % PRUNE_INTERVAL == 0)
+            {
+                _prune();
+            }
+        }
+
+        [[nodiscard]] bool is_occluded(size_t command_index) const
+        {
+            return command_index < _decisions.size() &&
+                   (_decisions[command_index] == Occluded || _decisions[command_index] == OccludedWithQuery);
+        }
+
+        // Returns true when the draw of the command has to be followed by end_query().
+        bool begin_query(const RenderCommandBuffer::Command &command, size_t command_index, RenderStats &stats)
+        {
+            if (command_index >= _decisions.size() || _decisions[command_index] != DrawWithQuery)
+            {
+                return false;
+            }
+
+            Occludee &occludee = _occludees[command.mesh];
+            glBeginQuery(_get_query_target(), occludee.query);
+            occludee.query_pending = true;
+            ++stats.occlusion_query_count;
+
+            return true;
+        }
+
+        void end_query()
+        {
+            glEndQuery(_get_query_target());
+        }
+
+        // Has to follow the opaque meshes, so that their depth is in the depth buffer.
+        void query_occluded(const RenderCommandBuffer &command_buffer, RenderStats &stats)
+        {
+            ASR_PROFILE_SCOPE("Renderer::occlusion_queries");
+
+            const auto &commands = command_buffer.get_commands();
+            bool started{false};
+            for (size_t i = 0; i < commands.size() && i < _decisions.size(); ++i)
+            {
+                if (_decisions[i] != OccludedWithQuery)
+                {
+                    continue;
+                }
+
+                if (!started)
+                {
+                    if (!_use(command_buffer.get_frame_constants()))
+                    {
+                        return;
+                    }
+                    started = true;
+                }
+
+                const AABB &bounding_box = command_buffer.get_world_bounding_box(commands[i]);
+                glm::mat4 box_matrix{1.0f};
+                box_matrix[0][0] = bounding_box.get_maximum().x - bounding_box.get_minimum().x;
+                box_matrix[1][1] = bounding_box.get_maximum().y - bounding_box.get_minimum().y;
+                box_matrix[2][2] = bounding_box.get_maximum().z - bounding_box.get_minimum().z;
+                box_matrix[3] = glm::vec4(bounding_box.get_minimum(), 1.0f);
+                glm::mat4 model_view_matrix = command_buffer.get_frame_constants().get_view_matrix() * box_matrix;
+                glUniformMatrix4fv(_shader->get_uniform_location(ModelViewMatrixUniform), 1, GL_FALSE,
+                                   glm::value_ptr(model_view_matrix));
+
+                Occludee &occludee = _occludees[commands[i].mesh];
+                glBeginQuery(_get_query_target(), occludee.query);
+                glDrawElements(GL_TRIANGLES, BOX_INDEX_COUNT, GL_UNSIGNED_BYTE, nullptr);
+                glEndQuery(_get_query_target());
+                occludee.query_pending = true;
+
+                ++stats.draw_call_count;
+                ++stats.occlusion_query_count;
+            }
+
+            if (started)
+            {
+                auto &state_cache = ES2StateCache::get_instance();
+                state_cache.bind_vertex_array(0);
+                state_cache.set_color_mask_enabled(true);
+                state_cache.set_depth_mask_enabled(true);
+            }
+        }
+
+    private:
+        inline static const uint64_t PRUNE_INTERVAL = 64;
+        inline static const GLsizei BOX_INDEX_COUNT = 36;
+
+        enum Decision : uint8_t
+        {
+            Draw,
+            DrawWithQuery,
+            Occluded,
+            OccludedWithQuery
+        };
+
+        enum UniformSlot
+        {
+            ModelViewMatrixUniform,
+            ProjectionMatrixUniform
+        };
+
+        struct Occludee
+        {
+            GLuint query{0};
+            bool query_pending{false};
+            bool visible{true};
+            uint64_t last_frame{0};
+        };
+
+        std::unordered_map<const Mesh *, Occludee> _occludees;
+        std::vector<GLuint> _free_queries;
+        std::vector<Decision> _decisions;
+        uint64_t _frame{0};
+
+        std::shared_ptr<Shader> _shader;
+        GLuint _vertex_array_object{0};
+        GLuint _vertex_buffer_object{0};
+        GLuint _index_buffer_object{0};
+
+        static GLenum _get_query_target()
+        {
+            return GLEW_VERSION_3_3 || GLEW_ARB_occlusion_query2 ? GL_ANY_SAMPLES_PASSED : GL_SAMPLES_PASSED;
+        }
+
+        // A box that crosses the near plane is clipped there, so its pixels can be missing although the mesh
+        // is in front of the camera.
+        static bool _reaches_near_plane(const AABB &bounding_box, const glm::mat4 &view_projection_matrix)
+        {
+            const glm::vec3 &minimum = bounding_box.get_minimum();
+            const glm::vec3 &maximum = bounding_box.get_maximum();
+            for (unsigned int corner = 0; corner < 8; ++corner)
+            {
+                glm::vec4 position{
+                    (corner & 1u) != 0 ? maximum.x : minimum.x,
+                    (corner & 2u) != 0 ? maximum.y : minimum.y,
+                    (corner & 4u) != 0 ? maximum.z : minimum.z,
+                    1.0f};
+                glm::vec4 clip_position = view_projection_matrix * position;
+                if (clip_position.z < -clip_position.w || clip_position.w <= 0.0f)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        GLuint _acquire_query()
+        {
+            if (_free_queries.empty())
+            {
+                GLuint query{0};
+                glGenQueries(1, &query);
+                return query;
+            }
+
+            GLuint query = _free_queries.back();
+            _free_queries.pop_back();
+
+            return query;
+        }
+
+        static void _read_result(Occludee &occludee)
+        {
+            if (!occludee.query_pending)
+            {
+                return;
+            }
+
+            GLuint available{0};
+            glGetQueryObjectuiv(occludee.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == 0)
+            {
+                return;
+            }
+
+            GLuint passed_samples{0};
+            glGetQueryObjectuiv(occludee.query, GL_QUERY_RESULT, &passed_samples);
+            occludee.visible = passed_samples > 0;
+            occludee.query_pending = false;
+        }
+
+        // Meshes that left the view or were destroyed give their queries back. Pending queries are kept until
+        // their results arrive, since a query can not be reused before.
+        void _prune()
+        {
+            for (auto entry = _occludees.begin(); entry != _occludees.end();)
+            {
+                Occludee &occludee = entry->second;
+                _read_result(occludee);
+                if (occludee.last_frame + PRUNE_INTERVAL < _frame && !occludee.query_pending)
+                {
+                    _free_queries.push_back(occludee.query);
+                    entry = _occludees.erase(entry);
+                }
+                else
+                {
+                    ++entry;
+                }
+            }
+        }
+
+        bool _use(const FrameConstants &frame_constants)
+        {
+            if (!_shader)
+            {
+                _shader = ES2ShaderCache::get_instance().get_shader(
+                    "data/shaders/es2_depth_shader.vert", "data/shaders/es2_depth_shader.frag",
+                    {"position"}, {"model_view_matrix", "projection_matrix"});
+            }
+            if (!_shader->is_compiled() && !_shader->is_dead())
+            {
+                _shader->compile();
+            }
+            if (_shader->is_dead())
+            {
+                return false;
+            }
+
+            if (_vertex_array_object == 0)
+            {
+                _create_vertex_array();
+            }
+
+            auto &state_cache = ES2StateCache::get_instance();
+            _shader->use();
+            state_cache.set_color_mask_enabled(false);
+            state_cache.set_depth_mask_enabled(false);
+            state_cache.set_depth_test_enabled(true);
+            state_cache.set_depth_function(GL_LEQUAL);
+            state_cache.set_blending_enabled(false);
+            state_cache.set_face_culling_enabled(false);
+            state_cache.set_polygon_offset_enabled(false);
+            state_cache.bind_vertex_array(_vertex_array_object);
+            glUniformMatrix4fv(_shader->get_uniform_location(ProjectionMatrixUniform), 1, GL_FALSE,
+                               glm::value_ptr(frame_constants.get_projection_matrix()));
+
+            return true;
+        }
+
+        void _create_vertex_array()
+        {
+            static const GLfloat POSITIONS[]{
+                0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f,
+                0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+            static const GLubyte INDICES[BOX_INDEX_COUNT]{
+                0, 2, 1, 1, 2, 3,
+                4, 5, 6, 5, 7, 6,
+                0, 1, 4, 1, 5, 4,
+                2, 6, 3, 3, 6, 7,
+                0, 4, 2, 2, 4, 6,
+                1, 3, 5, 3, 7, 5};
+
+#ifdef __APPLE__
+            glGenVertexArraysAPPLE(1, &_vertex_array_object);
+#else
+            glGenVertexArrays(1, &_vertex_array_object);
+#endif
+            ES2StateCache::get_instance().bind_vertex_array(_vertex_array_object);
+
+            glGenBuffers(1, &_vertex_buffer_object);
+            glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer_object);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(POSITIONS), POSITIONS, GL_STATIC_DRAW);
+
+            glGenBuffers(1, &_index_buffer_object);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer_object);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(INDICES), INDICES, GL_STATIC_DRAW);
+
+            auto location = static_cast<GLuint>(VertexLayout::Position);
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+            ES2StateCache::get_instance().bind_vertex_array(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+    };
+}
+
+#endif
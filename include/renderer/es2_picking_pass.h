@@ -0,0 +1,353 @@
+#ifndef ES2_PICKING_PASS_H
+#define ES2_PICKING_PASS_H
+
+#include "renderer/render_command_buffer.h"
+#include "renderer/render_stats.h"
+#include "renderer/pick_result.h"
+#include "renderer/es2_shader.h"
+#include "renderer/es2_shader_cache.h"
+#include "renderer/es2_state_cache.h"
+#include "renderer/es2_render_target.h"
+#include "renderer/es2_pixel_reader.h"
+#include "objects/object.h"
+#include "objects/mesh.h"
+#include "objects/instanced_mesh.h"
+#include "materials/material.h"
+#include "geometries/geometry.h"
+#include "math/aabb.h"
+#include "math/frustum.h"
+#include "utilities/profiler.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <array>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Draws an identifier for every mesh, and every instance of an instanced mesh, into a target of a few
+    // pixels and reads it back without waiting for the GPU. The projection is narrowed to the pixels around
+    // the picked one, so only the meshes whose bounds reach them are drawn, and the target stays the size of
+    // the searched region instead of the viewport.
+    class ES2PickingPass
+    {
+    public:
+        // Gives up when the reads of earlier picks are all still pending.
+        bool execute(const RenderCommandBuffer &command_buffer, int x, int y, unsigned int region_size, RenderStats &stats)
+        {
+            ASR_PROFILE_SCOPE("Renderer::picking_pass");
+
+            if (_reader.get_pending_count() == _reader.get_buffer_count())
+            {
+                return false;
+            }
+
+            if (!_shader)
+            {
+                _shader = ES2ShaderCache::get_instance().get_shader(
+                    "data/shaders/es2_picking_shader.vert", "data/shaders/es2_picking_shader.frag",
+                    {"position"}, {"model_view_projection_matrix", "point_size", "identifier"});
+            }
+            if (!_shader->is_compiled() && !_shader->is_dead())
+            {
+                _shader->compile();
+            }
+            if (_shader->is_dead())
+            {
+                return false;
+            }
+
+            if (!_target)
+            {
+                _target = std::make_unique<ES2RenderTarget>(region_size, region_size, false);
+            }
+            _target->set_size(region_size, region_size);
+            _target->use();
+
+            Pick &pick = _picks[(_first_pick + _reader.get_pending_count()) % _picks.size()];
+            pick.x = x;
+            pick.y = y;
+            pick.targets.clear();
+
+            // Scales the region around the pixel up to the whole clip space. The rows of the window count from
+            // the top and the ones of the framebuffer from the bottom.
+            auto width = static_cast<float>(command_buffer.get_viewport_width());
+            auto height = static_cast<float>(command_buffer.get_viewport_height());
+            float scale_x = width / static_cast<float>(region_size);
+            float scale_y = height / static_cast<float>(region_size);
+            float center_x = (static_cast<float>(x) + 0.5f) / width * 2.0f - 1.0f;
+            float center_y = (height - static_cast<float>(y) - 0.5f) / height * 2.0f - 1.0f;
+            glm::mat4 pick_matrix{1.0f};
+            pick_matrix[0][0] = scale_x;
+            pick_matrix[1][1] = scale_y;
+            pick_matrix[3][0] = -center_x * scale_x;
+            pick_matrix[3][1] = -center_y * scale_y;
+
+            const FrameConstants &frame_constants = command_buffer.get_frame_constants();
+            glm::mat4 view_projection_matrix =
+                pick_matrix * frame_constants.get_projection_matrix() * frame_constants.get_view_matrix();
+            Frustum frustum{view_projection_matrix};
+
+            auto &state_cache = ES2StateCache::get_instance();
+            _shader->use();
+            state_cache.set_color_mask_enabled(true);
+            state_cache.set_depth_mask_enabled(true);
+            state_cache.set_depth_function(GL_LEQUAL);
+            state_cache.set_blending_enabled(false);
+            state_cache.set_polygon_offset_enabled(false);
+
+            // Dithering could change the bytes of the identifiers, and a cleared pixel reads as no mesh.
+            GLfloat clear_color[4];
+            glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            glDisable(GL_DITHER);
+            glViewport(0, 0, static_cast<GLsizei>(region_size), static_cast<GLsizei>(region_size));
+            glClear(static_cast<unsigned int>(GL_COLOR_BUFFER_BIT) | static_cast<unsigned int>(GL_DEPTH_BUFFER_BIT));
+
+            for (const auto &command : command_buffer.get_commands())
+            {
+                if (!frustum.intersects(command_buffer.get_world_bounding_box(command)))
+                {
+                    continue;
+                }
+
+                const Material &material = *command.material;
+                state_cache.set_depth_test_enabled(material.is_depth_test_enabled());
+                state_cache.set_face_culling_enabled(material.is_face_culling_enabled());
+                if (material.is_face_culling_enabled())
+                {
+                    state_cache.set_cull_face_mode(_convert_cull_face_mode_to_es2_cull_face_mode(material.get_cull_face_mode()));
+                    state_cache.set_front_face_order(_convert_front_face_order_to_es2_front_face_order(material.get_front_face_order()));
+                }
+                glUniform1f(_shader->get_uniform_location(PointSizeUniform),
+                            material.is_point_sizing_enabled() ? material.get_point_size() : 1.0f);
+
+                Geometry &geometry = *command.geometry;
+                geometry.update(material);
+                geometry.use();
+
+                const glm::mat4 &world_matrix = command_buffer.get_world_matrix(command);
+                std::weak_ptr<const Object> mesh = command.mesh->weak_from_this();
+                if (command.instanced_mesh == nullptr)
+                {
+                    _draw(command, world_matrix, view_projection_matrix, pick, mesh, 0, stats);
+                    continue;
+                }
+
+                // The instances are drawn one by one, which is cheap for the few the narrow frustum keeps.
+                const AABB &bounding_box = geometry.get_bounding_box();
+                const auto &instance_transforms = command.instanced_mesh->get_instance_transforms();
+                for (size_t i = 0; i < instance_transforms.size(); ++i)
+                {
+                    glm::mat4 instance_world_matrix = world_matrix * instance_transforms[i];
+                    AABB instance_bounding_box{bounding_box};
+                    instance_bounding_box.transform(instance_world_matrix);
+                    if (frustum.intersects(instance_bounding_box))
+                    {
+                        _draw(command, instance_world_matrix, view_projection_matrix, pick, mesh, i, stats);
+                    }
+                }
+            }
+
+            _reader.start(region_size, region_size);
+
+            glEnable(GL_DITHER);
+            glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+
+            return true;
+        }
+
+        // Reads back the picks that were started before and passes their results to the callback. The call
+        // waits for the GPU if it did not finish drawing them yet, which it normally did a frame later.
+        void resolve(const std::function<void(const PickResult &)> &on_pick)
+        {
+            ASR_PROFILE_SCOPE("Renderer::resolve_picks");
+
+            while (_reader.get_pending_count() > 0)
+            {
+                Pick &pick = _picks[_first_pick];
+                _first_pick = (_first_pick + 1) % _picks.size();
+
+                unsigned int width{0};
+                unsigned int height{0};
+                PickResult result;
+                result.x = pick.x;
+                result.y = pick.y;
+                if (_reader.finish(_pixels, width, height))
+                {
+                    uint32_t identifier = _find_nearest_identifier(width, height);
+                    if (identifier != 0 && identifier <= pick.targets.size())
+                    {
+                        const Target &target = pick.targets[identifier - 1];
+                        if (auto object = target.mesh.lock())
+                        {
+                            result.mesh = std::static_pointer_cast<Mesh>(std::const_pointer_cast<Object>(object));
+                            result.instance = target.instance;
+                        }
+                    }
+                }
+                pick.targets.clear();
+
+                if (on_pick)
+                {
+                    on_pick(result);
+                }
+            }
+        }
+
+    private:
+        enum UniformSlot
+        {
+            ModelViewProjectionMatrixUniform,
+            PointSizeUniform,
+            IdentifierUniform
+        };
+
+        struct Target
+        {
+            std::weak_ptr<const Object> mesh;
+            size_t instance;
+        };
+
+        struct Pick
+        {
+            std::vector<Target> targets;
+            int x{0};
+            int y{0};
+        };
+
+        std::shared_ptr<Shader> _shader;
+        std::unique_ptr<ES2RenderTarget> _target;
+        ES2PixelReader _reader;
+        std::array<Pick, ES2PixelReader::DEFAULT_BUFFER_COUNT> _picks;
+        size_t _first_pick{0};
+        std::vector<uint8_t> _pixels;
+
+        void _draw(const RenderCommandBuffer::Command &command, const glm::mat4 &world_matrix,
+                   const glm::mat4 &view_projection_matrix, Pick &pick, const std::weak_ptr<const Object> &mesh,
+                   size_t instance, RenderStats &stats)
+        {
+            pick.targets.push_back(Target{mesh, instance});
+            auto identifier = static_cast<uint32_t>(pick.targets.size());
+            glUniform4f(_shader->get_uniform_location(IdentifierUniform),
+                        static_cast<float>(identifier & 0xFFu) / 255.0f,
+                        static_cast<float>((identifier >> 8u) & 0xFFu) / 255.0f,
+                        static_cast<float>((identifier >> 16u) & 0xFFu) / 255.0f,
+                        static_cast<float>((identifier >> 24u) & 0xFFu) / 255.0f);
+
+            glm::mat4 model_view_projection_matrix = view_projection_matrix * world_matrix;
+            glUniformMatrix4fv(_shader->get_uniform_location(ModelViewProjectionMatrixUniform), 1, GL_FALSE,
+                               glm::value_ptr(model_view_projection_matrix));
+
+            const Geometry &geometry = *command.geometry;
+            if (command.indexed)
+            {
+                glDrawElements(
+                    _convert_geometry_type_to_es2_geometry_type(geometry.get_type()),
+                    static_cast<GLsizei>(command.index_count),
+                    _convert_index_size_to_es2_index_type(geometry.get_index_size()),
+                    nullptr);
+            }
+            else
+            {
+                glDrawArrays(
+                    _convert_geometry_type_to_es2_geometry_type(geometry.get_type()),
+                    0, static_cast<GLsizei>(command.index_count));
+            }
+            ++stats.draw_call_count;
+        }
+
+        // The identifier closest to the center of the region, or zero if no mesh covers any of its pixels.
+        [[nodiscard]] uint32_t _find_nearest_identifier(unsigned int width, unsigned int height) const
+        {
+            auto center_x = static_cast<int>(width / 2);
+            auto center_y = static_cast<int>(height / 2);
+            uint32_t nearest_identifier{0};
+            int nearest_distance{std::numeric_limits<int>::max()};
+            for (unsigned int row = 0; row < height; ++row)
+            {
+                for (unsigned int column = 0; column < width; ++column)
+                {
+                    const uint8_t *pixel = &_pixels[(static_cast<size_t>(row) * width + column) * 4];
+                    uint32_t identifier = static_cast<uint32_t>(pixel[0]) | static_cast<uint32_t>(pixel[1]) << 8u |
+                                          static_cast<uint32_t>(pixel[2]) << 16u | static_cast<uint32_t>(pixel[3]) << 24u;
+                    int offset_x = static_cast<int>(column) - center_x;
+                    int offset_y = static_cast<int>(row) - center_y;
+                    int distance = offset_x * offset_x + offset_y * offset_y;
+                    if (identifier != 0 && distance < nearest_distance)
+                    {
+                        nearest_identifier = identifier;
+                        nearest_distance = distance;
+                    }
+                }
+            }
+
+            return nearest_identifier;
+        }
+
+        static GLenum _convert_index_size_to_es2_index_type(size_t index_size)
+        {
+            return index_size == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        }
+
+        static GLenum _convert_geometry_type_to_es2_geometry_type(Geometry::Type type)
+        {
+            switch (type)
+            {
+            case Geometry::Type::Points:
+                return GL_POINTS;
+            case Geometry::Type::Lines:
+                return GL_LINES;
+            case Geometry::Type::LineLoop:
+                return GL_LINE_LOOP;
+            case Geometry::Type::LineStrip:
+                return GL_LINE_STRIP;
+            case Geometry::Type::TriangleFan:
+                return GL_TRIANGLE_FAN;
+            case Geometry::Type::TriangleStrip:
+                return GL_TRIANGLE_STRIP;
+            default:
+                return GL_TRIANGLES;
+            }
+        }
+
+        static GLenum _convert_cull_face_mode_to_es2_cull_face_mode(Material::CullFaceMode cull_face_mode)
+        {
+            switch (cull_face_mode)
+            {
+            case Material::CullFaceMode::CullFrontFaces:
+                return GL_FRONT;
+            case Material::CullFaceMode::CullBackFaces:
+                return GL_BACK;
+            case Material::CullFaceMode::CullFrontAndBackFaces:
+                return GL_FRONT_AND_BACK;
+            }
+
+            return GL_BACK;
+        }
+
+        static GLenum _convert_front_face_order_to_es2_front_face_order(Material::FrontFaceOrder front_face_order)
+        {
+            switch (front_face_order)
+            {
+            case Material::FrontFaceOrder::Clockwise:
+                return GL_CW;
+            case Material::FrontFaceOrder::Counterclockwise:
+                return GL_CCW;
+            }
+
+            return GL_CW;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef ES2_PIXEL_READER_H
+#define ES2_PIXEL_READER_H
+
+#include "utilities/profiler.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <cstddef>
+
+namespace asr
+{
+    // Reads the RGBA pixels of the framebuffer in use without waiting for the GPU. start() copies them into
+    // the next of a ring of pixel buffers and returns right away, and finish() maps the oldest copy. With two
+    // buffers the pixels of a frame are fetched after the next frame was submitted, by when the copy is
+    // normally done. Without pixel buffer objects the pixels are read right away. The rows are stored
+    // bottom to top.
+    class ES2PixelReader
+    {
+    public:
+        inline static const size_t DEFAULT_BUFFER_COUNT = 2;
+
+        explicit ES2PixelReader(size_t buffer_count = DEFAULT_BUFFER_COUNT)
+            : _readbacks(std::max<size_t>(buffer_count, 1))
+        {
+        }
+
+        ES2PixelReader(const ES2PixelReader &other) = delete;
+        ES2PixelReader &operator=(const ES2PixelReader &other) = delete;
+
+        ~ES2PixelReader()
+        {
+            for (auto &readback : _readbacks)
+            {
+                if (readback.buffer != 0)
+                {
+                    glDeleteBuffers(1, &readback.buffer);
+                }
+            }
+        }
+
+        [[nodiscard]] static bool is_asynchronous()
+        {
+            return GLEW_ARB_pixel_buffer_object;
+        }
+
+        [[nodiscard]] size_t get_buffer_count() const
+        {
+            return _readbacks.size();
+        }
+
+        // The copies that were started and not finished yet.
+        [[nodiscard]] size_t get_pending_count() const
+        {
+            return _pending_count;
+        }
+
+        // Fails while every buffer holds a copy that was not finished.
+        bool start(unsigned int width, unsigned int height)
+        {
+            ASR_PROFILE_SCOPE("PixelReader::start");
+
+            if (_pending_count == _readbacks.size())
+            {
+                return false;
+            }
+
+            Readback &readback = _readbacks[(_first_pending + _pending_count) % _readbacks.size()];
+            readback.width = width;
+            readback.height = height;
+            size_t size = static_cast<size_t>(width) * height * 4;
+
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            if (is_asynchronous())
+            {
+                if (readback.buffer == 0)
+                {
+                    glGenBuffers(1, &readback.buffer);
+                }
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+                if (readback.buffer_size != size)
+                {
+                    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
+                    readback.buffer_size = size;
+                }
+                glReadPixels(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            }
+            else
+            {
+                readback.pixels.resize(size);
+                glReadPixels(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA, GL_UNSIGNED_BYTE,
+                             readback.pixels.data());
+            }
+            ++_pending_count;
+
+            return true;
+        }
+
+        // Copies out the pixels of the oldest copy that was started, waiting for it if it is not done yet.
+        // Fails if there is none.
+        bool finish(std::vector<uint8_t> &pixels, unsigned int &width, unsigned int &height)
+        {
+            ASR_PROFILE_SCOPE("PixelReader::finish");
+
+            if (_pending_count == 0)
+            {
+                return false;
+            }
+
+            Readback &readback = _readbacks[_first_pending];
+            _first_pending = (_first_pending + 1) % _readbacks.size();
+            --_pending_count;
+
+            width = readback.width;
+            height = readback.height;
+            size_t size = static_cast<size_t>(width) * height * 4;
+            if (readback.buffer == 0)
+            {
+                pixels.swap(readback.pixels);
+                return true;
+            }
+
+            pixels.resize(size);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+            const void *data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+            bool mapped = data != nullptr;
+            if (mapped)
+            {
+                std::memcpy(pixels.data(), data, size);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            return mapped;
+        }
+
+    private:
+        struct Readback
+        {
+            GLuint buffer{0};
+            size_t buffer_size{0};
+            std::vector<uint8_t> pixels;
+            unsigned int width{0};
+            unsigned int height{0};
+        };
+
+        std::vector<Readback> _readbacks;
+        size_t _first_pending{0};
+        size_t _pending_count{0};
+    };
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef ES2_RENDER_TARGET_H
+#define ES2_RENDER_TARGET_H
+
+#include "renderer/render_target.h"
+#include "renderer/es2_state_cache.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+
+#include <cstdlib>
+#include <iostream>
+
+namespace asr
+{
+    // A framebuffer object with an RGBA color texture and a depth and stencil renderbuffer. They are created
+    // on the first use and again after the size changed.
+    class ES2RenderTarget final : public RenderTarget
+    {
+    public:
+        // Unfiltered targets are sampled at the nearest texel, for values like packed depths that can not be
+        // interpolated.
+        ES2RenderTarget(unsigned int width, unsigned int height, bool filtered = true)
+            : RenderTarget(width, height), _filtered{filtered}
+        {
+        }
+
+        ES2RenderTarget(const ES2RenderTarget &other) = delete;
+        ES2RenderTarget &operator=(const ES2RenderTarget &other) = delete;
+
+        ~ES2RenderTarget() final
+        {
+            _destroy();
+        }
+
+        // Binds the framebuffer of the window again.
+        static void use_default()
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        // Zero until the first use.
+        [[nodiscard]] GLuint get_color_texture() const
+        {
+            return _color_texture;
+        }
+
+        void use() final
+        {
+            if (_requires_update)
+            {
+                _destroy();
+                _create();
+                _requires_update = false;
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        }
+
+    private:
+        bool _filtered;
+        GLuint _framebuffer{0};
+        GLuint _color_texture{0};
+        GLuint _depth_stencil_renderbuffer{0};
+
+        void _create()
+        {
+            glGenFramebuffers(1, &_framebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+
+            // Textures of any size can only be sampled without mipmaps and repetition in ES2.
+            auto &state_cache = ES2StateCache::get_instance();
+            glGenTextures(1, &_color_texture);
+            state_cache.bind_texture(0, _color_texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _filtered ? GL_LINEAR : GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _filtered ? GL_LINEAR : GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height), 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _color_texture, 0);
+
+            // ES2 has no combined attachment point, so the packed renderbuffer is attached twice.
+            glGenRenderbuffers(1, &_depth_stencil_renderbuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, _depth_stencil_renderbuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height));
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depth_stencil_renderbuffer);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depth_stencil_renderbuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            {
+                std::cerr << "Failed to create a render target of " << _width << "x" << _height << " pixels." << std::endl;
+                std::exit(-1);
+            }
+        }
+
+        void _destroy()
+        {
+            if (_framebuffer != 0)
+            {
+                glDeleteFramebuffers(1, &_framebuffer);
+                ES2StateCache::get_instance().forget_texture(_color_texture);
+                glDeleteTextures(1, &_color_texture);
+                glDeleteRenderbuffers(1, &_depth_stencil_renderbuffer);
+            }
+            _framebuffer = 0;
+            _color_texture = 0;
+            _depth_stencil_renderbuffer = 0;
+        }
+    };
+}
+
+#endif
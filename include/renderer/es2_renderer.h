@@ -4,14 +4,48 @@
 #include "renderer/renderer.h"
 #include "objects/object.h"
 #include "objects/mesh.h"
+#include "objects/instanced_mesh.h"
+#include "objects/lod_mesh.h"
+#include "objects/particle_system.h"
+#include "textures/texture.h"
+#include "renderer/es2_state_cache.h"
+#include "renderer/frame_constants.h"
+#include "renderer/es2_light_clusters.h"
+#include "renderer/es2_depth_pre_pass.h"
+#include "renderer/es2_occlusion_culling.h"
+#include "renderer/es2_render_target.h"
+#include "renderer/es2_upscale_pass.h"
+#include "renderer/es2_shadow_pass.h"
+#include "renderer/es2_picking_pass.h"
+#include "renderer/shadow_maps.h"
+#include "math/frustum.h"
+#include "renderer/render_command_buffer.h"
+#include "renderer/render_stats.h"
+#include "renderer/light_selection.h"
+#include "utilities/job_system.h"
+#include "utilities/frame_arena.h"
+#include "utilities/radix_sort.h"
+#include "utilities/allocation_counter.h"
+#include "utilities/profiler.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 #include <glm/glm.hpp>
+#include <imgui.h>
 
-#include <queue>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace asr
 {
@@ -26,115 +60,717 @@ namespace asr
 
             glEnable(GL_PROGRAM_POINT_SIZE);
 
-            std::queue<std::shared_ptr<Object>> queue;
-            queue.push(scene->get_root());
-            while (!queue.empty())
-            {
-                const auto object = queue.front();
-                queue.pop();
-                if (auto mesh = std::dynamic_pointer_cast<Mesh>(object))
-                {
-                    const auto &geometry = mesh->get_geometry();
-                    const auto &material = mesh->get_material();
+            ES2StateCache::get_instance().invalidate();
 
-                    material->use();
-                    material->update(scene, mesh);
-                    geometry->update(*mesh->get_material());
-                }
+            _frame_constants.update(*scene);
+
+            auto &render_list = scene->get_render_list();
+            render_list.update();
+            for (Mesh *mesh : render_list.get_meshes())
+            {
+                const auto &geometry = mesh->get_geometry();
+                const auto &material = mesh->get_material();
 
-                for (const auto &child : object->get_children())
+                material->use();
+                material->update(_frame_constants, mesh->get_world_matrix(), LightSelection{});
+                if (InstancedMesh *instanced_mesh = mesh->as_instanced_mesh())
                 {
-                    queue.push(child);
+                    instanced_mesh->update();
                 }
+                geometry->update(*material);
+            }
+        }
+
+        ES2Renderer(const ES2Renderer &other) = delete;
+        ES2Renderer &operator=(const ES2Renderer &other) = delete;
+
+        ~ES2Renderer() final
+        {
+            if (_gpu_timer_queries[0] != 0)
+            {
+                glDeleteQueries(static_cast<GLsizei>(_gpu_timer_queries.size()), _gpu_timer_queries.data());
             }
         }
 
         void render() final
         {
-            glViewport(0, 0, static_cast<GLsizei>(window->get_width()), static_cast<GLsizei>(window->get_height()));
-            glClear(static_cast<unsigned int>(GL_COLOR_BUFFER_BIT) | static_cast<unsigned int>(GL_DEPTH_BUFFER_BIT));
+            size_t allocation_count = AllocationCounter::get_count();
+            record();
+            submit();
+            _frame_allocation_count = AllocationCounter::get_count() - allocation_count;
+        }
+
+        void record() final
+        {
+            ASR_PROFILE_SCOPE("Renderer::record");
 
+            auto record_start_time = std::chrono::steady_clock::now();
+
+            unsigned int width = _render_target ? _render_target->get_width() : window->get_width();
+            unsigned int height = _render_target ? _render_target->get_height() : window->get_height();
             auto camera = scene->get_camera();
             if (camera->should_receive_aspect_ratio_from_renderer())
             {
-                float aspect_ratio = fabsf(static_cast<float>(window->get_width()) / static_cast<float>(window->get_height()));
+                float aspect_ratio = fabsf(static_cast<float>(width) / static_cast<float>(height));
                 camera->set_aspect_ratio(aspect_ratio);
             }
             if (camera->should_receive_viewport_from_renderer())
             {
-                camera->set_viewport(glm::vec4(0, 0, window->get_width(), window->get_height()));
+                camera->set_viewport(glm::vec4(0, 0, width, height));
+            }
+
+            _frame_constants.set_clustered_lighting_enabled(_clustered_lighting_enabled && ES2LightClusters::is_supported());
+            _frame_constants.update(*scene);
+            _frustum.update(camera->get_view_projection_matrix());
+
+            JobSystem *job_system = _parallel_update_enabled ? &JobSystem::get_instance() : nullptr;
+
+            {
+                ASR_PROFILE_SCOPE("Renderer::update_scene");
+                scene->get_transform_hierarchy().update();
+            }
+            auto &render_list = scene->get_render_list();
+            {
+                ASR_PROFILE_SCOPE("Renderer::update_render_list");
+                render_list.update(job_system);
+            }
+            {
+                ASR_PROFILE_SCOPE("Renderer::update_shadow_maps");
+                _shadow_maps.update(*scene, *camera, _frame_constants, _shadow_mapping_enabled ? _shadow_map_size : 0,
+                                    _shadow_map_update_budget);
+            }
+
+            // Everything the frontend sorts and culls lives in the arena until the next frame is recorded.
+            _frame_arena.reset();
+            size_t mesh_count = render_list.get_meshes().size();
+            _candidate_draws = _frame_arena.allocate<CandidateDraw>(mesh_count);
+            _opaque_draws = _frame_arena.allocate<std::pair<uint64_t, CandidateDraw *>>(mesh_count);
+            _transparent_draws = _frame_arena.allocate<std::pair<uint32_t, CandidateDraw *>>(mesh_count);
+            _selected_lights_per_draw = 0;
+            if (_light_culling_enabled && !_frame_constants.is_clustered_lighting_enabled())
+            {
+                _selected_lights_per_draw = _max_lights_per_mesh;
+                _selected_light_indices = _frame_arena.allocate<uint32_t>(mesh_count * _selected_lights_per_draw);
+            }
+            _candidate_draw_count = 0;
+            _visited_mesh_count = 0;
+            {
+                ASR_PROFILE_SCOPE("Renderer::cull");
+                if (_frustum_culling_enabled)
+                {
+                    render_list.get_bounding_volume_hierarchy().query(_frustum, [&](Mesh *mesh) {
+                        _add_candidate_draw(*mesh, *camera, job_system);
+                    });
+                }
+                else
+                {
+                    for (Mesh *mesh : render_list.get_meshes())
+                    {
+                        _add_candidate_draw(*mesh, *camera, job_system);
+                    }
+                }
+                _prepare_draws(job_system, camera->get_world_position());
+            }
+
+            {
+                ASR_PROFILE_SCOPE("Renderer::sort");
+                radix_sort(_transparent_draws, _frame_arena.allocate<std::pair<uint32_t, CandidateDraw *>>(_transparent_draw_count),
+                           _transparent_draw_count, [](const std::pair<uint32_t, CandidateDraw *> &draw) {
+                               return draw.first;
+                           });
+                if (!std::is_sorted(_opaque_draws, _opaque_draws + _opaque_draw_count))
+                {
+                    _sort_draws(job_system, _opaque_draws, _opaque_draw_count, std::less<std::pair<uint64_t, CandidateDraw *>>{});
+                }
+            }
+
+            RenderCommandBuffer &command_buffer = _command_buffer;
+            command_buffer.clear();
+            command_buffer.reserve(_opaque_draw_count + _transparent_draw_count + render_list.get_overlay_meshes().size());
+            command_buffer.set_frame_constants(_frame_constants);
+            _shadow_maps.record(command_buffer);
+            command_buffer.set_viewport_size(width, height);
+            command_buffer.set_render_target(_render_target);
+            command_buffer.set_resolution_scale(_dynamic_resolution_enabled ? _resolution_scale : 1.0f);
+            if (_pick_requested)
+            {
+                command_buffer.set_pick(_pick_x, _pick_y, _pick_region_size);
+                _pick_requested = false;
+            }
+            for (size_t i = 0; i < _opaque_draw_count; ++i)
+            {
+                const CandidateDraw &draw = *_opaque_draws[i].second;
+                command_buffer.add(*draw.mesh, _opaque_draws[i].first, draw.light_selection);
+            }
+            for (size_t i = 0; i < _transparent_draw_count; ++i)
+            {
+                const CandidateDraw &draw = *_transparent_draws[i].second;
+                command_buffer.add(*draw.mesh, 0, draw.light_selection);
+            }
+            for (Mesh *mesh : render_list.get_overlay_meshes())
+            {
+                if (mesh->get_geometry()->get_vertex_count() != 0)
+                {
+                    command_buffer.add(*mesh, 0);
+                }
+            }
+
+            RenderStats stats;
+            stats.visited_mesh_count = _visited_mesh_count;
+            stats.culled_mesh_count = render_list.get_meshes().size() - render_list.get_overlay_meshes().size() -
+                                      _opaque_draw_count - _transparent_draw_count;
+            stats.drawn_mesh_count = command_buffer.get_commands().size();
+            stats.cpu_record_time = _get_elapsed_time(record_start_time);
+            command_buffer.set_stats(stats);
+            _command_buffer_recorded = true;
+        }
+
+        void submit() final
+        {
+            ASR_PROFILE_SCOPE("Renderer::submit");
+            // The GL context is current on the thread the renderer was created on.
+            assert(std::this_thread::get_id() == _context_thread);
+
+            auto submit_start_time = std::chrono::steady_clock::now();
+
+            if (!_command_buffer_recorded)
+            {
+                return;
+            }
+            RenderCommandBuffer *command_buffer = &_command_buffer;
+
+            auto &state_cache = ES2StateCache::get_instance();
+            state_cache.invalidate();
+            _begin_gpu_timer();
+
+            // Clearing is masked like any other write, so the masks are restored after the last frame.
+            state_cache.set_color_mask_enabled(true);
+            state_cache.set_depth_mask_enabled(true);
+
+            const FrameConstants &frame_constants = command_buffer->get_frame_constants();
+            if (frame_constants.is_clustered_lighting_enabled())
+            {
+                _light_clusters.update(frame_constants.get_light_clusters());
+                _light_clusters.use();
+            }
+
+            // The atlas is drawn into before the output is bound, which has to be bound again afterwards.
+            RenderStats stats = command_buffer->get_stats();
+            if (!command_buffer->get_shadow_map_updates().empty())
+            {
+                _shadow_pass.execute(*command_buffer, stats);
+                _render_target_bound = true;
+            }
+            if (!frame_constants.get_shadow_maps().empty())
+            {
+                _shadow_pass.use();
+            }
+
+            // The picks of earlier frames are read back before the next one is drawn into the same target.
+            _picking_pass.resolve(_on_pick);
+            if (command_buffer->is_pick_requested())
+            {
+                _picking_pass.execute(*command_buffer, command_buffer->get_pick_x(), command_buffer->get_pick_y(),
+                                      command_buffer->get_pick_region_size(), stats);
+                _render_target_bound = true;
+            }
+
+            // Scaled frames are drawn into the lower left of a target of the full size, so changing the scale
+            // does not reallocate it.
+            unsigned int width = command_buffer->get_viewport_width();
+            unsigned int height = command_buffer->get_viewport_height();
+            float resolution_scale = command_buffer->get_resolution_scale();
+            auto scaled_width = std::max(static_cast<unsigned int>(std::lround(static_cast<float>(width) * resolution_scale)), 1u);
+            auto scaled_height = std::max(static_cast<unsigned int>(std::lround(static_cast<float>(height) * resolution_scale)), 1u);
+            bool scaled = scaled_width != width || scaled_height != height;
+            if (scaled)
+            {
+                if (!_scaled_render_target)
+                {
+                    _scaled_render_target = std::make_unique<ES2RenderTarget>(width, height);
+                }
+                _scaled_render_target->set_size(width, height);
+                _scaled_render_target->use();
+                _render_target_bound = true;
+            }
+            else
+            {
+                _use_output(*command_buffer);
+            }
+
+            glViewport(0, 0, static_cast<GLsizei>(scaled_width), static_cast<GLsizei>(scaled_height));
+            glClear(static_cast<unsigned int>(GL_COLOR_BUFFER_BIT) | static_cast<unsigned int>(GL_DEPTH_BUFFER_BIT));
+
+            stats.resolution_scale = scaled ? resolution_scale : 1.0f;
+            bool occlusion_culling = _occlusion_culling_enabled && ES2OcclusionCulling::is_supported();
+            if (occlusion_culling)
+            {
+                _occlusion_culling.begin(*command_buffer, _minimum_occludee_triangle_count, stats);
+                stats.drawn_mesh_count -= stats.occluded_mesh_count;
+            }
+            bool depth_pre_pass = _depth_pre_pass_enabled &&
+                                  _depth_pre_pass.execute(*command_buffer, stats, occlusion_culling ? &_occlusion_culling : nullptr);
+
+            // The bounds of the occluded meshes are tested once the opaque meshes are in the depth buffer.
+            bool occluded_meshes_queried = !occlusion_culling;
+            const auto &commands = command_buffer->get_commands();
+            for (size_t i = 0; i < commands.size(); ++i)
+            {
+                const auto &command = commands[i];
+                if (!occluded_meshes_queried && (command.material->is_transparent() || command.material->is_overlay()))
+                {
+                    _occlusion_culling.query_occluded(*command_buffer, stats);
+                    occluded_meshes_queried = true;
+                }
+                if (scaled && command.material->is_overlay())
+                {
+                    _upscale(*command_buffer, scaled_width, scaled_height, stats);
+                    scaled = false;
+                }
+                if (occlusion_culling && _occlusion_culling.is_occluded(i))
+                {
+                    continue;
+                }
+
+                bool queried = occlusion_culling && _occlusion_culling.begin_query(command, i, stats);
+                _execute_command(*command_buffer, command, depth_pre_pass, stats);
+                if (queried)
+                {
+                    _occlusion_culling.end_query();
+                }
+            }
+            if (!occluded_meshes_queried)
+            {
+                _occlusion_culling.query_occluded(*command_buffer, stats);
+            }
+            if (scaled)
+            {
+                _upscale(*command_buffer, scaled_width, scaled_height, stats);
+            }
+            bool window_output = !command_buffer->get_render_target();
+            _command_buffer_recorded = false;
+
+            _end_gpu_timer();
+
+            // The time between frames also covers the CPU, so it only stands in for missing timer queries.
+            auto submit_time = std::chrono::steady_clock::now();
+            float frame_interval = _last_submit_time == std::chrono::steady_clock::time_point{} ? 0.0f :
+                                   std::chrono::duration<float, std::milli>(submit_time - _last_submit_time).count();
+            _last_submit_time = submit_time;
+            _update_resolution_scale(command_buffer->get_resolution_scale(),
+                                     _gpu_timer_active ? _gpu_frame_time : frame_interval);
+
+            // Uploads and shader compiles made between frames, like the ones of newly created objects, are
+            // counted in the next frame.
+            const RenderStats &backend_stats = state_cache.get_stats();
+            stats.state_change_count = backend_stats.state_change_count;
+            stats.program_bind_count = backend_stats.program_bind_count;
+            stats.texture_bind_count = backend_stats.texture_bind_count;
+            stats.uploaded_buffer_bytes = backend_stats.uploaded_buffer_bytes;
+            stats.uploaded_texture_bytes = backend_stats.uploaded_texture_bytes;
+            stats.shader_compile_count = backend_stats.shader_compile_count;
+            stats.cpu_submit_time = _get_elapsed_time(submit_start_time);
+            stats.gpu_frame_time = _gpu_frame_time;
+            state_cache.reset_stats();
+            _stats = stats;
+
+            if (window_output)
+            {
+                if (_stats_overlay_enabled && ImGui::GetCurrentContext() != nullptr)
+                {
+                    _draw_stats_overlay();
+                }
+                window->swap();
+            }
+        }
+
+    private:
+        inline static const size_t PREPARE_GRAIN_SIZE = 256;
+        inline static const size_t SORT_GRAIN_SIZE = 1024;
+        inline static const size_t GPU_TIMER_QUERY_COUNT = 3;
+
+        struct CandidateDraw
+        {
+            Mesh *mesh;
+            bool visible;
+            bool transparent;
+            uint64_t sort_key;
+            LightSelection light_selection;
+        };
+
+        FrameConstants _frame_constants;
+        Frustum _frustum;
+        ES2LightClusters _light_clusters;
+        ES2DepthPrePass _depth_pre_pass;
+        ES2OcclusionCulling _occlusion_culling;
+        ShadowMaps _shadow_maps;
+        ES2ShadowPass _shadow_pass;
+        ES2PickingPass _picking_pass;
+        bool _render_target_bound{false};
+        std::unique_ptr<ES2RenderTarget> _scaled_render_target;
+        ES2UpscalePass _upscale_pass;
+        std::chrono::steady_clock::time_point _last_submit_time;
+
+        std::array<GLuint, GPU_TIMER_QUERY_COUNT> _gpu_timer_queries{};
+        std::array<bool, GPU_TIMER_QUERY_COUNT> _gpu_timer_query_issued{};
+        size_t _gpu_timer_query_index{0};
+        bool _gpu_timer_active{false};
+        float _gpu_frame_time{0.0f};
+
+        RenderCommandBuffer _command_buffer;
+        bool _command_buffer_recorded{false};
+        std::thread::id _context_thread{std::this_thread::get_id()};
+
+        FrameArena _frame_arena;
+        CandidateDraw *_candidate_draws{nullptr};
+        size_t _candidate_draw_count{0};
+        size_t _visited_mesh_count{0};
+        uint32_t *_selected_light_indices{nullptr};
+        size_t _selected_lights_per_draw{0};
+        std::pair<uint64_t, CandidateDraw *> *_opaque_draws{nullptr};
+        size_t _opaque_draw_count{0};
+        std::pair<uint32_t, CandidateDraw *> *_transparent_draws{nullptr};
+        size_t _transparent_draw_count{0};
+
+        void _add_candidate_draw(Mesh &mesh, Camera &camera, JobSystem *job_system)
+        {
+            ++_visited_mesh_count;
+
+            const auto &material = mesh.get_material();
+            if (material->is_overlay())
+            {
+                return;
             }
 
-            std::vector<std::shared_ptr<Mesh>> opaque, transparent, overlays;
-            std::queue<std::shared_ptr<Object>> queue;
-            queue.push(scene->get_root());
-            while (!queue.empty())
+            if (_level_of_detail_selection_enabled)
             {
-                const auto object = queue.front();
-                queue.pop();
-                if (auto mesh = std::dynamic_pointer_cast<Mesh>(object))
+                if (LODMesh *lod_mesh = mesh.as_lod_mesh())
+                {
+                    lod_mesh->select_level(camera);
+                }
+            }
+            if (ParticleSystem *particle_system = mesh.as_particle_system())
+            {
+                particle_system->write_vertices(camera.get_world_position(), job_system);
+            }
+            // Streamed geometries, like the layers of a primitive batch, can stay empty for a frame.
+            if (mesh.get_geometry()->get_vertex_count() == 0)
+            {
+                return;
+            }
+
+            // Geometries can be shared between meshes, so their bounds are brought up to date before the
+            // meshes are tested in parallel.
+            mesh.get_geometry()->get_bounding_box();
+            _candidate_draws[_candidate_draw_count++] = CandidateDraw{&mesh, false, material->is_transparent(), 0, LightSelection{}};
+        }
+
+        void _prepare_draws(JobSystem *job_system, const glm::vec3 &camera_position)
+        {
+            auto prepare = [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
                 {
-                    auto material = mesh->get_material();
-                    if (material->is_overlay())
+                    CandidateDraw &draw = _candidate_draws[i];
+                    draw.visible = !_frustum_culling_enabled || _frustum.intersects(draw.mesh->get_world_bounding_box());
+                    if (!draw.visible)
                     {
-                        overlays.push_back(mesh);
+                        continue;
                     }
-                    else if (material->is_transparent())
+
+                    if (draw.transparent)
                     {
-                        transparent.push_back(mesh);
+                        draw.sort_key = _calculate_depth_key(*draw.mesh, camera_position);
                     }
                     else
                     {
-                        opaque.push_back(mesh);
+                        draw.sort_key = _calculate_sort_key(*draw.mesh, camera_position, _front_to_back_sorting_enabled);
+                    }
+
+                    if (_selected_lights_per_draw > 0)
+                    {
+                        draw.light_selection = select_lights(
+                            draw.mesh->get_world_bounding_box(),
+                            _frame_constants.get_point_lights(), _frame_constants.get_spot_lights(),
+                            _selected_lights_per_draw, _selected_light_indices + i * _selected_lights_per_draw);
                     }
                 }
+            };
+
+            if (job_system != nullptr)
+            {
+                job_system->parallel_for(_candidate_draw_count, PREPARE_GRAIN_SIZE, prepare);
+            }
+            else
+            {
+                prepare(0, _candidate_draw_count);
+            }
+
+            _opaque_draw_count = 0;
+            _transparent_draw_count = 0;
+            for (size_t i = 0; i < _candidate_draw_count; ++i)
+            {
+                CandidateDraw &draw = _candidate_draws[i];
+                if (!draw.visible)
+                {
+                    continue;
+                }
 
-                for (const auto &child : object->get_children())
+                if (draw.transparent)
                 {
-                    queue.push(child);
+                    _transparent_draws[_transparent_draw_count++] = std::make_pair(static_cast<uint32_t>(draw.sort_key), &draw);
+                }
+                else
+                {
+                    _opaque_draws[_opaque_draw_count++] = std::make_pair(draw.sort_key, &draw);
                 }
             }
+        }
 
-            std::sort(std::begin(transparent), std::end(transparent), [&](const auto &a, const auto &b) {
-                return glm::length(camera->get_world_position() - a->get_world_position()) >
-                       glm::length(camera->get_world_position() - b->get_world_position());
-            });
-            std::sort(std::begin(overlays), std::end(overlays), [](const auto &a, const auto &b) {
-                return a->get_material()->get_overlay_priority() > b->get_material()->get_overlay_priority();
-            });
+        template <typename T, typename Compare>
+        void _sort_draws(JobSystem *job_system, T *draws, size_t draw_count, Compare compare)
+        {
+            if (job_system != nullptr && draw_count > SORT_GRAIN_SIZE)
+            {
+                job_system->parallel_sort(draws, draws + draw_count, _frame_arena.allocate<T>(draw_count), compare,
+                                          SORT_GRAIN_SIZE);
+            }
+            else
+            {
+                std::sort(draws, draws + draw_count, compare);
+            }
+        }
+
+        // Back-to-front order as an ascending key. The bits of a non-negative float compare like the float
+        // itself, so inverting the squared distance ones puts the farthest meshes first.
+        static uint32_t _calculate_depth_key(Mesh &mesh, const glm::vec3 &camera_position)
+        {
+            glm::vec3 offset = glm::vec3(mesh.get_world_matrix()[3]) - camera_position;
+            float squared_distance = glm::dot(offset, offset);
+
+            uint32_t bits;
+            std::memcpy(&bits, &squared_distance, sizeof(bits));
 
-            for (auto &mesh : opaque)
+            return ~bits;
+        }
+
+        // Groups draws by shader, render state and texture. Inside a group they are ordered by geometry or, for
+        // front-to-back sorting, by the upper bits of the squared distance, which is enough to order them coarsely.
+        static uint64_t _calculate_sort_key(Mesh &mesh, const glm::vec3 &camera_position, bool front_to_back)
+        {
+            const auto &geometry = mesh.get_geometry();
+            const auto &material = mesh.get_material();
+
+            auto program = static_cast<uint64_t>(material->get_shader()->get_program() + 1);
+
+            uint32_t render_state_key = material->get_render_state_key();
+            auto render_state = static_cast<uint64_t>((render_state_key ^ (render_state_key >> 16u)) & 0xFFFFu);
+
+            const Texture *texture = material->get_primary_texture();
+            auto texture_id = static_cast<uint64_t>(texture != nullptr ? texture->get_storage_id() : 0);
+
+            uint64_t order = static_cast<uint64_t>(geometry->get_id()) & 0xFFFFu;
+            if (front_to_back)
             {
-                _render_mesh(mesh);
+                glm::vec3 offset = glm::vec3(mesh.get_world_matrix()[3]) - camera_position;
+                float squared_distance = glm::dot(offset, offset);
+
+                uint32_t bits;
+                std::memcpy(&bits, &squared_distance, sizeof(bits));
+                order = static_cast<uint64_t>(bits >> 16u);
             }
-            for (auto &mesh : transparent)
+
+            return ((program & 0xFFFFu) << 48u) |
+                   (render_state << 32u) |
+                   ((texture_id & 0xFFFFu) << 16u) |
+                   order;
+        }
+
+        static void _execute_command(const RenderCommandBuffer &command_buffer, const RenderCommandBuffer::Command &command,
+                                     bool depth_pre_pass, RenderStats &stats)
+        {
+            Material &material = *command.material;
+            Geometry &geometry = *command.geometry;
+
             {
-                _render_mesh(mesh);
+                ASR_PROFILE_SCOPE("Material::update");
+                material.use();
+                material.update(command_buffer.get_frame_constants(), command_buffer.get_world_matrix(command),
+                                command_buffer.get_light_selection(command));
+                if (depth_pre_pass && ES2DepthPrePass::is_eligible(command))
+                {
+                    auto &state_cache = ES2StateCache::get_instance();
+                    state_cache.set_depth_function(GL_EQUAL);
+                    state_cache.set_depth_mask_enabled(false);
+                }
             }
-            for (auto &mesh : overlays)
+
             {
-                _render_mesh(mesh);
+                ASR_PROFILE_SCOPE("Geometry::update");
+                if (command.instanced_mesh != nullptr)
+                {
+                    command.instanced_mesh->update();
+                }
+                geometry.update(material);
+            }
+
+            ASR_PROFILE_SCOPE("Renderer::draw");
+            size_t triangle_count = _calculate_triangle_count(geometry.get_type(), command.index_count);
+            if (command.instanced_mesh != nullptr)
+            {
+                stats.draw_call_count += command.instanced_mesh->draw();
+                stats.triangle_count += triangle_count * command.instanced_mesh->get_instance_count();
+                return;
             }
 
-            window->swap();
+            geometry.use();
+
+            if (command.indexed)
+            {
+                glDrawElements(
+                    _convert_geometry_type_to_es2_geometry_type(geometry.get_type()),
+                    static_cast<GLsizei>(command.index_count),
+                    _convert_index_size_to_es2_index_type(geometry.get_index_size()),
+                    nullptr);
+            }
+            else
+            {
+                glDrawArrays(
+                    _convert_geometry_type_to_es2_geometry_type(geometry.get_type()),
+                    0, static_cast<GLsizei>(command.index_count));
+            }
+
+            ++stats.draw_call_count;
+            stats.triangle_count += triangle_count;
         }
 
-    private:
-        void _render_mesh(const std::shared_ptr<Mesh> &mesh) const
+        static size_t _calculate_triangle_count(Geometry::Type type, size_t index_count)
+        {
+            switch (type)
+            {
+            case Geometry::Type::Triangles:
+                return index_count / 3;
+            case Geometry::Type::TriangleFan:
+            case Geometry::Type::TriangleStrip:
+                return index_count > 2 ? index_count - 2 : 0;
+            default:
+                return 0;
+            }
+        }
+
+        static float _get_elapsed_time(std::chrono::steady_clock::time_point start_time)
+        {
+            return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+        }
+
+        void _use_output(const RenderCommandBuffer &command_buffer)
+        {
+            const auto &render_target = command_buffer.get_render_target();
+            if (render_target)
+            {
+                render_target->use();
+                _render_target_bound = true;
+            }
+            else if (_render_target_bound)
+            {
+                ES2RenderTarget::use_default();
+                _render_target_bound = false;
+            }
+        }
+
+        // The overlays are drawn over the scaled up frame and are only depth tested against each other.
+        void _upscale(const RenderCommandBuffer &command_buffer, unsigned int scaled_width, unsigned int scaled_height,
+                      RenderStats &stats)
         {
-            auto geometry = mesh->get_geometry();
-            auto material = mesh->get_material();
+            unsigned int width = command_buffer.get_viewport_width();
+            unsigned int height = command_buffer.get_viewport_height();
+            _use_output(command_buffer);
+            glViewport(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+            ES2StateCache::get_instance().set_depth_mask_enabled(true);
+            glClear(static_cast<unsigned int>(GL_DEPTH_BUFFER_BIT));
+
+            _upscale_pass.execute(*_scaled_render_target,
+                                  static_cast<float>(scaled_width) / static_cast<float>(width),
+                                  static_cast<float>(scaled_height) / static_cast<float>(height), stats);
+        }
 
-            material->use();
-            material->update(scene, mesh);
-            geometry->update(*material);
-            geometry->use();
+        // Drawn into the ImGui frame that the window started in poll(), so it is rendered by the next swap().
+        void _draw_stats_overlay() const
+        {
+            ImGui::SetNextWindowPos(ImVec2{10.0f, 10.0f}, ImGuiCond_Always);
+            ImGui::SetNextWindowBgAlpha(0.35f);
+            ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                     ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing |
+                                     ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoInputs;
+            if (ImGui::Begin("Renderer Stats", nullptr, flags))
+            {
+                ImGui::Text("Meshes: %zu visited, %zu culled, %zu occluded, %zu drawn",
+                            _stats.visited_mesh_count, _stats.culled_mesh_count, _stats.occluded_mesh_count,
+                            _stats.drawn_mesh_count);
+                ImGui::Text("Draw calls: %zu, triangles: %zu, occlusion queries: %zu",
+                            _stats.draw_call_count, _stats.triangle_count, _stats.occlusion_query_count);
+                ImGui::Text("State changes: %zu (%zu programs, %zu textures)",
+                            _stats.state_change_count, _stats.program_bind_count, _stats.texture_bind_count);
+                ImGui::Text("Uploads: %.1f KiB buffers, %.1f KiB textures",
+                            static_cast<double>(_stats.uploaded_buffer_bytes) / 1024.0,
+                            static_cast<double>(_stats.uploaded_texture_bytes) / 1024.0);
+                ImGui::Text("Shader compiles: %zu", _stats.shader_compile_count);
+                ImGui::Text("Shadow maps: %zu updated, %zu casters",
+                            _stats.shadow_map_update_count, _stats.shadow_caster_count);
+                ImGui::Separator();
+                if (_stats.resolution_scale < 1.0f)
+                {
+                    ImGui::Text("Resolution: %.0f%%", static_cast<double>(_stats.resolution_scale) * 100.0);
+                }
+                ImGui::Text("CPU: %.2f ms record, %.2f ms submit",
+                            static_cast<double>(_stats.cpu_record_time), static_cast<double>(_stats.cpu_submit_time));
+                if (_gpu_timer_active)
+                {
+                    ImGui::Text("GPU: %.2f ms", static_cast<double>(_stats.gpu_frame_time));
+                }
+            }
+            ImGui::End();
+        }
+
+        void _begin_gpu_timer()
+        {
+            _gpu_timer_active = (_gpu_timing_enabled || _dynamic_resolution_enabled) && GLEW_ARB_timer_query;
+            if (!_gpu_timer_active)
+            {
+                return;
+            }
 
-            glDrawElements(
-                _convert_geometry_type_to_es2_geometry_type(geometry->get_type()),
-                static_cast<GLsizei>(geometry->get_indices().size()),
-                GL_UNSIGNED_INT,
-                nullptr);
+            if (_gpu_timer_queries[0] == 0)
+            {
+                glGenQueries(static_cast<GLsizei>(_gpu_timer_queries.size()), _gpu_timer_queries.data());
+            }
+
+            // The query that is reused now was issued GPU_TIMER_QUERY_COUNT frames ago, so its result is
+            // normally available without waiting.
+            GLuint query = _gpu_timer_queries[_gpu_timer_query_index];
+            if (_gpu_timer_query_issued[_gpu_timer_query_index])
+            {
+                GLuint64 elapsed_time{0};
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_time);
+                _gpu_frame_time = static_cast<float>(static_cast<double>(elapsed_time) / 1.0e6);
+            }
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            _gpu_timer_query_issued[_gpu_timer_query_index] = true;
+        }
+
+        void _end_gpu_timer()
+        {
+            if (!_gpu_timer_active)
+            {
+                return;
+            }
+
+            glEndQuery(GL_TIME_ELAPSED);
+            _gpu_timer_query_index = (_gpu_timer_query_index + 1) % _gpu_timer_queries.size();
+        }
+
+        static GLenum _convert_index_size_to_es2_index_type(size_t index_size)
+        {
+            return index_size == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
         }
 
         static GLenum _convert_geometry_type_to_es2_geometry_type(Geometry::Type type)
@@ -2,6 +2,9 @@
 #define ES2_SHADER_H
 
 #include "renderer/shader.h"
+#include "renderer/es2_state_cache.h"
+#include "geometries/vertex_layout.h"
+#include "utilities/profiler.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
@@ -11,6 +14,7 @@
 #include <vector>
 #include <iostream>
 #include <cstdlib>
+#include <initializer_list>
 
 namespace asr
 {
@@ -30,12 +34,15 @@ namespace asr
         {
             if (_program != -1)
             {
+                ES2StateCache::get_instance().forget_program(static_cast<GLuint>(_program));
                 glDeleteProgram(static_cast<GLuint>(_program));
             }
         }
 
         void compile() final
         {
+            ASR_PROFILE_SCOPE("ES2Shader::compile");
+
             cleanup();
 
             int vertex_shader_object = _compile_shader(GL_VERTEX_SHADER);
@@ -66,17 +73,20 @@ namespace asr
         {
             if (_program != -1)
             {
+                ES2StateCache::get_instance().forget_program(static_cast<GLuint>(_program));
                 glDeleteProgram(static_cast<GLuint>(_program));
             }
             _program = -1;
             _dead = false;
+            _uploaded_lights_version = 0;
+            _uploaded_material_version = 0;
         }
 
         void use() final
         {
             if (_program != -1)
             {
-                glUseProgram(static_cast<GLuint>(_program));
+                ES2StateCache::get_instance().use_program(static_cast<GLuint>(_program));
             }
         }
 
@@ -89,6 +99,7 @@ namespace asr
             GLuint shader_object = glCreateShader(shader_type);
             glShaderSource(shader_object, 1, static_cast<const GLchar **>(&shader_source), nullptr);
             glCompileShader(shader_object);
+            ++ES2StateCache::get_instance().get_stats().shader_compile_count;
 
             GLint status;
             glGetShaderiv(shader_object, GL_COMPILE_STATUS, &status);
@@ -119,6 +130,19 @@ namespace asr
             GLuint shader_program = glCreateProgram();
             glAttachShader(shader_program, vertex_shader_object);
             glAttachShader(shader_program, fragment_shader_object);
+            for (unsigned int attribute = 0; attribute < VertexLayout::AttributeCount; ++attribute)
+            {
+                glBindAttribLocation(
+                    shader_program, static_cast<GLuint>(attribute),
+                    VertexLayout::get_attribute_name(static_cast<VertexLayout::Attribute>(attribute)));
+            }
+            for (auto instance_attribute : {VertexLayout::InstanceIndex, VertexLayout::InstanceModelMatrix, VertexLayout::InstanceColor,
+                                            VertexLayout::InstanceTextureRegion})
+            {
+                glBindAttribLocation(
+                    shader_program, static_cast<GLuint>(instance_attribute),
+                    VertexLayout::get_instance_attribute_name(instance_attribute));
+            }
             glLinkProgram(shader_program);
 
             GLint status;
@@ -156,6 +180,15 @@ namespace asr
                 _uniforms[uniform.first] = glGetUniformLocation(shader_program, uniform.first.c_str());
             }
 
+            for (size_t i = 0; i < _attribute_names.size(); ++i)
+            {
+                _attribute_locations[i] = _attributes[_attribute_names[i]];
+            }
+            for (size_t i = 0; i < _uniform_names.size(); ++i)
+            {
+                _uniform_locations[i] = _uniforms[_uniform_names[i]];
+            }
+
             return static_cast<int>(shader_program);
         }
     };
@@ -0,0 +1,153 @@
+#ifndef ES2_SHADER_CACHE_H
+#define ES2_SHADER_CACHE_H
+
+#include "renderer/shader.h"
+#include "renderer/es2_shader.h"
+#include "utilities/utilities.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <functional>
+#include <cstddef>
+
+namespace asr
+{
+    class ES2ShaderCache
+    {
+    public:
+        typedef std::map<std::string, std::string> defines_type;
+
+        static ES2ShaderCache &get_instance()
+        {
+            static ES2ShaderCache instance;
+            return instance;
+        }
+
+        ES2ShaderCache(const ES2ShaderCache &other) = delete;
+        ES2ShaderCache &operator=(const ES2ShaderCache &other) = delete;
+
+        const std::string &get_source(const std::string &path)
+        {
+            auto source = _sources.find(path);
+            if (source == _sources.end())
+            {
+                source = _sources.emplace(path, file_utilities::read_text_file(path)).first;
+            }
+
+            return source->second;
+        }
+
+        std::shared_ptr<Shader> get_shader(const std::string &vertex_shader_path, const std::string &fragment_shader_path,
+                                           const std::vector<std::string> &attributes, const std::vector<std::string> &uniforms,
+                                           const defines_type &defines = {})
+        {
+            const std::string &vertex_shader_source{get_source(vertex_shader_path)};
+            const std::string &fragment_shader_source{get_source(fragment_shader_path)};
+            std::string define_directives{_build_define_directives(defines)};
+
+            key_type key{
+                std::hash<std::string>{}(vertex_shader_source),
+                std::hash<std::string>{}(fragment_shader_source),
+                define_directives};
+
+            auto entry = _shaders.find(key);
+            if (entry != _shaders.end())
+            {
+                if (auto shader = entry->second.lock())
+                {
+                    return shader;
+                }
+            }
+
+            std::shared_ptr<Shader> shader = std::make_shared<ES2Shader>(
+                insert_define_directives(vertex_shader_source, define_directives),
+                insert_define_directives(fragment_shader_source, define_directives),
+                attributes, uniforms);
+            _shaders[key] = shader;
+
+            _remove_expired_shaders();
+
+            return shader;
+        }
+
+        [[nodiscard]] size_t get_shader_count() const
+        {
+            size_t count{0};
+            for (const auto &entry : _shaders)
+            {
+                if (!entry.second.expired())
+                {
+                    ++count;
+                }
+            }
+
+            return count;
+        }
+
+        static std::string insert_define_directives(const std::string &source, const std::string &define_directives)
+        {
+            if (define_directives.empty())
+            {
+                return source;
+            }
+
+            std::string::size_type position{0};
+            std::string::size_type first_character = source.find_first_not_of(" \t\r\n");
+            if (first_character != std::string::npos && source.compare(first_character, 8, "#version") == 0)
+            {
+                std::string::size_type line_end = source.find('\n', first_character);
+                position = line_end == std::string::npos ? source.size() : line_end + 1;
+            }
+
+            std::string result{source.substr(0, position)};
+            if (position > 0 && result.back() != '\n')
+            {
+                result += '\n';
+            }
+            result += define_directives;
+            result += '\n';
+            result += source.substr(position);
+
+            return result;
+        }
+
+    private:
+        typedef std::tuple<size_t, size_t, std::string> key_type;
+
+        ES2ShaderCache() = default;
+
+        std::map<std::string, std::string> _sources;
+        std::map<key_type, std::weak_ptr<Shader>> _shaders;
+
+        static std::string _build_define_directives(const defines_type &defines)
+        {
+            std::string define_directives;
+            for (const auto &define : defines)
+            {
+                define_directives += "#define " + define.first + " " + define.second + "\n";
+            }
+
+            return define_directives;
+        }
+
+        void _remove_expired_shaders()
+        {
+            for (auto entry = _shaders.begin(); entry != _shaders.end();)
+            {
+                if (entry->second.expired())
+                {
+                    entry = _shaders.erase(entry);
+                }
+                else
+                {
+                    ++entry;
+                }
+            }
+        }
+    };
+}
+
+#endif
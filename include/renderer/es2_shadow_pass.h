@@ -0,0 +1,208 @@
+#ifndef ES2_SHADOW_PASS_H
+#define ES2_SHADOW_PASS_H
+
+#include "renderer/render_command_buffer.h"
+#include "renderer/render_stats.h"
+#include "renderer/shadow_map_arrays.h"
+#include "renderer/es2_shader.h"
+#include "renderer/es2_shader_cache.h"
+#include "renderer/es2_state_cache.h"
+#include "renderer/es2_render_target.h"
+#include "materials/material.h"
+#include "geometries/geometry.h"
+#include "utilities/profiler.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Draws the shadow maps a frame updates into their tiles of the atlas. The atlas keeps the other tiles, so
+    // maps that are not updated are sampled as they were drawn in an earlier frame.
+    class ES2ShadowPass
+    {
+    public:
+        inline static const unsigned int ATLAS_TEXTURE_UNIT = 6;
+
+        // Pushes the depths of the casters back by their slope, so that lit surfaces do not shadow themselves
+        // where their depths were rounded into the texels of the map.
+        inline static const float POLYGON_OFFSET_FACTOR = 2.0f;
+        inline static const float POLYGON_OFFSET_UNITS = 4.0f;
+
+        void execute(const RenderCommandBuffer &command_buffer, RenderStats &stats)
+        {
+            ASR_PROFILE_SCOPE("Renderer::shadow_pass");
+
+            const ShadowMapArrays &shadow_maps = command_buffer.get_frame_constants().get_shadow_maps();
+            const auto &updates = command_buffer.get_shadow_map_updates();
+            if (updates.empty())
+            {
+                return;
+            }
+
+            if (!_shader)
+            {
+                _shader = ES2ShaderCache::get_instance().get_shader(
+                    "data/shaders/es2_shadow_shader.vert", "data/shaders/es2_shadow_shader.frag",
+                    {"position"}, {"model_view_projection_matrix"});
+            }
+            if (!_shader->is_compiled() && !_shader->is_dead())
+            {
+                _shader->compile();
+            }
+            if (_shader->is_dead())
+            {
+                return;
+            }
+
+            if (!_atlas)
+            {
+                _atlas = std::make_unique<ES2RenderTarget>(shadow_maps.get_atlas_width(), shadow_maps.get_atlas_height(), false);
+            }
+            _atlas->set_size(shadow_maps.get_atlas_width(), shadow_maps.get_atlas_height());
+            _atlas->use();
+
+            auto &state_cache = ES2StateCache::get_instance();
+            _shader->use();
+            state_cache.set_color_mask_enabled(true);
+            state_cache.set_depth_mask_enabled(true);
+            state_cache.set_depth_test_enabled(true);
+            state_cache.set_depth_function(GL_LESS);
+            state_cache.set_blending_enabled(false);
+            state_cache.set_polygon_offset_enabled(true);
+            state_cache.set_polygon_offset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+
+            // A cleared tile unpacks to a depth past the far plane, so nothing is shadowed where no caster was
+            // drawn. Only the tile is cleared, which the scissor test limits the clear to.
+            GLfloat clear_color[4];
+            glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+            glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+            glEnable(GL_SCISSOR_TEST);
+
+            const auto &casters = command_buffer.get_shadow_casters();
+            auto map_size = static_cast<GLsizei>(shadow_maps.map_size);
+            for (const auto &update : updates)
+            {
+                auto x = static_cast<GLint>(shadow_maps.get_map_x(update.shadow_map));
+                auto y = static_cast<GLint>(shadow_maps.get_map_y(update.shadow_map));
+                glViewport(x, y, map_size, map_size);
+                glScissor(x, y, map_size, map_size);
+                glClear(static_cast<unsigned int>(GL_COLOR_BUFFER_BIT) | static_cast<unsigned int>(GL_DEPTH_BUFFER_BIT));
+
+                for (uint32_t i = update.first_caster; i < update.first_caster + update.caster_count; ++i)
+                {
+                    const auto &caster = casters[i];
+                    const Material &material = *caster.material;
+                    state_cache.set_face_culling_enabled(material.is_face_culling_enabled());
+                    if (material.is_face_culling_enabled())
+                    {
+                        state_cache.set_cull_face_mode(_convert_cull_face_mode_to_es2_cull_face_mode(material.get_cull_face_mode()));
+                        state_cache.set_front_face_order(_convert_front_face_order_to_es2_front_face_order(material.get_front_face_order()));
+                    }
+
+                    glm::mat4 model_view_projection_matrix = update.view_projection_matrix * command_buffer.get_world_matrix(caster);
+                    glUniformMatrix4fv(_shader->get_uniform_location(ModelViewProjectionMatrixUniform), 1, GL_FALSE,
+                                       glm::value_ptr(model_view_projection_matrix));
+
+                    Geometry &geometry = *caster.geometry;
+                    geometry.update(material);
+                    geometry.use();
+                    if (caster.indexed)
+                    {
+                        glDrawElements(
+                            _convert_geometry_type_to_es2_geometry_type(geometry.get_type()),
+                            static_cast<GLsizei>(caster.index_count),
+                            _convert_index_size_to_es2_index_type(geometry.get_index_size()),
+                            nullptr);
+                    }
+                    else
+                    {
+                        glDrawArrays(
+                            _convert_geometry_type_to_es2_geometry_type(geometry.get_type()),
+                            0, static_cast<GLsizei>(caster.index_count));
+                    }
+                    ++stats.draw_call_count;
+                }
+                stats.shadow_caster_count += update.caster_count;
+            }
+            stats.shadow_map_update_count += updates.size();
+
+            glDisable(GL_SCISSOR_TEST);
+            glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+            state_cache.set_polygon_offset_enabled(false);
+        }
+
+        // Binds the atlas for the materials. Does nothing before the first map was drawn.
+        void use()
+        {
+            if (_atlas)
+            {
+                ES2StateCache::get_instance().bind_texture(ATLAS_TEXTURE_UNIT, _atlas->get_color_texture());
+            }
+        }
+
+    private:
+        enum UniformSlot
+        {
+            ModelViewProjectionMatrixUniform
+        };
+
+        std::shared_ptr<Shader> _shader;
+        std::unique_ptr<ES2RenderTarget> _atlas;
+
+        static GLenum _convert_index_size_to_es2_index_type(size_t index_size)
+        {
+            return index_size == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        }
+
+        static GLenum _convert_geometry_type_to_es2_geometry_type(Geometry::Type type)
+        {
+            switch (type)
+            {
+            case Geometry::Type::TriangleFan:
+                return GL_TRIANGLE_FAN;
+            case Geometry::Type::TriangleStrip:
+                return GL_TRIANGLE_STRIP;
+            default:
+                return GL_TRIANGLES;
+            }
+        }
+
+        static GLenum _convert_cull_face_mode_to_es2_cull_face_mode(Material::CullFaceMode cull_face_mode)
+        {
+            switch (cull_face_mode)
+            {
+            case Material::CullFaceMode::CullFrontFaces:
+                return GL_FRONT;
+            case Material::CullFaceMode::CullBackFaces:
+                return GL_BACK;
+            case Material::CullFaceMode::CullFrontAndBackFaces:
+                return GL_FRONT_AND_BACK;
+            }
+
+            return GL_BACK;
+        }
+
+        static GLenum _convert_front_face_order_to_es2_front_face_order(Material::FrontFaceOrder front_face_order)
+        {
+            switch (front_face_order)
+            {
+            case Material::FrontFaceOrder::Clockwise:
+                return GL_CW;
+            case Material::FrontFaceOrder::Counterclockwise:
+                return GL_CCW;
+            }
+
+            return GL_CW;
+        }
+    };
+}
+
+#endif
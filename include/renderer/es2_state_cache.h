@@ -0,0 +1,333 @@
+#ifndef ES2_STATE_CACHE_H
+#define ES2_STATE_CACHE_H
+
+#include "renderer/render_stats.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <tuple>
+
+namespace asr
+{
+    class ES2StateCache
+    {
+    public:
+        inline static const unsigned int MAX_TEXTURE_UNITS = 8;
+
+        static ES2StateCache &get_instance()
+        {
+            static ES2StateCache instance;
+            return instance;
+        }
+
+        ES2StateCache(const ES2StateCache &other) = delete;
+        ES2StateCache &operator=(const ES2StateCache &other) = delete;
+
+        // GL work issued on the context since the last reset: state calls that were not filtered out by the
+        // cache, and the uploads and shader compiles that the GL objects report here.
+        [[nodiscard]] RenderStats &get_stats()
+        {
+            return _stats;
+        }
+
+        void reset_stats()
+        {
+            _stats = RenderStats{};
+        }
+
+        void invalidate()
+        {
+            _color_mask_enabled.reset();
+            _depth_mask_enabled.reset();
+            _depth_test_enabled.reset();
+            _depth_function.reset();
+            _blending_enabled.reset();
+            _blending_equations.reset();
+            _blending_functions.reset();
+            _blending_constant_color.reset();
+            _face_culling_enabled.reset();
+            _cull_face_mode.reset();
+            _front_face_order.reset();
+            _polygon_offset_enabled.reset();
+            _polygon_offset.reset();
+            _line_width.reset();
+            _program.reset();
+            _active_texture_unit.reset();
+            for (auto &texture : _textures)
+            {
+                texture.reset();
+            }
+            _vertex_array_object.reset();
+        }
+
+        void set_color_mask_enabled(bool color_mask_enabled)
+        {
+            if (_color_mask_enabled != color_mask_enabled)
+            {
+                auto mask = static_cast<GLboolean>(color_mask_enabled);
+                glColorMask(mask, mask, mask, mask);
+                _color_mask_enabled = color_mask_enabled;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void set_depth_mask_enabled(bool depth_mask_enabled)
+        {
+            if (_depth_mask_enabled != depth_mask_enabled)
+            {
+                glDepthMask(static_cast<GLboolean>(depth_mask_enabled));
+                _depth_mask_enabled = depth_mask_enabled;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void set_depth_test_enabled(bool depth_test_enabled)
+        {
+            _set_capability(GL_DEPTH_TEST, depth_test_enabled, _depth_test_enabled);
+        }
+
+        void set_depth_function(GLenum depth_function)
+        {
+            if (_depth_function != depth_function)
+            {
+                glDepthFunc(depth_function);
+                _depth_function = depth_function;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void set_blending_enabled(bool blending_enabled)
+        {
+            _set_capability(GL_BLEND, blending_enabled, _blending_enabled);
+        }
+
+        void set_blending_equations(GLenum color_blending_equation, GLenum alpha_blending_equation)
+        {
+            auto blending_equations = std::make_tuple(color_blending_equation, alpha_blending_equation);
+            if (_blending_equations != blending_equations)
+            {
+                glBlendEquationSeparate(color_blending_equation, alpha_blending_equation);
+                _blending_equations = blending_equations;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void set_blending_functions(GLenum source_color_blending_function, GLenum destination_color_blending_function,
+                                    GLenum source_alpha_blending_function, GLenum destination_alpha_blending_function)
+        {
+            auto blending_functions = std::make_tuple(
+                source_color_blending_function, destination_color_blending_function,
+                source_alpha_blending_function, destination_alpha_blending_function);
+            if (_blending_functions != blending_functions)
+            {
+                glBlendFuncSeparate(source_color_blending_function, destination_color_blending_function,
+                                    source_alpha_blending_function, destination_alpha_blending_function);
+                _blending_functions = blending_functions;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void set_blending_constant_color(const glm::vec4 &blending_constant_color)
+        {
+            if (_blending_constant_color != blending_constant_color)
+            {
+                glBlendColor(static_cast<GLclampf>(blending_constant_color[0]),
+                             static_cast<GLclampf>(blending_constant_color[1]),
+                             static_cast<GLclampf>(blending_constant_color[2]),
+                             static_cast<GLclampf>(blending_constant_color[3]));
+                _blending_constant_color = blending_constant_color;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void set_face_culling_enabled(bool face_culling_enabled)
+        {
+            _set_capability(GL_CULL_FACE, face_culling_enabled, _face_culling_enabled);
+        }
+
+        void set_cull_face_mode(GLenum cull_face_mode)
+        {
+            if (_cull_face_mode != cull_face_mode)
+            {
+                glCullFace(cull_face_mode);
+                _cull_face_mode = cull_face_mode;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void set_front_face_order(GLenum front_face_order)
+        {
+            if (_front_face_order != front_face_order)
+            {
+                glFrontFace(front_face_order);
+                _front_face_order = front_face_order;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void set_polygon_offset_enabled(bool polygon_offset_enabled)
+        {
+            _set_capability(GL_POLYGON_OFFSET_FILL, polygon_offset_enabled, _polygon_offset_enabled);
+        }
+
+        void set_polygon_offset(float polygon_offset_factor, float polygon_offset_units)
+        {
+            auto polygon_offset = std::make_tuple(polygon_offset_factor, polygon_offset_units);
+            if (_polygon_offset != polygon_offset)
+            {
+                glPolygonOffset(static_cast<GLfloat>(polygon_offset_factor), static_cast<GLfloat>(polygon_offset_units));
+                _polygon_offset = polygon_offset;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void set_line_width(float line_width)
+        {
+            if (_line_width != line_width)
+            {
+                glLineWidth(static_cast<GLfloat>(line_width));
+                _line_width = line_width;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void use_program(GLuint program)
+        {
+            if (_program != program)
+            {
+                glUseProgram(program);
+                _program = program;
+                ++_stats.state_change_count;
+                ++_stats.program_bind_count;
+            }
+        }
+
+        void forget_program(GLuint program)
+        {
+            if (_program == program)
+            {
+                _program.reset();
+            }
+        }
+
+        void set_active_texture_unit(unsigned int unit)
+        {
+            if (_active_texture_unit != unit)
+            {
+                glActiveTexture(GL_TEXTURE0 + unit);
+                _active_texture_unit = unit;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void bind_texture(unsigned int unit, GLuint texture)
+        {
+            if (unit >= MAX_TEXTURE_UNITS)
+            {
+                set_active_texture_unit(unit);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                ++_stats.state_change_count;
+                ++_stats.texture_bind_count;
+                return;
+            }
+
+            if (_textures[unit] != texture)
+            {
+                set_active_texture_unit(unit);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                _textures[unit] = texture;
+                ++_stats.state_change_count;
+                ++_stats.texture_bind_count;
+            }
+        }
+
+        void forget_texture(GLuint texture)
+        {
+            for (auto &bound_texture : _textures)
+            {
+                if (bound_texture == texture)
+                {
+                    bound_texture.reset();
+                }
+            }
+        }
+
+        void bind_vertex_array(GLuint vertex_array_object)
+        {
+            if (_vertex_array_object != vertex_array_object)
+            {
+#ifdef __APPLE__
+                glBindVertexArrayAPPLE(vertex_array_object);
+#else
+                glBindVertexArray(vertex_array_object);
+#endif
+                _vertex_array_object = vertex_array_object;
+                ++_stats.state_change_count;
+            }
+        }
+
+        void forget_vertex_array(GLuint vertex_array_object)
+        {
+            if (_vertex_array_object == vertex_array_object)
+            {
+                _vertex_array_object.reset();
+            }
+        }
+
+    private:
+        ES2StateCache() = default;
+
+        std::optional<bool> _color_mask_enabled;
+        std::optional<bool> _depth_mask_enabled;
+        std::optional<bool> _depth_test_enabled;
+        std::optional<GLenum> _depth_function;
+
+        std::optional<bool> _blending_enabled;
+        std::optional<std::tuple<GLenum, GLenum>> _blending_equations;
+        std::optional<std::tuple<GLenum, GLenum, GLenum, GLenum>> _blending_functions;
+        std::optional<glm::vec4> _blending_constant_color;
+
+        std::optional<bool> _face_culling_enabled;
+        std::optional<GLenum> _cull_face_mode;
+        std::optional<GLenum> _front_face_order;
+
+        std::optional<bool> _polygon_offset_enabled;
+        std::optional<std::tuple<float, float>> _polygon_offset;
+
+        std::optional<float> _line_width;
+
+        std::optional<GLuint> _program;
+
+        std::optional<unsigned int> _active_texture_unit;
+        std::array<std::optional<GLuint>, MAX_TEXTURE_UNITS> _textures;
+
+        std::optional<GLuint> _vertex_array_object;
+
+        RenderStats _stats;
+
+        void _set_capability(GLenum capability, bool enabled, std::optional<bool> &cached_enabled)
+        {
+            if (cached_enabled != enabled)
+            {
+                if (enabled)
+                {
+                    glEnable(capability);
+                }
+                else
+                {
+                    glDisable(capability);
+                }
+                cached_enabled = enabled;
+                ++_stats.state_change_count;
+            }
+        }
+    };
+}
+
+#endif
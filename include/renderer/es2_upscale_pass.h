@@ -0,0 +1,122 @@
+#ifndef ES2_UPSCALE_PASS_H
+#define ES2_UPSCALE_PASS_H
+
+#include "renderer/es2_render_target.h"
+#include "renderer/es2_shader.h"
+#include "renderer/es2_shader_cache.h"
+#include "renderer/es2_state_cache.h"
+#include "renderer/render_stats.h"
+#include "geometries/vertex_layout.h"
+#include "utilities/profiler.h"
+
+#include <GL/glew.h>
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+
+#include <memory>
+
+namespace asr
+{
+    // Stretches the lower left part of a render target over the whole framebuffer in use with bilinear
+    // filtering, which is how frames drawn at a reduced resolution reach the window.
+    class ES2UpscalePass
+    {
+    public:
+        ES2UpscalePass() = default;
+
+        ES2UpscalePass(const ES2UpscalePass &other) = delete;
+        ES2UpscalePass &operator=(const ES2UpscalePass &other) = delete;
+
+        ~ES2UpscalePass()
+        {
+            if (_vertex_array_object != 0)
+            {
+                ES2StateCache::get_instance().forget_vertex_array(_vertex_array_object);
+#ifdef __APPLE__
+                glDeleteVertexArraysAPPLE(1, &_vertex_array_object);
+#else
+                glDeleteVertexArrays(1, &_vertex_array_object);
+#endif
+                glDeleteBuffers(1, &_vertex_buffer_object);
+            }
+        }
+
+        // The scales are the parts of the width and height of the source that were drawn.
+        void execute(const ES2RenderTarget &source, float width_scale, float height_scale, RenderStats &stats)
+        {
+            ASR_PROFILE_SCOPE("Renderer::upscale");
+
+            if (!_shader)
+            {
+                _shader = ES2ShaderCache::get_instance().get_shader(
+                    "data/shaders/es2_upscale_shader.vert", "data/shaders/es2_upscale_shader.frag",
+                    {"position"}, {"texture_coordinates_scale", "source_sampler"});
+            }
+            if (!_shader->is_compiled() && !_shader->is_dead())
+            {
+                _shader->compile();
+            }
+            if (_shader->is_dead())
+            {
+                return;
+            }
+
+            auto &state_cache = ES2StateCache::get_instance();
+            if (_vertex_array_object == 0)
+            {
+                _create_vertex_array();
+            }
+
+            _shader->use();
+            state_cache.set_color_mask_enabled(true);
+            state_cache.set_depth_test_enabled(false);
+            state_cache.set_blending_enabled(false);
+            state_cache.set_face_culling_enabled(false);
+            state_cache.set_polygon_offset_enabled(false);
+            state_cache.bind_texture(0, source.get_color_texture());
+            glUniform1i(_shader->get_uniform_location(SourceSamplerUniform), 0);
+            glUniform2f(_shader->get_uniform_location(TextureCoordinatesScaleUniform), width_scale, height_scale);
+
+            state_cache.bind_vertex_array(_vertex_array_object);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            state_cache.bind_vertex_array(0);
+            ++stats.draw_call_count;
+        }
+
+    private:
+        enum UniformSlot
+        {
+            TextureCoordinatesScaleUniform,
+            SourceSamplerUniform
+        };
+
+        std::shared_ptr<Shader> _shader;
+        GLuint _vertex_array_object{0};
+        GLuint _vertex_buffer_object{0};
+
+        void _create_vertex_array()
+        {
+            static const GLfloat POSITIONS[]{-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+
+#ifdef __APPLE__
+            glGenVertexArraysAPPLE(1, &_vertex_array_object);
+#else
+            glGenVertexArrays(1, &_vertex_array_object);
+#endif
+            ES2StateCache::get_instance().bind_vertex_array(_vertex_array_object);
+
+            glGenBuffers(1, &_vertex_buffer_object);
+            glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer_object);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(POSITIONS), POSITIONS, GL_STATIC_DRAW);
+
+            auto location = static_cast<GLuint>(VertexLayout::Position);
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+            ES2StateCache::get_instance().bind_vertex_array(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef FRAME_CONSTANTS_H
+#define FRAME_CONSTANTS_H
+
+#include "scene/scene.h"
+#include "renderer/light_arrays.h"
+#include "renderer/light_clusters.h"
+#include "renderer/shadow_map_arrays.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace asr
+{
+    class FrameConstants
+    {
+    public:
+        [[nodiscard]] const glm::mat4 &get_view_matrix() const
+        {
+            return _view_matrix;
+        }
+
+        [[nodiscard]] const glm::mat4 &get_projection_matrix() const
+        {
+            return _projection_matrix;
+        }
+
+        [[nodiscard]] const glm::mat4 &get_orthographic_projection_matrix() const
+        {
+            return _orthographic_projection_matrix;
+        }
+
+        [[nodiscard]] const glm::vec3 &get_ambient_light_color() const
+        {
+            return _ambient_light_color;
+        }
+
+        [[nodiscard]] const LightArrays &get_directional_lights() const
+        {
+            return _directional_lights;
+        }
+
+        [[nodiscard]] const LightArrays &get_point_lights() const
+        {
+            return _point_lights;
+        }
+
+        [[nodiscard]] const LightArrays &get_spot_lights() const
+        {
+            return _spot_lights;
+        }
+
+        [[nodiscard]] bool is_clustered_lighting_enabled() const
+        {
+            return _clustered_lighting_enabled;
+        }
+
+        void set_clustered_lighting_enabled(bool clustered_lighting_enabled)
+        {
+            _clustered_lighting_enabled = clustered_lighting_enabled;
+        }
+
+        // Only kept up to date while clustered lighting is enabled.
+        [[nodiscard]] const LightClusters &get_light_clusters() const
+        {
+            return _light_clusters;
+        }
+
+        // Empty while shadow mapping is disabled. Lights without shadow maps have empty ranges of them.
+        [[nodiscard]] const ShadowMapArrays &get_shadow_maps() const
+        {
+            return _shadow_maps;
+        }
+
+        [[nodiscard]] unsigned int get_lights_version() const
+        {
+            return _lights_version;
+        }
+
+        void update(const Scene &scene)
+        {
+            const auto &camera = scene.get_camera();
+            _view_matrix = camera->get_view_matrix();
+            _projection_matrix = camera->get_projection_matrix();
+            _orthographic_projection_matrix = camera->get_orthographic_projection_matrix();
+
+            bool changed{false};
+
+            _assign(_ambient_light_color, scene.get_ambient_light()->get_ambient_color(), changed);
+
+            const auto &directional_lights = scene.get_directional_lights();
+            changed |= _directional_lights.resize(directional_lights.size());
+            for (size_t i = 0; i < directional_lights.size(); ++i)
+            {
+                const auto &directional_light = directional_lights[i];
+
+                _assign(_directional_lights.enabled[i], static_cast<int>(directional_light->is_enabled()), changed);
+                _assign(_directional_lights.two_sided[i], static_cast<int>(directional_light->is_two_sided()), changed);
+                _assign(_directional_lights.view_directions[i],
+                        glm::vec3(_view_matrix * glm::vec4(directional_light->get_world_direction(), 0.0f)), changed);
+                _assign(_directional_lights.ambient_colors[i], directional_light->get_ambient_color(), changed);
+                _assign(_directional_lights.diffuse_colors[i], directional_light->get_diffuse_color(), changed);
+                _assign(_directional_lights.specular_colors[i], directional_light->get_specular_color(), changed);
+                _assign(_directional_lights.intensities[i], directional_light->get_intensity(), changed);
+            }
+
+            const auto &point_lights = scene.get_point_lights();
+            changed |= _point_lights.resize(point_lights.size());
+            for (size_t i = 0; i < point_lights.size(); ++i)
+            {
+                const auto &point_light = point_lights[i];
+
+                _assign(_point_lights.enabled[i], static_cast<int>(point_light->is_enabled()), changed);
+                _assign(_point_lights.two_sided[i], static_cast<int>(point_light->is_two_sided()), changed);
+                glm::vec3 point_light_world_position{point_light->get_world_matrix() * glm::vec4(point_light->get_position(), 1.0f)};
+                _assign(_point_lights.world_positions[i], point_light_world_position, changed);
+                _assign(_point_lights.view_positions[i], glm::vec3(_view_matrix * glm::vec4(point_light_world_position, 1.0f)), changed);
+                _assign(_point_lights.ambient_colors[i], point_light->get_ambient_color(), changed);
+                _assign(_point_lights.diffuse_colors[i], point_light->get_diffuse_color(), changed);
+                _assign(_point_lights.specular_colors[i], point_light->get_specular_color(), changed);
+                _assign(_point_lights.intensities[i], point_light->get_intensity(), changed);
+                _assign(_point_lights.constant_attenuations[i], point_light->get_constant_attenuation(), changed);
+                _assign(_point_lights.linear_attenuations[i], point_light->get_linear_attenuation(), changed);
+                _assign(_point_lights.quadratic_attenuations[i], point_light->get_quadratic_attenuation(), changed);
+                _assign(_point_lights.influence_radii[i], point_light->get_influence_radius(), changed);
+            }
+
+            const auto &spot_lights = scene.get_spot_lights();
+            changed |= _spot_lights.resize(spot_lights.size());
+            for (size_t i = 0; i < spot_lights.size(); ++i)
+            {
+                const auto &spot_light = spot_lights[i];
+
+                _assign(_spot_lights.enabled[i], static_cast<int>(spot_light->is_enabled()), changed);
+                _assign(_spot_lights.two_sided[i], static_cast<int>(spot_light->is_two_sided()), changed);
+                glm::vec3 spot_light_world_position{spot_light->get_world_matrix() * glm::vec4(spot_light->get_position(), 1.0f)};
+                _assign(_spot_lights.world_positions[i], spot_light_world_position, changed);
+                _assign(_spot_lights.view_positions[i], glm::vec3(_view_matrix * glm::vec4(spot_light_world_position, 1.0f)), changed);
+                _assign(_spot_lights.view_directions[i],
+                        glm::vec3(_view_matrix * glm::vec4(spot_light->get_world_direction(), 0.0f)), changed);
+                _assign(_spot_lights.ambient_colors[i], spot_light->get_ambient_color(), changed);
+                _assign(_spot_lights.diffuse_colors[i], spot_light->get_diffuse_color(), changed);
+                _assign(_spot_lights.specular_colors[i], spot_light->get_specular_color(), changed);
+                _assign(_spot_lights.exponents[i], spot_light->get_exponent(), changed);
+                _assign(_spot_lights.cutoff_angle_cosines[i], spot_light->get_cutoff_angle(), changed);
+                _assign(_spot_lights.intensities[i], spot_light->get_intensity(), changed);
+                _assign(_spot_lights.constant_attenuations[i], spot_light->get_constant_attenuation(), changed);
+                _assign(_spot_lights.linear_attenuations[i], spot_light->get_linear_attenuation(), changed);
+                _assign(_spot_lights.quadratic_attenuations[i], spot_light->get_quadratic_attenuation(), changed);
+                _assign(_spot_lights.influence_radii[i], spot_light->get_influence_radius(), changed);
+            }
+
+            if (_clustered_lighting_enabled)
+            {
+                // The clusters only depend on the lights and the projection, so they are not binned again
+                // while neither changes.
+                bool clusters_changed{changed || !_light_clusters_up_to_date};
+                _assign(_light_cluster_near_plane, camera->get_near_plane(), clusters_changed);
+                _assign(_light_cluster_far_plane, camera->get_far_plane(), clusters_changed);
+                _assign(_light_cluster_projection_matrix, _projection_matrix, clusters_changed);
+                if (clusters_changed)
+                {
+                    _light_clusters.update(_projection_matrix, _light_cluster_near_plane, _light_cluster_far_plane,
+                                           _point_lights, _spot_lights);
+                    changed = true;
+                }
+                _light_clusters_up_to_date = true;
+            }
+            else
+            {
+                _light_clusters_up_to_date = false;
+            }
+
+            if (changed)
+            {
+                ++_lights_version;
+            }
+        }
+
+        // Takes the shadow maps and the ranges of them the lights use after the lights were updated. The maps
+        // are looked up from view space, so their texture matrices follow the camera.
+        void update_shadow_maps(const ShadowMapArrays &shadow_maps,
+                                const std::vector<int> &directional_light_shadow_map_begins,
+                                const std::vector<int> &directional_light_shadow_map_ends,
+                                const std::vector<int> &spot_light_shadow_map_begins,
+                                const std::vector<int> &spot_light_shadow_map_ends)
+        {
+            bool changed{false};
+
+            _assign(_shadow_maps.map_size, shadow_maps.map_size, changed);
+            _assign(_shadow_maps.view_projection_matrices, shadow_maps.view_projection_matrices, changed);
+            _assign(_shadow_maps.regions, shadow_maps.regions, changed);
+            _assign(_shadow_maps.far_depths, shadow_maps.far_depths, changed);
+            _assign(_shadow_maps.biases, shadow_maps.biases, changed);
+
+            glm::mat4 inverse_view_matrix = glm::inverse(_view_matrix);
+            _shadow_maps.texture_matrices.resize(_shadow_maps.size());
+            for (size_t i = 0; i < _shadow_maps.size(); ++i)
+            {
+                _assign(_shadow_maps.texture_matrices[i],
+                        ShadowMapArrays::get_atlas_matrix(i) * _shadow_maps.view_projection_matrices[i] * inverse_view_matrix,
+                        changed);
+            }
+
+            _assign(_directional_lights.shadow_map_begins, directional_light_shadow_map_begins, changed);
+            _assign(_directional_lights.shadow_map_ends, directional_light_shadow_map_ends, changed);
+            _assign(_spot_lights.shadow_map_begins, spot_light_shadow_map_begins, changed);
+            _assign(_spot_lights.shadow_map_ends, spot_light_shadow_map_ends, changed);
+
+            if (changed)
+            {
+                ++_lights_version;
+            }
+        }
+
+    private:
+        glm::mat4 _view_matrix{1.0f};
+        glm::mat4 _projection_matrix{1.0f};
+        glm::mat4 _orthographic_projection_matrix{1.0f};
+
+        glm::vec3 _ambient_light_color{0.0f};
+        LightArrays _directional_lights;
+        LightArrays _point_lights;
+        LightArrays _spot_lights;
+
+        bool _clustered_lighting_enabled{false};
+        LightClusters _light_clusters;
+        bool _light_clusters_up_to_date{false};
+        glm::mat4 _light_cluster_projection_matrix{1.0f};
+        float _light_cluster_near_plane{0.0f};
+        float _light_cluster_far_plane{0.0f};
+
+        ShadowMapArrays _shadow_maps;
+
+        unsigned int _lights_version{1};
+
+        template <typename T>
+        static void _assign(T &target, const T &value, bool &changed)
+        {
+            if (target != value)
+            {
+                target = value;
+                changed = true;
+            }
+        }
+    };
+}
+
+#endif
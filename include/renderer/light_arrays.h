@@ -0,0 +1,72 @@
+#ifndef LIGHT_ARRAYS_H
+#define LIGHT_ARRAYS_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace asr
+{
+    struct LightArrays
+    {
+        std::vector<int> enabled;
+        std::vector<int> two_sided;
+        std::vector<glm::vec3> world_positions;
+        std::vector<glm::vec3> view_positions;
+        std::vector<glm::vec3> view_directions;
+        std::vector<glm::vec3> ambient_colors;
+        std::vector<glm::vec3> diffuse_colors;
+        std::vector<glm::vec3> specular_colors;
+        std::vector<float> exponents;
+        std::vector<float> cutoff_angle_cosines;
+        std::vector<float> intensities;
+        std::vector<float> constant_attenuations;
+        std::vector<float> linear_attenuations;
+        std::vector<float> quadratic_attenuations;
+        std::vector<float> influence_radii;
+        // The shadow maps of a light are the ones from its begin up to its end.
+        std::vector<int> shadow_map_begins;
+        std::vector<int> shadow_map_ends;
+
+        [[nodiscard]] size_t size() const
+        {
+            return enabled.size();
+        }
+
+        [[nodiscard]] bool empty() const
+        {
+            return enabled.empty();
+        }
+
+        bool resize(size_t count)
+        {
+            if (enabled.size() == count)
+            {
+                return false;
+            }
+
+            enabled.resize(count);
+            two_sided.resize(count);
+            world_positions.resize(count);
+            view_positions.resize(count);
+            view_directions.resize(count);
+            ambient_colors.resize(count);
+            diffuse_colors.resize(count);
+            specular_colors.resize(count);
+            exponents.resize(count);
+            cutoff_angle_cosines.resize(count);
+            intensities.resize(count);
+            constant_attenuations.resize(count);
+            linear_attenuations.resize(count);
+            quadratic_attenuations.resize(count);
+            influence_radii.resize(count);
+            shadow_map_begins.resize(count);
+            shadow_map_ends.resize(count);
+
+            return true;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,294 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include "renderer/light_arrays.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Bins the point and spot lights into clusters that divide the view frustum into screen tiles and
+    // exponentially growing depth slices, so that a fragment only has to evaluate the lights of its cluster.
+    // The results are laid out as RGBA float texels that a backend can upload to data textures as they are:
+    //  - a cluster texel holds the offset of the cluster's first light index and its light count,
+    //  - an index texel holds four light indices,
+    //  - a light takes LIGHT_DATA_TEXTURE_WIDTH texels, point lights come before spot lights.
+    class LightClusters
+    {
+    public:
+        inline static const unsigned int TILE_COUNT_X = 16;
+        inline static const unsigned int TILE_COUNT_Y = 9;
+        inline static const unsigned int SLICE_COUNT = 24;
+        inline static const unsigned int CLUSTER_COUNT = TILE_COUNT_X * TILE_COUNT_Y * SLICE_COUNT;
+
+        // Lights beyond this count in a single cluster are dropped.
+        inline static const unsigned int MAX_LIGHTS_PER_CLUSTER = 64;
+
+        inline static const unsigned int LIGHT_INDEX_TEXTURE_WIDTH = 1024;
+        inline static const unsigned int LIGHT_DATA_TEXTURE_WIDTH = 8;
+
+        [[nodiscard]] const std::vector<glm::vec4> &get_cluster_texels() const
+        {
+            return _cluster_texels;
+        }
+
+        [[nodiscard]] const std::vector<glm::vec4> &get_light_index_texels() const
+        {
+            return _light_index_texels;
+        }
+
+        [[nodiscard]] const std::vector<glm::vec4> &get_light_data_texels() const
+        {
+            return _light_data_texels;
+        }
+
+        // The slice of a view depth is floor(log(depth) * scale + bias).
+        [[nodiscard]] float get_depth_scale() const
+        {
+            return _depth_scale;
+        }
+
+        [[nodiscard]] float get_depth_bias() const
+        {
+            return _depth_bias;
+        }
+
+        // Changes every time the lights are binned again.
+        [[nodiscard]] unsigned int get_version() const
+        {
+            return _version;
+        }
+
+        void update(const glm::mat4 &projection_matrix, float near_plane, float far_plane,
+                    const LightArrays &point_lights, const LightArrays &spot_lights)
+        {
+            if (_cluster_bounds.empty() || _projection_matrix != projection_matrix ||
+                _near_plane != near_plane || _far_plane != far_plane)
+            {
+                _update_cluster_bounds(projection_matrix, near_plane, far_plane);
+            }
+
+            size_t light_count = point_lights.size() + spot_lights.size();
+            _light_data_texels.assign(std::max<size_t>(light_count, 1) * LIGHT_DATA_TEXTURE_WIDTH, glm::vec4{0.0f});
+            _cluster_light_counts.assign(CLUSTER_COUNT, 0);
+            _light_assignments.clear();
+
+            _add_lights(point_lights, 0, false);
+            _add_lights(spot_lights, point_lights.size(), true);
+
+            // The lists of the clusters are laid out one after another, the counts are reused as cursors.
+            _cluster_texels.resize(CLUSTER_COUNT);
+            uint32_t light_index_count{0};
+            for (size_t i = 0; i < CLUSTER_COUNT; ++i)
+            {
+                _cluster_texels[i] = glm::vec4{static_cast<float>(light_index_count), static_cast<float>(_cluster_light_counts[i]), 0.0f, 0.0f};
+                light_index_count += _cluster_light_counts[i];
+                _cluster_light_counts[i] = light_index_count - _cluster_light_counts[i];
+            }
+
+            size_t light_index_texel_count = (static_cast<size_t>(light_index_count) + 3) / 4;
+            size_t light_index_row_count = std::max<size_t>((light_index_texel_count + LIGHT_INDEX_TEXTURE_WIDTH - 1) / LIGHT_INDEX_TEXTURE_WIDTH, 1);
+            _light_index_texels.assign(light_index_row_count * LIGHT_INDEX_TEXTURE_WIDTH, glm::vec4{0.0f});
+            for (const auto &[cluster, light] : _light_assignments)
+            {
+                uint32_t light_index = _cluster_light_counts[cluster]++;
+                _light_index_texels[light_index / 4][static_cast<int>(light_index % 4)] = static_cast<float>(light);
+            }
+
+            ++_version;
+        }
+
+    private:
+        struct ClusterBounds
+        {
+            glm::vec3 minimum;
+            glm::vec3 maximum;
+        };
+
+        glm::mat4 _projection_matrix{1.0f};
+        float _near_plane{0.0f};
+        float _far_plane{0.0f};
+        float _depth_scale{0.0f};
+        float _depth_bias{0.0f};
+        std::vector<ClusterBounds> _cluster_bounds;
+
+        std::vector<uint32_t> _cluster_light_counts;
+        std::vector<std::pair<uint32_t, uint32_t>> _light_assignments;
+
+        std::vector<glm::vec4> _cluster_texels;
+        std::vector<glm::vec4> _light_index_texels;
+        std::vector<glm::vec4> _light_data_texels;
+
+        unsigned int _version{0};
+
+        [[nodiscard]] size_t _get_cluster_index(unsigned int x, unsigned int y, unsigned int slice) const
+        {
+            return (static_cast<size_t>(slice) * TILE_COUNT_Y + y) * TILE_COUNT_X + x;
+        }
+
+        [[nodiscard]] unsigned int _get_slice(float depth) const
+        {
+            float slice = std::floor(std::log(std::max(depth, _near_plane)) * _depth_scale + _depth_bias);
+
+            return static_cast<unsigned int>(std::clamp(slice, 0.0f, static_cast<float>(SLICE_COUNT - 1)));
+        }
+
+        [[nodiscard]] float _get_slice_depth(unsigned int slice) const
+        {
+            return _near_plane * std::pow(_far_plane / _near_plane, static_cast<float>(slice) / static_cast<float>(SLICE_COUNT));
+        }
+
+        // The view-space boxes around the clusters. The corners of a tile are unprojected to lines, which
+        // works for both perspective and orthographic projections.
+        void _update_cluster_bounds(const glm::mat4 &projection_matrix, float near_plane, float far_plane)
+        {
+            _projection_matrix = projection_matrix;
+            _near_plane = std::max(near_plane, 1.0e-4f);
+            _far_plane = std::max(far_plane, _near_plane * 1.001f);
+            _depth_scale = static_cast<float>(SLICE_COUNT) / std::log(_far_plane / _near_plane);
+            _depth_bias = -std::log(_near_plane) * _depth_scale;
+
+            glm::mat4 inverse_projection_matrix = glm::inverse(projection_matrix);
+            auto unproject = [&](float x, float y, float z) {
+                glm::vec4 position = inverse_projection_matrix * glm::vec4{x, y, z, 1.0f};
+                return glm::vec3{position} / position.w;
+            };
+
+            _cluster_bounds.resize(CLUSTER_COUNT);
+            for (unsigned int y = 0; y < TILE_COUNT_Y; ++y)
+            {
+                for (unsigned int x = 0; x < TILE_COUNT_X; ++x)
+                {
+                    std::array<glm::vec3, 4> near_corners;
+                    std::array<glm::vec3, 4> far_corners;
+                    for (unsigned int corner = 0; corner < 4; ++corner)
+                    {
+                        float ndc_x = -1.0f + 2.0f * static_cast<float>(x + (corner & 1u)) / static_cast<float>(TILE_COUNT_X);
+                        float ndc_y = -1.0f + 2.0f * static_cast<float>(y + (corner >> 1u)) / static_cast<float>(TILE_COUNT_Y);
+                        near_corners[corner] = unproject(ndc_x, ndc_y, -1.0f);
+                        far_corners[corner] = unproject(ndc_x, ndc_y, 1.0f);
+                    }
+
+                    for (unsigned int slice = 0; slice < SLICE_COUNT; ++slice)
+                    {
+                        ClusterBounds bounds{glm::vec3{INFINITY}, glm::vec3{-INFINITY}};
+                        for (float depth : {_get_slice_depth(slice), _get_slice_depth(slice + 1)})
+                        {
+                            for (unsigned int corner = 0; corner < 4; ++corner)
+                            {
+                                glm::vec3 direction = far_corners[corner] - near_corners[corner];
+                                float t = direction.z != 0.0f ? (-depth - near_corners[corner].z) / direction.z : 0.0f;
+                                glm::vec3 position = near_corners[corner] + t * direction;
+                                bounds.minimum = glm::min(bounds.minimum, position);
+                                bounds.maximum = glm::max(bounds.maximum, position);
+                            }
+                        }
+                        _cluster_bounds[_get_cluster_index(x, y, slice)] = bounds;
+                    }
+                }
+            }
+        }
+
+        void _add_lights(const LightArrays &lights, size_t first_light, bool spot)
+        {
+            for (size_t i = 0; i < lights.size(); ++i)
+            {
+                size_t light = first_light + i;
+                glm::vec4 *texels = _light_data_texels.data() + light * LIGHT_DATA_TEXTURE_WIDTH;
+                texels[0] = glm::vec4{lights.view_positions[i], spot ? 1.0f : 0.0f};
+                texels[1] = glm::vec4{lights.view_directions[i], lights.cutoff_angle_cosines[i]};
+                texels[2] = glm::vec4{lights.ambient_colors[i], lights.intensities[i]};
+                texels[3] = glm::vec4{lights.diffuse_colors[i], lights.exponents[i]};
+                texels[4] = glm::vec4{lights.specular_colors[i], static_cast<float>(lights.two_sided[i])};
+                texels[5] = glm::vec4{lights.constant_attenuations[i], lights.linear_attenuations[i], lights.quadratic_attenuations[i], 0.0f};
+
+                if (lights.enabled[i] != 0)
+                {
+                    _add_light(static_cast<uint32_t>(light), lights.view_positions[i], lights.influence_radii[i]);
+                }
+            }
+        }
+
+        void _add_light(uint32_t light, const glm::vec3 &center, float radius)
+        {
+            float minimum_depth = -center.z - radius;
+            float maximum_depth = -center.z + radius;
+            if (maximum_depth < _near_plane || minimum_depth > _far_plane)
+            {
+                return;
+            }
+
+            unsigned int first_x{0};
+            unsigned int last_x{TILE_COUNT_X - 1};
+            unsigned int first_y{0};
+            unsigned int last_y{TILE_COUNT_Y - 1};
+            if (minimum_depth > _near_plane)
+            {
+                // The projected corners of the box around the light bound its projection while it is in front
+                // of the near plane.
+                glm::vec2 minimum{INFINITY};
+                glm::vec2 maximum{-INFINITY};
+                for (unsigned int corner = 0; corner < 8; ++corner)
+                {
+                    glm::vec3 position{
+                        center.x + ((corner & 1u) != 0 ? radius : -radius),
+                        center.y + ((corner & 2u) != 0 ? radius : -radius),
+                        center.z + ((corner & 4u) != 0 ? radius : -radius)};
+                    glm::vec4 clip_position = _projection_matrix * glm::vec4{position, 1.0f};
+                    glm::vec2 ndc_position = glm::vec2{clip_position} / clip_position.w;
+                    minimum = glm::min(minimum, ndc_position);
+                    maximum = glm::max(maximum, ndc_position);
+                }
+                if (maximum.x < -1.0f || maximum.y < -1.0f || minimum.x > 1.0f || minimum.y > 1.0f)
+                {
+                    return;
+                }
+
+                first_x = _get_tile(minimum.x, TILE_COUNT_X);
+                last_x = _get_tile(maximum.x, TILE_COUNT_X);
+                first_y = _get_tile(minimum.y, TILE_COUNT_Y);
+                last_y = _get_tile(maximum.y, TILE_COUNT_Y);
+            }
+
+            unsigned int first_slice = _get_slice(minimum_depth);
+            unsigned int last_slice = _get_slice(maximum_depth);
+            float squared_radius = radius * radius;
+            for (unsigned int slice = first_slice; slice <= last_slice; ++slice)
+            {
+                for (unsigned int y = first_y; y <= last_y; ++y)
+                {
+                    for (unsigned int x = first_x; x <= last_x; ++x)
+                    {
+                        auto cluster = static_cast<uint32_t>(_get_cluster_index(x, y, slice));
+                        const ClusterBounds &bounds = _cluster_bounds[cluster];
+                        glm::vec3 offset = glm::clamp(center, bounds.minimum, bounds.maximum) - center;
+                        if (glm::dot(offset, offset) > squared_radius || _cluster_light_counts[cluster] >= MAX_LIGHTS_PER_CLUSTER)
+                        {
+                            continue;
+                        }
+
+                        ++_cluster_light_counts[cluster];
+                        _light_assignments.emplace_back(cluster, light);
+                    }
+                }
+            }
+        }
+
+        static unsigned int _get_tile(float ndc_position, unsigned int tile_count)
+        {
+            float tile = std::floor((ndc_position * 0.5f + 0.5f) * static_cast<float>(tile_count));
+
+            return static_cast<unsigned int>(std::clamp(tile, 0.0f, static_cast<float>(tile_count - 1)));
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef LIGHT_SELECTION_H
+#define LIGHT_SELECTION_H
+
+#include "math/aabb.h"
+#include "renderer/light_arrays.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // The point and spot lights picked for a single mesh, as indices into the light arrays of the frame. A
+    // default constructed selection stands for all lights.
+    struct LightSelection
+    {
+        inline static const size_t MAX_LIGHT_COUNT = 16;
+
+        bool selected{false};
+        const uint32_t *point_light_indices{nullptr};
+        uint32_t point_light_count{0};
+        const uint32_t *spot_light_indices{nullptr};
+        uint32_t spot_light_count{0};
+    };
+
+    // Picks up to max_light_count point and spot lights whose influence spheres reach the bounds, preferring
+    // the ones that are estimated to be the brightest at the nearest point of the box. The indices are written
+    // to light_indices, the point lights first, both in ascending order, so that meshes lit by the same lights
+    // end up with equal selections.
+    inline LightSelection select_lights(const AABB &bounds, const LightArrays &point_lights, const LightArrays &spot_lights,
+                                        size_t max_light_count, uint32_t *light_indices)
+    {
+        struct Candidate
+        {
+            float relevance;
+            uint32_t light;
+            bool spot;
+        };
+
+        max_light_count = std::min(max_light_count, LightSelection::MAX_LIGHT_COUNT);
+        std::array<Candidate, LightSelection::MAX_LIGHT_COUNT> candidates{};
+        size_t candidate_count{0};
+
+        auto consider = [&](const LightArrays &lights, bool spot) {
+            for (size_t i = 0; i < lights.size(); ++i)
+            {
+                float radius = lights.influence_radii[i];
+                if (lights.enabled[i] == 0 || radius <= 0.0f)
+                {
+                    continue;
+                }
+
+                const glm::vec3 &center = lights.world_positions[i];
+                glm::vec3 offset = glm::clamp(center, bounds.get_minimum(), bounds.get_maximum()) - center;
+                float squared_distance = glm::dot(offset, offset);
+                if (squared_distance > radius * radius)
+                {
+                    continue;
+                }
+
+                float distance = std::sqrt(squared_distance);
+                float relevance = lights.intensities[i] /
+                                  (lights.constant_attenuations[i] +
+                                   lights.linear_attenuations[i] * distance +
+                                   lights.quadratic_attenuations[i] * squared_distance);
+
+                // The candidates are kept sorted by descending relevance, so the least relevant one is dropped.
+                size_t position = candidate_count;
+                while (position > 0 && candidates[position - 1].relevance < relevance)
+                {
+                    --position;
+                }
+                if (position >= max_light_count)
+                {
+                    continue;
+                }
+
+                size_t last = std::min(candidate_count, max_light_count - 1);
+                for (size_t j = last; j > position; --j)
+                {
+                    candidates[j] = candidates[j - 1];
+                }
+                candidates[position] = Candidate{relevance, static_cast<uint32_t>(i), spot};
+                candidate_count = std::min(candidate_count + 1, max_light_count);
+            }
+        };
+        consider(point_lights, false);
+        consider(spot_lights, true);
+
+        LightSelection light_selection;
+        light_selection.selected = true;
+        light_selection.point_light_indices = light_indices;
+        for (size_t i = 0; i < candidate_count; ++i)
+        {
+            if (!candidates[i].spot)
+            {
+                light_indices[light_selection.point_light_count++] = candidates[i].light;
+            }
+        }
+        std::sort(light_indices, light_indices + light_selection.point_light_count);
+
+        uint32_t *spot_light_indices = light_indices + light_selection.point_light_count;
+        light_selection.spot_light_indices = spot_light_indices;
+        for (size_t i = 0; i < candidate_count; ++i)
+        {
+            if (candidates[i].spot)
+            {
+                spot_light_indices[light_selection.spot_light_count++] = candidates[i].light;
+            }
+        }
+        std::sort(spot_light_indices, spot_light_indices + light_selection.spot_light_count);
+
+        return light_selection;
+    }
+}
+
+#endif
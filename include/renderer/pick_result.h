@@ -0,0 +1,23 @@
+#ifndef PICK_RESULT_H
+#define PICK_RESULT_H
+
+#include "objects/mesh.h"
+
+#include <memory>
+#include <cstddef>
+
+namespace asr
+{
+    // The mesh under a pixel that was picked, or none when only the background was hit or the mesh was
+    // destroyed before the pick was read back. The instance is the index of the hit transform of an instanced
+    // mesh and zero for other meshes.
+    struct PickResult
+    {
+        std::shared_ptr<Mesh> mesh;
+        size_t instance{0};
+        int x{0};
+        int y{0};
+    };
+}
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef RENDER_COMMAND_BUFFER_H
+#define RENDER_COMMAND_BUFFER_H
+
+#include "objects/mesh.h"
+#include "objects/instanced_mesh.h"
+#include "geometries/geometry.h"
+#include "math/aabb.h"
+#include "materials/material.h"
+#include "renderer/frame_constants.h"
+#include "renderer/render_target.h"
+#include "renderer/render_stats.h"
+#include "renderer/light_selection.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // The draws of one frame, recorded by the renderer frontend and replayed by the backend. World matrices,
+    // bounds, light selections and frame constants are copied. Materials, geometries and instanced meshes are
+    // referenced, and their parameters, vertices and instances are read and uploaded when the buffer is
+    // submitted, so the scene must not change between recording and submitting a frame, and both happen on
+    // the GL context thread. The mesh only identifies the draw across frames and is not accessed by the backend.
+    class RenderCommandBuffer
+    {
+    public:
+        struct Command
+        {
+            Material *material;
+            Geometry *geometry;
+            InstancedMesh *instanced_mesh;
+            const Mesh *mesh;
+            uint64_t sort_key;
+            uint32_t world_matrix_offset;
+            // The vertices of geometries without indices are drawn in order.
+            bool indexed;
+            uint32_t index_count;
+            bool lights_selected;
+            uint32_t light_index_offset;
+            uint32_t point_light_count;
+            uint32_t spot_light_count;
+        };
+
+        // A shadow map to draw again before the frame, with the casters from its first one on.
+        struct ShadowMapUpdate
+        {
+            uint32_t shadow_map;
+            glm::mat4 view_projection_matrix;
+            uint32_t first_caster;
+            uint32_t caster_count;
+        };
+
+        [[nodiscard]] const std::vector<Command> &get_commands() const
+        {
+            return _commands;
+        }
+
+        [[nodiscard]] const std::vector<ShadowMapUpdate> &get_shadow_map_updates() const
+        {
+            return _shadow_map_updates;
+        }
+
+        [[nodiscard]] const std::vector<Command> &get_shadow_casters() const
+        {
+            return _shadow_casters;
+        }
+
+        [[nodiscard]] const glm::mat4 &get_world_matrix(const Command &command) const
+        {
+            return _world_matrices[command.world_matrix_offset];
+        }
+
+        [[nodiscard]] const AABB &get_world_bounding_box(const Command &command) const
+        {
+            return _world_bounding_boxes[command.world_matrix_offset];
+        }
+
+        // The selection points into the buffer, so it stays valid until the buffer is cleared.
+        [[nodiscard]] LightSelection get_light_selection(const Command &command) const
+        {
+            LightSelection light_selection;
+            if (command.lights_selected)
+            {
+                const uint32_t *light_indices = _light_indices.data() + command.light_index_offset;
+                light_selection.selected = true;
+                light_selection.point_light_indices = light_indices;
+                light_selection.point_light_count = command.point_light_count;
+                light_selection.spot_light_indices = light_indices + command.point_light_count;
+                light_selection.spot_light_count = command.spot_light_count;
+            }
+
+            return light_selection;
+        }
+
+        [[nodiscard]] const FrameConstants &get_frame_constants() const
+        {
+            return _frame_constants;
+        }
+
+        void set_frame_constants(const FrameConstants &frame_constants)
+        {
+            _frame_constants = frame_constants;
+        }
+
+        [[nodiscard]] unsigned int get_viewport_width() const
+        {
+            return _viewport_width;
+        }
+
+        [[nodiscard]] unsigned int get_viewport_height() const
+        {
+            return _viewport_height;
+        }
+
+        void set_viewport_size(unsigned int viewport_width, unsigned int viewport_height)
+        {
+            _viewport_width = viewport_width;
+            _viewport_height = viewport_height;
+        }
+
+        // The meshes are drawn at this part of the viewport size and scaled up before the overlays.
+        [[nodiscard]] float get_resolution_scale() const
+        {
+            return _resolution_scale;
+        }
+
+        void set_resolution_scale(float resolution_scale)
+        {
+            _resolution_scale = resolution_scale;
+        }
+
+        // A pick of the mesh under a window pixel, counted from the top left, to draw along with the frame.
+        [[nodiscard]] bool is_pick_requested() const
+        {
+            return _pick_requested;
+        }
+
+        [[nodiscard]] int get_pick_x() const
+        {
+            return _pick_x;
+        }
+
+        [[nodiscard]] int get_pick_y() const
+        {
+            return _pick_y;
+        }
+
+        [[nodiscard]] unsigned int get_pick_region_size() const
+        {
+            return _pick_region_size;
+        }
+
+        void set_pick(int x, int y, unsigned int region_size)
+        {
+            _pick_requested = true;
+            _pick_x = x;
+            _pick_y = y;
+            _pick_region_size = region_size;
+        }
+
+        // Null when the frame is drawn into the window.
+        [[nodiscard]] const std::shared_ptr<RenderTarget> &get_render_target() const
+        {
+            return _render_target;
+        }
+
+        void set_render_target(std::shared_ptr<RenderTarget> render_target)
+        {
+            _render_target = std::move(render_target);
+        }
+
+        // The counters filled in by the frontend, so that they reach the backend together with the draws.
+        [[nodiscard]] const RenderStats &get_stats() const
+        {
+            return _stats;
+        }
+
+        void set_stats(const RenderStats &stats)
+        {
+            _stats = stats;
+        }
+
+        void reserve(size_t command_count)
+        {
+            _commands.reserve(command_count);
+            _world_matrices.reserve(command_count);
+            _world_bounding_boxes.reserve(command_count);
+        }
+
+        void add(Mesh &mesh, uint64_t sort_key, const LightSelection &light_selection = LightSelection{})
+        {
+            _commands.push_back(_create_command(mesh, sort_key, light_selection));
+            _world_matrices.push_back(mesh.get_world_matrix());
+            _world_bounding_boxes.push_back(mesh.get_world_bounding_box());
+            _light_indices.insert(_light_indices.end(), light_selection.point_light_indices,
+                                  light_selection.point_light_indices + light_selection.point_light_count);
+            _light_indices.insert(_light_indices.end(), light_selection.spot_light_indices,
+                                  light_selection.spot_light_indices + light_selection.spot_light_count);
+        }
+
+        void add_shadow_map_update(uint32_t shadow_map, const glm::mat4 &view_projection_matrix)
+        {
+            _shadow_map_updates.push_back(ShadowMapUpdate{
+                shadow_map, view_projection_matrix, static_cast<uint32_t>(_shadow_casters.size()), 0});
+        }
+
+        // Adds a caster to the last shadow map update.
+        void add_shadow_caster(Mesh &mesh)
+        {
+            _shadow_casters.push_back(_create_command(mesh, 0, LightSelection{}));
+            _world_matrices.push_back(mesh.get_world_matrix());
+            _world_bounding_boxes.push_back(mesh.get_world_bounding_box());
+            ++_shadow_map_updates.back().caster_count;
+        }
+
+        void clear()
+        {
+            _commands.clear();
+            _world_matrices.clear();
+            _world_bounding_boxes.clear();
+            _light_indices.clear();
+            _shadow_map_updates.clear();
+            _shadow_casters.clear();
+            _pick_requested = false;
+        }
+
+    private:
+        std::vector<Command> _commands;
+        std::vector<glm::mat4> _world_matrices;
+        std::vector<AABB> _world_bounding_boxes;
+        std::vector<uint32_t> _light_indices;
+        std::vector<ShadowMapUpdate> _shadow_map_updates;
+        std::vector<Command> _shadow_casters;
+        FrameConstants _frame_constants;
+        RenderStats _stats;
+
+        unsigned int _viewport_width{0};
+        unsigned int _viewport_height{0};
+        float _resolution_scale{1.0f};
+        bool _pick_requested{false};
+        int _pick_x{0};
+        int _pick_y{0};
+        unsigned int _pick_region_size{1};
+        std::shared_ptr<RenderTarget> _render_target;
+
+        Command _create_command(Mesh &mesh, uint64_t sort_key, const LightSelection &light_selection) const
+        {
+            const auto &geometry = mesh.get_geometry();
+            return Command{
+                mesh.get_material().get(),
+                geometry.get(),
+                mesh.as_instanced_mesh(),
+                &mesh,
+                sort_key,
+                static_cast<uint32_t>(_world_matrices.size()),
+                geometry->get_index_count() > 0,
+                static_cast<uint32_t>(geometry->get_index_count() > 0 ? geometry->get_index_count() : geometry->get_vertex_count()),
+                light_selection.selected,
+                static_cast<uint32_t>(_light_indices.size()),
+                light_selection.point_light_count,
+                light_selection.spot_light_count};
+        }
+    };
+}
+
+#endif
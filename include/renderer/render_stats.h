@@ -0,0 +1,43 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <cstddef>
+
+namespace asr
+{
+    // Counters of a single frame. The frontend fills in the mesh counts while recording, the backend the GL
+    // work that was issued while submitting, and the meshes it skipped as occluded.
+    struct RenderStats
+    {
+        size_t visited_mesh_count{0};
+        size_t culled_mesh_count{0};
+        size_t occluded_mesh_count{0};
+        size_t drawn_mesh_count{0};
+
+        size_t draw_call_count{0};
+        size_t triangle_count{0};
+        size_t occlusion_query_count{0};
+        // Shadow maps drawn again this frame and the caster draws they took, which the draw calls include.
+        size_t shadow_map_update_count{0};
+        size_t shadow_caster_count{0};
+
+        size_t state_change_count{0};
+        size_t program_bind_count{0};
+        size_t texture_bind_count{0};
+
+        size_t uploaded_buffer_bytes{0};
+        size_t uploaded_texture_bytes{0};
+        size_t shader_compile_count{0};
+
+        // Milliseconds. The GPU time belongs to a frame submitted a few frames earlier and stays zero when
+        // GPU timing is disabled or unsupported.
+        float cpu_record_time{0.0f};
+        float cpu_submit_time{0.0f};
+        float gpu_frame_time{0.0f};
+
+        // The part of the output width and height the meshes were drawn at.
+        float resolution_scale{1.0f};
+    };
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+namespace asr
+{
+    // An offscreen surface the renderer draws into instead of the window. Its size replaces the one of the
+    // window for the viewport and the aspect ratio of the camera.
+    class RenderTarget
+    {
+    public:
+        RenderTarget(unsigned int width, unsigned int height)
+            : _width{width}, _height{height}
+        {
+        }
+
+        virtual ~RenderTarget() = default;
+
+        [[nodiscard]] unsigned int get_width() const
+        {
+            return _width;
+        }
+
+        [[nodiscard]] unsigned int get_height() const
+        {
+            return _height;
+        }
+
+        void set_size(unsigned int width, unsigned int height)
+        {
+            if (_width != width || _height != height)
+            {
+                _width = width;
+                _height = height;
+                _requires_update = true;
+            }
+        }
+
+        virtual void use() = 0;
+
+    protected:
+        unsigned int _width;
+        unsigned int _height;
+
+        bool _requires_update{true};
+    };
+}
+
+#endif
@@ -1,10 +1,19 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <utility>
+#include <cstddef>
 
 #include "scene/scene.h"
 #include "window/window.h"
+#include "renderer/render_target.h"
+#include "renderer/render_stats.h"
+#include "renderer/pick_result.h"
+#include "renderer/light_selection.h"
+#include "utilities/allocation_counter.h"
 
 namespace asr
 {
@@ -18,11 +27,336 @@ namespace asr
 
         virtual ~Renderer() = default;
 
+        [[nodiscard]] bool is_frustum_culling_enabled() const
+        {
+            return _frustum_culling_enabled;
+        }
+
+        void set_frustum_culling_enabled(bool frustum_culling_enabled)
+        {
+            _frustum_culling_enabled = frustum_culling_enabled;
+        }
+
+        [[nodiscard]] bool is_parallel_update_enabled() const
+        {
+            return _parallel_update_enabled;
+        }
+
+        void set_parallel_update_enabled(bool parallel_update_enabled)
+        {
+            _parallel_update_enabled = parallel_update_enabled;
+        }
+
+        // Point and spot lights are binned into view frustum clusters, so that each fragment only evaluates
+        // the lights that can reach it. Only takes effect where the backend supports it.
+        [[nodiscard]] bool is_clustered_lighting_enabled() const
+        {
+            return _clustered_lighting_enabled;
+        }
+
+        void set_clustered_lighting_enabled(bool clustered_lighting_enabled)
+        {
+            _clustered_lighting_enabled = clustered_lighting_enabled;
+        }
+
+        // Each mesh is only lit by the point and spot lights whose influence radius reaches its bounds, at most
+        // get_max_lights_per_mesh() of them. Clustered lighting takes precedence where it is supported.
+        [[nodiscard]] bool is_light_culling_enabled() const
+        {
+            return _light_culling_enabled;
+        }
+
+        void set_light_culling_enabled(bool light_culling_enabled)
+        {
+            _light_culling_enabled = light_culling_enabled;
+        }
+
+        [[nodiscard]] size_t get_max_lights_per_mesh() const
+        {
+            return _max_lights_per_mesh;
+        }
+
+        void set_max_lights_per_mesh(size_t max_lights_per_mesh)
+        {
+            _max_lights_per_mesh = std::min(max_lights_per_mesh, LightSelection::MAX_LIGHT_COUNT);
+        }
+
+        // Opaque meshes are written to the depth buffer with a minimal shader first and then shaded with an equal
+        // depth test, so hidden fragments skip the material shaders.
+        [[nodiscard]] bool is_depth_pre_pass_enabled() const
+        {
+            return _depth_pre_pass_enabled;
+        }
+
+        void set_depth_pre_pass_enabled(bool depth_pre_pass_enabled)
+        {
+            _depth_pre_pass_enabled = depth_pre_pass_enabled;
+        }
+
+        // Sorts the opaque meshes that share a shader, render state and texture from front to back instead of
+        // by geometry.
+        [[nodiscard]] bool is_front_to_back_sorting_enabled() const
+        {
+            return _front_to_back_sorting_enabled;
+        }
+
+        void set_front_to_back_sorting_enabled(bool front_to_back_sorting_enabled)
+        {
+            _front_to_back_sorting_enabled = front_to_back_sorting_enabled;
+        }
+
+        // Selects the level of every visible LODMesh from its size on the screen. When disabled, the meshes
+        // keep the levels they have.
+        [[nodiscard]] bool is_level_of_detail_selection_enabled() const
+        {
+            return _level_of_detail_selection_enabled;
+        }
+
+        void set_level_of_detail_selection_enabled(bool level_of_detail_selection_enabled)
+        {
+            _level_of_detail_selection_enabled = level_of_detail_selection_enabled;
+        }
+
+        // Opaque meshes with at least get_minimum_occludee_triangle_count() triangles are skipped while the
+        // occlusion queries of the previous frames found them hidden behind other meshes. The queries lag a
+        // frame behind, so a mesh that comes out behind an occluder appears one frame late. Only takes effect
+        // where the backend supports occlusion queries.
+        [[nodiscard]] bool is_occlusion_culling_enabled() const
+        {
+            return _occlusion_culling_enabled;
+        }
+
+        void set_occlusion_culling_enabled(bool occlusion_culling_enabled)
+        {
+            _occlusion_culling_enabled = occlusion_culling_enabled;
+        }
+
+        [[nodiscard]] size_t get_minimum_occludee_triangle_count() const
+        {
+            return _minimum_occludee_triangle_count;
+        }
+
+        void set_minimum_occludee_triangle_count(size_t minimum_occludee_triangle_count)
+        {
+            _minimum_occludee_triangle_count = minimum_occludee_triangle_count;
+        }
+
+        // Directional and spot lights that cast shadows get shadow maps, which are kept between frames and only
+        // drawn again when their light or a caster inside it moved. Only takes effect where the backend supports
+        // it.
+        [[nodiscard]] bool is_shadow_mapping_enabled() const
+        {
+            return _shadow_mapping_enabled;
+        }
+
+        void set_shadow_mapping_enabled(bool shadow_mapping_enabled)
+        {
+            _shadow_mapping_enabled = shadow_mapping_enabled;
+        }
+
+        // The width and height of every shadow map in pixels. Changing it draws all maps again.
+        [[nodiscard]] unsigned int get_shadow_map_size() const
+        {
+            return _shadow_map_size;
+        }
+
+        void set_shadow_map_size(unsigned int shadow_map_size)
+        {
+            _shadow_map_size = std::max(shadow_map_size, 1u);
+        }
+
+        // The most shadow maps drawn in a frame. Outdated maps over the budget wait for the next frames and are
+        // sampled as they were drawn until then.
+        [[nodiscard]] size_t get_shadow_map_update_budget() const
+        {
+            return _shadow_map_update_budget;
+        }
+
+        void set_shadow_map_update_budget(size_t shadow_map_update_budget)
+        {
+            _shadow_map_update_budget = shadow_map_update_budget;
+        }
+
+        // Frames are drawn into the render target instead of the window, which is not swapped then. Null draws
+        // into the window again.
+        [[nodiscard]] const std::shared_ptr<RenderTarget> &get_render_target() const
+        {
+            return _render_target;
+        }
+
+        void set_render_target(std::shared_ptr<RenderTarget> render_target)
+        {
+            _render_target = std::move(render_target);
+        }
+
+        // Counters of the last submitted frame.
+        [[nodiscard]] const RenderStats &get_stats() const
+        {
+            return _stats;
+        }
+
+        [[nodiscard]] bool is_stats_overlay_enabled() const
+        {
+            return _stats_overlay_enabled;
+        }
+
+        void set_stats_overlay_enabled(bool stats_overlay_enabled)
+        {
+            _stats_overlay_enabled = stats_overlay_enabled;
+        }
+
+        [[nodiscard]] bool is_gpu_timing_enabled() const
+        {
+            return _gpu_timing_enabled;
+        }
+
+        void set_gpu_timing_enabled(bool gpu_timing_enabled)
+        {
+            _gpu_timing_enabled = gpu_timing_enabled;
+        }
+
+        // Draws the meshes at a part of the output size that follows the frame time and stretches them over the
+        // output before the overlay meshes are drawn. The GPU time is measured where timer queries exist,
+        // otherwise the time between submitted frames, which vsync keeps from dropping below the refresh
+        // interval, so the resolution only recovers from a slow frame with timer queries.
+        [[nodiscard]] bool is_dynamic_resolution_enabled() const
+        {
+            return _dynamic_resolution_enabled;
+        }
+
+        void set_dynamic_resolution_enabled(bool dynamic_resolution_enabled)
+        {
+            _dynamic_resolution_enabled = dynamic_resolution_enabled;
+            _resolution_scale = 1.0f;
+        }
+
+        // Milliseconds.
+        [[nodiscard]] float get_target_frame_time() const
+        {
+            return _target_frame_time;
+        }
+
+        void set_target_frame_time(float target_frame_time)
+        {
+            _target_frame_time = target_frame_time;
+        }
+
+        [[nodiscard]] float get_minimum_resolution_scale() const
+        {
+            return _minimum_resolution_scale;
+        }
+
+        void set_minimum_resolution_scale(float minimum_resolution_scale)
+        {
+            _minimum_resolution_scale = minimum_resolution_scale;
+        }
+
+        [[nodiscard]] float get_resolution_scale() const
+        {
+            return _resolution_scale;
+        }
+
+        // Heap allocations made by the last render() call. Only counted in debug builds that provide the
+        // allocation counter implementation.
+        [[nodiscard]] size_t get_frame_allocation_count() const
+        {
+            return _frame_allocation_count;
+        }
+
+        // Finds the mesh under a pixel, counted from the top left like the mouse coordinates of the window, in
+        // the next frame that is submitted. The result is passed to the pick callback one frame later, once
+        // the GPU has drawn it, so the pick does not stall the frame. Only the latest request of a frame is
+        // taken.
+        void request_pick(int x, int y)
+        {
+            _pick_requested = true;
+            _pick_x = x;
+            _pick_y = y;
+        }
+
+        [[nodiscard]] const std::function<void(const PickResult &)> &get_on_pick() const
+        {
+            return _on_pick;
+        }
+
+        void set_on_pick(const std::function<void(const PickResult &)> &on_pick)
+        {
+            _on_pick = on_pick;
+        }
+
+        // The side in pixels of the square around the picked pixel that is searched for the nearest mesh, so
+        // that thin lines and small points can be hit. Even sizes are rounded up.
+        [[nodiscard]] unsigned int get_pick_region_size() const
+        {
+            return _pick_region_size;
+        }
+
+        void set_pick_region_size(unsigned int pick_region_size)
+        {
+            _pick_region_size = std::max(pick_region_size, 1u) | 1u;
+        }
+
+        // Builds the command buffer of the next frame from the scene.
+        virtual void record() = 0;
+
+        // Draws the last recorded frame on the thread of the GL context. The commands refer to the materials,
+        // geometries and instanced meshes of the scene, which are read and uploaded here, so submit() has to
+        // follow record() before the scene changes.
+        virtual void submit() = 0;
+
         virtual void render() = 0;
 
     protected:
+        inline static const float RESOLUTION_SCALE_HEADROOM = 0.15f;
+        inline static const float RESOLUTION_SCALE_RESPONSE = 0.1f;
+
         std::shared_ptr<Scene> scene;
         std::shared_ptr<Window> window;
+        std::shared_ptr<RenderTarget> _render_target;
+
+        bool _frustum_culling_enabled{true};
+        bool _parallel_update_enabled{true};
+        bool _clustered_lighting_enabled{false};
+        bool _light_culling_enabled{false};
+        size_t _max_lights_per_mesh{8};
+        bool _depth_pre_pass_enabled{false};
+        bool _front_to_back_sorting_enabled{false};
+        bool _level_of_detail_selection_enabled{true};
+        bool _occlusion_culling_enabled{false};
+        size_t _minimum_occludee_triangle_count{256};
+        bool _shadow_mapping_enabled{false};
+        unsigned int _shadow_map_size{1024};
+        size_t _shadow_map_update_budget{2};
+        size_t _frame_allocation_count{0};
+        RenderStats _stats;
+        bool _stats_overlay_enabled{false};
+        bool _gpu_timing_enabled{false};
+        bool _dynamic_resolution_enabled{false};
+        float _target_frame_time{1000.0f / 60.0f};
+        float _minimum_resolution_scale{0.5f};
+        float _resolution_scale{1.0f};
+        bool _pick_requested{false};
+        int _pick_x{0};
+        int _pick_y{0};
+        unsigned int _pick_region_size{5};
+        std::function<void(const PickResult &)> _on_pick;
+
+        // The pixel count, and with it the fragment work, follows the square of the scale. The scale moves a
+        // part of the way towards the one that meets the target, so that the frames the GPU timer lags behind
+        // do not make it oscillate, and it is only raised while the frame time stays below the target by the
+        // headroom. It starts from the scale of the submitted frame, which the frame time was measured with.
+        void _update_resolution_scale(float resolution_scale, float frame_time)
+        {
+            if (!_dynamic_resolution_enabled || frame_time <= 0.0f ||
+                (frame_time <= _target_frame_time && frame_time >= _target_frame_time * (1.0f - RESOLUTION_SCALE_HEADROOM)))
+            {
+                return;
+            }
+
+            float scale = resolution_scale * std::sqrt(_target_frame_time / frame_time);
+            resolution_scale += (scale - resolution_scale) * RESOLUTION_SCALE_RESPONSE;
+            _resolution_scale = std::clamp(resolution_scale, _minimum_resolution_scale, 1.0f);
+        }
     };
 }
 
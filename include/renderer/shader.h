@@ -1,10 +1,15 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include "renderer/light_selection.h"
+
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <utility>
 #include <map>
+#include <cstddef>
 
 namespace asr
 {
@@ -16,7 +21,11 @@ namespace asr
             std::string fragment_shader_source,
             const std::vector<std::string> &attributes = {},
             const std::vector<std::string> &uniforms = {}) : _vertex_shader_source{std::move(vertex_shader_source)},
-                                                             _fragment_shader_source{std::move(fragment_shader_source)}
+                                                             _fragment_shader_source{std::move(fragment_shader_source)},
+                                                             _attribute_names{attributes},
+                                                             _uniform_names{uniforms},
+                                                             _attribute_locations(attributes.size(), -1),
+                                                             _uniform_locations(uniforms.size(), -1)
         {
             for (const auto &uniform : uniforms)
             {
@@ -70,6 +79,63 @@ namespace asr
             return _uniforms;
         }
 
+        [[nodiscard]] int get_attribute_location(size_t slot) const
+        {
+            return _attribute_locations[slot];
+        }
+
+        [[nodiscard]] int get_uniform_location(size_t slot) const
+        {
+            return _uniform_locations[slot];
+        }
+
+        [[nodiscard]] unsigned int get_uploaded_lights_version() const
+        {
+            return _uploaded_lights_version;
+        }
+
+        void set_uploaded_lights_version(unsigned int uploaded_lights_version)
+        {
+            _uploaded_lights_version = uploaded_lights_version;
+        }
+
+        [[nodiscard]] uint64_t get_uploaded_material_version() const
+        {
+            return _uploaded_material_version;
+        }
+
+        void set_uploaded_material_version(uint64_t uploaded_material_version)
+        {
+            _uploaded_material_version = uploaded_material_version;
+        }
+
+        // Meshes that share the shader often pick the same lights, so their uniforms are only uploaded again
+        // when the selection differs from the last one.
+        [[nodiscard]] bool is_light_selection_uploaded(const LightSelection &light_selection) const
+        {
+            if (light_selection.selected != _uploaded_light_selection ||
+                light_selection.point_light_count != _uploaded_point_light_count ||
+                light_selection.point_light_count + light_selection.spot_light_count != _uploaded_light_indices.size())
+            {
+                return false;
+            }
+
+            return std::equal(light_selection.point_light_indices, light_selection.point_light_indices + light_selection.point_light_count,
+                              _uploaded_light_indices.begin()) &&
+                   std::equal(light_selection.spot_light_indices, light_selection.spot_light_indices + light_selection.spot_light_count,
+                              _uploaded_light_indices.begin() + light_selection.point_light_count);
+        }
+
+        void set_uploaded_light_selection(const LightSelection &light_selection)
+        {
+            _uploaded_light_selection = light_selection.selected;
+            _uploaded_point_light_count = light_selection.point_light_count;
+            _uploaded_light_indices.assign(light_selection.point_light_indices,
+                                           light_selection.point_light_indices + light_selection.point_light_count);
+            _uploaded_light_indices.insert(_uploaded_light_indices.end(), light_selection.spot_light_indices,
+                                           light_selection.spot_light_indices + light_selection.spot_light_count);
+        }
+
         [[nodiscard]] bool is_dead() const
         {
             return _dead;
@@ -80,6 +146,11 @@ namespace asr
             return _program != -1;
         }
 
+        [[nodiscard]] int get_program() const
+        {
+            return _program;
+        }
+
         virtual void compile() = 0;
 
         virtual void cleanup() = 0;
@@ -93,8 +164,19 @@ namespace asr
         std::map<std::string, int> _attributes;
         std::map<std::string, int> _uniforms;
 
+        std::vector<std::string> _attribute_names;
+        std::vector<std::string> _uniform_names;
+        std::vector<int> _attribute_locations;
+        std::vector<int> _uniform_locations;
+
         bool _dead{false};
         int _program{-1};
+
+        unsigned int _uploaded_lights_version{0};
+        uint64_t _uploaded_material_version{0};
+        bool _uploaded_light_selection{false};
+        uint32_t _uploaded_point_light_count{0};
+        std::vector<uint32_t> _uploaded_light_indices;
     };
 }
 
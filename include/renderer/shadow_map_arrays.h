@@ -0,0 +1,106 @@
+#ifndef SHADOW_MAP_ARRAYS_H
+#define SHADOW_MAP_ARRAYS_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace asr
+{
+    // The shadow maps of a frame. They are tiles of one atlas texture, placed in rows by their index, so a
+    // material samples all of them through a single texture unit.
+    struct ShadowMapArrays
+    {
+        inline static const size_t MAX_COUNT = 8;
+        inline static const size_t ATLAS_COLUMN_COUNT = 4;
+        inline static const size_t ATLAS_ROW_COUNT = 2;
+
+        // The width and height of every map in pixels.
+        unsigned int map_size{0};
+        // From world space to the clip space of the light, as the maps were last drawn.
+        std::vector<glm::mat4> view_projection_matrices;
+        // From view space to the texture coordinates and depths in the atlas.
+        std::vector<glm::mat4> texture_matrices;
+        // The texture coordinates a map may be sampled at, as the minimum in xy and the maximum in zw.
+        std::vector<glm::vec4> regions;
+        // A fragment uses the first map of its light it is nearer to the camera than. Maps that were not drawn
+        // yet have a negative far depth.
+        std::vector<float> far_depths;
+        std::vector<float> biases;
+
+        [[nodiscard]] size_t size() const
+        {
+            return view_projection_matrices.size();
+        }
+
+        [[nodiscard]] bool empty() const
+        {
+            return view_projection_matrices.empty();
+        }
+
+        void resize(size_t count)
+        {
+            view_projection_matrices.resize(count);
+            texture_matrices.resize(count);
+            regions.resize(count);
+            far_depths.resize(count);
+            biases.resize(count);
+        }
+
+        [[nodiscard]] unsigned int get_atlas_width() const
+        {
+            return map_size * static_cast<unsigned int>(ATLAS_COLUMN_COUNT);
+        }
+
+        [[nodiscard]] unsigned int get_atlas_height() const
+        {
+            return map_size * static_cast<unsigned int>(ATLAS_ROW_COUNT);
+        }
+
+        // The lower left pixel of a map in the atlas.
+        [[nodiscard]] unsigned int get_map_x(size_t map) const
+        {
+            return map_size * static_cast<unsigned int>(map % ATLAS_COLUMN_COUNT);
+        }
+
+        [[nodiscard]] unsigned int get_map_y(size_t map) const
+        {
+            return map_size * static_cast<unsigned int>(map / ATLAS_COLUMN_COUNT);
+        }
+
+        // Moves clip space coordinates into the tile of a map.
+        [[nodiscard]] static glm::mat4 get_atlas_matrix(size_t map)
+        {
+            auto column = static_cast<float>(map % ATLAS_COLUMN_COUNT);
+            auto row = static_cast<float>(map / ATLAS_COLUMN_COUNT);
+            auto column_count = static_cast<float>(ATLAS_COLUMN_COUNT);
+            auto row_count = static_cast<float>(ATLAS_ROW_COUNT);
+
+            glm::mat4 atlas_matrix{1.0f};
+            atlas_matrix[0][0] = 0.5f / column_count;
+            atlas_matrix[1][1] = 0.5f / row_count;
+            atlas_matrix[2][2] = 0.5f;
+            atlas_matrix[3] = glm::vec4{(column + 0.5f) / column_count, (row + 0.5f) / row_count, 0.5f, 1.0f};
+
+            return atlas_matrix;
+        }
+
+        // Lookups read the four texels around the coordinates, so the region is inset by a texel to keep them
+        // from reading the neighbouring maps.
+        [[nodiscard]] glm::vec4 get_region(size_t map) const
+        {
+            auto column = static_cast<float>(map % ATLAS_COLUMN_COUNT);
+            auto row = static_cast<float>(map / ATLAS_COLUMN_COUNT);
+            auto column_count = static_cast<float>(ATLAS_COLUMN_COUNT);
+            auto row_count = static_cast<float>(ATLAS_ROW_COUNT);
+            float texel_width = 1.0f / static_cast<float>(get_atlas_width());
+            float texel_height = 1.0f / static_cast<float>(get_atlas_height());
+
+            return glm::vec4{column / column_count + texel_width, row / row_count + texel_height,
+                             (column + 1.0f) / column_count - texel_width, (row + 1.0f) / row_count - texel_height};
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,394 @@
+#ifndef SHADOW_MAPS_H
+#define SHADOW_MAPS_H
+
+#include "scene/scene.h"
+#include "objects/camera.h"
+#include "objects/mesh.h"
+#include "lights/light.h"
+#include "lights/directional_light.h"
+#include "lights/spot_light.h"
+#include "geometries/geometry.h"
+#include "math/aabb.h"
+#include "math/frustum.h"
+#include "renderer/frame_constants.h"
+#include "renderer/render_command_buffer.h"
+#include "renderer/shadow_map_arrays.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace asr
+{
+    // Decides which shadow maps the lights get and which of them are drawn again. Directional lights get a
+    // map for every cascade and spot lights a single one, in the order of the lights, until the atlas is full.
+    // A map keeps its contents from frame to frame and is only drawn again when the matrix of its light changed
+    // or an opaque mesh was attached, detached or moved inside the frustum it was drawn with, so static lights
+    // over static meshes are drawn once. At most the update budget of maps is drawn per frame, the ones that
+    // were never drawn and the near cascades first, while the others are sampled with the matrices they were
+    // last drawn with.
+    class ShadowMaps
+    {
+    public:
+        [[nodiscard]] const ShadowMapArrays &get_arrays() const
+        {
+            return _arrays;
+        }
+
+        // The maps the last update decided to draw again.
+        [[nodiscard]] size_t get_update_count() const
+        {
+            return _updated_maps.size();
+        }
+
+        // A map size of zero drops all maps. The lights of the frame constants have to be up to date.
+        void update(Scene &scene, Camera &camera, FrameConstants &frame_constants, unsigned int map_size, size_t update_budget)
+        {
+            ++_frame;
+            _updated_maps.clear();
+            _casters.clear();
+            _caster_ends.clear();
+
+            if (_arrays.map_size != map_size)
+            {
+                _maps.clear();
+                _arrays.map_size = map_size;
+            }
+
+            const auto &directional_lights = scene.get_directional_lights();
+            const auto &spot_lights = scene.get_spot_lights();
+            _directional_light_begins.assign(directional_lights.size(), 0);
+            _directional_light_ends.assign(directional_lights.size(), 0);
+            _spot_light_begins.assign(spot_lights.size(), 0);
+            _spot_light_ends.assign(spot_lights.size(), 0);
+
+            auto &render_list = scene.get_render_list();
+            auto &bounding_volume_hierarchy = render_list.get_bounding_volume_hierarchy();
+            size_t map_count{0};
+            if (map_size > 0)
+            {
+                const glm::mat4 &view_matrix = camera.get_view_matrix();
+                const glm::mat4 &projection_matrix = camera.get_projection_matrix();
+                glm::mat4 inverse_view_projection_matrix = glm::inverse(projection_matrix * view_matrix);
+                AABB scene_bounding_box = bounding_volume_hierarchy.get_bounding_box();
+                Frustum camera_frustum{projection_matrix * view_matrix};
+
+                for (size_t i = 0; i < directional_lights.size() && map_count < ShadowMapArrays::MAX_COUNT; ++i)
+                {
+                    const DirectionalLight &light = *directional_lights[i];
+                    if (!light.is_enabled() || !light.is_casting_shadows())
+                    {
+                        continue;
+                    }
+
+                    size_t cascade_count = std::min(light.get_shadow_cascade_count(), ShadowMapArrays::MAX_COUNT - map_count);
+                    float near_plane = camera.get_near_plane();
+                    float far_plane = std::max(std::min(camera.get_far_plane(), light.get_shadow_distance()), near_plane);
+                    _directional_light_begins[i] = static_cast<int>(map_count);
+                    for (size_t cascade = 0; cascade < cascade_count; ++cascade)
+                    {
+                        float cascade_near_plane = _calculate_cascade_split(near_plane, far_plane, cascade, cascade_count);
+                        float cascade_far_plane = _calculate_cascade_split(near_plane, far_plane, cascade + 1, cascade_count);
+
+                        ShadowMap &map = _acquire_map(map_count++, light, cascade);
+                        map.view_projection_matrix = _calculate_cascade_matrix(
+                            light.get_world_direction(), inverse_view_projection_matrix, projection_matrix,
+                            cascade_near_plane, cascade_far_plane, scene_bounding_box, map_size);
+                        map.far_depth = cascade_far_plane;
+                        map.bias = light.get_shadow_bias();
+                        map.visible = true;
+                    }
+                    _directional_light_ends[i] = static_cast<int>(map_count);
+                }
+
+                const LightArrays &spot_light_arrays = frame_constants.get_spot_lights();
+                for (size_t i = 0; i < spot_lights.size() && map_count < ShadowMapArrays::MAX_COUNT; ++i)
+                {
+                    const SpotLight &light = *spot_lights[i];
+                    float radius = spot_light_arrays.influence_radii[i];
+                    if (!light.is_enabled() || !light.is_casting_shadows() || radius <= 0.0f)
+                    {
+                        continue;
+                    }
+
+                    const glm::vec3 &position = spot_light_arrays.world_positions[i];
+                    _spot_light_begins[i] = static_cast<int>(map_count);
+                    ShadowMap &map = _acquire_map(map_count++, light, 0);
+                    map.view_projection_matrix = _calculate_spot_matrix(position, light.get_world_direction(),
+                                                                        light.get_cutoff_angle(), radius);
+                    map.far_depth = std::numeric_limits<float>::max();
+                    map.bias = light.get_shadow_bias();
+                    map.visible = camera_frustum.intersects(AABB{position - glm::vec3{radius}, position + glm::vec3{radius}});
+                    _spot_light_ends[i] = static_cast<int>(map_count);
+                }
+            }
+            _maps.resize(map_count);
+
+            for (ShadowMap &map : _maps)
+            {
+                if (!map.drawn || map.view_projection_matrix != map.drawn_view_projection_matrix)
+                {
+                    map.outdated = true;
+                }
+            }
+            for (const AABB &box : render_list.get_changed_bounding_boxes())
+            {
+                for (ShadowMap &map : _maps)
+                {
+                    if (!map.outdated && map.drawn_frustum.intersects(box))
+                    {
+                        map.outdated = true;
+                    }
+                }
+            }
+
+            // Maps of spot lights out of view are not drawn until they come into view.
+            _candidate_maps.clear();
+            for (size_t i = 0; i < _maps.size(); ++i)
+            {
+                if (_maps[i].outdated && _maps[i].visible)
+                {
+                    _candidate_maps.push_back(i);
+                }
+            }
+            std::sort(_candidate_maps.begin(), _candidate_maps.end(), [this](size_t a, size_t b) {
+                const ShadowMap &map_a = _maps[a];
+                const ShadowMap &map_b = _maps[b];
+                if (map_a.drawn != map_b.drawn)
+                {
+                    return !map_a.drawn;
+                }
+                if (map_a.cascade != map_b.cascade)
+                {
+                    return map_a.cascade < map_b.cascade;
+                }
+                return map_a.drawn_frame < map_b.drawn_frame;
+            });
+
+            size_t update_count = std::min(update_budget, _candidate_maps.size());
+            for (size_t i = 0; i < update_count; ++i)
+            {
+                size_t index = _candidate_maps[i];
+                ShadowMap &map = _maps[index];
+                map.drawn_view_projection_matrix = map.view_projection_matrix;
+                map.drawn_frustum.update(map.drawn_view_projection_matrix);
+                map.drawn = true;
+                map.outdated = false;
+                map.drawn_frame = _frame;
+
+                _updated_maps.push_back(index);
+                bounding_volume_hierarchy.query(map.drawn_frustum, [&](Mesh *mesh) {
+                    if (_is_caster(*mesh))
+                    {
+                        _casters.push_back(mesh);
+                    }
+                });
+                _caster_ends.push_back(_casters.size());
+            }
+
+            _arrays.resize(_maps.size());
+            for (size_t i = 0; i < _maps.size(); ++i)
+            {
+                const ShadowMap &map = _maps[i];
+                _arrays.view_projection_matrices[i] = map.drawn_view_projection_matrix;
+                _arrays.regions[i] = _arrays.get_region(i);
+                _arrays.far_depths[i] = map.drawn ? map.far_depth : -1.0f;
+                _arrays.biases[i] = map.bias;
+            }
+
+            frame_constants.update_shadow_maps(_arrays, _directional_light_begins, _directional_light_ends,
+                                               _spot_light_begins, _spot_light_ends);
+        }
+
+        // Adds the maps the last update decided to draw again and their casters to the command buffer.
+        void record(RenderCommandBuffer &command_buffer) const
+        {
+            size_t caster_begin{0};
+            for (size_t i = 0; i < _updated_maps.size(); ++i)
+            {
+                size_t index = _updated_maps[i];
+                command_buffer.add_shadow_map_update(static_cast<uint32_t>(index), _maps[index].drawn_view_projection_matrix);
+                for (size_t caster = caster_begin; caster < _caster_ends[i]; ++caster)
+                {
+                    command_buffer.add_shadow_caster(*_casters[caster]);
+                }
+                caster_begin = _caster_ends[i];
+            }
+        }
+
+    private:
+        // Higher weights move the splits between the cascades towards the camera.
+        inline static const float CASCADE_SPLIT_WEIGHT = 0.75f;
+        // The radii of the cascades are rounded up to this step, so that rotating the camera does not change
+        // their matrices through rounding errors alone.
+        inline static const float CASCADE_RADIUS_STEP = 1.0f / 16.0f;
+        inline static const float SPOT_FIELD_OF_VIEW_MARGIN = 1.1f;
+        inline static const float MAX_SPOT_FIELD_OF_VIEW = 3.0f;
+        inline static const float SPOT_NEAR_PLANE_RATIO = 0.01f;
+
+        struct ShadowMap
+        {
+            const Light *light{nullptr};
+            size_t cascade{0};
+
+            glm::mat4 view_projection_matrix{1.0f};
+            float far_depth{0.0f};
+            float bias{0.0f};
+            bool visible{false};
+
+            glm::mat4 drawn_view_projection_matrix{1.0f};
+            Frustum drawn_frustum;
+            bool drawn{false};
+            bool outdated{true};
+            uint64_t drawn_frame{0};
+        };
+
+        std::vector<ShadowMap> _maps;
+        ShadowMapArrays _arrays;
+        uint64_t _frame{0};
+
+        std::vector<int> _directional_light_begins;
+        std::vector<int> _directional_light_ends;
+        std::vector<int> _spot_light_begins;
+        std::vector<int> _spot_light_ends;
+
+        std::vector<size_t> _candidate_maps;
+        std::vector<size_t> _updated_maps;
+        std::vector<Mesh *> _casters;
+        std::vector<size_t> _caster_ends;
+
+        // A map that another light or cascade used before starts over.
+        ShadowMap &_acquire_map(size_t index, const Light &light, size_t cascade)
+        {
+            if (index >= _maps.size())
+            {
+                _maps.emplace_back();
+            }
+
+            ShadowMap &map = _maps[index];
+            if (map.light != &light || map.cascade != cascade)
+            {
+                map = ShadowMap{};
+                map.light = &light;
+                map.cascade = cascade;
+            }
+
+            return map;
+        }
+
+        // Instanced meshes draw through the shaders of their materials and are left out like in the depth
+        // pre-pass.
+        static bool _is_caster(Mesh &mesh)
+        {
+            if (!mesh.is_casting_shadows() || mesh.as_instanced_mesh() != nullptr)
+            {
+                return false;
+            }
+
+            const auto &material = mesh.get_material();
+            if (material->is_transparent() || material->is_overlay())
+            {
+                return false;
+            }
+
+            Geometry::Type type = mesh.get_geometry()->get_type();
+            return type == Geometry::Type::Triangles || type == Geometry::Type::TriangleFan || type == Geometry::Type::TriangleStrip;
+        }
+
+        // Blends logarithmic splits, which keep the texel density on the screen even, with uniform ones.
+        static float _calculate_cascade_split(float near_plane, float far_plane, size_t cascade, size_t cascade_count)
+        {
+            float part = static_cast<float>(cascade) / static_cast<float>(cascade_count);
+            float uniform_split = near_plane + (far_plane - near_plane) * part;
+            float logarithmic_split = near_plane > 0.0f ? near_plane * std::pow(far_plane / near_plane, part) : uniform_split;
+
+            return CASCADE_SPLIT_WEIGHT * logarithmic_split + (1.0f - CASCADE_SPLIT_WEIGHT) * uniform_split;
+        }
+
+        static float _project_depth(const glm::mat4 &projection_matrix, float depth)
+        {
+            glm::vec4 position = projection_matrix * glm::vec4{0.0f, 0.0f, -depth, 1.0f};
+
+            return position.z / position.w;
+        }
+
+        static glm::vec3 _choose_up(const glm::vec3 &direction)
+        {
+            return std::fabs(direction.y) > 0.99f ? glm::vec3{0.0f, 0.0f, 1.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+        }
+
+        // The slice of the view frustum is bounded by a sphere, which keeps the size of the map in the world
+        // the same however the camera turns, and its center is snapped to the texels of the map, so that the
+        // edges of the shadows do not crawl while the camera moves. The depth range covers the scene, so that
+        // casters between the light and the slice are drawn.
+        static glm::mat4 _calculate_cascade_matrix(const glm::vec3 &direction, const glm::mat4 &inverse_view_projection_matrix,
+                                                   const glm::mat4 &projection_matrix, float near_plane, float far_plane,
+                                                   const AABB &scene_bounding_box, unsigned int map_size)
+        {
+            float near_depth = _project_depth(projection_matrix, near_plane);
+            float far_depth = _project_depth(projection_matrix, far_plane);
+
+            glm::vec3 corners[8];
+            glm::vec3 center{0.0f};
+            for (size_t i = 0; i < 8; ++i)
+            {
+                glm::vec4 corner = inverse_view_projection_matrix * glm::vec4{
+                    (i & 1u) != 0 ? 1.0f : -1.0f, (i & 2u) != 0 ? 1.0f : -1.0f, (i & 4u) != 0 ? far_depth : near_depth, 1.0f};
+                corners[i] = glm::vec3{corner} / corner.w;
+                center += corners[i];
+            }
+            center /= 8.0f;
+
+            float radius{CASCADE_RADIUS_STEP};
+            for (const glm::vec3 &corner : corners)
+            {
+                radius = std::max(radius, glm::length(corner - center));
+            }
+            radius = std::ceil(radius / CASCADE_RADIUS_STEP) * CASCADE_RADIUS_STEP;
+
+            glm::mat4 light_view_matrix = glm::lookAt(glm::vec3{0.0f}, -direction, _choose_up(direction));
+            glm::vec3 light_center{light_view_matrix * glm::vec4{center, 1.0f}};
+            float texel_size = 2.0f * radius / static_cast<float>(map_size);
+            light_center.x = std::floor(light_center.x / texel_size) * texel_size;
+            light_center.y = std::floor(light_center.y / texel_size) * texel_size;
+
+            float minimum_z = light_center.z - radius;
+            float maximum_z = light_center.z + radius;
+            const glm::vec3 &minimum = scene_bounding_box.get_minimum();
+            const glm::vec3 &maximum = scene_bounding_box.get_maximum();
+            for (size_t i = 0; i < 8; ++i)
+            {
+                glm::vec4 corner{(i & 1u) != 0 ? maximum.x : minimum.x, (i & 2u) != 0 ? maximum.y : minimum.y,
+                                 (i & 4u) != 0 ? maximum.z : minimum.z, 1.0f};
+                float z = (light_view_matrix * corner).z;
+                minimum_z = std::min(minimum_z, z);
+                maximum_z = std::max(maximum_z, z);
+            }
+            minimum_z = std::floor(minimum_z / radius) * radius;
+            maximum_z = std::ceil(maximum_z / radius) * radius;
+
+            return glm::ortho(light_center.x - radius, light_center.x + radius,
+                              light_center.y - radius, light_center.y + radius,
+                              -maximum_z, -minimum_z) * light_view_matrix;
+        }
+
+        static glm::mat4 _calculate_spot_matrix(const glm::vec3 &position, const glm::vec3 &direction,
+                                                float cutoff_angle_cosine, float radius)
+        {
+            float field_of_view = 2.0f * std::acos(std::clamp(cutoff_angle_cosine, 0.0f, 1.0f)) * SPOT_FIELD_OF_VIEW_MARGIN;
+            field_of_view = std::clamp(field_of_view, 0.01f, MAX_SPOT_FIELD_OF_VIEW);
+            float near_plane = std::max(radius * SPOT_NEAR_PLANE_RATIO, 0.01f);
+
+            return glm::perspective(field_of_view, 1.0f, near_plane, std::max(radius, 2.0f * near_plane)) *
+                   glm::lookAt(position, position + direction, _choose_up(direction));
+        }
+    };
+}
+
+#endif
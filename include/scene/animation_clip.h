@@ -0,0 +1,154 @@
+#ifndef ANIMATION_CLIP_H
+#define ANIMATION_CLIP_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace asr
+{
+    // Keyframe tracks that move, rotate and scale the targets of a clip. The times and values of all tracks
+    // are stored back to back in two arrays, every value as four floats, so that an AnimationSystem samples
+    // thousands of tracks without chasing pointers. Tracks refer to target slots, and the objects are bound
+    // to the slots when the clip is played, so one clip animates any number of objects.
+    //
+    // Positions and scales are interpolated linearly, rotations by normalized linear interpolation of their
+    // quaternions. Every rotation keyframe is stored in the hemisphere of the one before, so the
+    // interpolation always takes the short way. A clip must not change while it is played.
+    class AnimationClip
+    {
+    public:
+        enum Property : uint8_t
+        {
+            PositionProperty,
+            RotationProperty,
+            ScaleProperty
+        };
+
+        struct Track
+        {
+            uint32_t target;
+            Property property;
+            uint32_t first_keyframe;
+            uint32_t keyframe_count;
+        };
+
+        inline static const size_t VALUE_COMPONENT_COUNT = 4;
+
+        explicit AnimationClip(std::string name = "")
+            : _name{std::move(name)}
+        {}
+
+        [[nodiscard]] const std::string &get_name() const
+        {
+            return _name;
+        }
+
+        // The time of the last keyframe of all tracks.
+        [[nodiscard]] float get_duration() const
+        {
+            return _duration;
+        }
+
+        [[nodiscard]] size_t get_target_count() const
+        {
+            return _target_count;
+        }
+
+        [[nodiscard]] const std::vector<Track> &get_tracks() const
+        {
+            return _tracks;
+        }
+
+        [[nodiscard]] const std::vector<float> &get_times() const
+        {
+            return _times;
+        }
+
+        [[nodiscard]] const std::vector<float> &get_values() const
+        {
+            return _values;
+        }
+
+        void add_position_track(size_t target, const std::vector<float> &times, const std::vector<glm::vec3> &positions)
+        {
+            _add_track(target, PositionProperty, times, positions.size());
+            for (const glm::vec3 &position : positions)
+            {
+                _values.insert(_values.end(), {position.x, position.y, position.z, 0.0f});
+            }
+        }
+
+        void add_rotation_track(size_t target, const std::vector<float> &times, const std::vector<glm::quat> &rotations)
+        {
+            _add_track(target, RotationProperty, times, rotations.size());
+            glm::quat previous_rotation{1.0f, 0.0f, 0.0f, 0.0f};
+            for (size_t i = 0; i < rotations.size(); ++i)
+            {
+                glm::quat rotation = glm::normalize(rotations[i]);
+                float alignment = previous_rotation.x * rotation.x + previous_rotation.y * rotation.y +
+                                  previous_rotation.z * rotation.z + previous_rotation.w * rotation.w;
+                if (i > 0 && alignment < 0.0f)
+                {
+                    rotation = glm::quat{-rotation.w, -rotation.x, -rotation.y, -rotation.z};
+                }
+                _values.insert(_values.end(), {rotation.x, rotation.y, rotation.z, rotation.w});
+                previous_rotation = rotation;
+            }
+        }
+
+        void add_scale_track(size_t target, const std::vector<float> &times, const std::vector<glm::vec3> &scales)
+        {
+            _add_track(target, ScaleProperty, times, scales.size());
+            for (const glm::vec3 &scale : scales)
+            {
+                _values.insert(_values.end(), {scale.x, scale.y, scale.z, 0.0f});
+            }
+        }
+
+    private:
+        std::string _name;
+        std::vector<Track> _tracks;
+        std::vector<float> _times;
+        std::vector<float> _values;
+        size_t _target_count{0};
+        float _duration{0.0f};
+
+        void _add_track(size_t target, Property property, const std::vector<float> &times, size_t value_count)
+        {
+            if (times.empty() || times.size() != value_count)
+            {
+                std::cerr << "Failed to add a track to the animation clip '" << _name << "', it needs a value for each "
+                          << "of at least one keyframe time." << std::endl;
+                std::exit(-1);
+            }
+            for (size_t i = 1; i < times.size(); ++i)
+            {
+                if (times[i] <= times[i - 1])
+                {
+                    std::cerr << "Failed to add a track to the animation clip '" << _name << "', the keyframe times "
+                              << "have to increase." << std::endl;
+                    std::exit(-1);
+                }
+            }
+
+            _tracks.push_back(Track{
+                static_cast<uint32_t>(target), property,
+                static_cast<uint32_t>(_times.size()), static_cast<uint32_t>(times.size())});
+            _times.insert(_times.end(), times.begin(), times.end());
+            _values.reserve(_values.size() + times.size() * VALUE_COMPONENT_COUNT);
+            _target_count = std::max(_target_count, target + 1);
+            _duration = std::max(_duration, times.back());
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,396 @@
+#ifndef ANIMATION_SYSTEM_H
+#define ANIMATION_SYSTEM_H
+
+#include "scene/animation_clip.h"
+#include "objects/object.h"
+#include "geometries/geometry_processing.h"
+#include "utilities/job_system.h"
+#include "utilities/profiler.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace asr
+{
+    // Plays animation clips on objects. Every frame, update() samples the tracks of all playing clips into one
+    // array, four components at a time with SSE2 or NEON and split into ranges for a JobSystem when one is
+    // given, and then writes the position, rotation and scale of every animated object in a single pass. The
+    // objects take their transforms whole, without deriving Euler angles or marking their subtrees per
+    // property, and the transform hierarchy of the scene recomputes their world matrices with the rest.
+    //
+    // Tracks keep the keyframe they were last sampled at, so clips played forward find their keyframes
+    // without searching. Properties without a track keep the values the object has.
+    class AnimationSystem
+    {
+    public:
+        typedef uint32_t handle_type;
+
+        static constexpr handle_type NULL_HANDLE{UINT32_MAX};
+
+        inline static const size_t UPDATE_GRAIN_SIZE = 1024;
+
+        AnimationSystem() = default;
+
+        AnimationSystem(const AnimationSystem &other) = delete;
+        AnimationSystem &operator=(const AnimationSystem &other) = delete;
+
+        // Binds the objects to the target slots of the clip in order and starts playing it. Targets without
+        // an object are skipped.
+        handle_type play(std::shared_ptr<const AnimationClip> clip, std::vector<std::shared_ptr<Object>> targets,
+                         bool looping = true)
+        {
+            if (!clip || targets.size() < clip->get_target_count())
+            {
+                std::cerr << "Failed to play an animation clip, it needs an object for each of its targets." << std::endl;
+                std::exit(-1);
+            }
+
+            handle_type handle;
+            if (_free_handles.empty())
+            {
+                handle = static_cast<handle_type>(_players.size());
+                _players.emplace_back();
+            }
+            else
+            {
+                handle = _free_handles.back();
+                _free_handles.pop_back();
+            }
+
+            Player &player = _players[handle];
+            player.clip = std::move(clip);
+            player.targets = std::move(targets);
+            player.time = 0.0f;
+            player.speed = 1.0f;
+            player.looping = looping;
+            player.paused = false;
+            player.active = true;
+            _requires_rebuild = true;
+
+            return handle;
+        }
+
+        void stop(handle_type player)
+        {
+            _players[player] = Player{};
+            _free_handles.push_back(player);
+            _requires_rebuild = true;
+        }
+
+        [[nodiscard]] bool is_playing(handle_type player) const
+        {
+            return player < _players.size() && _players[player].active;
+        }
+
+        [[nodiscard]] float get_time(handle_type player) const
+        {
+            return _players[player].time;
+        }
+
+        void set_time(handle_type player, float time)
+        {
+            _players[player].time = time;
+        }
+
+        [[nodiscard]] float get_speed(handle_type player) const
+        {
+            return _players[player].speed;
+        }
+
+        void set_speed(handle_type player, float speed)
+        {
+            _players[player].speed = speed;
+        }
+
+        [[nodiscard]] bool is_paused(handle_type player) const
+        {
+            return _players[player].paused;
+        }
+
+        void set_paused(handle_type player, bool paused)
+        {
+            _players[player].paused = paused;
+        }
+
+        // Clips that do not loop stop advancing at their last keyframe and stay playing until stop() is called.
+        [[nodiscard]] bool is_finished(handle_type player) const
+        {
+            const Player &animation_player = _players[player];
+            return !animation_player.looping && animation_player.time >= animation_player.clip->get_duration();
+        }
+
+        [[nodiscard]] size_t get_channel_count() const
+        {
+            return _channels.size();
+        }
+
+        [[nodiscard]] size_t get_animated_object_count() const
+        {
+            return _bindings.size();
+        }
+
+        void update(float delta_time, JobSystem *job_system = nullptr)
+        {
+            ASR_PROFILE_SCOPE("AnimationSystem::update");
+
+            if (_requires_rebuild)
+            {
+                _rebuild();
+            }
+
+            for (Player &player : _players)
+            {
+                if (!player.active || player.paused)
+                {
+                    continue;
+                }
+
+                float duration = player.clip->get_duration();
+                player.time += delta_time * player.speed;
+                if (player.looping && duration > 0.0f)
+                {
+                    player.time = std::fmod(player.time, duration);
+                    if (player.time < 0.0f)
+                    {
+                        player.time += duration;
+                    }
+                }
+                else
+                {
+                    player.time = std::min(std::max(player.time, 0.0f), duration);
+                }
+            }
+            for (size_t i = 0; i < _players.size(); ++i)
+            {
+                _player_times[i] = _players[i].time;
+            }
+
+            {
+                ASR_PROFILE_SCOPE("AnimationSystem::sample");
+                auto sample = [this](size_t begin, size_t end) {
+                    _sample(begin, end);
+                };
+                if (job_system != nullptr)
+                {
+                    job_system->parallel_for(_channels.size(), UPDATE_GRAIN_SIZE, sample);
+                }
+                else if (!_channels.empty())
+                {
+                    sample(0, _channels.size());
+                }
+            }
+
+            ASR_PROFILE_SCOPE("AnimationSystem::apply");
+            const float *outputs = _outputs.data();
+            for (const Binding &binding : _bindings)
+            {
+                Object &object = *binding.object;
+                glm::vec3 position = object.get_position();
+                glm::quat quaternion_rotation = object.get_quaternion_rotation();
+                glm::vec3 scale = object.get_scale();
+                if (binding.position_channel != NO_CHANNEL)
+                {
+                    const float *value = outputs + binding.position_channel * AnimationClip::VALUE_COMPONENT_COUNT;
+                    position = glm::vec3{value[0], value[1], value[2]};
+                }
+                if (binding.rotation_channel != NO_CHANNEL)
+                {
+                    const float *value = outputs + binding.rotation_channel * AnimationClip::VALUE_COMPONENT_COUNT;
+                    quaternion_rotation = glm::quat{value[3], value[0], value[1], value[2]};
+                }
+                if (binding.scale_channel != NO_CHANNEL)
+                {
+                    const float *value = outputs + binding.scale_channel * AnimationClip::VALUE_COMPONENT_COUNT;
+                    scale = glm::vec3{value[0], value[1], value[2]};
+                }
+                object.set_local_transform(position, quaternion_rotation, scale);
+            }
+        }
+
+    private:
+        static constexpr uint32_t NO_CHANNEL{UINT32_MAX};
+
+        struct Player
+        {
+            std::shared_ptr<const AnimationClip> clip;
+            std::vector<std::shared_ptr<Object>> targets;
+            float time{0.0f};
+            float speed{1.0f};
+            bool looping{true};
+            bool paused{false};
+            bool active{false};
+        };
+
+        struct Channel
+        {
+            const float *times;
+            const float *values;
+            uint32_t keyframe_count;
+            uint32_t keyframe;
+            uint32_t player;
+            bool normalized;
+        };
+
+        struct Binding
+        {
+            Object *object;
+            uint32_t position_channel;
+            uint32_t rotation_channel;
+            uint32_t scale_channel;
+        };
+
+        std::vector<Player> _players;
+        std::vector<handle_type> _free_handles;
+        std::vector<float> _player_times;
+
+        std::vector<Channel> _channels;
+        std::vector<float> _outputs;
+        std::vector<Binding> _bindings;
+        bool _requires_rebuild{false};
+
+        void _rebuild()
+        {
+            _channels.clear();
+            _bindings.clear();
+            _player_times.resize(_players.size());
+
+            for (size_t i = 0; i < _players.size(); ++i)
+            {
+                const Player &player = _players[i];
+                if (!player.active)
+                {
+                    continue;
+                }
+
+                const AnimationClip &clip = *player.clip;
+                size_t first_binding = _bindings.size();
+                for (const auto &target : player.targets)
+                {
+                    _bindings.push_back(Binding{target.get(), NO_CHANNEL, NO_CHANNEL, NO_CHANNEL});
+                }
+
+                for (const AnimationClip::Track &track : clip.get_tracks())
+                {
+                    Binding &binding = _bindings[first_binding + track.target];
+                    auto channel = static_cast<uint32_t>(_channels.size());
+                    switch (track.property)
+                    {
+                    case AnimationClip::PositionProperty:
+                        binding.position_channel = channel;
+                        break;
+                    case AnimationClip::RotationProperty:
+                        binding.rotation_channel = channel;
+                        break;
+                    case AnimationClip::ScaleProperty:
+                        binding.scale_channel = channel;
+                        break;
+                    }
+
+                    _channels.push_back(Channel{
+                        clip.get_times().data() + track.first_keyframe,
+                        clip.get_values().data() + track.first_keyframe * AnimationClip::VALUE_COMPONENT_COUNT,
+                        track.keyframe_count, 0, static_cast<uint32_t>(i),
+                        track.property == AnimationClip::RotationProperty});
+                }
+            }
+
+            _bindings.erase(
+                std::remove_if(_bindings.begin(), _bindings.end(), [](const Binding &binding) {
+                    return binding.object == nullptr ||
+                           (binding.position_channel == NO_CHANNEL && binding.rotation_channel == NO_CHANNEL &&
+                            binding.scale_channel == NO_CHANNEL);
+                }),
+                _bindings.end());
+            _outputs.resize(_channels.size() * AnimationClip::VALUE_COMPONENT_COUNT);
+
+            _requires_rebuild = false;
+        }
+
+        void _sample(size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                Channel &channel = _channels[i];
+                float *output = _outputs.data() + i * AnimationClip::VALUE_COMPONENT_COUNT;
+                if (channel.keyframe_count == 1)
+                {
+                    std::copy(channel.values, channel.values + AnimationClip::VALUE_COMPONENT_COUNT, output);
+                    continue;
+                }
+
+                float time = _player_times[channel.player];
+                const float *times = channel.times;
+                uint32_t keyframe = channel.keyframe;
+                if (time < times[keyframe])
+                {
+                    const float *next = std::upper_bound(times, times + channel.keyframe_count, time);
+                    keyframe = next == times ? 0 : static_cast<uint32_t>(next - times - 1);
+                }
+                while (keyframe + 2 < channel.keyframe_count && times[keyframe + 1] <= time)
+                {
+                    ++keyframe;
+                }
+                channel.keyframe = keyframe;
+
+                float weight = (time - times[keyframe]) / (times[keyframe + 1] - times[keyframe]);
+                weight = std::min(std::max(weight, 0.0f), 1.0f);
+                const float *first = channel.values + keyframe * AnimationClip::VALUE_COMPONENT_COUNT;
+                _interpolate(first, first + AnimationClip::VALUE_COMPONENT_COUNT, weight, channel.normalized, output);
+            }
+        }
+
+        static void _interpolate(const float *first, const float *second, float weight, bool normalized, float *output)
+        {
+#if defined(ASR_SIMD_SSE2)
+            __m128 first_value = _mm_loadu_ps(first);
+            __m128 value = _mm_add_ps(first_value, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(second), first_value), _mm_set1_ps(weight)));
+            if (normalized)
+            {
+                __m128 squares = _mm_mul_ps(value, value);
+                squares = _mm_add_ps(squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(2, 3, 0, 1)));
+                squares = _mm_add_ps(squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(1, 0, 3, 2)));
+                value = _mm_div_ps(value, _mm_sqrt_ps(squares));
+            }
+            _mm_storeu_ps(output, value);
+#elif defined(ASR_SIMD_NEON)
+            float32x4_t first_value = vld1q_f32(first);
+            float32x4_t value = vaddq_f32(first_value, vmulq_n_f32(vsubq_f32(vld1q_f32(second), first_value), weight));
+            if (normalized)
+            {
+                float32x4_t squares = vmulq_f32(value, value);
+                float32x2_t sum = vadd_f32(vget_low_f32(squares), vget_high_f32(squares));
+                sum = vpadd_f32(sum, sum);
+                value = vmulq_n_f32(value, 1.0f / std::sqrt(vget_lane_f32(sum, 0)));
+            }
+            vst1q_f32(output, value);
+#else
+            float length_squared{0.0f};
+            for (size_t component = 0; component < AnimationClip::VALUE_COMPONENT_COUNT; ++component)
+            {
+                output[component] = first[component] + (second[component] - first[component]) * weight;
+                length_squared += output[component] * output[component];
+            }
+            if (normalized)
+            {
+                float inverse_length = 1.0f / std::sqrt(length_squared);
+                for (size_t component = 0; component < AnimationClip::VALUE_COMPONENT_COUNT; ++component)
+                {
+                    output[component] *= inverse_length;
+                }
+            }
+#endif
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,498 @@
+#ifndef BOUNDING_VOLUME_HIERARCHY_H
+#define BOUNDING_VOLUME_HIERARCHY_H
+
+#include "math/aabb.h"
+#include "math/frustum.h"
+#include "math/ray.h"
+#include "objects/mesh.h"
+#include "geometries/triangle_bvh.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+
+namespace asr
+{
+    // Dynamic AABB tree. Leaves store boxes enlarged by a margin so that small movements do not require
+    // reinsertion, and the tree is kept balanced with rotations on the way back up after every change.
+    class BoundingVolumeHierarchy
+    {
+    public:
+        inline static const int NULL_NODE = -1;
+
+        explicit BoundingVolumeHierarchy(float margin = 0.1f) : _margin{margin} {}
+
+        [[nodiscard]] float get_margin() const
+        {
+            return _margin;
+        }
+
+        void set_margin(float margin)
+        {
+            _margin = margin;
+        }
+
+        [[nodiscard]] size_t get_leaf_count() const
+        {
+            return _leaf_count;
+        }
+
+        [[nodiscard]] int get_height() const
+        {
+            return _root == NULL_NODE ? 0 : _nodes[static_cast<size_t>(_root)].height;
+        }
+
+        // The enlarged box of the root, which holds every leaf, or an empty box at the origin without leaves.
+        [[nodiscard]] AABB get_bounding_box() const
+        {
+            return _root == NULL_NODE ? AABB{glm::vec3{0.0f}, glm::vec3{0.0f}} : get_bounding_box(_root);
+        }
+
+        [[nodiscard]] AABB get_bounding_box(int node) const
+        {
+            const Node &bounded_node = _nodes[static_cast<size_t>(node)];
+            return AABB{bounded_node.minimum, bounded_node.maximum};
+        }
+
+        int insert(const AABB &box, Mesh *mesh)
+        {
+            int leaf = _allocate_node();
+            Node &node = _nodes[static_cast<size_t>(leaf)];
+            node.minimum = box.get_minimum() - glm::vec3{_margin};
+            node.maximum = box.get_maximum() + glm::vec3{_margin};
+            node.mesh = mesh;
+            node.height = 0;
+
+            _insert_leaf(leaf);
+            ++_leaf_count;
+
+            return leaf;
+        }
+
+        void remove(int leaf)
+        {
+            _remove_leaf(leaf);
+            _free_node(leaf);
+            --_leaf_count;
+        }
+
+        bool update(int leaf, const AABB &box)
+        {
+            Node &node = _nodes[static_cast<size_t>(leaf)];
+            const glm::vec3 &minimum = box.get_minimum();
+            const glm::vec3 &maximum = box.get_maximum();
+            if (node.minimum.x <= minimum.x && node.minimum.y <= minimum.y && node.minimum.z <= minimum.z &&
+                maximum.x <= node.maximum.x && maximum.y <= node.maximum.y && maximum.z <= node.maximum.z)
+            {
+                return false;
+            }
+
+            _remove_leaf(leaf);
+            Node &moved_node = _nodes[static_cast<size_t>(leaf)];
+            moved_node.minimum = minimum - glm::vec3{_margin};
+            moved_node.maximum = maximum + glm::vec3{_margin};
+            _insert_leaf(leaf);
+
+            return true;
+        }
+
+        template <typename Callback>
+        void query(const Frustum &frustum, Callback callback)
+        {
+            _traverse(
+                [&](const Node &node) {
+                    return frustum.intersects(AABB{node.minimum, node.maximum});
+                },
+                callback);
+        }
+
+        template <typename Callback>
+        void query(const AABB &box, Callback callback)
+        {
+            const glm::vec3 &minimum = box.get_minimum();
+            const glm::vec3 &maximum = box.get_maximum();
+            _traverse(
+                [&](const Node &node) {
+                    return node.minimum.x <= maximum.x && minimum.x <= node.maximum.x &&
+                           node.minimum.y <= maximum.y && minimum.y <= node.maximum.y &&
+                           node.minimum.z <= maximum.z && minimum.z <= node.maximum.z;
+                },
+                callback);
+        }
+
+        // Visits every leaf hit by the ray. The callback receives the mesh and the distance to its box and
+        // returns false to stop the traversal.
+        template <typename Callback>
+        void raycast(const Ray &ray, Callback callback)
+        {
+            if (_root == NULL_NODE)
+            {
+                return;
+            }
+
+            _stack.clear();
+            _stack.push_back(_root);
+            while (!_stack.empty())
+            {
+                int index = _stack.back();
+                _stack.pop_back();
+
+                const Node &node = _nodes[static_cast<size_t>(index)];
+                auto [intersects, distance] = ray.intersects_with_aabb(node.minimum, node.maximum);
+                if (!intersects)
+                {
+                    continue;
+                }
+
+                if (node.is_leaf())
+                {
+                    if (!callback(node.mesh, distance))
+                    {
+                        return;
+                    }
+                }
+                else
+                {
+                    _stack.push_back(node.left);
+                    _stack.push_back(node.right);
+                }
+            }
+        }
+
+        Mesh *pick(const Ray &ray)
+        {
+            Mesh *nearest_mesh{nullptr};
+            float nearest_distance{INFINITY};
+            raycast(ray, [&](Mesh *mesh, float distance) {
+                if (distance < nearest_distance)
+                {
+                    nearest_distance = distance;
+                    nearest_mesh = mesh;
+                }
+                return true;
+            });
+
+            return nearest_mesh;
+        }
+
+        // The nearest mesh whose triangles the ray hits. Meshes are only tested while their boxes are nearer
+        // than the nearest hit so far.
+        Mesh *pick_triangles(const Ray &ray, TriangleBVH::Hit &hit)
+        {
+            Mesh *nearest_mesh{nullptr};
+            hit = TriangleBVH::Hit{};
+            raycast(ray, [&](Mesh *mesh, float distance) {
+                if (distance < hit.distance)
+                {
+                    TriangleBVH::Hit mesh_hit = mesh->intersect_ray(ray);
+                    if (mesh_hit.hit && mesh_hit.distance < hit.distance)
+                    {
+                        hit = mesh_hit;
+                        nearest_mesh = mesh;
+                    }
+                }
+                return true;
+            });
+
+            return nearest_mesh;
+        }
+
+        void clear()
+        {
+            _nodes.clear();
+            _root = NULL_NODE;
+            _free_list = NULL_NODE;
+            _leaf_count = 0;
+        }
+
+    private:
+        struct Node
+        {
+            glm::vec3 minimum{0.0f};
+            glm::vec3 maximum{0.0f};
+            Mesh *mesh{nullptr};
+            int parent{NULL_NODE};
+            int left{NULL_NODE};
+            int right{NULL_NODE};
+            int height{-1};
+
+            [[nodiscard]] bool is_leaf() const
+            {
+                return left == NULL_NODE;
+            }
+        };
+
+        float _margin;
+
+        std::vector<Node> _nodes;
+        int _root{NULL_NODE};
+        int _free_list{NULL_NODE};
+        size_t _leaf_count{0};
+
+        std::vector<int> _stack;
+
+        template <typename Test, typename Callback>
+        void _traverse(Test test, Callback callback)
+        {
+            if (_root == NULL_NODE)
+            {
+                return;
+            }
+
+            _stack.clear();
+            _stack.push_back(_root);
+            while (!_stack.empty())
+            {
+                int index = _stack.back();
+                _stack.pop_back();
+
+                const Node &node = _nodes[static_cast<size_t>(index)];
+                if (!test(node))
+                {
+                    continue;
+                }
+
+                if (node.is_leaf())
+                {
+                    callback(node.mesh);
+                }
+                else
+                {
+                    _stack.push_back(node.left);
+                    _stack.push_back(node.right);
+                }
+            }
+        }
+
+        int _allocate_node()
+        {
+            if (_free_list == NULL_NODE)
+            {
+                _nodes.emplace_back();
+                return static_cast<int>(_nodes.size() - 1);
+            }
+
+            int index = _free_list;
+            _free_list = _nodes[static_cast<size_t>(index)].parent;
+            _nodes[static_cast<size_t>(index)] = Node{};
+
+            return index;
+        }
+
+        void _free_node(int index)
+        {
+            Node &node = _nodes[static_cast<size_t>(index)];
+            node.parent = _free_list;
+            node.height = -1;
+            node.mesh = nullptr;
+            _free_list = index;
+        }
+
+        static float _area(const glm::vec3 &minimum, const glm::vec3 &maximum)
+        {
+            glm::vec3 size = maximum - minimum;
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        void _fit(int index)
+        {
+            Node &node = _nodes[static_cast<size_t>(index)];
+            const Node &left = _nodes[static_cast<size_t>(node.left)];
+            const Node &right = _nodes[static_cast<size_t>(node.right)];
+            node.minimum = glm::min(left.minimum, right.minimum);
+            node.maximum = glm::max(left.maximum, right.maximum);
+            node.height = 1 + std::max(left.height, right.height);
+        }
+
+        void _insert_leaf(int leaf)
+        {
+            if (_root == NULL_NODE)
+            {
+                _root = leaf;
+                _nodes[static_cast<size_t>(leaf)].parent = NULL_NODE;
+                return;
+            }
+
+            glm::vec3 leaf_minimum = _nodes[static_cast<size_t>(leaf)].minimum;
+            glm::vec3 leaf_maximum = _nodes[static_cast<size_t>(leaf)].maximum;
+
+            int index = _root;
+            while (!_nodes[static_cast<size_t>(index)].is_leaf())
+            {
+                const Node &node = _nodes[static_cast<size_t>(index)];
+
+                float area = _area(node.minimum, node.maximum);
+                float combined_area = _area(glm::min(node.minimum, leaf_minimum), glm::max(node.maximum, leaf_maximum));
+                float cost = 2.0f * combined_area;
+                float inheritance_cost = 2.0f * (combined_area - area);
+
+                float left_cost = _descend_cost(node.left, leaf_minimum, leaf_maximum) + inheritance_cost;
+                float right_cost = _descend_cost(node.right, leaf_minimum, leaf_maximum) + inheritance_cost;
+                if (cost < left_cost && cost < right_cost)
+                {
+                    break;
+                }
+
+                index = left_cost < right_cost ? node.left : node.right;
+            }
+
+            int sibling = index;
+            int old_parent = _nodes[static_cast<size_t>(sibling)].parent;
+            int new_parent = _allocate_node();
+
+            Node &parent_node = _nodes[static_cast<size_t>(new_parent)];
+            parent_node.parent = old_parent;
+            parent_node.left = sibling;
+            parent_node.right = leaf;
+            _nodes[static_cast<size_t>(sibling)].parent = new_parent;
+            _nodes[static_cast<size_t>(leaf)].parent = new_parent;
+            _fit(new_parent);
+
+            if (old_parent == NULL_NODE)
+            {
+                _root = new_parent;
+            }
+            else if (_nodes[static_cast<size_t>(old_parent)].left == sibling)
+            {
+                _nodes[static_cast<size_t>(old_parent)].left = new_parent;
+            }
+            else
+            {
+                _nodes[static_cast<size_t>(old_parent)].right = new_parent;
+            }
+
+            _refit_ancestors(_nodes[static_cast<size_t>(leaf)].parent);
+        }
+
+        float _descend_cost(int index, const glm::vec3 &leaf_minimum, const glm::vec3 &leaf_maximum) const
+        {
+            const Node &node = _nodes[static_cast<size_t>(index)];
+            float combined_area = _area(glm::min(node.minimum, leaf_minimum), glm::max(node.maximum, leaf_maximum));
+            if (node.is_leaf())
+            {
+                return combined_area;
+            }
+
+            return combined_area - _area(node.minimum, node.maximum);
+        }
+
+        void _remove_leaf(int leaf)
+        {
+            if (leaf == _root)
+            {
+                _root = NULL_NODE;
+                return;
+            }
+
+            int parent = _nodes[static_cast<size_t>(leaf)].parent;
+            int grand_parent = _nodes[static_cast<size_t>(parent)].parent;
+            int sibling = _nodes[static_cast<size_t>(parent)].left == leaf
+                              ? _nodes[static_cast<size_t>(parent)].right
+                              : _nodes[static_cast<size_t>(parent)].left;
+
+            if (grand_parent == NULL_NODE)
+            {
+                _root = sibling;
+                _nodes[static_cast<size_t>(sibling)].parent = NULL_NODE;
+            }
+            else
+            {
+                Node &grand_parent_node = _nodes[static_cast<size_t>(grand_parent)];
+                if (grand_parent_node.left == parent)
+                {
+                    grand_parent_node.left = sibling;
+                }
+                else
+                {
+                    grand_parent_node.right = sibling;
+                }
+                _nodes[static_cast<size_t>(sibling)].parent = grand_parent;
+                _refit_ancestors(grand_parent);
+            }
+
+            _free_node(parent);
+            _nodes[static_cast<size_t>(leaf)].parent = NULL_NODE;
+        }
+
+        void _refit_ancestors(int index)
+        {
+            while (index != NULL_NODE)
+            {
+                index = _balance(index);
+                _fit(index);
+                index = _nodes[static_cast<size_t>(index)].parent;
+            }
+        }
+
+        int _balance(int a)
+        {
+            Node &node_a = _nodes[static_cast<size_t>(a)];
+            if (node_a.is_leaf() || node_a.height < 2)
+            {
+                return a;
+            }
+
+            int b = node_a.left;
+            int c = node_a.right;
+            int balance = _nodes[static_cast<size_t>(c)].height - _nodes[static_cast<size_t>(b)].height;
+            if (balance > 1)
+            {
+                return _rotate(a, c, b);
+            }
+            if (balance < -1)
+            {
+                return _rotate(a, b, c);
+            }
+
+            return a;
+        }
+
+        // Promotes the taller child of a and moves the shorter grandchild down in its place.
+        int _rotate(int a, int taller, int shorter)
+        {
+            Node &node_taller = _nodes[static_cast<size_t>(taller)];
+            int f = node_taller.left;
+            int g = node_taller.right;
+
+            node_taller.parent = _nodes[static_cast<size_t>(a)].parent;
+            _nodes[static_cast<size_t>(a)].parent = taller;
+            if (node_taller.parent == NULL_NODE)
+            {
+                _root = taller;
+            }
+            else if (_nodes[static_cast<size_t>(node_taller.parent)].left == a)
+            {
+                _nodes[static_cast<size_t>(node_taller.parent)].left = taller;
+            }
+            else
+            {
+                _nodes[static_cast<size_t>(node_taller.parent)].right = taller;
+            }
+
+            int kept = f;
+            int moved = g;
+            if (_nodes[static_cast<size_t>(f)].height < _nodes[static_cast<size_t>(g)].height)
+            {
+                kept = g;
+                moved = f;
+            }
+
+            node_taller.left = a;
+            node_taller.right = kept;
+            Node &node_a = _nodes[static_cast<size_t>(a)];
+            node_a.left = shorter;
+            node_a.right = moved;
+            _nodes[static_cast<size_t>(moved)].parent = a;
+
+            _fit(a);
+            _fit(taller);
+
+            return taller;
+        }
+    };
+}
+
+#endif
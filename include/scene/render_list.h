@@ -0,0 +1,277 @@
+#ifndef RENDER_LIST_H
+#define RENDER_LIST_H
+
+#include "scene/scene_graph_listener.h"
+#include "objects/object.h"
+#include "objects/mesh.h"
+#include "materials/material.h"
+#include "scene/bounding_volume_hierarchy.h"
+#include "math/aabb.h"
+#include "utilities/job_system.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace asr
+{
+    class RenderList final : public SceneGraphListener
+    {
+    public:
+        inline static const size_t RESOLVE_GRAIN_SIZE = 256;
+
+        RenderList() = default;
+
+        RenderList(const RenderList &other) = delete;
+        RenderList &operator=(const RenderList &other) = delete;
+
+        void on_object_attached(Object &object) final
+        {
+            _world_matrices_resolved = false;
+            object.get_world_matrix();
+            if (Mesh *mesh = object.as_mesh())
+            {
+                mesh->set_render_list_index(_meshes.size());
+                _meshes.push_back(mesh);
+                _requires_buckets_update = true;
+
+                mesh->set_bounding_volume_proxy(_bounding_volume_hierarchy.insert(mesh->get_world_bounding_box(), mesh));
+                _record_change(*mesh, mesh->get_world_bounding_box(), _pending_changed_bounding_boxes);
+            }
+        }
+
+        void on_object_detached(Object &object) final
+        {
+            if (Mesh *mesh = object.as_mesh())
+            {
+                size_t index = mesh->get_render_list_index();
+                Mesh *last_mesh = _meshes.back();
+                _meshes[index] = last_mesh;
+                last_mesh->set_render_list_index(index);
+                _meshes.pop_back();
+                _requires_buckets_update = true;
+
+                _record_change(*mesh, _bounding_volume_hierarchy.get_bounding_box(mesh->get_bounding_volume_proxy()),
+                               _pending_changed_bounding_boxes);
+                _bounding_volume_hierarchy.remove(mesh->get_bounding_volume_proxy());
+                mesh->set_bounding_volume_proxy(BoundingVolumeHierarchy::NULL_NODE);
+            }
+
+            // The queued object may be destroyed before the next update, which skips the cleared place.
+            if (object.is_transform_update_pending())
+            {
+                _transformed_objects[object.get_transform_update_index()] = nullptr;
+                object.set_transform_update_pending(false);
+            }
+        }
+
+        void on_object_transformed(Object &object) final
+        {
+            _world_matrices_resolved = false;
+            object.set_transform_update_index(_transformed_objects.size());
+            _transformed_objects.push_back(&object);
+        }
+
+        [[nodiscard]] const std::vector<Mesh *> &get_meshes() const
+        {
+            return _meshes;
+        }
+
+        [[nodiscard]] std::vector<Mesh *> &get_opaque_meshes()
+        {
+            return _opaque_meshes;
+        }
+
+        [[nodiscard]] std::vector<Mesh *> &get_transparent_meshes()
+        {
+            return _transparent_meshes;
+        }
+
+        [[nodiscard]] std::vector<Mesh *> &get_overlay_meshes()
+        {
+            return _overlay_meshes;
+        }
+
+        [[nodiscard]] BoundingVolumeHierarchy &get_bounding_volume_hierarchy()
+        {
+            return _bounding_volume_hierarchy;
+        }
+
+        // The world bounds that opaque meshes were attached at, detached from, moved out of or moved into until
+        // the last update, so that what was drawn into a region can be drawn again when it changed.
+        [[nodiscard]] const std::vector<AABB> &get_changed_bounding_boxes() const
+        {
+            return _changed_bounding_boxes;
+        }
+
+        [[nodiscard]] unsigned int get_version() const
+        {
+            return _version;
+        }
+
+        void update(JobSystem *job_system = nullptr)
+        {
+            _changed_bounding_boxes.swap(_pending_changed_bounding_boxes);
+            _pending_changed_bounding_boxes.clear();
+            _resolve_transforms(job_system);
+            _world_matrices_resolved = true;
+
+            unsigned int bucket_version = Material::get_bucket_version();
+            if (!_requires_buckets_update && _bucket_version == bucket_version)
+            {
+                return;
+            }
+
+            _opaque_meshes.clear();
+            _transparent_meshes.clear();
+            _overlay_meshes.clear();
+            for (Mesh *mesh : _meshes)
+            {
+                const auto &material = mesh->get_material();
+                if (material->is_overlay())
+                {
+                    _overlay_meshes.push_back(mesh);
+                }
+                else if (material->is_transparent())
+                {
+                    _transparent_meshes.push_back(mesh);
+                }
+                else
+                {
+                    _opaque_meshes.push_back(mesh);
+                }
+            }
+
+            std::stable_sort(std::begin(_overlay_meshes), std::end(_overlay_meshes), [](const Mesh *a, const Mesh *b) {
+                return a->get_material()->get_overlay_priority() > b->get_material()->get_overlay_priority();
+            });
+
+            _bucket_version = bucket_version;
+            _requires_buckets_update = false;
+            ++_version;
+        }
+
+    private:
+        std::vector<Mesh *> _meshes;
+
+        std::vector<Mesh *> _opaque_meshes;
+        std::vector<Mesh *> _transparent_meshes;
+        std::vector<Mesh *> _overlay_meshes;
+
+        BoundingVolumeHierarchy _bounding_volume_hierarchy;
+        std::vector<Object *> _transformed_objects;
+        std::vector<Object *> _resolved_objects;
+        std::vector<size_t> _resolved_level_offsets;
+        std::vector<AABB> _changed_bounding_boxes;
+        std::vector<AABB> _pending_changed_bounding_boxes;
+
+        bool _requires_buckets_update{true};
+        unsigned int _bucket_version{0};
+        unsigned int _version{0};
+
+        void _resolve_transforms(JobSystem *job_system)
+        {
+            if (_transformed_objects.empty())
+            {
+                return;
+            }
+
+            // Objects below another moved object are covered by its subtree, so each moved subtree is walked once.
+            _resolved_objects.clear();
+            for (Object *object : _transformed_objects)
+            {
+                if (object == nullptr)
+                {
+                    continue;
+                }
+
+                bool covered{false};
+                for (Object *parent = object->get_parent_object(); parent && !covered; parent = parent->get_parent_object())
+                {
+                    covered = parent->is_transform_update_pending();
+                }
+                if (!covered)
+                {
+                    _resolved_objects.push_back(object);
+                }
+            }
+            _transformed_objects.clear();
+
+            // The subtrees are flattened level by level in hierarchy order. An object only reads the world
+            // matrices of the previous levels, so every level can be resolved in parallel.
+            _resolved_level_offsets.clear();
+            size_t level_begin{0};
+            while (level_begin < _resolved_objects.size())
+            {
+                size_t level_end = _resolved_objects.size();
+                _resolved_level_offsets.push_back(level_begin);
+                for (size_t i = level_begin; i < level_end; ++i)
+                {
+                    Object *object = _resolved_objects[i];
+                    object->set_transform_update_pending(false);
+                    if (Mesh *mesh = object->as_mesh())
+                    {
+                        mesh->get_geometry()->get_bounding_box();
+                    }
+                    for (const auto &child : object->get_children())
+                    {
+                        _resolved_objects.push_back(child.get());
+                    }
+                }
+                level_begin = level_end;
+            }
+            _resolved_level_offsets.push_back(_resolved_objects.size());
+
+            for (size_t level = 0; level + 1 < _resolved_level_offsets.size(); ++level)
+            {
+                size_t first = _resolved_level_offsets[level];
+                size_t count = _resolved_level_offsets[level + 1] - first;
+                auto resolve = [this, first](size_t begin, size_t end) {
+                    for (size_t i = first + begin; i < first + end; ++i)
+                    {
+                        Object *object = _resolved_objects[i];
+                        object->get_world_matrix();
+                        if (Mesh *mesh = object->as_mesh())
+                        {
+                            mesh->get_world_bounding_box();
+                        }
+                    }
+                };
+
+                if (job_system != nullptr)
+                {
+                    job_system->parallel_for(count, RESOLVE_GRAIN_SIZE, resolve);
+                }
+                else
+                {
+                    resolve(0, count);
+                }
+            }
+
+            // The enlarged box of the leaf still holds the bounds the mesh was moved out of.
+            for (Object *object : _resolved_objects)
+            {
+                if (Mesh *mesh = object->as_mesh())
+                {
+                    int proxy = mesh->get_bounding_volume_proxy();
+                    _record_change(*mesh, _bounding_volume_hierarchy.get_bounding_box(proxy), _changed_bounding_boxes);
+                    _record_change(*mesh, mesh->get_world_bounding_box(), _changed_bounding_boxes);
+                    _bounding_volume_hierarchy.update(proxy, mesh->get_world_bounding_box());
+                }
+            }
+        }
+
+        // Transparent meshes like particle systems move every frame and are not drawn into the shadow maps, so
+        // their changes are left out.
+        static void _record_change(Mesh &mesh, const AABB &box, std::vector<AABB> &changed_bounding_boxes)
+        {
+            const auto &material = mesh.get_material();
+            if (!material->is_transparent() && !material->is_overlay())
+            {
+                changed_bounding_boxes.push_back(box);
+            }
+        }
+    };
+}
+
+#endif
@@ -1,12 +1,15 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include "scene/render_list.h"
+#include "scene/transform_hierarchy.h"
 #include "objects/object.h"
 #include "objects/camera.h"
 #include "lights/ambient_light.h"
 #include "lights/directional_light.h"
 #include "lights/point_light.h"
 #include "lights/spot_light.h"
+#include "utilities/node_pool.h"
 
 #include <glm/glm.hpp>
 
@@ -20,15 +23,28 @@ namespace asr
     {
     public:
         explicit Scene(const std::vector<std::shared_ptr<Object>> &objects)
-            : _root{std::make_shared<Object>()}, _camera{std::make_shared<Camera>()},
-              _ambient_light{std::make_shared<AmbientLight>()}
+            : _root{create_node<Object>()}, _camera{create_node<Camera>()},
+              _ambient_light{create_node<AmbientLight>()}
         {
+            _root->set_scene_graph_listener(&_render_list);
             for (const auto &object : objects)
             {
                 _root->add_child(object);
             }
         }
 
+        Scene(const Scene &other) = delete;
+        Scene &operator=(const Scene &other) = delete;
+
+        ~Scene()
+        {
+            if (_root)
+            {
+                _root->set_scene_graph_listener(nullptr);
+                _root->set_transform_hierarchy(nullptr);
+            }
+        }
+
         [[nodiscard]] const glm::vec4 &get_clear_color() const
         {
             return _clear_color;
@@ -46,7 +62,41 @@ namespace asr
 
         void set_root(const std::shared_ptr<Object> &root)
         {
+            if (_root)
+            {
+                _root->set_scene_graph_listener(nullptr);
+                _root->set_transform_hierarchy(nullptr);
+            }
             _root = root;
+            if (_root)
+            {
+                _root->set_scene_graph_listener(&_render_list);
+                _root->set_transform_hierarchy(_transform_hierarchy_enabled ? &_transform_hierarchy : nullptr);
+            }
+        }
+
+        [[nodiscard]] bool is_transform_hierarchy_enabled() const
+        {
+            return _transform_hierarchy_enabled;
+        }
+
+        void set_transform_hierarchy_enabled(bool transform_hierarchy_enabled)
+        {
+            _transform_hierarchy_enabled = transform_hierarchy_enabled;
+            if (_root)
+            {
+                _root->set_transform_hierarchy(_transform_hierarchy_enabled ? &_transform_hierarchy : nullptr);
+            }
+        }
+
+        [[nodiscard]] TransformHierarchy &get_transform_hierarchy()
+        {
+            return _transform_hierarchy;
+        }
+
+        [[nodiscard]] RenderList &get_render_list()
+        {
+            return _render_list;
         }
 
         [[nodiscard]] const std::shared_ptr<Camera> &get_camera() const
@@ -102,6 +152,10 @@ namespace asr
     private:
         glm::vec4 _clear_color{0.0f};
 
+        RenderList _render_list;
+        TransformHierarchy _transform_hierarchy;
+        bool _transform_hierarchy_enabled{false};
+
         std::shared_ptr<Object> _root;
         std::shared_ptr<Camera> _camera;
 
@@ -0,0 +1,32 @@
+#ifndef SCENE_GRAPH_LISTENER_H
+#define SCENE_GRAPH_LISTENER_H
+
+namespace asr
+{
+    class Object;
+
+    class SceneGraphListener
+    {
+    public:
+        virtual ~SceneGraphListener() = default;
+
+        virtual void on_object_attached(Object &object) = 0;
+
+        virtual void on_object_detached(Object &object) = 0;
+
+        virtual void on_object_transformed(Object &object) = 0;
+
+        // Set by the listener while the world matrices of all attached objects are up to date, from the end of
+        // the update that resolved them until the next object is attached or transformed, so that reading them
+        // does not have to check the parents.
+        [[nodiscard]] bool are_world_matrices_resolved() const
+        {
+            return _world_matrices_resolved;
+        }
+
+    protected:
+        bool _world_matrices_resolved{false};
+    };
+}
+
+#endif
@@ -0,0 +1,1050 @@
+#ifndef SCENE_SNAPSHOT_H
+#define SCENE_SNAPSHOT_H
+
+#include "scene/scene.h"
+#include "objects/object.h"
+#include "objects/mesh.h"
+#include "objects/lod_mesh.h"
+#include "objects/camera.h"
+#include "lights/light.h"
+#include "lights/directional_light.h"
+#include "lights/point_light.h"
+#include "lights/spot_light.h"
+#include "geometries/geometry.h"
+#include "geometries/mesh_data.h"
+#include "materials/material.h"
+#include "materials/phong_material.h"
+#include "materials/constant_material.h"
+#include "textures/texture.h"
+#include "textures/texture_cache.h"
+#include "utilities/mapped_file.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Stores a whole scene in a binary scene file: the hierarchy with the transforms of its objects, the
+    // parameters of the meshes, materials, lights and camera, the light lists, the ambient light and the clear
+    // color. The geometries are written to mesh files next to the scene file, named after it, and the textures
+    // are referenced by the files they were loaded from, so only textures from the TextureLoader or the
+    // TextureCache can be stored. Instanced meshes and particle systems are not supported.
+    //
+    // The scene file is memory-mapped and read front to back. It holds little-endian records in order: the
+    // identifier and the version, the counts of the geometries, textures, materials, objects and lights, the
+    // geometry file names, the texture references, the materials, the objects in pre-order with the index of
+    // their parent, and the light lists as object indices. All objects are allocated from a single block, the
+    // geometries are mapped with MeshData::read_mesh_file() and the textures are requested from the
+    // TextureCache, so they are decoded in the background once the scene is read.
+    class SceneSnapshot
+    {
+    public:
+        template <typename GeometryType, typename TextureType, typename PhongMaterialType, typename ConstantMaterialType>
+        static std::shared_ptr<Scene> read_scene_file(const std::string &path)
+        {
+            std::shared_ptr<Scene> scene;
+            if (!try_read_scene_file<GeometryType, TextureType, PhongMaterialType, ConstantMaterialType>(path, scene))
+            {
+                std::exit(-1);
+            }
+
+            return scene;
+        }
+
+        template <typename GeometryType, typename TextureType, typename PhongMaterialType, typename ConstantMaterialType>
+        static bool try_read_scene_file(const std::string &path, std::shared_ptr<Scene> &scene)
+        {
+            MappedFile file;
+            if (!file.open(path))
+            {
+                std::cerr << "Failed to open the file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            Reader reader{file.get_data(), file.get_size()};
+            uint8_t identifier[sizeof(IDENTIFIER)];
+            for (uint8_t &byte : identifier)
+            {
+                byte = reader.read<uint8_t>();
+            }
+            if (std::memcmp(identifier, IDENTIFIER, sizeof(IDENTIFIER)) != 0 || reader.read<uint32_t>() != VERSION)
+            {
+                std::cerr << "Invalid scene file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            auto geometry_count = reader.read<uint32_t>();
+            auto texture_count = reader.read<uint32_t>();
+            auto material_count = reader.read<uint32_t>();
+            auto node_count = reader.read<uint32_t>();
+            auto directional_light_count = reader.read<uint32_t>();
+            auto point_light_count = reader.read<uint32_t>();
+            auto spot_light_count = reader.read<uint32_t>();
+            auto camera_index = reader.read<uint32_t>();
+            bool transform_hierarchy_enabled = reader.read_bool();
+            auto clear_color = reader.read<glm::vec4>();
+            auto ambient_color = reader.read<glm::vec3>();
+
+            // Every record takes at least four bytes, which bounds the counts before anything is reserved.
+            size_t record_limit = file.get_size() / 4;
+            if (!reader.is_valid() || geometry_count > record_limit || texture_count > record_limit ||
+                material_count > record_limit || node_count > record_limit || directional_light_count > record_limit ||
+                point_light_count > record_limit || spot_light_count > record_limit)
+            {
+                std::cerr << "Invalid scene file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            std::string directory = _get_directory(path);
+            std::vector<std::shared_ptr<Geometry>> geometries;
+            geometries.reserve(geometry_count);
+            for (uint32_t i = 0; i < geometry_count; ++i)
+            {
+                std::string file_name = reader.read_string();
+                if (!reader.is_valid())
+                {
+                    break;
+                }
+
+                auto mesh_data = std::make_shared<MeshData>();
+                if (!mesh_data->open_mesh_file(directory + file_name))
+                {
+                    return false;
+                }
+                geometries.push_back(std::make_shared<GeometryType>(std::move(mesh_data)));
+            }
+
+            std::vector<std::shared_ptr<Texture>> textures;
+            textures.reserve(texture_count);
+            for (uint32_t i = 0; i < texture_count; ++i)
+            {
+                std::string texture_path = reader.read_string();
+                TextureCache::Sampling sampling;
+                sampling.wrap_mode_s = reader.read_enum(Texture::ClampToEdge);
+                sampling.wrap_mode_t = reader.read_enum(Texture::ClampToEdge);
+                sampling.minification_filter = reader.read_enum(Texture::LinearMipmapLinear);
+                sampling.magnification_filter = reader.read_enum(Texture::LinearMipmapLinear);
+                sampling.anisotropy = reader.read<float>();
+                sampling.mipmaps_enabled = reader.read_bool();
+                auto mode = reader.read_enum(Texture::Decaling);
+                bool enabled = reader.read_bool();
+                bool transformation_enabled = reader.read_bool();
+                auto transformation_matrix = reader.read<glm::mat4>();
+                if (!reader.is_valid())
+                {
+                    break;
+                }
+
+                auto texture = TextureCache::get_instance().get<TextureType>(texture_path, sampling);
+                texture->set_mode(mode);
+                texture->set_enabled(enabled);
+                texture->set_transformation_enabled(transformation_enabled);
+                texture->set_transformation_matrix(transformation_matrix);
+                textures.push_back(std::move(texture));
+            }
+
+            auto read_texture = [&reader, &textures]() -> std::shared_ptr<Texture> {
+                auto index = reader.read<uint32_t>();
+                if (index == NO_INDEX)
+                {
+                    return nullptr;
+                }
+                if (index >= textures.size())
+                {
+                    reader.invalidate();
+                    return nullptr;
+                }
+
+                return textures[index];
+            };
+
+            std::vector<std::shared_ptr<Material>> materials;
+            materials.reserve(material_count);
+            for (uint32_t i = 0; i < material_count && reader.is_valid(); ++i)
+            {
+                auto kind = reader.read<uint32_t>();
+                if (kind == PhongMaterialKind)
+                {
+                    auto material = std::make_shared<PhongMaterialType>();
+                    _read_material_state(reader, *material);
+                    material->set_ambient_color(reader.read<glm::vec3>());
+                    material->set_diffuse_color(reader.read<glm::vec4>());
+                    material->set_emission_color(reader.read<glm::vec4>());
+                    material->set_specular_color(reader.read<glm::vec3>());
+                    material->set_specular_exponent(reader.read<float>());
+                    material->set_texture_1(read_texture());
+                    material->set_texture_1_normals(read_texture());
+                    material->set_texture_2(read_texture());
+                    materials.push_back(std::move(material));
+                }
+                else if (kind == ConstantMaterialKind)
+                {
+                    auto material = std::make_shared<ConstantMaterialType>();
+                    _read_material_state(reader, *material);
+                    material->set_emission_color(reader.read<glm::vec4>());
+                    material->set_texture_1(read_texture());
+                    material->set_texture_2(read_texture());
+                    materials.push_back(std::move(material));
+                }
+                else
+                {
+                    reader.invalidate();
+                }
+            }
+
+            auto read_geometry = [&reader, &geometries]() -> std::shared_ptr<Geometry> {
+                auto index = reader.read<uint32_t>();
+                if (index >= geometries.size())
+                {
+                    reader.invalidate();
+                    return nullptr;
+                }
+
+                return geometries[index];
+            };
+            auto read_material = [&reader, &materials]() -> std::shared_ptr<Material> {
+                auto index = reader.read<uint32_t>();
+                if (index >= materials.size())
+                {
+                    reader.invalidate();
+                    return nullptr;
+                }
+
+                return materials[index];
+            };
+
+            auto node_block = std::make_shared<NodeBlock>(static_cast<size_t>(node_count) * NODE_ALLOCATION_SIZE);
+            std::vector<std::shared_ptr<Object>> nodes;
+            std::vector<uint32_t> node_kinds;
+            std::vector<std::shared_ptr<Object>> objects;
+            nodes.reserve(node_count);
+            node_kinds.reserve(node_count);
+            for (uint32_t i = 0; i < node_count && reader.is_valid(); ++i)
+            {
+                auto kind = reader.read<uint32_t>();
+                auto parent = reader.read<uint32_t>();
+                std::string name = reader.read_string();
+                auto position = reader.read<glm::vec3>();
+                auto rotation = reader.read<glm::vec3>();
+                auto scale = reader.read<glm::vec3>();
+                auto up = reader.read<glm::vec3>();
+                if (parent != NO_PARENT && parent != DETACHED && parent >= i)
+                {
+                    reader.invalidate();
+                }
+
+                std::shared_ptr<Object> node;
+                switch (kind)
+                {
+                    case ObjectNode:
+                    {
+                        node = std::allocate_shared<Object>(NodeAllocator<Object>{node_block}, std::move(name),
+                                                            position, rotation, scale);
+                        break;
+                    }
+                    case MeshNode:
+                    {
+                        auto geometry = read_geometry();
+                        auto material = read_material();
+                        auto casting_shadows = reader.read_bool();
+                        if (reader.is_valid())
+                        {
+                            auto mesh = std::allocate_shared<Mesh>(NodeAllocator<Mesh>{node_block}, std::move(geometry),
+                                                                   std::move(material), position, rotation, scale);
+                            mesh->set_casting_shadows(casting_shadows);
+                            mesh->set_name(name);
+                            node = std::move(mesh);
+                        }
+                        break;
+                    }
+                    case LODMeshNode:
+                    {
+                        auto geometry = read_geometry();
+                        auto material = read_material();
+                        auto casting_shadows = reader.read_bool();
+                        auto level_count = reader.read<uint32_t>();
+                        auto hysteresis = reader.read<float>();
+                        if (!reader.is_valid() || level_count == 0 || level_count > record_limit)
+                        {
+                            reader.invalidate();
+                            break;
+                        }
+
+                        auto lod_mesh = std::allocate_shared<LODMesh>(NodeAllocator<LODMesh>{node_block}, geometry,
+                                                                      std::move(material), position, rotation, scale);
+                        auto previous_screen_size = lod_mesh->get_level_screen_size(0);
+                        for (uint32_t level = 1; level < level_count && reader.is_valid(); ++level)
+                        {
+                            auto level_geometry = read_geometry();
+                            auto screen_size = reader.read<float>();
+                            if (!reader.is_valid() || !(screen_size < previous_screen_size))
+                            {
+                                reader.invalidate();
+                                break;
+                            }
+                            lod_mesh->add_level(std::move(level_geometry), screen_size);
+                            previous_screen_size = screen_size;
+                        }
+                        lod_mesh->set_hysteresis(hysteresis);
+                        lod_mesh->set_casting_shadows(casting_shadows);
+                        lod_mesh->set_name(name);
+                        node = std::move(lod_mesh);
+                        break;
+                    }
+                    case CameraNode:
+                    {
+                        auto camera = std::allocate_shared<Camera>(NodeAllocator<Camera>{node_block});
+                        camera->set_perspective(reader.read_bool());
+                        camera->set_receive_aspect_ratio_from_renderer(reader.read_bool());
+                        camera->set_aspect_ratio(reader.read<float>());
+                        camera->set_field_of_view(reader.read<float>());
+                        camera->set_near_plane(reader.read<float>());
+                        camera->set_far_plane(reader.read<float>());
+                        camera->set_viewport(reader.read<glm::vec4>());
+                        camera->set_receive_viewport_from_renderer(reader.read_bool());
+                        camera->set_zoom(reader.read<float>());
+                        node = std::move(camera);
+                        _set_transform(*node, name, position, rotation, scale);
+                        break;
+                    }
+                    case DirectionalLightNode:
+                    {
+                        auto light = std::allocate_shared<DirectionalLight>(NodeAllocator<DirectionalLight>{node_block});
+                        _read_light_state(reader, *light);
+                        light->set_direction(reader.read<glm::vec3>());
+                        light->set_shadow_cascade_count(reader.read<uint32_t>());
+                        light->set_shadow_distance(reader.read<float>());
+                        node = std::move(light);
+                        _set_transform(*node, name, position, rotation, scale);
+                        break;
+                    }
+                    case PointLightNode:
+                    {
+                        auto light = std::allocate_shared<PointLight>(NodeAllocator<PointLight>{node_block});
+                        _read_light_state(reader, *light);
+                        _read_attenuation(reader, *light);
+                        node = std::move(light);
+                        _set_transform(*node, name, position, rotation, scale);
+                        break;
+                    }
+                    case SpotLightNode:
+                    {
+                        auto light = std::allocate_shared<SpotLight>(NodeAllocator<SpotLight>{node_block});
+                        _read_light_state(reader, *light);
+                        _read_attenuation(reader, *light);
+                        light->set_direction(reader.read<glm::vec3>());
+                        light->set_exponent(reader.read<float>());
+                        light->set_cutoff_angle(reader.read<float>());
+                        node = std::move(light);
+                        _set_transform(*node, name, position, rotation, scale);
+                        break;
+                    }
+                    default:
+                    {
+                        reader.invalidate();
+                        break;
+                    }
+                }
+                if (!reader.is_valid())
+                {
+                    break;
+                }
+
+                node->set_up(up);
+                if (parent == NO_PARENT)
+                {
+                    objects.push_back(node);
+                }
+                else if (parent != DETACHED)
+                {
+                    nodes[parent]->add_child(node);
+                }
+                nodes.push_back(std::move(node));
+                node_kinds.push_back(kind);
+            }
+
+            auto read_light_list = [&reader, &nodes, &node_kinds](uint32_t count, uint32_t kind, auto &lights) {
+                using light_type = typename std::decay_t<decltype(lights)>::value_type::element_type;
+                lights.reserve(count);
+                for (uint32_t i = 0; i < count && reader.is_valid(); ++i)
+                {
+                    auto index = reader.read<uint32_t>();
+                    if (index >= nodes.size() || node_kinds[index] != kind)
+                    {
+                        reader.invalidate();
+                        break;
+                    }
+                    lights.push_back(std::static_pointer_cast<light_type>(nodes[index]));
+                }
+            };
+            std::vector<std::shared_ptr<DirectionalLight>> directional_lights;
+            std::vector<std::shared_ptr<PointLight>> point_lights;
+            std::vector<std::shared_ptr<SpotLight>> spot_lights;
+            read_light_list(directional_light_count, DirectionalLightNode, directional_lights);
+            read_light_list(point_light_count, PointLightNode, point_lights);
+            read_light_list(spot_light_count, SpotLightNode, spot_lights);
+            if (camera_index != NO_INDEX && (camera_index >= nodes.size() || node_kinds[camera_index] != CameraNode))
+            {
+                reader.invalidate();
+            }
+
+            if (!reader.is_valid() || nodes.size() != node_count)
+            {
+                std::cerr << "Invalid scene file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            scene = std::make_shared<Scene>(objects);
+            scene->set_clear_color(clear_color);
+            scene->get_ambient_light()->set_ambient_color(ambient_color);
+            if (camera_index != NO_INDEX)
+            {
+                scene->set_camera(std::static_pointer_cast<Camera>(nodes[camera_index]));
+            }
+            scene->get_directional_lights() = std::move(directional_lights);
+            scene->get_point_lights() = std::move(point_lights);
+            scene->get_spot_lights() = std::move(spot_lights);
+            scene->set_transform_hierarchy_enabled(transform_hierarchy_enabled);
+
+            return true;
+        }
+
+        // The geometries are written to "<path>.<index>.mesh" in the directory of the scene file.
+        static bool write_scene_file(const std::string &path, Scene &scene)
+        {
+            std::vector<std::pair<Object *, uint32_t>> typed_nodes;
+            if (scene.get_camera())
+            {
+                typed_nodes.emplace_back(scene.get_camera().get(), CameraNode);
+            }
+            for (const auto &light : scene.get_directional_lights())
+            {
+                typed_nodes.emplace_back(light.get(), DirectionalLightNode);
+            }
+            for (const auto &light : scene.get_point_lights())
+            {
+                typed_nodes.emplace_back(light.get(), PointLightNode);
+            }
+            for (const auto &light : scene.get_spot_lights())
+            {
+                typed_nodes.emplace_back(light.get(), SpotLightNode);
+            }
+            std::unordered_map<const Object *, uint32_t> node_kinds{typed_nodes.begin(), typed_nodes.end()};
+
+            // The camera and the lights of the lists that are not part of the hierarchy are stored without a
+            // parent, so they are restored outside of it as well.
+            std::vector<Object *> nodes;
+            std::vector<uint32_t> parents;
+            std::unordered_map<const Object *, uint32_t> node_indices;
+            for (const auto &child : scene.get_root()->get_children())
+            {
+                _collect_nodes(child.get(), NO_PARENT, nodes, parents, node_indices);
+            }
+            for (const auto &[object, kind] : typed_nodes)
+            {
+                if (node_indices.find(object) == node_indices.end())
+                {
+                    _collect_nodes(object, DETACHED, nodes, parents, node_indices);
+                }
+            }
+
+            std::vector<Geometry *> geometries;
+            std::unordered_map<const Geometry *, uint32_t> geometry_indices;
+            auto get_geometry_index = [&geometries, &geometry_indices](const std::shared_ptr<Geometry> &geometry) {
+                auto [entry, inserted] = geometry_indices.emplace(geometry.get(), static_cast<uint32_t>(geometries.size()));
+                if (inserted)
+                {
+                    geometries.push_back(geometry.get());
+                }
+
+                return entry->second;
+            };
+
+            std::vector<Texture *> textures;
+            std::unordered_map<const Texture *, uint32_t> texture_indices;
+            bool textures_valid{true};
+            auto get_texture_index = [&textures, &texture_indices, &textures_valid](const std::shared_ptr<Texture> &texture) {
+                if (!texture)
+                {
+                    return NO_INDEX;
+                }
+                if (texture->get_path().empty())
+                {
+                    textures_valid = false;
+                    return NO_INDEX;
+                }
+
+                auto [entry, inserted] = texture_indices.emplace(texture.get(), static_cast<uint32_t>(textures.size()));
+                if (inserted)
+                {
+                    textures.push_back(texture.get());
+                }
+
+                return entry->second;
+            };
+
+            std::vector<uint8_t> material_data;
+            std::vector<Material *> materials;
+            std::unordered_map<const Material *, uint32_t> material_indices;
+            bool materials_valid{true};
+            auto get_material_index = [&](const std::shared_ptr<Material> &material) {
+                auto [entry, inserted] = material_indices.emplace(material.get(), static_cast<uint32_t>(materials.size()));
+                if (!inserted)
+                {
+                    return entry->second;
+                }
+
+                materials.push_back(material.get());
+                if (PhongMaterial *phong_material = material->as_phong_material())
+                {
+                    _write<uint32_t>(material_data, PhongMaterialKind);
+                    _write_material_state(material_data, *material);
+                    _write(material_data, phong_material->get_ambient_color());
+                    _write(material_data, phong_material->get_diffuse_color());
+                    _write(material_data, phong_material->get_emission_color());
+                    _write(material_data, phong_material->get_specular_color());
+                    _write(material_data, phong_material->get_specular_exponent());
+                    _write(material_data, get_texture_index(phong_material->get_texture_1()));
+                    _write(material_data, get_texture_index(phong_material->get_texture_1_normals()));
+                    _write(material_data, get_texture_index(phong_material->get_texture_2()));
+                }
+                else if (ConstantMaterial *constant_material = material->as_constant_material())
+                {
+                    _write<uint32_t>(material_data, ConstantMaterialKind);
+                    _write_material_state(material_data, *material);
+                    _write(material_data, constant_material->get_emission_color());
+                    _write(material_data, get_texture_index(constant_material->get_texture_1()));
+                    _write(material_data, get_texture_index(constant_material->get_texture_2()));
+                }
+                else
+                {
+                    materials_valid = false;
+                }
+
+                return entry->second;
+            };
+
+            std::vector<uint8_t> node_data;
+            for (size_t i = 0; i < nodes.size(); ++i)
+            {
+                Object &node = *nodes[i];
+                Mesh *mesh = node.as_mesh();
+                auto kind_entry = node_kinds.find(&node);
+                uint32_t kind = kind_entry != node_kinds.end() ? kind_entry->second : ObjectNode;
+                if (mesh != nullptr)
+                {
+                    if (mesh->as_instanced_mesh() != nullptr || mesh->as_particle_system() != nullptr)
+                    {
+                        std::cerr << "Failed to write the scene file: '" << path << "', instanced meshes and particle systems can not be stored." << std::endl;
+                        return false;
+                    }
+                    kind = mesh->as_lod_mesh() != nullptr ? LODMeshNode : MeshNode;
+                }
+
+                _write(node_data, kind);
+                _write(node_data, parents[i]);
+                _write_string(node_data, node.get_name());
+                _write(node_data, node.get_position());
+                _write(node_data, node.get_rotation());
+                _write(node_data, node.get_scale());
+                _write(node_data, node.get_up());
+                if (kind == MeshNode)
+                {
+                    _write(node_data, get_geometry_index(mesh->get_geometry()));
+                    _write(node_data, get_material_index(mesh->get_material()));
+                    _write_bool(node_data, mesh->is_casting_shadows());
+                }
+                else if (kind == LODMeshNode)
+                {
+                    LODMesh &lod_mesh = *mesh->as_lod_mesh();
+                    _write(node_data, get_geometry_index(lod_mesh.get_level_geometry(0)));
+                    _write(node_data, get_material_index(lod_mesh.get_material()));
+                    _write_bool(node_data, lod_mesh.is_casting_shadows());
+                    _write(node_data, static_cast<uint32_t>(lod_mesh.get_level_count()));
+                    _write(node_data, lod_mesh.get_hysteresis());
+                    for (size_t level = 1; level < lod_mesh.get_level_count(); ++level)
+                    {
+                        _write(node_data, get_geometry_index(lod_mesh.get_level_geometry(level)));
+                        _write(node_data, lod_mesh.get_level_screen_size(level));
+                    }
+                }
+                else if (kind == CameraNode)
+                {
+                    auto &camera = static_cast<Camera &>(node);
+                    _write_bool(node_data, camera.is_perspective());
+                    _write_bool(node_data, camera.should_receive_aspect_ratio_from_renderer());
+                    _write(node_data, camera.get_aspect_ratio());
+                    _write(node_data, camera.get_field_of_view());
+                    _write(node_data, camera.get_near_plane());
+                    _write(node_data, camera.get_far_plane());
+                    _write(node_data, camera.get_viewport());
+                    _write_bool(node_data, camera.should_receive_viewport_from_renderer());
+                    _write(node_data, camera.get_zoom());
+                }
+                else if (kind == DirectionalLightNode)
+                {
+                    auto &light = static_cast<DirectionalLight &>(node);
+                    _write_light_state(node_data, light);
+                    _write(node_data, light.get_direction());
+                    _write(node_data, static_cast<uint32_t>(light.get_shadow_cascade_count()));
+                    _write(node_data, light.get_shadow_distance());
+                }
+                else if (kind == PointLightNode)
+                {
+                    auto &light = static_cast<PointLight &>(node);
+                    _write_light_state(node_data, light);
+                    _write_attenuation(node_data, light);
+                }
+                else if (kind == SpotLightNode)
+                {
+                    auto &light = static_cast<SpotLight &>(node);
+                    _write_light_state(node_data, light);
+                    _write_attenuation(node_data, light);
+                    _write(node_data, light.get_direction());
+                    _write(node_data, light.get_exponent());
+                    _write(node_data, light.get_cutoff_angle());
+                }
+            }
+            if (!materials_valid)
+            {
+                std::cerr << "Failed to write the scene file: '" << path << "', only Phong and constant materials can be stored." << std::endl;
+                return false;
+            }
+            if (!textures_valid)
+            {
+                std::cerr << "Failed to write the scene file: '" << path << "', textures that were not loaded from files can not be stored." << std::endl;
+                return false;
+            }
+
+            std::vector<uint8_t> data(IDENTIFIER, IDENTIFIER + sizeof(IDENTIFIER));
+            _write(data, VERSION);
+            _write(data, static_cast<uint32_t>(geometries.size()));
+            _write(data, static_cast<uint32_t>(textures.size()));
+            _write(data, static_cast<uint32_t>(materials.size()));
+            _write(data, static_cast<uint32_t>(nodes.size()));
+            _write(data, static_cast<uint32_t>(scene.get_directional_lights().size()));
+            _write(data, static_cast<uint32_t>(scene.get_point_lights().size()));
+            _write(data, static_cast<uint32_t>(scene.get_spot_lights().size()));
+            _write(data, scene.get_camera() ? node_indices[scene.get_camera().get()] : NO_INDEX);
+            _write_bool(data, scene.is_transform_hierarchy_enabled());
+            _write(data, scene.get_clear_color());
+            _write(data, scene.get_ambient_light()->get_ambient_color());
+
+            std::string file_name = path.substr(_get_directory(path).size());
+            for (size_t i = 0; i < geometries.size(); ++i)
+            {
+                std::string geometry_file_name = file_name + "." + std::to_string(i) + ".mesh";
+                if (!geometries[i]->write_mesh_file(_get_directory(path) + geometry_file_name))
+                {
+                    return false;
+                }
+                _write_string(data, geometry_file_name);
+            }
+            for (Texture *texture : textures)
+            {
+                _write_string(data, texture->get_path());
+                _write(data, static_cast<uint32_t>(texture->get_wrap_mode_s()));
+                _write(data, static_cast<uint32_t>(texture->get_wrap_mode_t()));
+                _write(data, static_cast<uint32_t>(texture->get_minification_filter()));
+                _write(data, static_cast<uint32_t>(texture->get_magnification_filter()));
+                _write(data, texture->get_anisotropy());
+                _write_bool(data, texture->are_mipmaps_enabled());
+                _write(data, static_cast<uint32_t>(texture->get_mode()));
+                _write_bool(data, texture->is_enabled());
+                _write_bool(data, texture->is_transformation_enabled());
+                _write(data, texture->get_transformation_matrix());
+            }
+            data.insert(data.end(), material_data.begin(), material_data.end());
+            data.insert(data.end(), node_data.begin(), node_data.end());
+            for (const auto &light : scene.get_directional_lights())
+            {
+                _write(data, node_indices[light.get()]);
+            }
+            for (const auto &light : scene.get_point_lights())
+            {
+                _write(data, node_indices[light.get()]);
+            }
+            for (const auto &light : scene.get_spot_lights())
+            {
+                _write(data, node_indices[light.get()]);
+            }
+
+            std::ofstream file_stream{path, std::ios::binary};
+            if (!file_stream.is_open())
+            {
+                std::cerr << "Failed to open the file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            file_stream.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file_stream)
+            {
+                std::cerr << "Failed to write the file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            return true;
+        }
+
+    private:
+        inline static const uint8_t IDENTIFIER[4]{'A', 'S', 'R', 'S'};
+        inline static const uint32_t VERSION = 2;
+        inline static const uint32_t NO_INDEX = 0xFFFFFFFFu;
+        inline static const uint32_t NO_PARENT = 0xFFFFFFFFu;
+        inline static const uint32_t DETACHED = 0xFFFFFFFEu;
+
+        enum MaterialKind : uint32_t
+        {
+            PhongMaterialKind,
+            ConstantMaterialKind
+        };
+
+        enum NodeKind : uint32_t
+        {
+            ObjectNode,
+            MeshNode,
+            LODMeshNode,
+            CameraNode,
+            DirectionalLightNode,
+            PointLightNode,
+            SpotLightNode
+        };
+
+        // Room for the largest node and the control block of its shared pointer.
+        inline static const size_t NODE_ALLOCATION_SIZE =
+            std::max({sizeof(Object), sizeof(Mesh), sizeof(LODMesh), sizeof(Camera),
+                      sizeof(DirectionalLight), sizeof(PointLight), sizeof(SpotLight)}) + 64;
+
+        // The memory the objects of a scene are allocated from. Every object keeps the block alive through its
+        // allocator, so it is released with the last of them. Allocations that do not fit come from the heap.
+        struct NodeBlock
+        {
+            explicit NodeBlock(size_t capacity)
+                : data{std::make_unique<uint8_t[]>(capacity)}, capacity{capacity}
+            {
+            }
+
+            std::unique_ptr<uint8_t[]> data;
+            size_t capacity;
+            size_t offset{0};
+        };
+
+        template <typename T>
+        struct NodeAllocator
+        {
+            typedef T value_type;
+
+            explicit NodeAllocator(std::shared_ptr<NodeBlock> block) : block{std::move(block)} {}
+
+            template <typename U>
+            NodeAllocator(const NodeAllocator<U> &other) : block{other.block} {}
+
+            T *allocate(size_t count)
+            {
+                size_t size = count * sizeof(T);
+                auto address = reinterpret_cast<uintptr_t>(block->data.get()) + block->offset;
+                size_t padding = (alignof(T) - address % alignof(T)) % alignof(T);
+                if (block->offset + padding + size <= block->capacity)
+                {
+                    block->offset += padding + size;
+                    return reinterpret_cast<T *>(block->data.get() + (block->offset - size));
+                }
+
+                return std::allocator<T>{}.allocate(count);
+            }
+
+            void deallocate(T *pointer, size_t count)
+            {
+                auto bytes = reinterpret_cast<const uint8_t *>(pointer);
+                if (bytes < block->data.get() || bytes >= block->data.get() + block->capacity)
+                {
+                    std::allocator<T>{}.deallocate(pointer, count);
+                }
+            }
+
+            template <typename U>
+            bool operator==(const NodeAllocator<U> &other) const
+            {
+                return block == other.block;
+            }
+
+            template <typename U>
+            bool operator!=(const NodeAllocator<U> &other) const
+            {
+                return block != other.block;
+            }
+
+            std::shared_ptr<NodeBlock> block;
+        };
+
+        // Reads the records in order. Reading past the end or finding an invalid value marks the reader as
+        // invalid and returns zeros from then on, so the records are checked once they are complete.
+        class Reader
+        {
+        public:
+            Reader(const uint8_t *data, size_t size) : _data{data}, _size{size} {}
+
+            template <typename T>
+            T read()
+            {
+                static_assert(std::is_trivially_copyable_v<T>, "only plain values are stored in scene files");
+
+                T value{};
+                if (_valid && _offset + sizeof(T) <= _size)
+                {
+                    std::memcpy(&value, _data + _offset, sizeof(T));
+                    _offset += sizeof(T);
+                }
+                else
+                {
+                    _valid = false;
+                }
+
+                return value;
+            }
+
+            bool read_bool()
+            {
+                return read<uint32_t>() != 0;
+            }
+
+            template <typename EnumType>
+            EnumType read_enum(EnumType last)
+            {
+                auto value = read<uint32_t>();
+                if (value > static_cast<uint32_t>(last))
+                {
+                    _valid = false;
+                    return last;
+                }
+
+                return static_cast<EnumType>(value);
+            }
+
+            std::string read_string()
+            {
+                auto length = read<uint32_t>();
+                if (!_valid || length > _size - _offset)
+                {
+                    _valid = false;
+                    return {};
+                }
+
+                std::string value{reinterpret_cast<const char *>(_data + _offset), length};
+                _offset += length;
+
+                return value;
+            }
+
+            void invalidate()
+            {
+                _valid = false;
+            }
+
+            [[nodiscard]] bool is_valid() const
+            {
+                return _valid;
+            }
+
+        private:
+            const uint8_t *_data;
+            size_t _size;
+            size_t _offset{0};
+            bool _valid{true};
+        };
+
+        static void _collect_nodes(Object *object, uint32_t parent, std::vector<Object *> &nodes,
+                                   std::vector<uint32_t> &parents,
+                                   std::unordered_map<const Object *, uint32_t> &node_indices)
+        {
+            std::vector<std::pair<Object *, uint32_t>> stack{{object, parent}};
+            while (!stack.empty())
+            {
+                auto [node, node_parent] = stack.back();
+                stack.pop_back();
+
+                auto index = static_cast<uint32_t>(nodes.size());
+                node_indices[node] = index;
+                nodes.push_back(node);
+                parents.push_back(node_parent);
+
+                const auto &children = node->get_children();
+                for (auto child = children.rbegin(); child != children.rend(); ++child)
+                {
+                    stack.emplace_back(child->get(), index);
+                }
+            }
+        }
+
+        static std::string _get_directory(const std::string &path)
+        {
+            size_t separator = path.find_last_of("/\\");
+
+            return separator == std::string::npos ? std::string{} : path.substr(0, separator + 1);
+        }
+
+        static void _set_transform(Object &object, const std::string &name, const glm::vec3 &position,
+                                   const glm::vec3 &rotation, const glm::vec3 &scale)
+        {
+            object.set_name(name);
+            object.set_position(position);
+            object.set_rotation(rotation);
+            object.set_scale(scale);
+        }
+
+        template <typename T>
+        static void _write(std::vector<uint8_t> &data, const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "only plain values are stored in scene files");
+
+            size_t offset = data.size();
+            data.resize(offset + sizeof(T));
+            std::memcpy(data.data() + offset, &value, sizeof(T));
+        }
+
+        static void _write_bool(std::vector<uint8_t> &data, bool value)
+        {
+            _write<uint32_t>(data, value ? 1u : 0u);
+        }
+
+        static void _write_string(std::vector<uint8_t> &data, const std::string &value)
+        {
+            _write(data, static_cast<uint32_t>(value.size()));
+            data.insert(data.end(), value.begin(), value.end());
+        }
+
+        static void _write_material_state(std::vector<uint8_t> &data, const Material &material)
+        {
+            _write(data, material.get_line_width());
+            _write_bool(data, material.prefer_line_width_from_geometry());
+            _write_bool(data, material.is_point_sizing_enabled());
+            _write(data, material.get_point_size());
+            _write_bool(data, material.prefer_point_size_from_geometry());
+            _write_bool(data, material.is_depth_mask_enabled());
+            _write_bool(data, material.is_depth_test_enabled());
+            _write(data, static_cast<uint32_t>(material.get_depth_test_function()));
+            _write_bool(data, material.is_blending_enabled());
+            _write(data, static_cast<uint32_t>(material.get_color_blending_equation()));
+            _write(data, static_cast<uint32_t>(material.get_alpha_blending_equation()));
+            _write(data, static_cast<uint32_t>(material.get_source_color_blending_function()));
+            _write(data, static_cast<uint32_t>(material.get_source_alpha_blending_function()));
+            _write(data, static_cast<uint32_t>(material.get_destination_color_blending_function()));
+            _write(data, static_cast<uint32_t>(material.get_destination_alpha_blending_function()));
+            _write(data, material.get_blending_constant_color());
+            _write_bool(data, material.is_face_culling_enabled());
+            _write(data, static_cast<uint32_t>(material.get_cull_face_mode()));
+            _write(data, static_cast<uint32_t>(material.get_front_face_order()));
+            _write_bool(data, material.is_polygon_offset_enabled());
+            _write(data, material.get_polygon_offset_factor());
+            _write(data, material.get_polygon_offset_units());
+            _write_bool(data, material.is_fog_enabled());
+            _write(data, static_cast<uint32_t>(material.get_fog_type()));
+            _write(data, static_cast<uint32_t>(material.get_fog_depth()));
+            _write(data, material.get_fog_color());
+            _write(data, material.get_fog_near_plane());
+            _write(data, material.get_fog_far_plane());
+            _write(data, material.get_fog_density());
+            _write_bool(data, material.is_transparent());
+            _write_bool(data, material.is_overlay());
+            _write(data, static_cast<int32_t>(material.get_overlay_priority()));
+        }
+
+        static void _read_material_state(Reader &reader, Material &material)
+        {
+            material.set_line_width(reader.read<float>());
+            material.set_prefer_line_width_from_geometry(reader.read_bool());
+            material.set_point_sizing_enabled(reader.read_bool());
+            material.set_point_size(reader.read<float>());
+            material.set_prefer_point_size_from_geometry(reader.read_bool());
+            material.set_depth_mask_enabled(reader.read_bool());
+            material.set_depth_test_enabled(reader.read_bool());
+            material.set_depth_test_function(reader.read_enum(Material::NotEqual));
+            material.set_blending_enabled(reader.read_bool());
+            material.set_color_blending_equation(reader.read_enum(Material::ReverseSubtraction));
+            material.set_alpha_blending_equation(reader.read_enum(Material::ReverseSubtraction));
+            material.set_source_color_blending_function(reader.read_enum(Material::SourceAlphaSaturate));
+            material.set_source_alpha_blending_function(reader.read_enum(Material::SourceAlphaSaturate));
+            material.set_destination_color_blending_function(reader.read_enum(Material::SourceAlphaSaturate));
+            material.set_destination_alpha_blending_function(reader.read_enum(Material::SourceAlphaSaturate));
+            material.set_blending_constant_color(reader.read<glm::vec4>());
+            material.set_face_culling_enabled(reader.read_bool());
+            material.set_cull_face_mode(reader.read_enum(Material::CullFrontAndBackFaces));
+            material.set_front_face_order(reader.read_enum(Material::Counterclockwise));
+            material.set_polygon_offset_enabled(reader.read_bool());
+            material.set_polygon_offset_factor(reader.read<float>());
+            material.set_polygon_offset_units(reader.read<float>());
+            material.set_fog_enabled(reader.read_bool());
+            material.set_fog_type(reader.read_enum(Material::Exp2));
+            material.set_fog_depth(reader.read_enum(Material::Radial));
+            material.set_fog_color(reader.read<glm::vec3>());
+            material.set_fog_near_plane(reader.read<float>());
+            material.set_fog_far_plane(reader.read<float>());
+            material.set_fog_density(reader.read<float>());
+            material.set_transparent(reader.read_bool());
+            material.set_overlay(reader.read_bool());
+            material.set_overlay_priority(reader.read<int32_t>());
+        }
+
+        static void _write_light_state(std::vector<uint8_t> &data, const Light &light)
+        {
+            _write_bool(data, light.is_enabled());
+            _write(data, light.get_ambient_color());
+            _write(data, light.get_diffuse_color());
+            _write(data, light.get_specular_color());
+            _write(data, light.get_intensity());
+            _write_bool(data, light.is_two_sided());
+            _write_bool(data, light.is_casting_shadows());
+            _write(data, light.get_shadow_bias());
+        }
+
+        static void _read_light_state(Reader &reader, Light &light)
+        {
+            light.set_enabled(reader.read_bool());
+            light.set_ambient_color(reader.read<glm::vec3>());
+            light.set_diffuse_color(reader.read<glm::vec3>());
+            light.set_specular_color(reader.read<glm::vec3>());
+            light.set_intensity(reader.read<float>());
+            light.set_two_sided(reader.read_bool());
+            light.set_casting_shadows(reader.read_bool());
+            light.set_shadow_bias(reader.read<float>());
+        }
+
+        // Point and spot lights share their attenuation parameters without sharing a base class.
+        template <typename LightType>
+        static void _write_attenuation(std::vector<uint8_t> &data, const LightType &light)
+        {
+            _write(data, light.get_attenuation_distance());
+            _write_bool(data, light.is_use_constant_linear_quadratic_attenuation());
+            _write(data, light.get_constant_attenuation());
+            _write(data, light.get_linear_attenuation());
+            _write(data, light.get_quadratic_attenuation());
+            _write(data, light.get_culling_range());
+        }
+
+        template <typename LightType>
+        static void _read_attenuation(Reader &reader, LightType &light)
+        {
+            light.set_attenuation_distance(reader.read<float>());
+            light.set_use_constant_linear_quadratic_attenuation(reader.read_bool());
+            light.set_constant_attenuation(reader.read<float>());
+            light.set_linear_attenuation(reader.read<float>());
+            light.set_quadratic_attenuation(reader.read<float>());
+            light.set_culling_range(reader.read<float>());
+        }
+    };
+}
+
+#endif
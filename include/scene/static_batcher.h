@@ -0,0 +1,232 @@
+#ifndef STATIC_BATCHER_H
+#define STATIC_BATCHER_H
+
+#include "objects/object.h"
+#include "objects/mesh.h"
+#include "geometries/geometry.h"
+#include "geometries/vertex.h"
+#include "geometries/vertex_layout.h"
+#include "materials/material.h"
+#include "utilities/node_pool.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <vector>
+#include <memory>
+#include <tuple>
+#include <map>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+namespace asr
+{
+    // Merges static meshes that share a material into large world-space batches. With a positive chunk size
+    // the batches are split along a uniform grid so that each chunk can still be culled on its own. The
+    // resulting meshes already have world-space vertices and must be attached without a parent transform.
+    class StaticBatcher
+    {
+    public:
+        struct Batch
+        {
+            std::shared_ptr<Material> material;
+            Geometry::Type type;
+            VertexLayout vertex_layout;
+            std::vector<unsigned int> indices;
+            std::vector<Vertex> vertices;
+            std::vector<std::shared_ptr<Object>> source_meshes;
+        };
+
+        explicit StaticBatcher(float chunk_size = 0.0f) : _chunk_size{chunk_size} {}
+
+        [[nodiscard]] float get_chunk_size() const
+        {
+            return _chunk_size;
+        }
+
+        void set_chunk_size(float chunk_size)
+        {
+            _chunk_size = chunk_size;
+        }
+
+        [[nodiscard]] const std::vector<Batch> &get_batches() const
+        {
+            return _batches;
+        }
+
+        void add(const std::shared_ptr<Object> &root)
+        {
+            if (Mesh *mesh = root->as_mesh())
+            {
+                if (is_batchable(*mesh))
+                {
+                    _add_mesh(root, *mesh);
+                }
+            }
+
+            for (const auto &child : root->get_children())
+            {
+                add(child);
+            }
+        }
+
+        void clear()
+        {
+            _batches.clear();
+            _batch_indices.clear();
+        }
+
+        template <typename GeometryType>
+        [[nodiscard]] std::vector<std::shared_ptr<Mesh>> create_meshes() const
+        {
+            std::vector<std::shared_ptr<Mesh>> meshes;
+            meshes.reserve(_batches.size());
+            for (const auto &batch : _batches)
+            {
+                auto geometry = std::make_shared<GeometryType>(batch.indices, batch.vertices, batch.vertex_layout);
+                geometry->set_type(batch.type);
+
+                auto mesh = create_node<Mesh>(geometry, batch.material);
+                mesh->set_name("static batch");
+                meshes.push_back(mesh);
+            }
+
+            return meshes;
+        }
+
+        void remove_source_meshes()
+        {
+            for (const auto &batch : _batches)
+            {
+                for (const auto &source_mesh : batch.source_meshes)
+                {
+                    if (Object *parent = source_mesh->get_parent_object())
+                    {
+                        parent->remove_child(*source_mesh);
+                    }
+                }
+            }
+        }
+
+        static bool is_batchable(Mesh &mesh)
+        {
+            const auto &geometry = mesh.get_geometry();
+            const auto &material = mesh.get_material();
+            if (!geometry || !material || mesh.as_instanced_mesh() != nullptr || mesh.as_lod_mesh() != nullptr ||
+                mesh.as_particle_system() != nullptr || geometry->get_mesh_data() || geometry->are_vertices_packed())
+            {
+                return false;
+            }
+            if (material->is_transparent() || material->is_overlay())
+            {
+                return false;
+            }
+
+            Geometry::Type type = geometry->get_type();
+            return type == Geometry::Type::Points || type == Geometry::Type::Lines || type == Geometry::Type::Triangles;
+        }
+
+    private:
+        typedef std::tuple<const Material *, int, size_t, int, int, int> key_type;
+
+        float _chunk_size;
+
+        std::vector<Batch> _batches;
+        std::map<key_type, size_t> _batch_indices;
+
+        void _add_mesh(const std::shared_ptr<Object> &object, Mesh &mesh)
+        {
+            const auto &geometry = mesh.get_geometry();
+            const auto &source_vertices = geometry->get_vertices();
+            const auto &source_indices = geometry->get_indices();
+            if (source_vertices.empty() || source_indices.empty())
+            {
+                return;
+            }
+
+            const glm::mat4 &world_matrix = mesh.get_world_matrix();
+            glm::mat3 direction_matrix{world_matrix};
+            glm::mat3 normal_matrix = glm::inverseTranspose(direction_matrix);
+            bool mirrored = glm::determinant(direction_matrix) < 0.0f;
+
+            glm::vec3 center{0.0f};
+            for (const auto &vertex : source_vertices)
+            {
+                center += vertex.position;
+            }
+            center = glm::vec3(world_matrix * glm::vec4(center / static_cast<float>(source_vertices.size()), 1.0f));
+
+            Batch &batch = _get_batch(mesh, center);
+            auto first_vertex = static_cast<unsigned int>(batch.vertices.size());
+
+            batch.vertices.reserve(batch.vertices.size() + source_vertices.size());
+            for (Vertex vertex : source_vertices)
+            {
+                vertex.position = glm::vec3(world_matrix * glm::vec4(vertex.position, 1.0f));
+                vertex.normal = _normalize(normal_matrix * vertex.normal);
+                vertex.tangent = glm::vec4(_normalize(direction_matrix * glm::vec3(vertex.tangent)), vertex.tangent.w);
+                vertex.binormal = _normalize(direction_matrix * vertex.binormal);
+                batch.vertices.push_back(vertex);
+            }
+
+            batch.indices.reserve(batch.indices.size() + source_indices.size());
+            if (mirrored && batch.type == Geometry::Type::Triangles)
+            {
+                for (size_t i = 0; i + 2 < source_indices.size(); i += 3)
+                {
+                    batch.indices.push_back(first_vertex + source_indices[i]);
+                    batch.indices.push_back(first_vertex + source_indices[i + 2]);
+                    batch.indices.push_back(first_vertex + source_indices[i + 1]);
+                }
+            }
+            else
+            {
+                for (unsigned int index : source_indices)
+                {
+                    batch.indices.push_back(first_vertex + index);
+                }
+            }
+
+            batch.source_meshes.push_back(object);
+        }
+
+        Batch &_get_batch(Mesh &mesh, const glm::vec3 &center)
+        {
+            const auto &geometry = mesh.get_geometry();
+            const auto &material = mesh.get_material();
+
+            size_t layout_index{0};
+            while (layout_index < _batches.size() && _batches[layout_index].vertex_layout != geometry->get_vertex_layout())
+            {
+                ++layout_index;
+            }
+
+            glm::ivec3 cell{0};
+            if (_chunk_size > 0.0f)
+            {
+                cell = glm::ivec3(glm::floor(center / _chunk_size));
+            }
+
+            key_type key{material.get(), static_cast<int>(geometry->get_type()), layout_index, cell.x, cell.y, cell.z};
+            auto entry = _batch_indices.find(key);
+            if (entry != _batch_indices.end())
+            {
+                return _batches[entry->second];
+            }
+
+            _batch_indices.emplace(key, _batches.size());
+            _batches.push_back(Batch{material, geometry->get_type(), geometry->get_vertex_layout(), {}, {}, {}});
+
+            return _batches.back();
+        }
+
+        static glm::vec3 _normalize(const glm::vec3 &vector)
+        {
+            float length = glm::length(vector);
+            return length > 0.0f ? vector / length : vector;
+        }
+    };
+}
+
+#endif
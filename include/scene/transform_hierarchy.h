@@ -0,0 +1,416 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Stores local and world transforms in contiguous arrays ordered parent-before-child, so that every dirty
+    // world matrix can be recomputed in a single linear pass without chasing parent pointers. Handles stay
+    // stable while the arrays are reordered or compacted.
+    class TransformHierarchy
+    {
+    public:
+        typedef uint32_t handle_type;
+
+        static constexpr handle_type NULL_HANDLE{UINT32_MAX};
+
+        TransformHierarchy() = default;
+
+        TransformHierarchy(const TransformHierarchy &other) = delete;
+        TransformHierarchy &operator=(const TransformHierarchy &other) = delete;
+
+        handle_type create(handle_type parent = NULL_HANDLE)
+        {
+            handle_type handle;
+            if (_free_handles.empty())
+            {
+                handle = static_cast<handle_type>(_indices.size());
+                _indices.push_back(NULL_INDEX);
+            }
+            else
+            {
+                handle = _free_handles.back();
+                _free_handles.pop_back();
+            }
+
+            _indices[handle] = static_cast<int32_t>(_handles.size());
+            _handles.push_back(handle);
+            _parents.push_back(parent == NULL_HANDLE ? NULL_INDEX : _indices[parent]);
+            _positions.emplace_back(0.0f);
+            _quaternion_rotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+            _scales.emplace_back(1.0f);
+            _world_matrices.emplace_back(1.0f);
+            _world_versions.push_back(0);
+            _flags.push_back(LocalTransformChanged);
+
+            ++_count;
+            _requires_update = true;
+
+            return handle;
+        }
+
+        void destroy(handle_type handle)
+        {
+            int32_t index = _indices[handle];
+            _flags[static_cast<size_t>(index)] = Removed;
+            _indices[handle] = NULL_INDEX;
+            _free_handles.push_back(handle);
+
+            --_count;
+            _requires_compaction = true;
+            _requires_update = true;
+        }
+
+        [[nodiscard]] size_t get_count() const
+        {
+            return _count;
+        }
+
+        [[nodiscard]] bool is_valid(handle_type handle) const
+        {
+            return handle < _indices.size() && _indices[handle] != NULL_INDEX;
+        }
+
+        [[nodiscard]] handle_type get_parent(handle_type handle) const
+        {
+            int32_t parent = _parents[static_cast<size_t>(_indices[handle])];
+            return parent == NULL_INDEX ? NULL_HANDLE : _handles[static_cast<size_t>(parent)];
+        }
+
+        bool set_parent(handle_type handle, handle_type parent)
+        {
+            if (_requires_compaction)
+            {
+                _compact();
+            }
+
+            for (handle_type ancestor = parent; ancestor != NULL_HANDLE; ancestor = get_parent(ancestor))
+            {
+                if (ancestor == handle)
+                {
+                    return false;
+                }
+            }
+
+            auto index = static_cast<size_t>(_indices[handle]);
+            int32_t parent_index = parent == NULL_HANDLE ? NULL_INDEX : _indices[parent];
+            if (_parents[index] == parent_index)
+            {
+                return true;
+            }
+
+            _parents[index] = parent_index;
+            _flags[index] |= LocalTransformChanged;
+            if (parent_index > static_cast<int32_t>(index))
+            {
+                _requires_sort = true;
+            }
+            _requires_update = true;
+
+            return true;
+        }
+
+        void set_local_transform(handle_type handle, const glm::vec3 &position,
+                                 const glm::quat &quaternion_rotation, const glm::vec3 &scale)
+        {
+            auto index = static_cast<size_t>(_indices[handle]);
+            _positions[index] = position;
+            _quaternion_rotations[index] = quaternion_rotation;
+            _scales[index] = scale;
+            _flags[index] |= LocalTransformChanged;
+            _requires_update = true;
+        }
+
+        [[nodiscard]] const glm::vec3 &get_position(handle_type handle) const
+        {
+            return _positions[static_cast<size_t>(_indices[handle])];
+        }
+
+        [[nodiscard]] const glm::quat &get_quaternion_rotation(handle_type handle) const
+        {
+            return _quaternion_rotations[static_cast<size_t>(_indices[handle])];
+        }
+
+        [[nodiscard]] const glm::vec3 &get_scale(handle_type handle) const
+        {
+            return _scales[static_cast<size_t>(_indices[handle])];
+        }
+
+        const glm::mat4 &get_world_matrix(handle_type handle)
+        {
+            update();
+
+            return _world_matrices[static_cast<size_t>(_indices[handle])];
+        }
+
+        unsigned int get_world_version(handle_type handle)
+        {
+            update();
+
+            return _world_versions[static_cast<size_t>(_indices[handle])];
+        }
+
+        [[nodiscard]] bool is_requires_update() const
+        {
+            return _requires_update;
+        }
+
+        void update()
+        {
+            if (!_requires_update)
+            {
+                return;
+            }
+
+            if (_requires_compaction)
+            {
+                _compact();
+            }
+            if (_requires_sort)
+            {
+                _sort();
+            }
+
+            size_t count = _world_matrices.size();
+            const int32_t *parents = _parents.data();
+            const glm::vec3 *positions = _positions.data();
+            const glm::quat *quaternion_rotations = _quaternion_rotations.data();
+            const glm::vec3 *scales = _scales.data();
+            glm::mat4 *world_matrices = _world_matrices.data();
+            unsigned int *world_versions = _world_versions.data();
+            uint8_t *flags = _flags.data();
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                int32_t parent = parents[i];
+                bool changed = (flags[i] & LocalTransformChanged) != 0 ||
+                               (parent != NULL_INDEX && (flags[parent] & WorldTransformChanged) != 0);
+                flags[i] = changed ? static_cast<uint8_t>(WorldTransformChanged) : static_cast<uint8_t>(0);
+                if (!changed)
+                {
+                    continue;
+                }
+
+                glm::mat4 local_matrix{quaternion_rotations[i]};
+                local_matrix[0] *= scales[i].x;
+                local_matrix[1] *= scales[i].y;
+                local_matrix[2] *= scales[i].z;
+                local_matrix[3] = glm::vec4(positions[i], 1.0f);
+
+                world_matrices[i] = parent == NULL_INDEX ? local_matrix : world_matrices[parent] * local_matrix;
+                ++world_versions[i];
+            }
+
+            _requires_update = false;
+        }
+
+        void clear()
+        {
+            _indices.clear();
+            _free_handles.clear();
+            _handles.clear();
+            _parents.clear();
+            _positions.clear();
+            _quaternion_rotations.clear();
+            _scales.clear();
+            _world_matrices.clear();
+            _world_versions.clear();
+            _flags.clear();
+
+            _count = 0;
+            _requires_compaction = false;
+            _requires_sort = false;
+            _requires_update = false;
+        }
+
+    private:
+        enum Flags : uint8_t
+        {
+            LocalTransformChanged = 1u << 0u,
+            WorldTransformChanged = 1u << 1u,
+            Removed = 1u << 2u
+        };
+
+        static constexpr int32_t NULL_INDEX{-1};
+
+        std::vector<int32_t> _indices;
+        std::vector<handle_type> _free_handles;
+
+        std::vector<handle_type> _handles;
+        std::vector<int32_t> _parents;
+        std::vector<glm::vec3> _positions;
+        std::vector<glm::quat> _quaternion_rotations;
+        std::vector<glm::vec3> _scales;
+        std::vector<glm::mat4> _world_matrices;
+        std::vector<unsigned int> _world_versions;
+        std::vector<uint8_t> _flags;
+
+        std::vector<int32_t> _remap;
+        std::vector<uint8_t> _removed;
+        std::vector<uint32_t> _depths;
+        std::vector<size_t> _order;
+
+        size_t _count{0};
+        bool _requires_compaction{false};
+        bool _requires_sort{false};
+        bool _requires_update{false};
+
+        void _compact()
+        {
+            // Parents of the survivors are remapped in a single pass, which requires them to come first.
+            if (_requires_sort)
+            {
+                _sort();
+            }
+
+            size_t count = _handles.size();
+            _remap.assign(count, NULL_INDEX);
+            _removed.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                _removed[i] = static_cast<uint8_t>((_flags[i] & Removed) != 0);
+            }
+
+            size_t last = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                int32_t parent = _parents[i];
+                int32_t remapped_parent = parent == NULL_INDEX ? NULL_INDEX : _remap[static_cast<size_t>(parent)];
+                if (_removed[i] != 0)
+                {
+                    // Children of a removed transform are kept and attached to its closest surviving ancestor.
+                    _remap[i] = remapped_parent;
+                    continue;
+                }
+
+                _remap[i] = static_cast<int32_t>(last);
+                _indices[_handles[i]] = static_cast<int32_t>(last);
+                _handles[last] = _handles[i];
+                _parents[last] = remapped_parent;
+                _positions[last] = _positions[i];
+                _quaternion_rotations[last] = _quaternion_rotations[i];
+                _scales[last] = _scales[i];
+                _world_matrices[last] = _world_matrices[i];
+                _world_versions[last] = _world_versions[i];
+                _flags[last] = _flags[i];
+                if (parent != NULL_INDEX && _removed[static_cast<size_t>(parent)] != 0)
+                {
+                    _flags[last] |= LocalTransformChanged;
+                }
+                ++last;
+            }
+
+            _handles.resize(last);
+            _parents.resize(last);
+            _positions.resize(last);
+            _quaternion_rotations.resize(last);
+            _scales.resize(last);
+            _world_matrices.resize(last);
+            _world_versions.resize(last);
+            _flags.resize(last);
+
+            _requires_compaction = false;
+        }
+
+        void _sort()
+        {
+            size_t count = _handles.size();
+
+            // Parents are placed before their children once every transform is ordered by its depth.
+            _depths.assign(count, UINT32_MAX);
+            for (size_t i = 0; i < count; ++i)
+            {
+                _update_depth(i);
+            }
+
+            _order.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                _order[i] = i;
+            }
+            std::stable_sort(_order.begin(), _order.end(), [this](size_t a, size_t b) {
+                return _depths[a] < _depths[b];
+            });
+
+            _remap.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                _remap[_order[i]] = static_cast<int32_t>(i);
+            }
+
+            _permute(_handles);
+            _permute(_positions);
+            _permute(_quaternion_rotations);
+            _permute(_scales);
+            _permute(_world_matrices);
+            _permute(_world_versions);
+            _permute(_flags);
+            _permute(_parents);
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (_parents[i] != NULL_INDEX)
+                {
+                    _parents[i] = _remap[static_cast<size_t>(_parents[i])];
+                }
+                _indices[_handles[i]] = static_cast<int32_t>(i);
+            }
+
+            _requires_sort = false;
+        }
+
+        uint32_t _update_depth(size_t index)
+        {
+            if (_depths[index] != UINT32_MAX)
+            {
+                return _depths[index];
+            }
+
+            uint32_t depth{0};
+            size_t current = index;
+            while (_parents[current] != NULL_INDEX)
+            {
+                current = static_cast<size_t>(_parents[current]);
+                if (_depths[current] != UINT32_MAX)
+                {
+                    depth += _depths[current] + 1;
+                    break;
+                }
+                ++depth;
+            }
+
+            current = index;
+            for (uint32_t current_depth = depth; _depths[current] == UINT32_MAX; --current_depth)
+            {
+                _depths[current] = current_depth;
+                if (_parents[current] == NULL_INDEX)
+                {
+                    break;
+                }
+                current = static_cast<size_t>(_parents[current]);
+            }
+
+            return depth;
+        }
+
+        template <typename T>
+        void _permute(std::vector<T> &values) const
+        {
+            std::vector<T> permuted;
+            permuted.reserve(values.size());
+            for (size_t index : _order)
+            {
+                permuted.push_back(values[index]);
+            }
+            values.swap(permuted);
+        }
+    };
+}
+
+#endif
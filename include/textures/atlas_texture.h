@@ -0,0 +1,57 @@
+#ifndef ATLAS_TEXTURE_H
+#define ATLAS_TEXTURE_H
+
+#include "textures/texture.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace asr
+{
+    // A region of an atlas texture. It holds no pixels of its own: updating and binding it updates and binds the
+    // atlas, and the materials map the texture coordinates into the region. Materials that use regions of the
+    // same atlas share the storage id, so the renderer sorts them next to each other and draws them without
+    // rebinding the texture. The mode and the transformation are taken from the view, the wrap modes and the
+    // filters from the atlas.
+    class AtlasTexture final : public Texture
+    {
+    public:
+        AtlasTexture(std::shared_ptr<Texture> atlas, const glm::vec4 &region, unsigned int width, unsigned int height)
+            : Texture(std::vector<uint8_t>{}, width, height, atlas->get_channels()), _atlas{std::move(atlas)}
+        {
+            _storage_id = _atlas->get_storage_id();
+            _region = region;
+            _requires_params_update = false;
+            _requires_data_update = false;
+        }
+
+        AtlasTexture(const AtlasTexture &other) = delete;
+        AtlasTexture &operator=(const AtlasTexture &other) = delete;
+
+        ~AtlasTexture() final = default;
+
+        [[nodiscard]] const std::shared_ptr<Texture> &get_atlas() const
+        {
+            return _atlas;
+        }
+
+        void update(unsigned int sampler) final
+        {
+            _atlas->update(sampler);
+        }
+
+        void use(unsigned int sampler) final
+        {
+            _mark_used();
+            _atlas->use(sampler);
+        }
+
+    private:
+        std::shared_ptr<Texture> _atlas;
+    };
+}
+
+#endif
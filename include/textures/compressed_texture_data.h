@@ -0,0 +1,198 @@
+#ifndef COMPRESSED_TEXTURE_DATA_H
+#define COMPRESSED_TEXTURE_DATA_H
+
+#include "utilities/mapped_file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace asr
+{
+    // A block-compressed image with its stored mipmap chain. The levels point straight into a memory-mapped
+    // KTX file, so the pixels are never copied on the CPU side and the mapping is released together with
+    // this object.
+    class CompressedTextureData
+    {
+    public:
+        enum Format
+        {
+            ETC2RGB8,
+            ETC2RGBA8,
+            ASTC4x4RGBA,
+            BC1RGB,
+            BC1RGBA,
+            BC3RGBA,
+            BC7RGBA
+        };
+
+        struct Level
+        {
+            const uint8_t *data;
+            size_t size;
+            unsigned int width;
+            unsigned int height;
+        };
+
+        static std::shared_ptr<CompressedTextureData> read_ktx_file(const std::string &path)
+        {
+            auto compressed_texture_data = std::make_shared<CompressedTextureData>();
+            if (!compressed_texture_data->open_ktx_file(path))
+            {
+                std::exit(-1);
+            }
+
+            return compressed_texture_data;
+        }
+
+        bool open_ktx_file(const std::string &path)
+        {
+            _levels.clear();
+            if (!_file.open(path))
+            {
+                std::cerr << "Failed to open the file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            const uint8_t *data = _file.get_data();
+            size_t size = _file.get_size();
+            if (size < KTX_HEADER_SIZE || std::memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0 ||
+                _read_uint32(data + 12) != KTX_ENDIANNESS)
+            {
+                std::cerr << "Invalid KTX file (only little-endian KTX 1.1 files are supported): '" << path << "'"
+                          << std::endl;
+                _file.close();
+                return false;
+            }
+
+            uint32_t internal_format = _read_uint32(data + 28);
+            uint32_t width = _read_uint32(data + 36);
+            uint32_t height = _read_uint32(data + 40);
+            uint32_t depth = _read_uint32(data + 44);
+            uint32_t array_element_count = _read_uint32(data + 48);
+            uint32_t face_count = _read_uint32(data + 52);
+            uint32_t level_count = std::max<uint32_t>(_read_uint32(data + 56), 1);
+            uint32_t key_value_data_size = _read_uint32(data + 60);
+            if (!_convert_ktx_internal_format_to_format(internal_format, _format) || _read_uint32(data + 16) != 0 ||
+                depth > 1 || array_element_count > 1 || face_count != 1 || width == 0 || height == 0)
+            {
+                std::cerr << "Unsupported KTX file (only compressed 2D ETC2, ASTC 4x4 and BC1, BC3, BC7 textures are "
+                             "supported): '" << path << "'" << std::endl;
+                _file.close();
+                return false;
+            }
+
+            size_t offset = KTX_HEADER_SIZE + key_value_data_size;
+            for (uint32_t i = 0; i < level_count; ++i)
+            {
+                if (offset + 4 > size)
+                {
+                    break;
+                }
+                size_t level_size = _read_uint32(data + offset);
+                offset += 4;
+                if (offset + level_size > size)
+                {
+                    break;
+                }
+
+                _levels.push_back(Level{data + offset, level_size, std::max(width >> i, 1u), std::max(height >> i, 1u)});
+                offset += (level_size + 3) & ~static_cast<size_t>(3);
+            }
+            if (_levels.size() != level_count)
+            {
+                std::cerr << "Truncated KTX file: '" << path << "'" << std::endl;
+                _levels.clear();
+                _file.close();
+                return false;
+            }
+
+            _width = width;
+            _height = height;
+
+            return true;
+        }
+
+        [[nodiscard]] Format get_format() const
+        {
+            return _format;
+        }
+
+        [[nodiscard]] unsigned int get_width() const
+        {
+            return _width;
+        }
+
+        [[nodiscard]] unsigned int get_height() const
+        {
+            return _height;
+        }
+
+        [[nodiscard]] unsigned int get_channels() const
+        {
+            return _format == ETC2RGB8 || _format == BC1RGB ? 3 : 4;
+        }
+
+        [[nodiscard]] const std::vector<Level> &get_levels() const
+        {
+            return _levels;
+        }
+
+    private:
+        inline static const uint8_t KTX_IDENTIFIER[12]{0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+        inline static const uint32_t KTX_ENDIANNESS = 0x04030201;
+        inline static const size_t KTX_HEADER_SIZE = 64;
+
+        MappedFile _file;
+
+        Format _format{ETC2RGB8};
+        unsigned int _width{0};
+        unsigned int _height{0};
+        std::vector<Level> _levels;
+
+        static uint32_t _read_uint32(const uint8_t *data)
+        {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+
+            return value;
+        }
+
+        static bool _convert_ktx_internal_format_to_format(uint32_t internal_format, Format &format)
+        {
+            switch (internal_format)
+            {
+            case 0x9274:
+                format = ETC2RGB8;
+                return true;
+            case 0x9278:
+                format = ETC2RGBA8;
+                return true;
+            case 0x93B0:
+                format = ASTC4x4RGBA;
+                return true;
+            case 0x83F0:
+                format = BC1RGB;
+                return true;
+            case 0x83F1:
+                format = BC1RGBA;
+                return true;
+            case 0x83F3:
+                format = BC3RGBA;
+                return true;
+            case 0x8E8C:
+                format = BC7RGBA;
+                return true;
+            default:
+                return false;
+            }
+        }
+    };
+}
+
+#endif
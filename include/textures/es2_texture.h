@@ -2,11 +2,14 @@
 #define ES2_TEXTURE_H
 
 #include "textures/texture.h"
+#include "renderer/es2_state_cache.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace asr
@@ -19,6 +22,11 @@ namespace asr
         {
         }
 
+        explicit ES2Texture(std::shared_ptr<const CompressedTextureData> compressed_data)
+            : Texture(std::move(compressed_data))
+        {
+        }
+
         ES2Texture(const ES2Texture &other) = delete;
         ES2Texture &operator=(const ES2Texture &other) = delete;
 
@@ -26,19 +34,43 @@ namespace asr
         {
             if (_texture != 0)
             {
+                ES2StateCache::get_instance().forget_texture(_texture);
                 glDeleteTextures(1, &_texture);
             }
         }
 
         void update(unsigned int sampler) final
         {
-            if (_requires_data_update)
+            auto &state_cache = ES2StateCache::get_instance();
+
+            if (_requires_data_update && _compressed_data)
+            {
+                if (_texture == 0)
+                {
+                    glGenTextures(1, &_texture);
+                }
+                _upload_compressed_data(sampler);
+
+                if (_release_image_data_after_upload)
+                {
+                    _compressed_data.reset();
+                }
+                _requires_data_update = false;
+            }
+            else if (_requires_data_update && _image_data.empty())
+            {
+                // The pixels were released after an earlier upload, so the texture keeps its current contents.
+                _requires_data_update = false;
+            }
+            else if (_requires_data_update)
             {
-                glActiveTexture(GL_TEXTURE0 + sampler);
                 if (_texture == 0)
                 {
                     glGenTextures(1, &_texture);
-                    glBindTexture(GL_TEXTURE_2D, _texture);
+                }
+                if (_allocated_width != _width || _allocated_height != _height || _allocated_channels != _channels)
+                {
+                    state_cache.bind_texture(sampler, _texture);
                     GLint format = _channels == 3 ? GL_RGB : GL_RGBA;
                     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
                     glTexImage2D(
@@ -47,10 +79,14 @@ namespace asr
                         static_cast<GLsizei>(_height),
                         0, static_cast<GLenum>(format), GL_UNSIGNED_BYTE,
                         reinterpret_cast<GLvoid *>(_image_data.data()));
+
+                    _allocated_width = _width;
+                    _allocated_height = _height;
+                    _allocated_channels = _channels;
                 }
                 else
                 {
-                    glBindTexture(GL_TEXTURE_2D, _texture);
+                    state_cache.bind_texture(sampler, _texture);
                     GLint format = _channels == 3 ? GL_RGB : GL_RGBA;
                     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
                     glTexSubImage2D(
@@ -60,19 +96,22 @@ namespace asr
                         static_cast<GLenum>(format), GL_UNSIGNED_BYTE,
                         reinterpret_cast<GLvoid *>(_image_data.data()));
                 }
+                state_cache.get_stats().uploaded_texture_bytes += _image_data.size();
                 if (_mipmaps_enabled)
                 {
                     glGenerateMipmap(GL_TEXTURE_2D);
                 }
-                glBindTexture(GL_TEXTURE_2D, 0);
 
+                if (_release_image_data_after_upload)
+                {
+                    std::vector<uint8_t>{}.swap(_image_data);
+                }
                 _requires_data_update = false;
             }
 
             if (_requires_params_update)
             {
-                glActiveTexture(GL_TEXTURE0 + sampler);
-                glBindTexture(GL_TEXTURE_2D, _texture);
+                state_cache.bind_texture(sampler, _texture);
 
                 glTexParameteri(
                     GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
@@ -89,23 +128,75 @@ namespace asr
                 glTexParameterf(
                     GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, static_cast<GLfloat>(_anisotropy));
 
-                glBindTexture(GL_TEXTURE_2D, 0);
-
                 _requires_params_update = false;
             }
         }
 
         void use(unsigned int sampler) final
         {
+            _mark_used();
             if (_texture != 0)
             {
-                glActiveTexture(GL_TEXTURE0 + sampler);
-                glBindTexture(GL_TEXTURE_2D, _texture);
+                ES2StateCache::get_instance().bind_texture(sampler, _texture);
             }
         }
 
     private:
         GLuint _texture{0};
+        unsigned int _allocated_width{0};
+        unsigned int _allocated_height{0};
+        unsigned int _allocated_channels{0};
+
+        // Compressed textures use their stored mipmap chain, since glGenerateMipmap can not produce
+        // compressed levels.
+        void _upload_compressed_data(unsigned int sampler)
+        {
+            ES2StateCache::get_instance().bind_texture(sampler, _texture);
+
+            GLenum format = _convert_compressed_format_to_es2_internal_format(_compressed_data->get_format());
+            const auto &levels = _compressed_data->get_levels();
+            size_t level_count = _mipmaps_enabled ? levels.size() : 1;
+            for (size_t i = 0; i < level_count; ++i)
+            {
+                const auto &level = levels[i];
+                glCompressedTexImage2D(
+                    GL_TEXTURE_2D, static_cast<GLint>(i), format,
+                    static_cast<GLsizei>(level.width),
+                    static_cast<GLsizei>(level.height),
+                    0, static_cast<GLsizei>(level.size),
+                    reinterpret_cast<const GLvoid *>(level.data));
+                ES2StateCache::get_instance().get_stats().uploaded_texture_bytes += level.size;
+            }
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(level_count - 1));
+
+            // The next uncompressed upload has to allocate new storage.
+            _allocated_width = 0;
+            _allocated_height = 0;
+            _allocated_channels = 0;
+        }
+
+        static GLenum _convert_compressed_format_to_es2_internal_format(CompressedTextureData::Format format)
+        {
+            switch (format)
+            {
+            case CompressedTextureData::ETC2RGB8:
+                return GL_COMPRESSED_RGB8_ETC2;
+            case CompressedTextureData::ETC2RGBA8:
+                return GL_COMPRESSED_RGBA8_ETC2_EAC;
+            case CompressedTextureData::ASTC4x4RGBA:
+                return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+            case CompressedTextureData::BC1RGB:
+                return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case CompressedTextureData::BC1RGBA:
+                return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case CompressedTextureData::BC3RGBA:
+                return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case CompressedTextureData::BC7RGBA:
+                return GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+            }
+
+            return GL_COMPRESSED_RGB8_ETC2;
+        }
 
         static GLint _convert_wrap_mode_to_es2_texture_wrap_mode(Texture::WrapMode wrap_mode)
         {
@@ -2,9 +2,13 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include "textures/compressed_texture_data.h"
+
 #include <glm/glm.hpp>
 
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 #include <utility>
 
@@ -44,8 +48,50 @@ namespace asr
         {
         }
 
+        explicit Texture(std::shared_ptr<const CompressedTextureData> compressed_data)
+            : _compressed_data{std::move(compressed_data)},
+              _width{_compressed_data->get_width()},
+              _height{_compressed_data->get_height()},
+              _channels{_compressed_data->get_channels()}
+        {
+        }
+
         virtual ~Texture() = default;
 
+        [[nodiscard]] unsigned int get_id() const
+        {
+            return _id;
+        }
+
+        // The id of the texture that holds the pixels. Textures that share one, like the regions of an atlas,
+        // are sorted next to each other and drawn without rebinding.
+        [[nodiscard]] unsigned int get_storage_id() const
+        {
+            return _storage_id;
+        }
+
+        // The part of the storage texture this texture covers, as offset and scale of its coordinates.
+        [[nodiscard]] const glm::vec4 &get_region() const
+        {
+            return _region;
+        }
+
+        [[nodiscard]] bool has_region() const
+        {
+            return _region != glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        }
+
+        // The file the texture was loaded from by the TextureLoader, empty for textures created from memory.
+        [[nodiscard]] const std::string &get_path() const
+        {
+            return _path;
+        }
+
+        void set_path(const std::string &path)
+        {
+            _path = path;
+        }
+
         [[nodiscard]] const std::vector<uint8_t> &get_image_data() const
         {
             return _image_data;
@@ -53,10 +99,36 @@ namespace asr
 
         void set_image_data(const std::vector<uint8_t> &image_data)
         {
+            _compressed_data.reset();
             _image_data = image_data;
             _requires_data_update = true;
         }
 
+        [[nodiscard]] const std::shared_ptr<const CompressedTextureData> &get_compressed_data() const
+        {
+            return _compressed_data;
+        }
+
+        void set_compressed_data(std::shared_ptr<const CompressedTextureData> compressed_data)
+        {
+            _compressed_data = std::move(compressed_data);
+            _image_data.clear();
+            _width = _compressed_data->get_width();
+            _height = _compressed_data->get_height();
+            _channels = _compressed_data->get_channels();
+            _requires_data_update = true;
+        }
+
+        void set_image(std::vector<uint8_t> image_data, unsigned int width, unsigned int height, unsigned int channels)
+        {
+            _compressed_data.reset();
+            _image_data = std::move(image_data);
+            _width = width;
+            _height = height;
+            _channels = channels;
+            _requires_data_update = true;
+        }
+
         [[nodiscard]] unsigned int get_width() const
         {
             return _width;
@@ -107,6 +179,7 @@ namespace asr
         void set_enabled(bool enabled)
         {
             _enabled = enabled;
+            ++_version;
         }
 
         [[nodiscard]] bool requires_params_update() const
@@ -129,6 +202,18 @@ namespace asr
             _requires_data_update = requires_data_update;
         }
 
+        // Frees the pixels on the CPU side once they are uploaded. The texture can not be uploaded again
+        // afterwards, for example when mipmaps are toggled, unless new image data is set.
+        [[nodiscard]] bool should_release_image_data_after_upload() const
+        {
+            return _release_image_data_after_upload;
+        }
+
+        void set_release_image_data_after_upload(bool release_image_data_after_upload)
+        {
+            _release_image_data_after_upload = release_image_data_after_upload;
+        }
+
         [[nodiscard]] bool are_mipmaps_enabled() const
         {
             return _mipmaps_enabled;
@@ -151,6 +236,7 @@ namespace asr
         void set_mode(Mode mode)
         {
             _mode = mode;
+            ++_version;
         }
 
         [[nodiscard]] WrapMode get_wrap_mode_s() const
@@ -231,6 +317,7 @@ namespace asr
         void set_transformation_enabled(bool transformation_enabled)
         {
             _transformation_enabled = transformation_enabled;
+            ++_version;
         }
 
         [[nodiscard]] const glm::mat4 &get_transformation_matrix() const
@@ -241,6 +328,38 @@ namespace asr
         void set_transformation_matrix(const glm::mat4 &transformation_matrix)
         {
             _transformation_matrix = transformation_matrix;
+            ++_version;
+        }
+
+        // The transformation followed by the mapping into the region, which is what the shaders apply to the
+        // texture coordinates when is_transformation_enabled() or has_region() is true.
+        [[nodiscard]] glm::mat4 get_region_transformation_matrix() const
+        {
+            glm::mat4 region_matrix{1.0f};
+            region_matrix[0][0] = _region.z;
+            region_matrix[1][1] = _region.w;
+            region_matrix[3][0] = _region.x;
+            region_matrix[3][1] = _region.y;
+
+            return _transformation_enabled ? region_matrix * _transformation_matrix : region_matrix;
+        }
+
+        // Changes with the parameters the materials upload as uniforms: enabled, mode and transformation.
+        [[nodiscard]] unsigned int get_version() const
+        {
+            return _version;
+        }
+
+        // Every use of a texture takes the next value of a clock shared by all textures, which tells caches
+        // the order in which the textures were used last.
+        [[nodiscard]] static uint64_t get_use_clock()
+        {
+            return _use_clock;
+        }
+
+        [[nodiscard]] uint64_t get_last_use() const
+        {
+            return _last_use;
         }
 
         virtual void update(unsigned int sampler) = 0;
@@ -248,10 +367,23 @@ namespace asr
         virtual void use(unsigned int sampler) = 0;
 
     protected:
+        inline static unsigned int _next_id{0};
+        const unsigned int _id{++_next_id};
+        unsigned int _storage_id{_id};
+        glm::vec4 _region{0.0f, 0.0f, 1.0f, 1.0f};
+        unsigned int _version{0};
+
+        inline static uint64_t _use_clock{0};
+        uint64_t _last_use{0};
+
+        std::string _path;
+
         bool _enabled{true};
         bool _requires_params_update{true};
         bool _requires_data_update{true};
         std::vector<uint8_t> _image_data;
+        std::shared_ptr<const CompressedTextureData> _compressed_data;
+        bool _release_image_data_after_upload{false};
 
         unsigned int _width;
         unsigned int _height;
@@ -267,6 +399,11 @@ namespace asr
 
         bool _transformation_enabled{false};
         glm::mat4 _transformation_matrix{1.0f};
+
+        void _mark_used()
+        {
+            _last_use = ++_use_clock;
+        }
     };
 }
 
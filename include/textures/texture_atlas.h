@@ -0,0 +1,306 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "textures/texture.h"
+#include "textures/atlas_texture.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+
+namespace asr
+{
+    // Packs many small images into one RGBA texture, so that meshes with different sprites can share a texture
+    // binding and be drawn one after another, or as the instances of a single instanced mesh. The images are
+    // placed on shelves sorted by height. Every image is surrounded by a border that repeats its edge pixels,
+    // which keeps linear filtering from bleeding the neighbours in. The atlas starts at the smallest power of
+    // two that could hold the images and grows up to the maximum size.
+    class TextureAtlas
+    {
+    public:
+        inline static const unsigned int DEFAULT_MAX_SIZE = 4096;
+        inline static const unsigned int DEFAULT_PADDING = 2;
+
+        explicit TextureAtlas(unsigned int max_size = DEFAULT_MAX_SIZE, unsigned int padding = DEFAULT_PADDING)
+            : _max_size{max_size}, _padding{padding}
+        {
+        }
+
+        // Returns the index of the image in the atlas. Images with one or two channels are stored as gray or
+        // gray with alpha, images with three channels get an opaque alpha.
+        size_t add(std::vector<uint8_t> image_data, unsigned int width, unsigned int height, unsigned int channels)
+        {
+            _images.push_back(Image{std::move(image_data), width, height, channels});
+            _placements.clear();
+
+            return _images.size() - 1;
+        }
+
+        size_t add(const Texture &texture)
+        {
+            if (texture.get_compressed_data() || texture.get_image_data().empty())
+            {
+                std::cerr << "Failed to add a texture to the atlas, its pixels are compressed or were released." << std::endl;
+                std::exit(-1);
+            }
+
+            return add(texture.get_image_data(), texture.get_width(), texture.get_height(), texture.get_channels());
+        }
+
+        [[nodiscard]] size_t get_image_count() const
+        {
+            return _images.size();
+        }
+
+        [[nodiscard]] unsigned int get_width() const
+        {
+            return _width;
+        }
+
+        [[nodiscard]] unsigned int get_height() const
+        {
+            return _height;
+        }
+
+        [[nodiscard]] bool is_packed() const
+        {
+            return !_images.empty() && _placements.size() == _images.size();
+        }
+
+        // The offset and the scale that map the texture coordinates of the image into the atlas, in the
+        // format of Texture::get_region() and InstancedMesh::add_instance().
+        [[nodiscard]] glm::vec4 get_region(size_t index) const
+        {
+            const Image &image = _images[index];
+            const Placement &placement = _placements[index];
+
+            return glm::vec4{
+                static_cast<float>(placement.x) / static_cast<float>(_width),
+                static_cast<float>(placement.y) / static_cast<float>(_height),
+                static_cast<float>(image.width) / static_cast<float>(_width),
+                static_cast<float>(image.height) / static_cast<float>(_height)};
+        }
+
+        // Returns false when the images do not fit into the maximum size.
+        bool try_pack()
+        {
+            _placements.clear();
+            if (_images.empty())
+            {
+                return false;
+            }
+
+            std::vector<size_t> order(_images.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+                if (_images[a].height != _images[b].height)
+                {
+                    return _images[a].height > _images[b].height;
+                }
+                return _images[a].width > _images[b].width;
+            });
+
+            size_t area{0};
+            unsigned int largest_side{1};
+            for (const Image &image : _images)
+            {
+                unsigned int padded_width = image.width + 2 * _padding;
+                unsigned int padded_height = image.height + 2 * _padding;
+                area += static_cast<size_t>(padded_width) * padded_height;
+                largest_side = std::max({largest_side, padded_width, padded_height});
+            }
+
+            unsigned int width{1};
+            while (width < largest_side || static_cast<size_t>(width) * width < area)
+            {
+                width *= 2;
+            }
+            unsigned int height{width};
+
+            std::vector<Placement> placements(_images.size());
+            while (width <= _max_size && height <= _max_size)
+            {
+                if (_try_place(order, width, height, placements))
+                {
+                    _width = width;
+                    _height = height;
+                    _placements = std::move(placements);
+                    return true;
+                }
+
+                if (width == height)
+                {
+                    width *= 2;
+                }
+                else
+                {
+                    height *= 2;
+                }
+            }
+
+            return false;
+        }
+
+        // Packs the images if they are not packed yet and creates the texture that holds them. Regions of it
+        // are created with create_texture().
+        template <typename TextureType>
+        std::shared_ptr<TextureType> build()
+        {
+            if (!is_packed() && !try_pack())
+            {
+                std::cerr << "Failed to pack " << _images.size() << " images into a texture atlas of at most "
+                          << _max_size << "x" << _max_size << " pixels." << std::endl;
+                std::exit(-1);
+            }
+
+            auto texture = std::make_shared<TextureType>(_compose(), _width, _height, 4);
+            texture->set_wrap_mode_s(Texture::ClampToEdge);
+            texture->set_wrap_mode_t(Texture::ClampToEdge);
+            _texture = texture;
+
+            return texture;
+        }
+
+        [[nodiscard]] const std::shared_ptr<Texture> &get_texture() const
+        {
+            return _texture;
+        }
+
+        // A view onto the image in the last built atlas texture that can be used like a texture of its own.
+        [[nodiscard]] std::shared_ptr<AtlasTexture> create_texture(size_t index) const
+        {
+            const Image &image = _images[index];
+            return std::make_shared<AtlasTexture>(_texture, get_region(index), image.width, image.height);
+        }
+
+    private:
+        struct Image
+        {
+            std::vector<uint8_t> data;
+            unsigned int width;
+            unsigned int height;
+            unsigned int channels;
+        };
+
+        struct Placement
+        {
+            unsigned int x;
+            unsigned int y;
+        };
+
+        unsigned int _max_size;
+        unsigned int _padding;
+
+        std::vector<Image> _images;
+        std::vector<Placement> _placements;
+        unsigned int _width{0};
+        unsigned int _height{0};
+
+        std::shared_ptr<Texture> _texture;
+
+        bool _try_place(const std::vector<size_t> &order, unsigned int width, unsigned int height, std::vector<Placement> &placements) const
+        {
+            unsigned int x{0};
+            unsigned int y{0};
+            unsigned int shelf_height{0};
+            for (size_t index : order)
+            {
+                const Image &image = _images[index];
+                unsigned int padded_width = image.width + 2 * _padding;
+                unsigned int padded_height = image.height + 2 * _padding;
+                if (padded_width > width)
+                {
+                    return false;
+                }
+                if (x + padded_width > width)
+                {
+                    x = 0;
+                    y += shelf_height;
+                    shelf_height = 0;
+                }
+                if (y + padded_height > height)
+                {
+                    return false;
+                }
+
+                placements[index] = Placement{x + _padding, y + _padding};
+                x += padded_width;
+                shelf_height = std::max(shelf_height, padded_height);
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] std::vector<uint8_t> _compose() const
+        {
+            std::vector<uint8_t> pixels(static_cast<size_t>(_width) * _height * 4, 0);
+
+            auto padding = static_cast<int>(_padding);
+            for (size_t i = 0; i < _images.size(); ++i)
+            {
+                const Image &image = _images[i];
+                const Placement &placement = _placements[i];
+                auto image_width = static_cast<int>(image.width);
+                auto image_height = static_cast<int>(image.height);
+                if (image_width == 0 || image_height == 0)
+                {
+                    continue;
+                }
+
+                for (int y = -padding; y < image_height + padding; ++y)
+                {
+                    int source_y = std::clamp(y, 0, image_height - 1);
+                    for (int x = -padding; x < image_width + padding; ++x)
+                    {
+                        int source_x = std::clamp(x, 0, image_width - 1);
+                        const uint8_t *source = &image.data[
+                            (static_cast<size_t>(source_y) * image.width + static_cast<size_t>(source_x)) * image.channels];
+
+                        size_t target_x = static_cast<size_t>(static_cast<int>(placement.x) + x);
+                        size_t target_y = static_cast<size_t>(static_cast<int>(placement.y) + y);
+                        _convert_pixel_to_rgba(source, image.channels, &pixels[(target_y * _width + target_x) * 4]);
+                    }
+                }
+            }
+
+            return pixels;
+        }
+
+        static void _convert_pixel_to_rgba(const uint8_t *source, unsigned int channels, uint8_t *target)
+        {
+            switch (channels)
+            {
+            case 1:
+                target[0] = target[1] = target[2] = source[0];
+                target[3] = 255;
+                break;
+            case 2:
+                target[0] = target[1] = target[2] = source[0];
+                target[3] = source[1];
+                break;
+            case 3:
+                target[0] = source[0];
+                target[1] = source[1];
+                target[2] = source[2];
+                target[3] = 255;
+                break;
+            default:
+                target[0] = source[0];
+                target[1] = source[1];
+                target[2] = source[2];
+                target[3] = source[3];
+                break;
+            }
+        }
+    };
+}
+
+#endif
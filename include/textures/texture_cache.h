@@ -0,0 +1,257 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "textures/texture.h"
+#include "textures/texture_loader.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Shares the textures loaded from the same file with the same sampling parameters, and keeps the memory of
+    // the textures it handed out within a budget. update() should be called once per frame, after the frame is
+    // drawn. It evicts the textures that were used least recently until the estimated memory fits the budget,
+    // leaving the textures of the last frame alone, and loads evicted textures again once they are used. An
+    // evicted texture shows a single white pixel until its file is decoded again. The textures free their pixels
+    // on the CPU side after the upload, since they can always be read from their files again. Decoded images
+    // are handed over by TextureLoader::update(). The shared textures share their mode and transformation as
+    // well, so textures that are animated separately should be loaded without the cache.
+    class TextureCache
+    {
+    public:
+        inline static const size_t DEFAULT_BYTE_BUDGET = 256 * 1024 * 1024;
+
+        struct Sampling
+        {
+            Texture::WrapMode wrap_mode_s{Texture::ClampToEdge};
+            Texture::WrapMode wrap_mode_t{Texture::ClampToEdge};
+            Texture::FilterType minification_filter{Texture::Linear};
+            Texture::FilterType magnification_filter{Texture::Linear};
+            float anisotropy{0.0f};
+            bool mipmaps_enabled{false};
+        };
+
+        static TextureCache &get_instance()
+        {
+            static TextureCache instance;
+            return instance;
+        }
+
+        explicit TextureCache(TextureLoader &texture_loader = TextureLoader::get_instance(), size_t byte_budget = DEFAULT_BYTE_BUDGET)
+            : _texture_loader{texture_loader}, _byte_budget{byte_budget}
+        {
+        }
+
+        TextureCache(const TextureCache &other) = delete;
+        TextureCache &operator=(const TextureCache &other) = delete;
+
+        template <typename TextureType>
+        std::shared_ptr<TextureType> get(const std::string &path)
+        {
+            return get<TextureType>(path, Sampling{});
+        }
+
+        template <typename TextureType>
+        std::shared_ptr<TextureType> get(const std::string &path, const Sampling &sampling)
+        {
+            key_type key{
+                std::type_index{typeid(TextureType)}, path,
+                sampling.wrap_mode_s, sampling.wrap_mode_t,
+                sampling.minification_filter, sampling.magnification_filter,
+                sampling.anisotropy, sampling.mipmaps_enabled};
+
+            auto entry = _entries.find(key);
+            if (entry != _entries.end())
+            {
+                if (auto texture = entry->second.texture.lock())
+                {
+                    return std::static_pointer_cast<TextureType>(texture);
+                }
+            }
+
+            std::shared_ptr<TextureType> texture = _texture_loader.load<TextureType>(path);
+            texture->set_wrap_mode_s(sampling.wrap_mode_s);
+            texture->set_wrap_mode_t(sampling.wrap_mode_t);
+            texture->set_minification_filter(sampling.minification_filter);
+            texture->set_magnification_filter(sampling.magnification_filter);
+            texture->set_anisotropy(sampling.anisotropy);
+            texture->set_mipmaps_enabled(sampling.mipmaps_enabled);
+            texture->set_release_image_data_after_upload(true);
+            _entries[key] = Entry{texture, path, false, 0};
+
+            _remove_expired_entries();
+
+            return texture;
+        }
+
+        [[nodiscard]] size_t get_byte_budget() const
+        {
+            return _byte_budget;
+        }
+
+        void set_byte_budget(size_t byte_budget)
+        {
+            _byte_budget = byte_budget;
+        }
+
+        // The estimated memory of the cached textures as of the last update().
+        [[nodiscard]] size_t get_resident_byte_count() const
+        {
+            return _resident_byte_count;
+        }
+
+        [[nodiscard]] size_t get_texture_count() const
+        {
+            size_t count{0};
+            for (const auto &entry : _entries)
+            {
+                if (!entry.second.texture.expired())
+                {
+                    ++count;
+                }
+            }
+
+            return count;
+        }
+
+        [[nodiscard]] size_t get_evicted_texture_count() const
+        {
+            size_t count{0};
+            for (const auto &entry : _entries)
+            {
+                if (entry.second.evicted && !entry.second.texture.expired())
+                {
+                    ++count;
+                }
+            }
+
+            return count;
+        }
+
+        void update()
+        {
+            _remove_expired_entries();
+
+            uint64_t frame_start = _frame_start;
+            _frame_start = Texture::get_use_clock();
+
+            _resident_byte_count = 0;
+            std::vector<std::pair<uint64_t, Entry *>> candidates;
+            for (auto &[key, entry] : _entries)
+            {
+                std::shared_ptr<Texture> texture = entry.texture.lock();
+                if (entry.evicted)
+                {
+                    if (texture->get_last_use() > entry.eviction_time)
+                    {
+                        _texture_loader.reload(entry.path, texture);
+                        entry.evicted = false;
+                    }
+                    continue;
+                }
+
+                _resident_byte_count += _calculate_byte_count(*texture);
+                if (texture->get_last_use() <= frame_start)
+                {
+                    candidates.emplace_back(texture->get_last_use(), &entry);
+                }
+            }
+
+            if (_resident_byte_count <= _byte_budget)
+            {
+                return;
+            }
+
+            std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+                return a.first < b.first;
+            });
+            for (auto &[last_use, entry] : candidates)
+            {
+                if (_resident_byte_count <= _byte_budget)
+                {
+                    break;
+                }
+
+                std::shared_ptr<Texture> texture = entry->texture.lock();
+                size_t byte_count = _calculate_byte_count(*texture);
+                texture->set_image(std::vector<uint8_t>{255, 255, 255, 255}, 1, 1, 4);
+                // Textures that are not drawn are not updated either, so the storage is replaced right away.
+                texture->update(0);
+                entry->evicted = true;
+                entry->eviction_time = Texture::get_use_clock();
+                _resident_byte_count -= std::min(byte_count - _calculate_byte_count(*texture), _resident_byte_count);
+            }
+        }
+
+    private:
+        typedef std::tuple<std::type_index, std::string, Texture::WrapMode, Texture::WrapMode,
+                           Texture::FilterType, Texture::FilterType, float, bool> key_type;
+
+        struct Entry
+        {
+            std::weak_ptr<Texture> texture;
+            std::string path;
+            bool evicted;
+            uint64_t eviction_time;
+        };
+
+        TextureLoader &_texture_loader;
+        size_t _byte_budget;
+        size_t _resident_byte_count{0};
+        uint64_t _frame_start{0};
+
+        std::map<key_type, Entry> _entries;
+
+        // Drivers usually store three channel images with four, and a full mipmap chain adds a third.
+        static size_t _calculate_byte_count(const Texture &texture)
+        {
+            size_t byte_count{0};
+            if (const auto &compressed_data = texture.get_compressed_data())
+            {
+                const auto &levels = compressed_data->get_levels();
+                size_t level_count = texture.are_mipmaps_enabled() ? levels.size() : std::min<size_t>(levels.size(), 1);
+                for (size_t i = 0; i < level_count; ++i)
+                {
+                    byte_count += levels[i].size;
+                }
+
+                return byte_count;
+            }
+
+            byte_count = static_cast<size_t>(texture.get_width()) * texture.get_height() * 4;
+            if (texture.are_mipmaps_enabled())
+            {
+                byte_count += byte_count / 3;
+            }
+
+            return byte_count;
+        }
+
+        void _remove_expired_entries()
+        {
+            for (auto entry = _entries.begin(); entry != _entries.end();)
+            {
+                if (entry->second.texture.expired())
+                {
+                    entry = _entries.erase(entry);
+                }
+                else
+                {
+                    ++entry;
+                }
+            }
+        }
+    };
+}
+
+#endif
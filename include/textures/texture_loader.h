@@ -0,0 +1,159 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include "textures/texture.h"
+#include "utilities/utilities.h"
+#include "utilities/job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Decodes image files on a pool of loader threads. load() returns right away with a texture that holds a
+    // single placeholder pixel; update() hands the decoded images to their textures on the rendering thread,
+    // a limited number of bytes per call, so that the uploads are spread over several frames. Files that fail
+    // to load keep their placeholder.
+    class TextureLoader
+    {
+    public:
+        inline static const size_t DEFAULT_UPDATE_BYTE_BUDGET = 8 * 1024 * 1024;
+
+        static TextureLoader &get_instance()
+        {
+            static TextureLoader instance;
+            return instance;
+        }
+
+        explicit TextureLoader(size_t thread_count = _get_default_thread_count()) : _job_system{thread_count} {}
+
+        TextureLoader(const TextureLoader &other) = delete;
+        TextureLoader &operator=(const TextureLoader &other) = delete;
+
+        ~TextureLoader()
+        {
+            wait();
+        }
+
+        template <typename TextureType>
+        std::shared_ptr<TextureType> load(const std::string &path, const glm::vec4 &placeholder_color = glm::vec4{1.0f})
+        {
+            std::vector<uint8_t> placeholder_data{
+                _convert_color_component_to_byte(placeholder_color.r),
+                _convert_color_component_to_byte(placeholder_color.g),
+                _convert_color_component_to_byte(placeholder_color.b),
+                _convert_color_component_to_byte(placeholder_color.a)};
+            auto texture = std::make_shared<TextureType>(placeholder_data, 1, 1, 4);
+            texture->set_path(path);
+            reload(path, texture);
+
+            return texture;
+        }
+
+        // Decodes the file again and hands it to an existing texture, which keeps its current image until then.
+        void reload(const std::string &path, const std::shared_ptr<Texture> &texture)
+        {
+            std::weak_ptr<Texture> weak_texture{texture};
+            _job_system.submit([this, path, weak_texture]() {
+                file_utilities::image_data_type image;
+                if (!file_utilities::try_read_image_file(path, image))
+                {
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock{_decoded_images_mutex};
+                _decoded_images.push_back(DecodedImage{weak_texture, std::move(image)});
+            }, _pending_loads);
+        }
+
+        [[nodiscard]] bool is_idle()
+        {
+            if (!_pending_loads.is_done())
+            {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock{_decoded_images_mutex};
+            return _decoded_images.empty();
+        }
+
+        // Called on the rendering thread. At least one image is handed over per call, even if it is larger
+        // than the budget.
+        void update(size_t byte_budget = DEFAULT_UPDATE_BYTE_BUDGET)
+        {
+            {
+                std::lock_guard<std::mutex> lock{_decoded_images_mutex};
+                size_t image_count{0};
+                size_t byte_count{0};
+                while (image_count < _decoded_images.size())
+                {
+                    size_t image_size = std::get<0>(_decoded_images[image_count].image).size();
+                    if (image_count > 0 && byte_count + image_size > byte_budget)
+                    {
+                        break;
+                    }
+                    byte_count += image_size;
+                    ++image_count;
+                }
+
+                _updated_images.clear();
+                std::move(_decoded_images.begin(), _decoded_images.begin() + static_cast<std::ptrdiff_t>(image_count),
+                          std::back_inserter(_updated_images));
+                _decoded_images.erase(_decoded_images.begin(), _decoded_images.begin() + static_cast<std::ptrdiff_t>(image_count));
+            }
+
+            for (auto &decoded_image : _updated_images)
+            {
+                if (auto texture = decoded_image.texture.lock())
+                {
+                    auto &[image_data, width, height, channels] = decoded_image.image;
+                    texture->set_image(std::move(image_data), width, height, channels);
+                }
+            }
+            _updated_images.clear();
+        }
+
+        // Blocks until every requested file is decoded. The images still have to be handed over by update().
+        void wait()
+        {
+            _job_system.wait(_pending_loads);
+        }
+
+    private:
+        struct DecodedImage
+        {
+            std::weak_ptr<Texture> texture;
+            file_utilities::image_data_type image;
+        };
+
+        JobSystem _job_system;
+        JobSystem::Counter _pending_loads;
+
+        std::mutex _decoded_images_mutex;
+        std::vector<DecodedImage> _decoded_images;
+        std::vector<DecodedImage> _updated_images;
+
+        static size_t _get_default_thread_count()
+        {
+            return std::max<size_t>(std::thread::hardware_concurrency() / 2, 1);
+        }
+
+        static uint8_t _convert_color_component_to_byte(float component)
+        {
+            return static_cast<uint8_t>(std::clamp(component, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    };
+}
+
+#endif
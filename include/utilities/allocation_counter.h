@@ -0,0 +1,74 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+namespace asr
+{
+    // Counts calls to the global operator new in debug builds. The replacement operators are only emitted by
+    // the single translation unit that defines ASR_ALLOCATION_COUNTER_IMPLEMENTATION before including this
+    // header, which also works when the header was already included through a precompiled asr.h. Release
+    // builds and programs without the implementation always report zero.
+    class AllocationCounter
+    {
+    public:
+        [[nodiscard]] static size_t get_count()
+        {
+            return _count.load(std::memory_order_relaxed);
+        }
+
+        static void increment()
+        {
+            _count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+    private:
+        inline static std::atomic<size_t> _count{0};
+    };
+}
+
+#endif
+
+#if !defined(NDEBUG) && defined(ASR_ALLOCATION_COUNTER_IMPLEMENTATION) && !defined(ASR_ALLOCATION_COUNTER_IMPLEMENTED)
+#define ASR_ALLOCATION_COUNTER_IMPLEMENTED
+
+void *operator new(std::size_t size)
+{
+    asr::AllocationCounter::increment();
+    if (void *memory = std::malloc(size > 0 ? size : 1))
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t /* size */) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t /* size */) noexcept
+{
+    std::free(memory);
+}
+
+#endif
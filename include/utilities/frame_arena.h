@@ -0,0 +1,95 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <memory>
+#include <new>
+#include <vector>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // A linear allocator for scratch data that lives for a single frame. Allocations only bump an offset and
+    // everything is released at once by reset(). When a frame needs more memory than the block holds, the
+    // excess is served from overflow blocks and the block grows on the next reset, so a steady workload stops
+    // allocating after a few frames.
+    class FrameArena
+    {
+    public:
+        explicit FrameArena(size_t capacity = 64 * 1024)
+            : _block{std::make_unique<uint8_t[]>(capacity)}, _capacity{capacity}
+        {
+        }
+
+        FrameArena(const FrameArena &other) = delete;
+        FrameArena &operator=(const FrameArena &other) = delete;
+
+        [[nodiscard]] size_t get_capacity() const
+        {
+            return _capacity;
+        }
+
+        [[nodiscard]] size_t get_used_size() const
+        {
+            return _offset + _overflow_size;
+        }
+
+        void *allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+        {
+            auto address = reinterpret_cast<uintptr_t>(_block.get()) + _offset;
+            size_t padding = (alignment - address % alignment) % alignment;
+            if (_offset + padding + size <= _capacity)
+            {
+                _offset += padding + size;
+                return _block.get() + (_offset - size);
+            }
+
+            size_t overflow_size = size + alignment;
+            _overflow_blocks.push_back(std::make_unique<uint8_t[]>(overflow_size));
+            _overflow_size += overflow_size;
+
+            void *overflow_block = _overflow_blocks.back().get();
+            return std::align(alignment, size, overflow_block, overflow_size);
+        }
+
+        // Value-initialised elements that stay valid until the next reset. Destructors are never run, so only
+        // trivially destructible types are accepted.
+        template <typename T>
+        T *allocate(size_t count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "frame arena elements are never destroyed");
+
+            auto values = static_cast<T *>(allocate(std::max<size_t>(count, 1) * sizeof(T), alignof(T)));
+            for (size_t i = 0; i < count; ++i)
+            {
+                new (values + i) T();
+            }
+
+            return values;
+        }
+
+        void reset()
+        {
+            if (!_overflow_blocks.empty())
+            {
+                _capacity = std::max(_capacity * 2, _offset + _overflow_size);
+                _block = std::make_unique<uint8_t[]>(_capacity);
+                _overflow_blocks.clear();
+                _overflow_size = 0;
+            }
+            _offset = 0;
+        }
+
+    private:
+        std::unique_ptr<uint8_t[]> _block;
+        size_t _capacity;
+        size_t _offset{0};
+
+        std::vector<std::unique_ptr<uint8_t[]>> _overflow_blocks;
+        size_t _overflow_size{0};
+    };
+}
+
+#endif
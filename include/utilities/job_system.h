@@ -0,0 +1,352 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace asr
+{
+    // A fixed pool of worker threads with one job queue per worker. Workers take their own newest jobs first
+    // and steal the oldest jobs of the other queues when they run dry. Threads that wait for a counter keep
+    // executing queued jobs instead of blocking. Ranges queued by parallel_for are plain structs in ring
+    // buffers that keep their capacity, so they do not allocate once the queues have grown.
+    class JobSystem
+    {
+    public:
+        typedef std::function<void()> job_type;
+
+        class Counter
+        {
+        public:
+            Counter() = default;
+
+            Counter(const Counter &other) = delete;
+            Counter &operator=(const Counter &other) = delete;
+
+            [[nodiscard]] bool is_done() const
+            {
+                return _value.load(std::memory_order_acquire) == 0;
+            }
+
+        private:
+            friend class JobSystem;
+
+            std::atomic<size_t> _value{0};
+        };
+
+        static JobSystem &get_instance()
+        {
+            static JobSystem instance;
+            return instance;
+        }
+
+        explicit JobSystem(size_t worker_count = _get_default_worker_count())
+        {
+            _queues.reserve(worker_count + 1);
+            for (size_t i = 0; i <= worker_count; ++i)
+            {
+                _queues.push_back(std::make_unique<Queue>());
+            }
+
+            _workers.reserve(worker_count);
+            for (size_t i = 0; i < worker_count; ++i)
+            {
+                _workers.emplace_back([this, i]() {
+                    _run_worker(i + 1);
+                });
+            }
+        }
+
+        JobSystem(const JobSystem &other) = delete;
+        JobSystem &operator=(const JobSystem &other) = delete;
+
+        ~JobSystem()
+        {
+            {
+                std::lock_guard<std::mutex> lock{_sleep_mutex};
+                _stopping = true;
+            }
+            _sleep_condition.notify_all();
+
+            for (auto &worker : _workers)
+            {
+                worker.join();
+            }
+        }
+
+        [[nodiscard]] size_t get_worker_count() const
+        {
+            return _workers.size();
+        }
+
+        void submit(job_type job, Counter &counter)
+        {
+            if (_workers.empty())
+            {
+                job();
+                return;
+            }
+
+            _push(Job{&_invoke_function, new job_type{std::move(job)}, 0, 0, &counter});
+        }
+
+        void wait(Counter &counter)
+        {
+            size_t queue_index = _get_submission_queue_index();
+            while (!counter.is_done())
+            {
+                Job job;
+                if (_try_pop(queue_index, job))
+                {
+                    _execute(job);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        // Calls function(begin, end) for consecutive ranges of at most grain_size elements and returns once
+        // all of them are finished. The calling thread processes the first range itself.
+        template <typename Function>
+        void parallel_for(size_t count, size_t grain_size, const Function &function)
+        {
+            grain_size = std::max<size_t>(grain_size, 1);
+            if (count <= grain_size || _workers.empty())
+            {
+                if (count > 0)
+                {
+                    function(static_cast<size_t>(0), count);
+                }
+                return;
+            }
+
+            Counter counter;
+            for (size_t begin = grain_size; begin < count; begin += grain_size)
+            {
+                size_t end = std::min(begin + grain_size, count);
+                _push(Job{&_invoke_range<Function>, const_cast<Function *>(&function), begin, end, &counter});
+            }
+            function(static_cast<size_t>(0), grain_size);
+            wait(counter);
+        }
+
+        // Sorts chunks of grain_size elements in parallel and merges them pairwise. The merges alternate
+        // between the range and the scratch buffer, which has to hold at least last - first elements.
+        template <typename T, typename Compare>
+        void parallel_sort(T *first, T *last, T *scratch, Compare compare, size_t grain_size)
+        {
+            auto count = static_cast<size_t>(last - first);
+            grain_size = std::max<size_t>(grain_size, 1);
+            if (count <= grain_size || _workers.empty())
+            {
+                std::sort(first, last, compare);
+                return;
+            }
+
+            size_t chunk_count = (count + grain_size - 1) / grain_size;
+            parallel_for(chunk_count, 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    std::sort(first + i * grain_size, first + std::min((i + 1) * grain_size, count), compare);
+                }
+            });
+
+            T *source = first;
+            T *destination = scratch;
+            for (size_t width = grain_size; width < count; width *= 2)
+            {
+                size_t merge_count = (count + 2 * width - 1) / (2 * width);
+                parallel_for(merge_count, 1, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        size_t merge_first = i * 2 * width;
+                        size_t middle = std::min(merge_first + width, count);
+                        size_t merge_last = std::min(merge_first + 2 * width, count);
+                        std::merge(source + merge_first, source + middle, source + middle, source + merge_last,
+                                   destination + merge_first, compare);
+                    }
+                });
+                std::swap(source, destination);
+            }
+
+            if (source != first)
+            {
+                std::copy(source, source + count, first);
+            }
+        }
+
+    private:
+        struct Job
+        {
+            void (*invoke)(void *context, size_t begin, size_t end);
+            void *context;
+            size_t begin;
+            size_t end;
+            Counter *counter;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::vector<Job> jobs{16};
+            size_t first{0};
+            size_t count{0};
+
+            void push_back(const Job &job)
+            {
+                if (count == jobs.size())
+                {
+                    std::vector<Job> grown_jobs(jobs.size() * 2);
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        grown_jobs[i] = jobs[(first + i) % jobs.size()];
+                    }
+                    jobs.swap(grown_jobs);
+                    first = 0;
+                }
+                jobs[(first + count) % jobs.size()] = job;
+                ++count;
+            }
+
+            Job pop_back()
+            {
+                --count;
+                return jobs[(first + count) % jobs.size()];
+            }
+
+            Job pop_front()
+            {
+                Job job = jobs[first];
+                first = (first + 1) % jobs.size();
+                --count;
+                return job;
+            }
+        };
+
+        inline static thread_local const JobSystem *_current_job_system{nullptr};
+        inline static thread_local size_t _current_queue_index{0};
+
+        std::vector<std::unique_ptr<Queue>> _queues;
+        std::vector<std::thread> _workers;
+
+        std::mutex _sleep_mutex;
+        std::condition_variable _sleep_condition;
+        size_t _pending_job_count{0};
+        bool _stopping{false};
+
+        static size_t _get_default_worker_count()
+        {
+            unsigned int hardware_concurrency = std::thread::hardware_concurrency();
+            return hardware_concurrency > 1 ? hardware_concurrency - 1 : 0;
+        }
+
+        template <typename Function>
+        static void _invoke_range(void *context, size_t begin, size_t end)
+        {
+            (*static_cast<const Function *>(context))(begin, end);
+        }
+
+        static void _invoke_function(void *context, size_t /* begin */, size_t /* end */)
+        {
+            std::unique_ptr<job_type> function{static_cast<job_type *>(context)};
+            (*function)();
+        }
+
+        void _push(const Job &job)
+        {
+            job.counter->_value.fetch_add(1, std::memory_order_relaxed);
+
+            Queue &queue = *_queues[_get_submission_queue_index()];
+            {
+                std::lock_guard<std::mutex> lock{queue.mutex};
+                queue.push_back(job);
+            }
+            {
+                std::lock_guard<std::mutex> lock{_sleep_mutex};
+                ++_pending_job_count;
+            }
+            _sleep_condition.notify_one();
+        }
+
+        [[nodiscard]] size_t _get_submission_queue_index() const
+        {
+            return _current_job_system == this ? _current_queue_index : 0;
+        }
+
+        void _run_worker(size_t queue_index)
+        {
+            _current_job_system = this;
+            _current_queue_index = queue_index;
+
+            while (true)
+            {
+                Job job;
+                if (_try_pop(queue_index, job))
+                {
+                    _execute(job);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock{_sleep_mutex};
+                _sleep_condition.wait(lock, [this]() {
+                    return _stopping || _pending_job_count > 0;
+                });
+                if (_stopping && _pending_job_count == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+        bool _try_pop(size_t queue_index, Job &job)
+        {
+            {
+                Queue &queue = *_queues[queue_index];
+                std::lock_guard<std::mutex> lock{queue.mutex};
+                if (queue.count > 0)
+                {
+                    job = queue.pop_back();
+                    _on_job_taken();
+                    return true;
+                }
+            }
+
+            for (size_t i = 1; i < _queues.size(); ++i)
+            {
+                Queue &queue = *_queues[(queue_index + i) % _queues.size()];
+                std::lock_guard<std::mutex> lock{queue.mutex};
+                if (queue.count > 0)
+                {
+                    job = queue.pop_front();
+                    _on_job_taken();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void _on_job_taken()
+        {
+            std::lock_guard<std::mutex> lock{_sleep_mutex};
+            --_pending_job_count;
+        }
+
+        static void _execute(Job &job)
+        {
+            job.invoke(job.context, job.begin, job.end);
+            job.counter->_value.fetch_sub(1, std::memory_order_release);
+        }
+    };
+}
+
+#endif
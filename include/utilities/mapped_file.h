@@ -0,0 +1,146 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace asr
+{
+    // A read-only memory mapping of a whole file. The pages are only read from disk when they are touched.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+
+        MappedFile(const MappedFile &other) = delete;
+        MappedFile &operator=(const MappedFile &other) = delete;
+
+        ~MappedFile()
+        {
+            close();
+        }
+
+        bool open(const std::string &path)
+        {
+            close();
+
+#ifdef _WIN32
+            _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (_file == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+            {
+                close();
+                return false;
+            }
+            _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (_mapping == nullptr)
+            {
+                close();
+                return false;
+            }
+            _data = static_cast<const uint8_t *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+            if (_data == nullptr)
+            {
+                close();
+                return false;
+            }
+            _size = static_cast<size_t>(size.QuadPart);
+#else
+            int file = ::open(path.c_str(), O_RDONLY);
+            if (file < 0)
+            {
+                return false;
+            }
+
+            struct stat file_status{};
+            if (fstat(file, &file_status) != 0 || file_status.st_size == 0)
+            {
+                ::close(file);
+                return false;
+            }
+            void *data = mmap(nullptr, static_cast<size_t>(file_status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            ::close(file);
+            if (data == MAP_FAILED)
+            {
+                return false;
+            }
+            _data = static_cast<const uint8_t *>(data);
+            _size = static_cast<size_t>(file_status.st_size);
+#endif
+
+            return true;
+        }
+
+        void close()
+        {
+#ifdef _WIN32
+            if (_data != nullptr)
+            {
+                UnmapViewOfFile(_data);
+            }
+            if (_mapping != nullptr)
+            {
+                CloseHandle(_mapping);
+                _mapping = nullptr;
+            }
+            if (_file != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(_file);
+                _file = INVALID_HANDLE_VALUE;
+            }
+#else
+            if (_data != nullptr)
+            {
+                munmap(const_cast<uint8_t *>(_data), _size);
+            }
+#endif
+            _data = nullptr;
+            _size = 0;
+        }
+
+        [[nodiscard]] bool is_open() const
+        {
+            return _data != nullptr;
+        }
+
+        [[nodiscard]] const uint8_t *get_data() const
+        {
+            return _data;
+        }
+
+        [[nodiscard]] size_t get_size() const
+        {
+            return _size;
+        }
+
+    private:
+        const uint8_t *_data{nullptr};
+        size_t _size{0};
+
+#ifdef _WIN32
+        HANDLE _file{INVALID_HANDLE_VALUE};
+        HANDLE _mapping{nullptr};
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Fixed-size blocks for scene nodes and the control blocks of their shared pointers, carved from slabs of
+    // SLAB_SIZE bytes. Building a scene only bumps an offset into the current slab, so nodes created in the
+    // order they are traversed lie next to each other in memory, and tearing it down pushes the blocks onto a
+    // free list that the next scene is built from without going back to the heap. Blocks are rounded up to
+    // cache lines, so nodes whose world matrices are resolved on different threads never share one.
+    class NodePool
+    {
+    public:
+        inline static const size_t SLAB_SIZE = 256 * 1024;
+        inline static const size_t BLOCK_ALIGNMENT = 64;
+        // Larger allocations, like arrays of nodes, come from the heap.
+        inline static const size_t MAX_BLOCK_SIZE = 4096;
+
+        explicit NodePool(size_t block_size)
+            : _block_size{(std::max(block_size, sizeof(FreeBlock)) + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT}
+        {
+        }
+
+        NodePool(const NodePool &other) = delete;
+        NodePool &operator=(const NodePool &other) = delete;
+
+        ~NodePool()
+        {
+            for (uint8_t *slab : _slabs)
+            {
+                ::operator delete(slab, std::align_val_t{BLOCK_ALIGNMENT});
+            }
+        }
+
+        // The pool of a block size. Pools are never destroyed, so nodes that are still alive when the static
+        // objects of the program are destroyed can return their blocks safely.
+        template <size_t BlockSize>
+        static NodePool &get_instance()
+        {
+            static auto *instance = new NodePool(BlockSize);
+            return *instance;
+        }
+
+        [[nodiscard]] size_t get_block_size() const
+        {
+            return _block_size;
+        }
+
+        [[nodiscard]] size_t get_live_block_count() const
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            return _live_block_count;
+        }
+
+        [[nodiscard]] size_t get_slab_count() const
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            return _slabs.size();
+        }
+
+        void *allocate()
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            ++_live_block_count;
+            if (_free_blocks != nullptr)
+            {
+                FreeBlock *block = _free_blocks;
+                _free_blocks = block->next;
+                return block;
+            }
+
+            if (_slabs.empty() || _slab_offset + _block_size > SLAB_SIZE)
+            {
+                _slabs.push_back(static_cast<uint8_t *>(::operator new(SLAB_SIZE, std::align_val_t{BLOCK_ALIGNMENT})));
+                _slab_offset = 0;
+            }
+            void *block = _slabs.back() + _slab_offset;
+            _slab_offset += _block_size;
+
+            return block;
+        }
+
+        void deallocate(void *memory)
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            auto *block = static_cast<FreeBlock *>(memory);
+            block->next = _free_blocks;
+            _free_blocks = block;
+            --_live_block_count;
+        }
+
+    private:
+        struct FreeBlock
+        {
+            FreeBlock *next;
+        };
+
+        size_t _block_size;
+        std::vector<uint8_t *> _slabs;
+        size_t _slab_offset{0};
+        FreeBlock *_free_blocks{nullptr};
+        size_t _live_block_count{0};
+        mutable std::mutex _mutex;
+    };
+
+    // Serves single objects from the node pool of their size, and everything else from the heap.
+    template <typename T>
+    struct NodePoolAllocator
+    {
+        typedef T value_type;
+
+        NodePoolAllocator() = default;
+
+        template <typename U>
+        NodePoolAllocator(const NodePoolAllocator<U> & /*other*/) noexcept {}
+
+        static constexpr bool is_pooled()
+        {
+            return sizeof(T) <= NodePool::MAX_BLOCK_SIZE && alignof(T) <= NodePool::BLOCK_ALIGNMENT;
+        }
+
+        // Sizes that round up to the same number of cache lines share a pool.
+        static NodePool &get_pool()
+        {
+            return NodePool::get_instance<(sizeof(T) + NodePool::BLOCK_ALIGNMENT - 1) / NodePool::BLOCK_ALIGNMENT *
+                                          NodePool::BLOCK_ALIGNMENT>();
+        }
+
+        T *allocate(size_t count)
+        {
+            if (is_pooled() && count == 1)
+            {
+                return static_cast<T *>(get_pool().allocate());
+            }
+
+            return std::allocator<T>{}.allocate(count);
+        }
+
+        void deallocate(T *pointer, size_t count)
+        {
+            if (is_pooled() && count == 1)
+            {
+                get_pool().deallocate(pointer);
+                return;
+            }
+
+            std::allocator<T>{}.deallocate(pointer, count);
+        }
+
+        template <typename U>
+        bool operator==(const NodePoolAllocator<U> & /*other*/) const
+        {
+            return true;
+        }
+
+        template <typename U>
+        bool operator!=(const NodePoolAllocator<U> & /*other*/) const
+        {
+            return false;
+        }
+    };
+
+    // Creates a node, like an Object, a Mesh, a Camera or a light, in a single block of the node pool that also
+    // holds the reference counts of its shared pointer.
+    template <typename T, typename... Arguments>
+    std::shared_ptr<T> create_node(Arguments &&...arguments)
+    {
+        return std::allocate_shared<T>(NodePoolAllocator<T>{}, std::forward<Arguments>(arguments)...);
+    }
+}
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace asr
+{
+    // Records timed zones into a ring buffer per thread. Only the owning thread writes to its buffer, so
+    // recording a zone takes no lock; the buffers are registered once per thread. Zones are only recorded
+    // while the profiler is enabled, and the oldest ones are overwritten when a buffer is full.
+    class Profiler
+    {
+    public:
+        inline static const size_t EVENTS_PER_THREAD = 32768;
+
+        static Profiler &get_instance()
+        {
+            static Profiler instance;
+            return instance;
+        }
+
+        Profiler(const Profiler &other) = delete;
+        Profiler &operator=(const Profiler &other) = delete;
+
+        [[nodiscard]] bool is_enabled() const
+        {
+            return _enabled.load(std::memory_order_relaxed);
+        }
+
+        void set_enabled(bool enabled)
+        {
+            _enabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        // Nanoseconds since the profiler was created.
+        [[nodiscard]] uint64_t get_time() const
+        {
+            return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start_time).count());
+        }
+
+        // The name has to outlive the profiler, so zones are normally named with string literals.
+        void record(const char *name, uint64_t begin_time, uint64_t end_time)
+        {
+            ThreadBuffer &buffer = _get_thread_buffer();
+            size_t head = buffer.head.load(std::memory_order_relaxed);
+            buffer.events[head % EVENTS_PER_THREAD] = Event{name, begin_time, end_time};
+            buffer.head.store(head + 1, std::memory_order_release);
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock{_thread_buffers_mutex};
+            for (auto &buffer : _thread_buffers)
+            {
+                buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+            }
+        }
+
+        // Writes the recorded zones in the Chrome trace event format, which Perfetto and chrome://tracing open.
+        // Threads that keep recording while the file is written may overwrite the events that are being read,
+        // so traces are best written between frames.
+        bool write_chrome_trace(const std::string &path)
+        {
+            std::ofstream file{path};
+            if (!file)
+            {
+                std::cerr << "Failed to open the file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            file << "{\"traceEvents\":[";
+            bool first = true;
+            {
+                std::lock_guard<std::mutex> lock{_thread_buffers_mutex};
+                for (const auto &buffer : _thread_buffers)
+                {
+                    size_t head = buffer->head.load(std::memory_order_acquire);
+                    size_t tail = buffer->tail.load(std::memory_order_relaxed);
+                    size_t begin = std::max(tail, head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : size_t{0});
+                    for (size_t i = begin; i < head; ++i)
+                    {
+                        const Event &event = buffer->events[i % EVENTS_PER_THREAD];
+                        file << (first ? "\n" : ",\n")
+                             << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread_id
+                             << ",\"ts\":" << static_cast<double>(event.begin_time) / 1000.0
+                             << ",\"dur\":" << static_cast<double>(event.end_time - event.begin_time) / 1000.0 << "}";
+                        first = false;
+                    }
+                }
+            }
+            file << "\n]}\n";
+
+            if (!file)
+            {
+                std::cerr << "Failed to write the file: '" << path << "'" << std::endl;
+                return false;
+            }
+
+            return true;
+        }
+
+    private:
+        struct Event
+        {
+            const char *name;
+            uint64_t begin_time;
+            uint64_t end_time;
+        };
+
+        struct ThreadBuffer
+        {
+            explicit ThreadBuffer(size_t thread_id) : events(EVENTS_PER_THREAD), thread_id{thread_id} {}
+
+            std::vector<Event> events;
+            std::atomic<size_t> head{0};
+            std::atomic<size_t> tail{0};
+            size_t thread_id;
+        };
+
+        Profiler() : _start_time{std::chrono::steady_clock::now()} {}
+
+        std::atomic<bool> _enabled{false};
+        std::chrono::steady_clock::time_point _start_time;
+
+        // The buffers stay registered after their threads exit, so their zones can still be written out.
+        std::mutex _thread_buffers_mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> _thread_buffers;
+
+        ThreadBuffer &_get_thread_buffer()
+        {
+            thread_local ThreadBuffer *thread_buffer{nullptr};
+            if (thread_buffer == nullptr)
+            {
+                std::lock_guard<std::mutex> lock{_thread_buffers_mutex};
+                _thread_buffers.push_back(std::make_unique<ThreadBuffer>(_thread_buffers.size()));
+                thread_buffer = _thread_buffers.back().get();
+            }
+
+            return *thread_buffer;
+        }
+    };
+
+    class ProfilerZone
+    {
+    public:
+        explicit ProfilerZone(const char *name)
+        {
+            Profiler &profiler = Profiler::get_instance();
+            if (profiler.is_enabled())
+            {
+                _name = name;
+                _begin_time = profiler.get_time();
+            }
+        }
+
+        ProfilerZone(const ProfilerZone &other) = delete;
+        ProfilerZone &operator=(const ProfilerZone &other) = delete;
+
+        ~ProfilerZone()
+        {
+            if (_name != nullptr)
+            {
+                Profiler &profiler = Profiler::get_instance();
+                profiler.record(_name, _begin_time, profiler.get_time());
+            }
+        }
+
+    private:
+        const char *_name{nullptr};
+        uint64_t _begin_time{0};
+    };
+}
+
+#define ASR_PROFILER_CONCATENATE_IMPLEMENTATION(a, b) a##b
+#define ASR_PROFILER_CONCATENATE(a, b) ASR_PROFILER_CONCATENATE_IMPLEMENTATION(a, b)
+
+#ifdef ASR_PROFILER_DISABLED
+#define ASR_PROFILE_SCOPE(name) ((void)0)
+#else
+#define ASR_PROFILE_SCOPE(name) ::asr::ProfilerZone ASR_PROFILER_CONCATENATE(asr_profiler_zone_, __LINE__){name}
+#endif
+
+#endif
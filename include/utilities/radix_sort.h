@@ -0,0 +1,50 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+namespace asr
+{
+    // Stable least-significant-digit radix sort of values by an unsigned 32-bit key, one byte per pass. The
+    // scratch buffer has to hold count values. Passes in which every key shares the same byte are skipped.
+    template <typename T, typename KeyFunction>
+    void radix_sort(T *values, T *scratch, size_t count, KeyFunction key)
+    {
+        T *source = values;
+        T *destination = scratch;
+        for (unsigned int shift = 0; shift < 32; shift += 8)
+        {
+            size_t offsets[256] = {};
+            for (size_t i = 0; i < count; ++i)
+            {
+                ++offsets[(static_cast<uint32_t>(key(source[i])) >> shift) & 0xFFu];
+            }
+            if (count == 0 || offsets[(static_cast<uint32_t>(key(source[0])) >> shift) & 0xFFu] == count)
+            {
+                continue;
+            }
+
+            size_t offset{0};
+            for (size_t &bucket : offsets)
+            {
+                size_t bucket_size = bucket;
+                bucket = offset;
+                offset += bucket_size;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                destination[offsets[(static_cast<uint32_t>(key(source[i])) >> shift) & 0xFFu]++] = source[i];
+            }
+            std::swap(source, destination);
+        }
+
+        if (source != values)
+        {
+            std::copy(source, source + count, values);
+        }
+    }
+}
+
+#endif
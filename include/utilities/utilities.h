@@ -1,7 +1,6 @@
 #ifndef UTILITIES_H
 #define UTILITIES_H
 
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 #include <tuple>
@@ -11,6 +10,7 @@
 #include <cstdlib>
 #include <sstream>
 #include <vector>
+#include <utility>
 
 namespace asr::file_utilities
 {
@@ -31,7 +31,8 @@ namespace asr::file_utilities
         return string_stream.str();
     }
 
-    static image_data_type read_image_file(const std::string &path)
+    // Reports failures on std::cerr and returns false instead of exiting, so it can be used by loader threads.
+    static bool try_read_image_file(const std::string &path, image_data_type &image)
     {
         int image_width, image_height;
         int bytes_per_pixel;
@@ -40,19 +41,33 @@ namespace asr::file_utilities
         if (!image_data)
         {
             std::cerr << "Failed to open the file: '" << path << "'" << std::endl;
-            std::exit(-1);
+            return false;
         }
         if (!(bytes_per_pixel == 3 || bytes_per_pixel == 4))
         {
             std::cerr << "Invalid image file format (only RGB and RGBA files are supported): '" << path << "'"
                       << std::endl;
-            std::exit(-1);
+            stbi_image_free(image_data);
+            return false;
         }
 
         std::vector<uint8_t> result{image_data, image_data + image_height * image_width * bytes_per_pixel};
         stbi_image_free(image_data);
 
-        return std::make_tuple(result, image_width, image_height, bytes_per_pixel);
+        image = std::make_tuple(std::move(result), image_width, image_height, bytes_per_pixel);
+
+        return true;
+    }
+
+    static image_data_type read_image_file(const std::string &path)
+    {
+        image_data_type image;
+        if (!try_read_image_file(path, image))
+        {
+            std::exit(-1);
+        }
+
+        return image;
     }
 }
 
@@ -0,0 +1,140 @@
+#ifndef ES2_HEADLESS_WINDOW_H
+#define ES2_HEADLESS_WINDOW_H
+
+#include "window/window.h"
+#include "utilities/profiler.h"
+
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace asr
+{
+    // An OpenGL context created through EGL without a display server, drawing into a pixel buffer surface of
+    // the size of the window. The first GPU that EGL enumerates is used where EGL_EXT_platform_device is
+    // available, otherwise the default display. There is no input and no ImGui, so the stats overlay stays
+    // empty, and the frames are read back with an ES2PixelReader, optionally from an ES2RenderTarget.
+    class ES2HeadlessWindow final : public Window
+    {
+    public:
+        ES2HeadlessWindow(const std::string &name, unsigned int width, unsigned int height) : Window{name, width, height}
+        {
+            _display = _get_display();
+            if (_display == EGL_NO_DISPLAY || eglInitialize(_display, nullptr, nullptr) != EGL_TRUE)
+            {
+                std::cerr << "Failed to initialize EGL." << std::endl;
+                std::exit(-1);
+            }
+
+            const EGLint config_attributes[]{
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                EGL_RED_SIZE, 8,
+                EGL_GREEN_SIZE, 8,
+                EGL_BLUE_SIZE, 8,
+                EGL_ALPHA_SIZE, 8,
+                EGL_DEPTH_SIZE, 24,
+                EGL_STENCIL_SIZE, 8,
+                EGL_NONE};
+            EGLConfig config;
+            EGLint config_count{0};
+            if (eglChooseConfig(_display, config_attributes, &config, 1, &config_count) != EGL_TRUE || config_count == 0)
+            {
+                std::cerr << "Failed to find an EGL configuration for OpenGL." << std::endl;
+                std::exit(-1);
+            }
+
+            const EGLint surface_attributes[]{
+                EGL_WIDTH, static_cast<EGLint>(width),
+                EGL_HEIGHT, static_cast<EGLint>(height),
+                EGL_NONE};
+            _surface = eglCreatePbufferSurface(_display, config, surface_attributes);
+
+            eglBindAPI(EGL_OPENGL_API);
+            _context = eglCreateContext(_display, config, EGL_NO_CONTEXT, nullptr);
+            if (_surface == EGL_NO_SURFACE || _context == EGL_NO_CONTEXT ||
+                eglMakeCurrent(_display, _surface, _surface, _context) != EGL_TRUE)
+            {
+                std::cerr << "Failed to create a headless OpenGL context." << std::endl;
+                std::exit(-1);
+            }
+
+            // GLEW built for GLX loads the OpenGL functions before it looks for an X display, so that error
+            // is expected without one.
+            GLenum result = glewInit();
+            if (result != GLEW_OK && result != GLEW_ERROR_NO_GLX_DISPLAY)
+            {
+                std::cerr << "Failed to initialize the OpenGL loader." << std::endl;
+                std::exit(-1);
+            }
+
+            _on_exit = []() {};
+            _on_key_down = [](int /* key */) {};
+            _on_late_keys_down = [](const uint8_t * /* keys */) {};
+            _on_mouse_move = [](int /* x */, int /* y */, int /* x_rel */, int /* y_rel */) {};
+            _on_mouse_down = [](int /* button */, int /* x */, int /* y */) {};
+        }
+
+        ES2HeadlessWindow(const ES2HeadlessWindow &other) = delete;
+        ES2HeadlessWindow &operator=(const ES2HeadlessWindow &other) = delete;
+
+        ~ES2HeadlessWindow() final
+        {
+            eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(_display, _context);
+            eglDestroySurface(_display, _surface);
+            eglTerminate(_display);
+        }
+
+        void poll() final
+        {
+            if (_late_input_sampling_enabled)
+            {
+                _limit_frame_rate();
+            }
+        }
+
+        // Pixel buffer surfaces are not swapped, the frame is only handed to the GPU.
+        void swap() final
+        {
+            ASR_PROFILE_SCOPE("Window::swap");
+
+            if (!_late_input_sampling_enabled)
+            {
+                _limit_frame_rate();
+            }
+            glFlush();
+            _measure_frame_interval();
+        }
+
+    private:
+        EGLDisplay _display{EGL_NO_DISPLAY};
+        EGLSurface _surface{EGL_NO_SURFACE};
+        EGLContext _context{EGL_NO_CONTEXT};
+
+        static EGLDisplay _get_display()
+        {
+            auto query_devices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+            auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            EGLDeviceEXT device;
+            EGLint device_count{0};
+            if (query_devices != nullptr && get_platform_display != nullptr &&
+                query_devices(1, &device, &device_count) == EGL_TRUE && device_count > 0)
+            {
+                EGLDisplay display = get_platform_display(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+                if (display != EGL_NO_DISPLAY)
+                {
+                    return display;
+                }
+            }
+
+            return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+    };
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define ES2_SDL_WINDOW_H
 
 #include "window/window.h"
+#include "utilities/profiler.h"
 
 #include <GL/glew.h>
 #define SDL_MAIN_HANDLED
@@ -88,10 +89,7 @@ namespace asr
                 exit(-1);
             }
 
-            if (SDL_GL_SetSwapInterval(-1) < 0)
-            {
-                SDL_GL_SetSwapInterval(1);
-            }
+            set_swap_interval(_swap_interval);
 
             IMGUI_CHECKVERSION();
             ImGui::CreateContext();
@@ -125,6 +123,13 @@ namespace asr
 
         void poll() final
         {
+            ASR_PROFILE_SCOPE("Window::poll");
+
+            if (_late_input_sampling_enabled)
+            {
+                _limit_frame_rate();
+            }
+
             SDL_Event event;
             while (SDL_PollEvent(&event))
             {
@@ -156,9 +161,77 @@ namespace asr
 
         void swap() final
         {
+            ASR_PROFILE_SCOPE("Window::swap");
+
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            if (!_late_input_sampling_enabled)
+            {
+                _limit_frame_rate();
+            }
             SDL_GL_SwapWindow(_window);
+            if (_wait_for_gpu_enabled)
+            {
+                glFinish();
+            }
+            _measure_frame_interval();
+        }
+
+        [[nodiscard]] bool is_vsync_enabled() const
+        {
+            return _swap_interval != 0;
+        }
+
+        void set_vsync_enabled(bool vsync_enabled)
+        {
+            set_swap_interval(vsync_enabled ? -1 : 0);
+        }
+
+        // The number of vertical blanks a swap waits for. -1 waits for one unless the frame is late, which
+        // tears instead of stalling for a whole refresh, and falls back to 1 where it is not supported.
+        [[nodiscard]] int get_swap_interval() const
+        {
+            return _swap_interval;
+        }
+
+        void set_swap_interval(int swap_interval)
+        {
+            _swap_interval = swap_interval;
+            if (SDL_GL_SetSwapInterval(_swap_interval) < 0 && _swap_interval < 0)
+            {
+                _swap_interval = -_swap_interval;
+                SDL_GL_SetSwapInterval(_swap_interval);
+            }
+        }
+
+        // Waits for the GPU after every swap, so the CPU does not queue frames ahead of the display and the
+        // input of a frame is at most one frame old when it is shown, at the cost of the CPU and GPU no longer
+        // working in parallel.
+        [[nodiscard]] bool is_wait_for_gpu_enabled() const
+        {
+            return _wait_for_gpu_enabled;
+        }
+
+        void set_wait_for_gpu_enabled(bool wait_for_gpu_enabled)
+        {
+            _wait_for_gpu_enabled = wait_for_gpu_enabled;
+        }
+
+        [[nodiscard]] bool is_visible() const
+        {
+            return (SDL_GetWindowFlags(_window) & SDL_WINDOW_SHOWN) != 0;
+        }
+
+        void set_visible(bool visible)
+        {
+            if (visible)
+            {
+                SDL_ShowWindow(_window);
+            }
+            else
+            {
+                SDL_HideWindow(_window);
+            }
         }
 
         [[nodiscard]] bool is_relative_mouse_mode_enabled() const
@@ -204,6 +277,8 @@ namespace asr
         SDL_GLContext _gl_context;
         SDL_Window *_window{nullptr};
 
+        int _swap_interval{-1};
+        bool _wait_for_gpu_enabled{false};
         bool _relative_mouse_mode_enabled{false};
         bool _capture_mouse_enabled{false};
     };
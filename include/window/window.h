@@ -1,7 +1,9 @@
 #ifndef WINDOW_H
 #define WINDOW_H
 
+#include <chrono>
 #include <string>
+#include <thread>
 #include <utility>
 #include <functional>
 
@@ -79,6 +81,41 @@ namespace asr
             _on_mouse_down = on_mouse_down;
         }
 
+        // Frames are limited to the rate by sleeping, zero leaves them unlimited. The limit is applied before
+        // the swap, or, with late input sampling, at the start of poll(), so that the events are read and the
+        // frame is recorded right before it is presented.
+        [[nodiscard]] float get_target_frame_rate() const
+        {
+            return _target_frame_rate;
+        }
+
+        void set_target_frame_rate(float target_frame_rate)
+        {
+            _target_frame_rate = target_frame_rate;
+        }
+
+        [[nodiscard]] bool is_late_input_sampling_enabled() const
+        {
+            return _late_input_sampling_enabled;
+        }
+
+        void set_late_input_sampling_enabled(bool late_input_sampling_enabled)
+        {
+            _late_input_sampling_enabled = late_input_sampling_enabled;
+        }
+
+        // Milliseconds between the last two presented frames, zero before the second one.
+        [[nodiscard]] float get_frame_interval() const
+        {
+            return _frame_interval;
+        }
+
+        // The frame interval smoothed over roughly the last 20 frames.
+        [[nodiscard]] float get_average_frame_interval() const
+        {
+            return _average_frame_interval;
+        }
+
         virtual void poll() = 0;
 
         virtual void swap() = 0;
@@ -94,6 +131,56 @@ namespace asr
         std::function<void(const uint8_t *)> _on_late_keys_down;
         std::function<void(int, int, int, int)> _on_mouse_move;
         std::function<void(int, int, int)> _on_mouse_down;
+
+        float _target_frame_rate{0.0f};
+        bool _late_input_sampling_enabled{false};
+        float _frame_interval{0.0f};
+        float _average_frame_interval{0.0f};
+
+        // Sleeping wakes up late by up to the granularity of the scheduler, so the last part is spun.
+        void _limit_frame_rate()
+        {
+            if (_target_frame_rate <= 0.0f)
+            {
+                return;
+            }
+
+            auto frame_duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(1.0 / static_cast<double>(_target_frame_rate)));
+            auto now = std::chrono::steady_clock::now();
+            if (now < _next_frame_time)
+            {
+                std::this_thread::sleep_until(_next_frame_time - FRAME_LIMIT_SPIN_DURATION);
+                while (std::chrono::steady_clock::now() < _next_frame_time)
+                {
+                    std::this_thread::yield();
+                }
+                now = _next_frame_time;
+            }
+
+            // A frame that missed its time by more than a frame starts the schedule over instead of being
+            // followed by a burst of frames.
+            _next_frame_time = now - _next_frame_time > frame_duration ? now + frame_duration : _next_frame_time + frame_duration;
+        }
+
+        void _measure_frame_interval()
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (_last_present_time != std::chrono::steady_clock::time_point{})
+            {
+                _frame_interval = std::chrono::duration<float, std::milli>(now - _last_present_time).count();
+                _average_frame_interval = _average_frame_interval == 0.0f
+                                              ? _frame_interval
+                                              : _average_frame_interval + (_frame_interval - _average_frame_interval) * 0.05f;
+            }
+            _last_present_time = now;
+        }
+
+    private:
+        inline static const std::chrono::steady_clock::duration FRAME_LIMIT_SPIN_DURATION{std::chrono::milliseconds{1}};
+
+        std::chrono::steady_clock::time_point _next_frame_time;
+        std::chrono::steady_clock::time_point _last_present_time;
     };
 }
 
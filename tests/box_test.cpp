@@ -7,20 +7,19 @@
     auto window = std::make_shared<ES2SDLWindow>("asr");
 
     auto [box_indices, box_vertices] = geometry_generators::generate_box_geometry_data(150.0f, 70.0f, 150.0f, 150, 150, 150);
-    auto box_geometry = std::make_shared<ES2Geometry>(box_indices, box_vertices);
+    auto box_geometry = std::make_shared<ES2Geometry>(std::move(box_indices), std::move(box_vertices));
     auto box_material = std::make_shared<ES2PhongMaterial>();
     box_material->set_face_culling_enabled(false);
-    auto [image1_data, image1_width, image1_height, image1_channels] = file_utilities::read_image_file("data/images/room_cubemap.png");
-    auto [image1_normals_data, image1_normals_width, image1_normals_height, image1_normals_channels] = file_utilities::read_image_file("data/images/room_normalmap.png");
-    auto box_texture1 = std::make_shared<ES2Texture>(image1_data, image1_width, image1_height, image1_channels);
-    auto box_texture1_normals = std::make_shared<ES2Texture>(image1_normals_data, image1_normals_width, image1_normals_height, image1_normals_channels);
+    auto &texture_loader = TextureLoader::get_instance();
+    auto box_texture1 = texture_loader.load<ES2Texture>("data/images/room_cubemap.png");
+    auto box_texture1_normals = texture_loader.load<ES2Texture>("data/images/room_normalmap.png", glm::vec4{0.5f, 0.5f, 1.0f, 1.0f});
     box_material->set_texture_1(box_texture1);
     box_material->set_texture_1_normals(box_texture1_normals);
     box_material->set_ambient_color(glm::vec3{0.1f});
     auto box = std::make_shared<Mesh>(box_geometry, box_material);
 
     auto [lamp_indices, lamp_vertices] = geometry_generators::generate_sphere_geometry_data(0.05f, 20, 20);
-    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(lamp_indices, lamp_vertices);
+    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(std::move(lamp_indices), std::move(lamp_vertices));
     auto lamp_material = std::make_shared<ES2ConstantMaterial>();
     lamp_material->set_emission_color(glm::vec4(1.0f));
     auto lamp = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
@@ -84,6 +83,7 @@
     for (;;)
     {
         window->poll();
+        texture_loader.update();
 
         point_light->set_x(cosf(point_light_angle) * point_light_radius);
         point_light->set_z(sinf(point_light_angle) * point_light_radius);
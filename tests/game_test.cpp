@@ -40,7 +40,7 @@ public:
         _set_first_dying_texture_frame(first_dying_state_sprite_frame);
 
         auto [billboard_indices, billboard_vertices] = geometry_generators::generate_plane_geometry_data(size, size, 1, 1);
-        auto billboard_geometry = std::make_shared<ES2Geometry>(billboard_indices, billboard_vertices);
+        auto billboard_geometry = std::make_shared<ES2Geometry>(std::move(billboard_indices), std::move(billboard_vertices));
         auto billboard_material = std::make_shared<ES2ConstantMaterial>();
         billboard_material->set_texture_1(_texture);
         billboard_material->set_blending_enabled(true);
@@ -49,7 +49,6 @@ public:
 
         _mesh = std::make_shared<Mesh>(billboard_geometry, billboard_material);
         _mesh->set_position(position);
-        _bounding_volume = Sphere{_mesh->get_position(), size / 2};
     }
 
     [[nodiscard]] const std::shared_ptr<Mesh> &get_mesh() const
@@ -113,7 +112,6 @@ public:
             _velocity = glm::normalize(target - position) * _speed;
             _position += _velocity * delta_time;
             _mesh->set_position(_position);
-            _bounding_volume.set_center(_position);
         }
 
         _mesh->billboard_toward_camera(_target);
@@ -121,7 +119,7 @@ public:
 
     [[nodiscard]] bool intersects_with_ray(const Ray &ray) const
     {
-        return ray.intersects_with_sphere(_bounding_volume).first;
+        return _mesh->intersect_ray(ray).hit;
     }
 
     void kill()
@@ -141,7 +139,6 @@ private:
     glm::vec3 _velocity{0.0f};
 
     std::shared_ptr<Mesh> _mesh;
-    Sphere _bounding_volume{glm::vec3{0.0f}, 1.0f};
 
     std::shared_ptr<Camera> _target{nullptr};
 
@@ -200,7 +197,7 @@ public:
         _set_texture_frames(sprite_frame_count);
 
         auto [overlay_indices, overlay_vertices] = geometry_generators::generate_plane_geometry_data(2, 2, 1, 1);
-        auto overlay_geometry = std::make_shared<ES2Geometry>(overlay_indices, overlay_vertices);
+        auto overlay_geometry = std::make_shared<ES2Geometry>(std::move(overlay_indices), std::move(overlay_vertices));
         auto overlay_material = std::make_shared<ES2ConstantMaterial>();
         overlay_material->set_texture_1(_texture);
         overlay_material->set_blending_enabled(true);
@@ -248,7 +245,7 @@ public:
         }
     }
 
-    void shoot(const std::vector<std::shared_ptr<Enemy>> &enemies)
+    void shoot(RenderList &render_list, const std::vector<std::shared_ptr<Enemy>> &enemies)
     {
         if (_state == Idling)
         {
@@ -259,14 +256,18 @@ public:
                 return;
             }
 
-            for (auto &enemy : enemies)
-            {
-                if (enemy->intersects_with_ray(_point_of_view->world_ray_from_screen_point(_target.x, _target.y)))
+            Ray ray = _point_of_view->world_ray_from_screen_point(_target.x, _target.y);
+            render_list.get_bounding_volume_hierarchy().raycast(ray, [&](Mesh *mesh, float /* distance */) {
+                for (auto &enemy : enemies)
                 {
-                    enemy->kill();
-                    return;
+                    if (enemy->get_mesh().get() == mesh && enemy->intersects_with_ray(ray))
+                    {
+                        enemy->kill();
+                        return false;
+                    }
                 }
-            }
+                return true;
+            });
         }
     }
 
@@ -329,7 +330,7 @@ private:
     // Room
 
     auto [box_indices, box_vertices] = geometry_generators::generate_box_geometry_data(70.0f, 25.0f, 75.0f, 375, 375, 375);
-    auto box_geometry = std::make_shared<ES2Geometry>(box_indices, box_vertices);
+    auto box_geometry = std::make_shared<ES2Geometry>(std::move(box_indices), std::move(box_vertices));
     auto box_material = std::make_shared<ES2PhongMaterial>();
     box_material->set_face_culling_enabled(true);
     auto [image1_data, image1_width, image1_height, image1_channels] = file_utilities::read_image_file("data/images/room.png");
@@ -342,7 +343,7 @@ private:
     auto box = std::make_shared<Mesh>(box_geometry, box_material);
 
     auto [room_ground_indices, room_ground_vertices] = geometry_generators::generate_plane_geometry_data(50, 50, 1, 1);
-    auto room_ground_geometry = std::make_shared<ES2Geometry>(room_ground_indices, room_ground_vertices);
+    auto room_ground_geometry = std::make_shared<ES2Geometry>(std::move(room_ground_indices), std::move(room_ground_vertices));
     auto room_ground_material = std::make_shared<ES2PhongMaterial>();
     room_ground_material->set_specular_exponent(1.0f);
     room_ground_material->set_specular_color(glm::vec3{0.0f});
@@ -388,7 +389,7 @@ private:
     // Lamps
 
     auto [lamp_indices, lamp_vertices] = geometry_generators::generate_sphere_geometry_data(0.02f, 20, 20);
-    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(lamp_indices, lamp_vertices);
+    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(std::move(lamp_indices), std::move(lamp_vertices));
     auto lamp_material = std::make_shared<ES2ConstantMaterial>();
     auto lamp1 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
     auto lamp2 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
@@ -485,7 +486,7 @@ private:
                               { camera->add_to_rotation_y(static_cast<float>(-x_rel) * CAMERA_SENSITIVITY); });
 
     window->set_on_mouse_down([&](int button, int x, int y)
-                              { gun->shoot(enemies); });
+                              { gun->shoot(scene->get_render_list(), enemies); });
 
     // Music
 
@@ -40,7 +40,7 @@ public:
         _set_first_dying_texture_frame(first_dying_state_sprite_frame);
 
         auto [billboard_indices, billboard_vertices] = geometry_generators::generate_plane_geometry_data(size, size, 1, 1);
-        auto billboard_geometry = std::make_shared<ES2Geometry>(billboard_indices, billboard_vertices);
+        auto billboard_geometry = std::make_shared<ES2Geometry>(std::move(billboard_indices), std::move(billboard_vertices));
         auto billboard_material = std::make_shared<ES2ConstantMaterial>();
         billboard_material->set_texture_1(_texture);
         billboard_material->set_blending_enabled(true);
@@ -190,7 +190,7 @@ public:
         _set_texture_frames(sprite_frame_count);
 
         auto [overlay_indices, overlay_vertices] = geometry_generators::generate_plane_geometry_data(2, 2, 1, 1);
-        auto overlay_geometry = std::make_shared<ES2Geometry>(overlay_indices, overlay_vertices);
+        auto overlay_geometry = std::make_shared<ES2Geometry>(std::move(overlay_indices), std::move(overlay_vertices));
         auto overlay_material = std::make_shared<ES2ConstantMaterial>();
         overlay_material->set_texture_1(_texture);
         overlay_material->set_blending_enabled(true);
@@ -319,7 +319,7 @@ private:
     // Room Ground
 
     auto [room_ground_indices, room_ground_vertices] = geometry_generators::generate_plane_geometry_data(50, 50, 1, 1);
-    auto room_ground_geometry = std::make_shared<ES2Geometry>(room_ground_indices, room_ground_vertices);
+    auto room_ground_geometry = std::make_shared<ES2Geometry>(std::move(room_ground_indices), std::move(room_ground_vertices));
     auto room_ground_material = std::make_shared<ES2PhongMaterial>();
     room_ground_material->set_specular_exponent(1.0f);
     room_ground_material->set_specular_color(glm::vec3{0.0f});
@@ -361,7 +361,7 @@ private:
     // Lamps
 
     auto [lamp_indices, lamp_vertices] = geometry_generators::generate_sphere_geometry_data(0.2f, 20, 20);
-    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(lamp_indices, lamp_vertices);
+    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(std::move(lamp_indices), std::move(lamp_vertices));
     auto lamp_material = std::make_shared<ES2ConstantMaterial>();
     auto lamp1 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
     auto lamp2 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
@@ -0,0 +1,140 @@
+#include "asr.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    int failures{0};
+
+    void check(bool condition, const char *message)
+    {
+        if (!condition)
+        {
+            std::cerr << "geometry_upload_test: " << message << std::endl;
+            ++failures;
+        }
+    }
+
+    // Uploads the vertices into a vector the way ES2Geometry uploads them into its vertex buffer object.
+    class UploadGeometry final : public asr::Geometry
+    {
+    public:
+        using Geometry::Geometry;
+
+        std::vector<uint8_t> buffer;
+
+        void update(const asr::Material & /* material */) final
+        {
+            if (!_requires_vertices_update)
+            {
+                return;
+            }
+
+            const size_t stride{_vertex_layout.get_stride()};
+            const size_t vertex_count{get_vertex_count()};
+            size_t range_begin = std::min(_vertices_update_range_begin, vertex_count);
+            size_t range_end = std::min(_vertices_update_range_end, vertex_count);
+            if (buffer.size() != vertex_count * stride)
+            {
+                buffer.resize(vertex_count * stride);
+                range_begin = 0;
+                range_end = vertex_count;
+            }
+
+            const uint8_t *vertex_data = _begin_vertices_upload(range_begin, range_end);
+            std::memcpy(buffer.data() + range_begin * stride, vertex_data, (range_end - range_begin) * stride);
+            _end_vertices_upload();
+        }
+
+        void use() final {}
+    };
+
+    class UploadMaterial final : public asr::ConstantMaterial
+    {
+    public:
+        void update(const asr::FrameConstants & /* frame_constants */, const glm::mat4 & /* model_matrix */,
+                    const asr::LightSelection & /* lights */) final {}
+
+        void use() final {}
+    };
+
+    std::vector<asr::Vertex> create_vertices(size_t count)
+    {
+        std::vector<asr::Vertex> vertices(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            vertices[i].position = glm::vec3(static_cast<float>(i), 1.0f, 2.0f);
+        }
+
+        return vertices;
+    }
+
+    bool is_uploaded(const UploadGeometry &geometry)
+    {
+        const auto &vertices = geometry.get_vertices();
+        const asr::VertexLayout &vertex_layout = geometry.get_vertex_layout();
+        std::vector<uint8_t> packed_vertices(vertices.size() * vertex_layout.get_stride());
+        vertex_layout.pack(vertices, 0, vertices.size(), packed_vertices.data());
+
+        return geometry.buffer == packed_vertices;
+    }
+}
+
+int main()
+{
+    using namespace asr;
+
+    UploadMaterial material;
+    const size_t vertex_count{64};
+
+    // Static vertices handed over with std::move are packed for the upload, and the packed copy is released
+    // afterwards, so the geometry keeps only the vertices it was given.
+    {
+        UploadGeometry geometry{std::vector<unsigned int>{0, 1, 2}, create_vertices(vertex_count)};
+        geometry.update(material);
+
+        check(is_uploaded(geometry), "the static vertices were not uploaded");
+        check(geometry.get_vertex_upload_buffer_size() == 0, "the static geometry kept a packed copy of its vertices");
+
+        geometry.edit_vertices(8, 4)[0].position = glm::vec3(-1.0f);
+        geometry.update(material);
+
+        check(is_uploaded(geometry), "the edited static vertices were not uploaded");
+        check(geometry.get_vertex_upload_buffer_size() == 0, "the edited static geometry kept a packed copy");
+    }
+
+    // Dynamic vertices are uploaded by the edited range, packed at the start of the upload buffer.
+    {
+        UploadGeometry geometry{std::vector<unsigned int>{0, 1, 2}, create_vertices(vertex_count)};
+        geometry.set_vertices_usage_strategy(Geometry::DynamicStrategy);
+        geometry.update(material);
+
+        Vertex *vertices = geometry.edit_vertices(40, 3);
+        vertices[0].position = glm::vec3(-1.0f);
+        vertices[2].position = glm::vec3(-2.0f);
+        geometry.update(material);
+
+        check(is_uploaded(geometry), "the edited range of the dynamic vertices was not uploaded");
+    }
+
+    // Vertices the geometry stores packed are uploaded from that storage, without another copy.
+    {
+        UploadGeometry geometry{std::vector<unsigned int>{0, 1, 2}, std::vector<Vertex>{}};
+        const size_t stride{geometry.get_vertex_layout().get_stride()};
+        uint8_t *packed_vertices = geometry.edit_packed_vertices(vertex_count, AABB{glm::vec3{0.0f}, glm::vec3{1.0f}});
+        for (size_t i = 0; i < vertex_count * stride; ++i)
+        {
+            packed_vertices[i] = static_cast<uint8_t>(i);
+        }
+        geometry.update(material);
+
+        check(geometry.buffer.size() == vertex_count * stride &&
+                  std::memcmp(geometry.buffer.data(), packed_vertices, vertex_count * stride) == 0,
+              "the packed vertices were not uploaded");
+        check(geometry.get_vertex_upload_buffer_size() == 0, "the packed vertices were copied for the upload");
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
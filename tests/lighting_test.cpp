@@ -10,17 +10,17 @@
     material->set_specular_exponent(30.0f);
 
     auto [plane_indices, plane_vertices] = geometry_generators::generate_plane_geometry_data(500.0f, 500.0f, 10, 10);
-    auto plane_geometry = std::make_shared<ES2Geometry>(plane_indices, plane_vertices);
+    auto plane_geometry = std::make_shared<ES2Geometry>(std::move(plane_indices), std::move(plane_vertices));
     auto plane = std::make_shared<Mesh>(plane_geometry, material);
     plane->set_y(-2.0f);
     plane->set_rotation_x(-static_cast<float>(M_PI) * 0.5f);
 
     auto [sphere_indices, sphere_vertices] = geometry_generators::generate_sphere_geometry_data(1.0f, 100, 100);
-    auto sphere_geometry = std::make_shared<ES2Geometry>(sphere_indices, sphere_vertices);
+    auto sphere_geometry = std::make_shared<ES2Geometry>(std::move(sphere_indices), std::move(sphere_vertices));
     auto sphere = std::make_shared<Mesh>(sphere_geometry, material);
 
     auto [lamp_indices, lamp_vertices] = geometry_generators::generate_sphere_geometry_data(0.2f, 20, 20);
-    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(lamp_indices, lamp_vertices);
+    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(std::move(lamp_indices), std::move(lamp_vertices));
     auto lamp_material = std::make_shared<ES2ConstantMaterial>();
     lamp_material->set_emission_color(glm::vec4(1.0f));
     auto lamp1 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
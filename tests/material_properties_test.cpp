@@ -7,7 +7,7 @@
     auto window = std::make_shared<ES2SDLWindow>("asr");
 
     auto [plane1_indices, plane1_vertices] = geometry_generators::generate_plane_geometry_data(20, 20, 2, 2);
-    auto plane1_geometry = std::make_shared<ES2Geometry>(plane1_indices, plane1_vertices);
+    auto plane1_geometry = std::make_shared<ES2Geometry>(std::move(plane1_indices), std::move(plane1_vertices));
     auto plane1_material = std::make_shared<ES2PhongMaterial>();
     auto [image1_data, image1_width, image1_height, image1_channels] = file_utilities::read_image_file("data/images/checkerboard.png");
     auto texture1 = std::make_shared<ES2Texture>(image1_data, image1_width, image1_height, image1_channels);
@@ -17,7 +17,7 @@
     plane1->set_rotation(glm::vec3(0.0f, 0.0f, 0.0f));
 
     auto [plane2_indices, plane2_vertices] = geometry_generators::generate_plane_geometry_data(20, 20, 2, 2);
-    auto plane2_geometry = std::make_shared<ES2Geometry>(plane2_indices, plane2_vertices);
+    auto plane2_geometry = std::make_shared<ES2Geometry>(std::move(plane2_indices), std::move(plane2_vertices));
     auto plane2_material = std::make_shared<ES2PhongMaterial>();
     plane2_material->set_texture_1(texture1);
     plane2_material->set_emission_color(glm::vec4(1.0f, 1.0f, 1.0f, 0.0f));
@@ -26,7 +26,7 @@
     plane2->set_rotation(glm::vec3(-M_PI / 2, 0.0f, 0.0f));
 
     auto [sphere1_indices, sphere1_vertices] = geometry_generators::generate_sphere_geometry_data(1.0f, 20, 20);
-    auto sphere1_geometry = std::make_shared<ES2Geometry>(sphere1_indices, sphere1_vertices);
+    auto sphere1_geometry = std::make_shared<ES2Geometry>(std::move(sphere1_indices), std::move(sphere1_vertices));
     auto sphere1_material = std::make_shared<ES2PhongMaterial>();
     sphere1_material->set_diffuse_color(glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
     sphere1_material->set_specular_exponent(40.f);
@@ -38,7 +38,7 @@
     sphere1->set_position(glm::vec3(0.0f, 0.0f, 0.0f));
 
     auto [lamp_indices, lamp_vertices] = geometry_generators::generate_sphere_geometry_data(0.2f, 20, 20);
-    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(lamp_indices, lamp_vertices);
+    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(std::move(lamp_indices), std::move(lamp_vertices));
     auto lamp_material = std::make_shared<ES2ConstantMaterial>();
     lamp_material->set_emission_color(glm::vec4(1.0f));
     auto lamp1 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
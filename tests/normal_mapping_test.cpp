@@ -7,7 +7,7 @@
     auto window = std::make_shared<ES2SDLWindow>("asr", 0, 0);
 
     auto [plane1_indices, plane1_vertices] = geometry_generators::generate_plane_geometry_data(40, 40, 1, 1);
-    auto plane1_geometry = std::make_shared<ES2Geometry>(plane1_indices, plane1_vertices);
+    auto plane1_geometry = std::make_shared<ES2Geometry>(std::move(plane1_indices), std::move(plane1_vertices));
     plane1_geometry->calculate_tangents_and_binormals();
     auto plane1_material = std::make_shared<ES2PhongMaterial>();
     auto [image1_data, image1_width, image1_height, image1_channels] = file_utilities::read_image_file("data/images/bricks.png");
@@ -23,7 +23,7 @@
     plane1->set_rotation_x(-static_cast<float>(M_PI) * 0.5f);
 
     auto [lamp_indices, lamp_vertices] = geometry_generators::generate_sphere_geometry_data(0.2f, 20, 20);
-    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(lamp_indices, lamp_vertices);
+    auto lamp_sphere_geometry = std::make_shared<ES2Geometry>(std::move(lamp_indices), std::move(lamp_vertices));
     auto lamp_material = std::make_shared<ES2ConstantMaterial>();
     lamp_material->set_emission_color(glm::vec4(1.0f));
     auto lamp1 = std::make_shared<Mesh>(lamp_sphere_geometry, lamp_material);
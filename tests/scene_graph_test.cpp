@@ -12,14 +12,14 @@
     auto window = std::make_shared<ES2SDLWindow>("asr");
 
     auto [plane_indices, plane_vertices] = geometry_generators::generate_plane_geometry_data(0.15f, 0.15f, 2, 2);
-    auto plane_geometry = std::make_shared<ES2Geometry>(plane_indices, plane_vertices);
+    auto plane_geometry = std::make_shared<ES2Geometry>(std::move(plane_indices), std::move(plane_vertices));
 
     auto [circle_indices, circle_vertices] = geometry_generators::generate_circle_geometry_data(0.025f, 20);
-    auto circle_geometry = std::make_shared<ES2Geometry>(circle_indices, circle_vertices);
+    auto circle_geometry = std::make_shared<ES2Geometry>(std::move(circle_indices), std::move(circle_vertices));
     circle_geometry->set_type(Geometry::Type::TriangleFan);
 
     auto [sphere_indices, sphere_vertices] = geometry_generators::generate_sphere_geometry_data(0.15f, 10, 10);
-    auto sphere_geometry = std::make_shared<ES2Geometry>(sphere_indices, sphere_vertices);
+    auto sphere_geometry = std::make_shared<ES2Geometry>(std::move(sphere_indices), std::move(sphere_vertices));
 
     auto seconds_material = std::make_shared<ES2ConstantMaterial>();
     seconds_material->set_emission_color(glm::vec4{1.0f, 1.0f, 1.0f, 1.0f});
@@ -7,7 +7,7 @@
     auto window = std::make_shared<ES2SDLWindow>("asr");
 
     auto [plane1_indices, plane1_vertices] = geometry_generators::generate_plane_geometry_data(5, 3, 2, 2);
-    auto plane1_geometry = std::make_shared<ES2Geometry>(plane1_indices, plane1_vertices);
+    auto plane1_geometry = std::make_shared<ES2Geometry>(std::move(plane1_indices), std::move(plane1_vertices));
     auto plane1_material = std::make_shared<ES2PhongMaterial>();
     auto [image1_data, image1_width, image1_height, image1_channels] = file_utilities::read_image_file("data/images/city.jpg");
     auto texture1 = std::make_shared<ES2Texture>(image1_data, image1_width, image1_height, image1_channels);
@@ -16,7 +16,7 @@
     auto plane1 = std::make_shared<Mesh>(plane1_geometry, plane1_material);
 
     auto [plane2_indices, plane2_vertices] = geometry_generators::generate_plane_geometry_data(100, 100, 2, 2);
-    auto plane2_geometry = std::make_shared<ES2Geometry>(plane2_indices, plane2_vertices);
+    auto plane2_geometry = std::make_shared<ES2Geometry>(std::move(plane2_indices), std::move(plane2_vertices));
     auto plane2_material = std::make_shared<ES2PhongMaterial>();
     auto [image2_data, image2_width, image2_height, image2_channels] = file_utilities::read_image_file("data/images/checkerboard.png");
     auto [image3_data, image3_width, image3_height, image3_channels] = file_utilities::read_image_file("data/images/city.jpg");
@@ -0,0 +1,86 @@
+#include "asr.h"
+
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+    int failures{0};
+
+    void check(bool condition, const char *message)
+    {
+        if (!condition)
+        {
+            std::cerr << "transform_hierarchy_test: " << message << std::endl;
+            ++failures;
+        }
+    }
+
+    bool is_translated_by(const glm::mat4 &matrix, const glm::vec3 &translation)
+    {
+        return glm::vec3(matrix[3]) == translation;
+    }
+}
+
+int main()
+{
+    using namespace asr;
+
+    // A transform reparented below a later transform is still attached to it when another transform is
+    // destroyed before the hierarchy is sorted again.
+    {
+        TransformHierarchy hierarchy;
+        auto child = hierarchy.create();
+        auto removed = hierarchy.create();
+        auto parent = hierarchy.create();
+        hierarchy.set_local_transform(child, glm::vec3(1.0f, 0.0f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+        hierarchy.set_local_transform(parent, glm::vec3(0.0f, 2.0f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+
+        hierarchy.set_parent(child, parent);
+        hierarchy.destroy(removed);
+        hierarchy.update();
+
+        check(hierarchy.get_count() == 2, "the destroyed transform was not removed");
+        check(hierarchy.get_parent(child) == parent, "the child lost its later parent on compaction");
+        check(is_translated_by(hierarchy.get_world_matrix(child), glm::vec3(1.0f, 2.0f, 0.0f)),
+              "the child is not placed relative to its later parent");
+    }
+
+    // The same when the next reparenting compacts the hierarchy instead of the update.
+    {
+        TransformHierarchy hierarchy;
+        auto child = hierarchy.create();
+        auto removed = hierarchy.create();
+        auto parent = hierarchy.create();
+        auto other = hierarchy.create();
+
+        hierarchy.set_parent(child, parent);
+        hierarchy.destroy(removed);
+        hierarchy.set_parent(other, child);
+        hierarchy.update();
+
+        check(hierarchy.get_parent(child) == parent, "the child lost its later parent on reparenting");
+        check(hierarchy.get_parent(other) == child, "the reparented transform has the wrong parent");
+    }
+
+    // A handle reused before the sort keeps pointing at its new transform.
+    {
+        TransformHierarchy hierarchy;
+        auto child = hierarchy.create();
+        auto removed = hierarchy.create();
+        auto parent = hierarchy.create();
+
+        hierarchy.set_parent(child, parent);
+        hierarchy.destroy(removed);
+        auto reused = hierarchy.create();
+        hierarchy.set_local_transform(reused, glm::vec3(0.0f, 0.0f, 3.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+        hierarchy.update();
+
+        check(hierarchy.is_valid(reused), "the reused handle is not valid");
+        check(is_translated_by(hierarchy.get_world_matrix(reused), glm::vec3(0.0f, 0.0f, 3.0f)),
+              "the reused handle points at another transform");
+        check(hierarchy.get_parent(child) == parent, "the child lost its later parent next to a reused handle");
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
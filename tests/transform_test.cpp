@@ -27,7 +27,7 @@
     moon_material->set_texture_1(moon_texture);
 
     auto [sphere_indices, sphere_vertices] = geometry_generators::generate_sphere_geometry_data(1.0f, 20, 20);
-    auto sphere_geometry = std::make_shared<ES2Geometry>(sphere_indices, sphere_vertices);
+    auto sphere_geometry = std::make_shared<ES2Geometry>(std::move(sphere_indices), std::move(sphere_vertices));
 
     auto sun_mesh = std::make_shared<Mesh>(sphere_geometry, sun_material);
     auto venus_mesh = std::make_shared<Mesh>(sphere_geometry, venus_material);
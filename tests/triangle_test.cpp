@@ -7,7 +7,7 @@
     auto window = std::make_shared<ES2SDLWindow>("asr");
 
     auto [triangle_indices, triangle_vertices] = geometry_generators::generate_triangle_geometry_data(4.0f);
-    auto triangle_geometry = std::make_shared<ES2Geometry>(triangle_indices, triangle_vertices);
+    auto triangle_geometry = std::make_shared<ES2Geometry>(std::move(triangle_indices), std::move(triangle_vertices));
     triangle_geometry->get_vertices()[0].color = glm::vec4{1.0f, 0.0f, 0.0f, 1.0f};
     triangle_geometry->get_vertices()[1].color = glm::vec4{0.0f, 1.0f, 0.0f, 1.0f};
     triangle_geometry->get_vertices()[2].color = glm::vec4{0.0f, 0.0f, 1.0f, 1.0f};